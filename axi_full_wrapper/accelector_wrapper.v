@@ -3,12 +3,36 @@
 Author: Jingling Hou
 
 Module Description: Read only AXI Full wrapper for the accelector module
+
+Reads DDR from C_M_TARGET_SLAVE_BASE_ADDR upwards in INCR bursts of
+C_M_AXI_BURST_LEN beats and streams the data out in address order on an
+AXI4-Stream master (M_AXIS_*, clocked by M_AXI_ACLK).  TLAST marks the last
+beat of every burst.
+
+Up to C_M_MAX_OUTSTANDING bursts are in flight at once.  Every burst owns a
+slot of the reorder buffer from its AR handshake until its last beat has been
+read out to the stream, so RREADY never has to drop for lack of space and
+RVALID gaps are ordinary stalls.  Slot s is read with ARID s % NUM_IDS, so
+the slave may return (or interleave) bursts of different IDs out of order;
+bursts of one ID come back in order as AXI requires.
+
+A rising edge on INIT_AXI_TXN starts a transaction from the base address.
+With C_M_TXN_BURSTS = 0 it runs until reset; otherwise TXN_DONE rises once
+that many bursts have left on the stream.  ERROR rises on SLVERR/DECERR, on
+an RID with no burst outstanding, or on RLAST in the wrong place; no new
+bursts are issued, the ones in flight are drained (a burst the slave ends
+early with RLAST counts as drained), and the engine waits in IDLE for the
+next INIT_AXI_TXN edge.
 */
 module accelector_wrapper #(
     // Base address of targeted slave
     parameter  C_M_TARGET_SLAVE_BASE_ADDR = 32'h0000_0000, //DDR base addr
-    // Burst length (beats per burst)
+    // Burst length (beats per burst), 2 to 256; a burst must not cross 4 KB
     parameter integer C_M_AXI_BURST_LEN   = 256,
+    // Bursts in flight (reorder buffer slots), a power of two >= 2
+    parameter integer C_M_MAX_OUTSTANDING = 4,
+    // Bursts per transaction, 0 = continuous
+    parameter integer C_M_TXN_BURSTS      = 0,
     // Widths
     parameter integer C_M_AXI_ID_WIDTH    = 1,
     parameter integer C_M_AXI_ADDR_WIDTH  = 32,
@@ -46,7 +70,13 @@ module accelector_wrapper #(
     input  wire                          M_AXI_RLAST,
     input  wire [C_M_AXI_RUSER_WIDTH-1:0]  M_AXI_RUSER,
     input  wire                          M_AXI_RVALID,
-    output wire                          M_AXI_RREADY
+    output wire                          M_AXI_RREADY,
+
+    // AXI4-Stream output, in address order
+    output wire [C_M_AXI_DATA_WIDTH-1:0] M_AXIS_TDATA,
+    output wire                          M_AXIS_TLAST,
+    output wire                          M_AXIS_TVALID,
+    input  wire                          M_AXIS_TREADY
 );
     // Helper function declaration
     function integer clogb2(input integer bit_depth);
@@ -61,26 +91,74 @@ module accelector_wrapper #(
 
     //width of beat counter of each burst
     localparam integer C_BURST_NUM = clogb2(C_M_AXI_BURST_LEN - 1);
+    //reorder buffer slots, and the IDs they are read with
+    localparam integer SLOTS    = C_M_MAX_OUTSTANDING;
+    localparam integer SLOT_W   = clogb2(SLOTS - 1);
+    localparam integer NUM_IDS  = ((1 << C_M_AXI_ID_WIDTH) < SLOTS) ? (1 << C_M_AXI_ID_WIDTH) : SLOTS;
+    localparam integer ID_W     = clogb2(NUM_IDS - 1);
+
+    localparam [C_M_AXI_ADDR_WIDTH-1:0] BURST_SIZE_BYTES = C_M_AXI_BURST_LEN * (C_M_AXI_DATA_WIDTH/8);
+    localparam [C_BURST_NUM-1:0]        LAST_BEAT        = C_M_AXI_BURST_LEN - 1;
 
     //FSM states
-    localparam [1:0] IDLE = 2'b00, READ_ADDR = 2'b01, READ_DATA = 2'b10, DONE = 2'b11;
+    localparam [1:0] IDLE = 2'b00, RUN = 2'b01, FLUSH = 2'b10, DONE = 2'b11;
 
     //Internal Reg
     reg [1:0]                              state_read;
     reg                                    axi_arvalid_reg;
-    reg                                    axi_rready_reg;
     reg [C_M_AXI_ADDR_WIDTH-1:0]           axi_araddr;
-    reg [C_BURST_NUM:0]                    read_index;
     reg                                    init_ff, init_ff2;
+    reg [31:0]                             bursts_issued;
+    reg [31:0]                             bursts_streamed;
+
+    // Issue side: next slot to request, slots owned by a burst
+    reg [SLOT_W-1:0]                       issue_slot;
+    reg [SLOT_W:0]                         slots_used;
+    reg [SLOTS-1:0]                        pending;     // AR accepted, last beat not yet received
 
-    wire [C_BURST_NUM + 1: 0] burst_size_bytes = C_M_AXI_BURST_LEN * (C_M_AXI_DATA_WIDTH/8); //256 * 2
+    // Receive side, per ID: the slot its next beat belongs to and the beat number
+    reg [SLOT_W-1:0]                       rx_slot[0:NUM_IDS-1];
+    reg [C_BURST_NUM-1:0]                  rx_beat[0:NUM_IDS-1];
+    reg [C_BURST_NUM:0]                    fill[0:SLOTS-1];     // beats received per slot
+
+    // Stream side: slot and beat to read next, one cycle of RAM latency, 2-entry output buffer
+    reg [SLOT_W-1:0]                       out_slot;
+    reg [C_BURST_NUM-1:0]                  out_beat;
+    reg                                    rd_vld, rd_last;
+    reg [C_M_AXI_DATA_WIDTH-1:0]           ob_data0, ob_data1;
+    reg                                    ob_last0, ob_last1;
+    reg [1:0]                              ob_cnt;
+
+    reg [C_M_AXI_DATA_WIDTH-1:0] rob[0:(SLOTS << C_BURST_NUM) - 1];
+    reg [C_M_AXI_DATA_WIDTH-1:0] rob_q;
 
     // Handshake helpers
-    wire init_pulse = INIT_AXI_TXN & ~init_ff2; //Note this will result in a one time transaction, if need continuous burst transaction, change init pulse generator
-    wire rnext      = M_AXI_RVALID & axi_rready_reg; //Read Next 
+    wire init_pulse = init_ff & ~init_ff2; //One cycle per rising edge of INIT_AXI_TXN
+    wire ar_fire    = axi_arvalid_reg & M_AXI_ARREADY;
+    wire rnext      = M_AXI_RVALID & M_AXI_RREADY; //Read Next
+    wire pop        = M_AXIS_TVALID & M_AXIS_TREADY;
+
+    wire [ID_W-1:0]        rx_id       = M_AXI_RID[ID_W-1:0];
+    wire [SLOT_W-1:0]      rx_wslot    = rx_slot[rx_id];
+    wire [C_BURST_NUM-1:0] rx_wbeat    = rx_beat[rx_id];
+    wire                   rx_known    = (M_AXI_RID < NUM_IDS) && pending[rx_wslot];
+    // A burst ends at its last beat or at RLAST, whichever comes first: an early
+    // RLAST is an error, but the slave is done with the burst and so is its slot
+    wire                   rx_end      = rnext && rx_known && ((rx_wbeat == LAST_BEAT) || M_AXI_RLAST);
+    wire                   rx_err      = rnext && (M_AXI_RRESP[1] || !rx_known || (M_AXI_RLAST != (rx_wbeat == LAST_BEAT)));
+
+    // Read the next beat when it has arrived and the output buffer will have room for it
+    wire                   rd_en       = (state_read == RUN) && ({1'b0, out_beat} < fill[out_slot]) &&
+                                         ({1'b0, ob_cnt} + rd_vld < 3'd2 + pop);
+    wire                   slot_free   = rd_en && (out_beat == LAST_BEAT);
+
+    wire [SLOT_W:0]        slots_next  = slots_used + ar_fire - slot_free;
+    wire [31:0]            issued_next = bursts_issued + ar_fire;
+    wire                   can_issue   = (slots_next < SLOTS) && !rx_err &&
+                                         (C_M_TXN_BURSTS == 0 || issued_next < C_M_TXN_BURSTS);
 
     // AXI I/O assignments
-    assign M_AXI_ARID    = {C_M_AXI_ID_WIDTH{1'b0}};
+    assign M_AXI_ARID    = issue_slot[ID_W-1:0];
     assign M_AXI_ARADDR  = C_M_TARGET_SLAVE_BASE_ADDR + axi_araddr;
     assign M_AXI_ARLEN   = C_M_AXI_BURST_LEN - 1;
     assign M_AXI_ARSIZE  = clogb2((C_M_AXI_DATA_WIDTH/8)-1);
@@ -91,8 +169,12 @@ module accelector_wrapper #(
     assign M_AXI_ARQOS   = 4'b0000;
     assign M_AXI_ARUSER  = 'b1;
     assign M_AXI_ARVALID = axi_arvalid_reg;
-    assign M_AXI_RREADY  = axi_rready_reg;
-    
+    assign M_AXI_RREADY  = |pending;         // every pending burst already owns its slot
+
+    assign M_AXIS_TDATA  = ob_data0;
+    assign M_AXIS_TLAST  = ob_last0;
+    assign M_AXIS_TVALID = (ob_cnt != 0);
+
     assign TXN_DONE = (state_read == DONE);
 
     // init pulse generate
@@ -102,99 +184,149 @@ module accelector_wrapper #(
             init_ff <= 'b0;
             init_ff2 <= 'b0;
         end
-        else 
+        else
         begin
             init_ff <= INIT_AXI_TXN;
             init_ff2 <= init_ff; //Shift reg
         end
     end
 
+    // Reorder buffer, one write and one registered read port (block RAM)
+    always @(posedge M_AXI_ACLK) begin
+        if(rnext && rx_known)
+            rob[{rx_wslot, rx_wbeat}] <= M_AXI_RDATA;
+        if(rd_en)
+            rob_q <= rob[{out_slot, out_beat}];
+    end
+
     //FSM (Read Only AXI Full)
     //Only Read channels implemented
 
     //FSM design logic (Fully registered one process FSM):
     /*
-    IDLE -> init pulse -> RADDR
-    RADDR -> ARvalid && ARready handshake -> RDATA
-    For this stage, Rready is asserted and the address is incremented by burst size
-    RDATA -> Rvalid && Rready handshake -> check if Rlast
-                                            -> if Rlast, reset read index and prepare for the next transaction
-                                            -> if not Rlast, but read index reaches maximum, 
-    For this stage, Rread is deasserted @ RLast high
+    IDLE  -> init pulse -> RUN, every slot free, address back to the base
+    RUN   -> ARVALID whenever a slot is free; beats land in their burst's slot
+             by RID and leave on the stream in slot order
+          -> ERROR -> FLUSH
+          -> C_M_TXN_BURSTS streamed -> DONE
+    FLUSH -> no new bursts; the outstanding ones (and a held ARVALID) are
+             drained and the output buffer empties -> IDLE
+    DONE  -> init pulse -> RUN
+    ARVALID, once raised, holds until ARREADY in every state.
     */
 
-    reg [C_M_AXI_DATA_WIDTH - 1:0] read_buffer[0: C_M_AXI_BURST_LEN - 1];
+    integer i;
 
     always @(posedge M_AXI_ACLK) begin
-        if(!M_AXI_ARESETN || init_pulse)
+        if(!M_AXI_ARESETN)
         begin
             state_read <= IDLE;
-            axi_arvalid_reg <= 'b0;
-            axi_rready_reg <= 'b0;
+            axi_arvalid_reg <= 1'b0;
             axi_araddr <= 0;
-            read_index <= 0;
+            issue_slot <= 0;
+            slots_used <= 0;
+            pending <= 0;
+            rd_vld <= 1'b0;
+            ob_cnt <= 0;
             ERROR <= 1'b0;
         end
-        case(state_read)
-            IDLE:
-            begin
-                if(init_pulse) begin
-                    axi_arvalid_reg <= 1'b1;
-                    axi_rready_reg <= 1'b0;
-                    state_read <= READ_ADDR;
-                    ERROR <= 1'b0;
-                end
-                else 
-                begin
-                    state_read <= IDLE;
-                end
+        else
+        begin
+            // Address channel
+            if(ar_fire) begin
+                axi_araddr <= axi_araddr + BURST_SIZE_BYTES; //Increment address by burst size
+                issue_slot <= issue_slot + 1'b1;
+                bursts_issued <= issued_next;
             end
+            if(axi_arvalid_reg && !M_AXI_ARREADY)
+                axi_arvalid_reg <= 1'b1; //Hold until the slave takes it
+            else
+                axi_arvalid_reg <= (state_read == RUN) && can_issue;
+            slots_used <= slots_next;
 
-            READ_ADDR:
-            begin
-                if(M_AXI_ARREADY && axi_arvalid_reg) begin
-                    axi_arvalid_reg <= 1'b0; //ARvalid deasserted
-                    axi_rready_reg <= 1'b1; //Rready asserted
-                    axi_araddr <= axi_araddr + burst_size_bytes; //Increment address by burst size
-                    state_read <= READ_DATA;
+            // Read data channel
+            if(rnext && rx_known) begin
+                fill[rx_wslot] <= fill[rx_wslot] + 1'b1;
+                if(rx_end) begin
+                    rx_beat[rx_id] <= 0;
+                    rx_slot[rx_id] <= rx_wslot + NUM_IDS; //Next burst of this ID
                 end
                 else
-                    state_read <= state_read; //Stay in Read Addr state, waiting for slave to respond
+                    rx_beat[rx_id] <= rx_wbeat + 1'b1;
             end
+            pending <= (pending | (ar_fire ? ({{(SLOTS-1){1'b0}}, 1'b1} << issue_slot) : {SLOTS{1'b0}}))
+                               & ~(rx_end ? ({{(SLOTS-1){1'b0}}, 1'b1} << rx_wslot) : {SLOTS{1'b0}});
 
-            READ_DATA:
-            begin
-                if(rnext) begin
-                    //Data capture logic here
-                    read_buffer[read_index] <= M_AXI_RDATA;
-
-                    if(M_AXI_RLAST) begin
-                        axi_rready_reg <= 1'b0; //Rready deasserted
-                        axi_arvalid_reg <= 1'b1;
-                        read_index <= 0;
-                        state_read <= READ_ADDR;
-                    end
-                    else if (read_index == C_M_AXI_BURST_LEN)
-                    begin
-                        state_read <= IDLE;
-                        //ERROR Rlast should be triggered before this clock cycle
-                        ERROR <= 1'b1;
-                    end
-                    else begin
-                        axi_rready_reg <= 1'b1; //Rready asserted
-                        read_index <= read_index + 1;
-                        state_read <= READ_DATA;
-                    end
+            // Stream side
+            if(rd_en) begin
+                rd_last <= (out_beat == LAST_BEAT);
+                if(out_beat == LAST_BEAT) begin
+                    fill[out_slot] <= 0; //Slot free for the next burst
+                    out_slot <= out_slot + 1'b1;
+                    out_beat <= 0;
+                end
+                else
+                    out_beat <= out_beat + 1'b1;
+            end
+            rd_vld <= rd_en;
+            if(pop) begin
+                ob_data0 <= ob_data1;
+                ob_last0 <= ob_last1;
+            end
+            if(rd_vld) begin
+                if(ob_cnt - pop == 0) begin
+                    ob_data0 <= rob_q;
+                    ob_last0 <= rd_last;
                 end
                 else begin
-                    state_read <= IDLE;
-                    //ERROR
-                    ERROR <= 1'b1;
+                    ob_data1 <= rob_q;
+                    ob_last1 <= rd_last;
                 end
             end
+            ob_cnt <= ob_cnt - pop + rd_vld;
+            if(pop && ob_last0)
+                bursts_streamed <= bursts_streamed + 1;
 
+            case(state_read)
+                IDLE, DONE:
+                begin
+                    if(init_pulse) begin
+                        state_read <= RUN;
+                        ERROR <= 1'b0;
+                        axi_araddr <= 0;
+                        issue_slot <= 0;
+                        slots_used <= 0;
+                        bursts_issued <= 0;
+                        bursts_streamed <= 0;
+                        out_slot <= 0;
+                        out_beat <= 0;
+                        for (i = 0; i < NUM_IDS; i = i + 1) begin
+                            rx_slot[i] <= i;
+                            rx_beat[i] <= 0;
+                        end
+                        for (i = 0; i < SLOTS; i = i + 1)
+                            fill[i] <= 0;
+                    end
+                end
 
-        endcase
+                RUN:
+                begin
+                    if(rx_err) begin
+                        ERROR <= 1'b1;
+                        state_read <= FLUSH;
+                    end
+                    else if(C_M_TXN_BURSTS != 0 && bursts_streamed == C_M_TXN_BURSTS)
+                        state_read <= DONE;
+                end
+
+                FLUSH:
+                begin
+                    //Wait for the slave to finish what it accepted, and the stream to empty
+                    if(!axi_arvalid_reg && pending == 0 && !rd_vld && ob_cnt == 0)
+                        state_read <= IDLE;
+                end
+            endcase
+        end
     end
-    
-endmodule
\ No newline at end of file
+
+endmodule
@@ -0,0 +1,109 @@
+#include "axi_mem_model.h"
+
+#include <algorithm>
+#include <stdexcept>
+#include <vector>
+
+axi_mem_model::axi_mem_model(const axi_mem_config &cfg, unsigned data_bytes)
+    : cfg_(cfg), bytes_(data_bytes), rng_(cfg.seed * 2 + 1)
+{
+    if (data_bytes < 2 || data_bytes > 128 || (data_bytes & (data_bytes - 1)))
+        throw std::invalid_argument("axi_mem_model: data width must be 16 to 1024 bits, a power of two");
+    if (cfg_.max_outstanding == 0) throw std::invalid_argument("axi_mem_model: max_outstanding must be >= 1");
+    cfg_.r_latency = std::max(cfg_.r_latency, 1u);
+    prepare();
+}
+
+uint64_t axi_mem_model::rword(unsigned i) const
+{
+    if (!rvalid_) return 0;
+    const burst &b = q_[cur_];
+    uint64_t lane = (b.addr + (uint64_t)b.beat * bytes_) / 2 + (uint64_t)i * 4, w = 0;
+    for (unsigned k = 0; k < 4 && (i * 4 + k) * 2 < bytes_; k++) w |= ((lane + k) & 0xffff) << (16 * k);
+    return w;
+}
+
+double axi_mem_model::uniform()
+{
+    rng_ = rng_ * 6364136223846793005ULL + 1442695040888963407ULL;
+    return (double)(rng_ >> 11) * 0x1.0p-53;
+}
+
+void axi_mem_model::clock(bool arvalid, unsigned arid, uint64_t araddr, unsigned arlen, unsigned arsize,
+                          unsigned arburst, bool rready)
+{
+    /* Read data channel */
+    r_taken_ = rvalid_ && rready;
+    if (r_taken_) {
+        st_.beats++;
+        burst &b = q_[cur_];
+        if (++b.beat == b.end) {
+            if (b.end != b.len) st_.early_rlast++;
+            q_.erase(q_.begin() + (std::ptrdiff_t)cur_);
+            busy_ = false;
+            st_.bursts++;
+        }
+        if (cfg_.gap_every && st_.beats % cfg_.gap_every == 0) gap_left_ = cfg_.gap_len;
+    } else if (rvalid_) {
+        st_.r_stall++;
+    } else if (rready) {
+        st_.r_starve++;
+    }
+
+    /* Read address channel: once valid, ARVALID and ARADDR hold until the handshake */
+    if (ar_pending_ && (!arvalid || araddr != ar_pending_addr_)) st_.protocol_errors++;
+    if (arvalid && arready_) {
+        unsigned want_size = 0;
+        while ((2u << want_size) <= bytes_) want_size++;
+        if (arsize != want_size || arburst != 1) st_.protocol_errors++;
+        if (expect_valid_ && araddr != expect_addr_) st_.addr_errors++;
+        expect_valid_ = true;
+        expect_addr_ = araddr + (uint64_t)(arlen + 1) * bytes_;
+        st_.ar++;
+        bool early = cfg_.early_rlast_every && st_.ar % cfg_.early_rlast_every == 0;
+        q_.push_back(burst{ araddr, arid, arlen + 1, 0, early ? std::max((arlen + 1) / 2, 1u) : arlen + 1,
+                            st_.cycles + cfg_.r_latency });
+        ar_wait_ = 0;
+        ar_pending_ = false;
+    } else if (arvalid) {
+        ar_wait_++;
+        ar_pending_ = true;
+        ar_pending_addr_ = araddr;
+    } else {
+        ar_wait_ = 0;
+        ar_pending_ = false;
+    }
+
+    st_.cycles++;
+    prepare();
+}
+
+void axi_mem_model::prepare()
+{
+    arready_ = ar_wait_ >= cfg_.ar_latency && q_.size() < cfg_.max_outstanding;
+
+    if (rvalid_ && !r_taken_) return;   // RVALID holds until the handshake
+    rvalid_ = false;
+    if (gap_left_) {
+        gap_left_--;
+        return;
+    }
+    if (!busy_) {
+        /* The oldest burst of each ID that is due; usually the oldest of all */
+        std::vector<std::size_t> ready;
+        for (std::size_t i = 0; i < q_.size() && st_.cycles >= q_[i].due; i++) {
+            bool oldest = true;
+            for (std::size_t j = 0; j < i && oldest; j++) oldest = q_[j].id != q_[i].id;
+            if (oldest) ready.push_back(i);
+        }
+        if (ready.empty()) return;
+        cur_ = ready[0];
+        if (ready.size() > 1 && cfg_.reorder_prob > 0.0 && uniform() < cfg_.reorder_prob) {
+            cur_ = ready[1 + (std::size_t)(uniform() * (double)(ready.size() - 1))];
+            st_.reordered++;
+        }
+        busy_ = true;
+    }
+    if (cfg_.gap_prob > 0.0 && uniform() < cfg_.gap_prob) return;
+    rvalid_ = true;
+}
@@ -0,0 +1,94 @@
+/* axi_mem_model.h
+ * AXI4 read-only slave memory for the accelector_wrapper bench: INCR bursts
+ * with configurable address-channel latency, read latency, RVALID gaps and a
+ * limit on outstanding bursts.  Bursts of one ID are answered in order; with
+ * reorder_prob a burst of another ID may be answered first.  The beats of a
+ * burst are never interleaved with another burst's.  With early_rlast_every
+ * the model misbehaves on purpose: that burst ends with RLAST halfway through.
+ *
+ * The model is cycle based.  Its outputs for the current cycle are valid
+ * after construction or clock(); clock() takes the master's outputs as they
+ * were just before the rising edge.  Beat data is the byte address counter
+ * in 16-bit lanes: lane k of the beat at A is (A / 2 + k) & 0xffff.
+ */
+
+#ifndef AXI_MEM_MODEL_H
+#define AXI_MEM_MODEL_H
+
+#include <cstdint>
+#include <deque>
+
+struct axi_mem_config {
+    unsigned ar_latency = 0;            // cycles ARVALID waits for ARREADY
+    unsigned r_latency = 1;             // cycles from the AR handshake to the burst's first RVALID, >= 1
+    unsigned max_outstanding = 4;       // accepted bursts not yet delivered; ARREADY is low at the limit
+    unsigned gap_every = 0;             // RVALID low for gap_len cycles after every gap_every beats, 0 = never
+    unsigned gap_len = 1;
+    double gap_prob = 0.0;              // chance of a one-cycle RVALID gap ahead of each beat
+    double reorder_prob = 0.0;          // chance that a later burst of another ID is answered first
+    uint64_t seed = 1;
+    unsigned early_rlast_every = 0;     // every n-th burst ends with RLAST after len / 2 beats, 0 = never
+};
+
+struct axi_mem_stats {
+    uint64_t cycles = 0;
+    uint64_t ar = 0;                    // address handshakes
+    uint64_t beats = 0;                 // data handshakes
+    uint64_t bursts = 0;                // bursts delivered to RLAST
+    uint64_t early_rlast = 0;           // of those, ended early
+    uint64_t reordered = 0;             // bursts answered ahead of an older one
+    uint64_t r_stall = 0;               // RVALID high, RREADY low
+    uint64_t r_starve = 0;              // RREADY high, RVALID low
+    uint64_t addr_errors = 0;           // ARADDR not where the previous burst ended
+    uint64_t protocol_errors = 0;       // ARVALID or ARADDR changed before ARREADY, bad ARSIZE or ARBURST
+};
+
+class axi_mem_model {
+public:
+    axi_mem_model(const axi_mem_config &cfg, unsigned data_bytes);
+
+    bool arready() const { return arready_; }
+    bool rvalid() const { return rvalid_; }
+    bool rlast() const { return rvalid_ && q_[cur_].beat + 1 == q_[cur_].end; }
+    unsigned rid() const { return rvalid_ ? q_[cur_].id : 0; }
+    uint64_t rword(unsigned i) const;   // 64-bit word i of RDATA
+
+    /* The rising edge: handshakes on the current outputs, then the next cycle's outputs */
+    void clock(bool arvalid, unsigned arid, uint64_t araddr, unsigned arlen, unsigned arsize, unsigned arburst,
+               bool rready);
+
+    /* The master was reset: forget the address it was expected to continue from */
+    void restart() { expect_valid_ = false; }
+
+    /* Accepted bursts not yet delivered to RLAST */
+    std::size_t outstanding() const { return q_.size(); }
+
+    const axi_mem_stats &stats() const { return st_; }
+
+private:
+    struct burst {
+        uint64_t addr;
+        unsigned id, len, beat;
+        unsigned end;                   // beats up to RLAST, len unless ended early
+        uint64_t due;                   // first cycle its data may be valid
+    };
+
+    void prepare();
+    double uniform();
+
+    axi_mem_config cfg_;
+    unsigned bytes_;
+    std::deque<burst> q_;               // accepted bursts, oldest first
+    std::size_t cur_ = 0;               // the burst on the data channel, valid while busy_
+    bool busy_ = false;
+    bool arready_ = false, rvalid_ = false, r_taken_ = false;
+    unsigned ar_wait_ = 0, gap_left_ = 0;
+    bool ar_pending_ = false;
+    uint64_t ar_pending_addr_ = 0;
+    bool expect_valid_ = false;
+    uint64_t expect_addr_ = 0;
+    uint64_t rng_;
+    axi_mem_stats st_;
+};
+
+#endif /* AXI_MEM_MODEL_H */
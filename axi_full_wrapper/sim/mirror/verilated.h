@@ -0,0 +1,28 @@
+/* verilated.h (mirror build)
+ * The few pieces of the Verilator runtime wrapper_bench uses, so the bench
+ * compiles unchanged against wrapper_mirror.h when BENCH_MIRROR is set.
+ */
+
+#ifndef MIRROR_VERILATED_H
+#define MIRROR_VERILATED_H
+
+#include <cstddef>
+#include <cstdint>
+
+struct VerilatedContext {
+    uint64_t time = 0;
+    void timeInc(uint64_t add) { time += add; }
+};
+
+struct Verilated {
+    static void commandArgs(int, char **) {}
+};
+
+/* A port wider than 64 bits, as 32-bit words, least significant first */
+template <std::size_t N> struct VlWide {
+    uint32_t w[N];
+    uint32_t &operator[](std::size_t i) { return w[i]; }
+    const uint32_t &operator[](std::size_t i) const { return w[i]; }
+};
+
+#endif /* MIRROR_VERILATED_H */
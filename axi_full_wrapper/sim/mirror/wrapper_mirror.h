@@ -0,0 +1,265 @@
+/* wrapper_mirror.h
+ * Cycle-level C++ mirror of ../../accelector_wrapper.v, for running
+ * wrapper_bench where Verilator is not installed (BENCH_MIRROR).
+ *
+ * The class has the ports of a Verilated model of the module, with the same
+ * names and C types, and eval() works the same way: on a rising edge of
+ * M_AXI_ACLK every register takes the value the RTL's nonblocking
+ * assignments give it, computed from the inputs and the registers before
+ * the edge; the outputs then follow the registers.  Registers and wires keep
+ * their RTL names.  The mirror has to be kept in step with the RTL by hand:
+ * a clean run against it says the design works, not that the Verilog does.
+ */
+
+#ifndef WRAPPER_MIRROR_H
+#define WRAPPER_MIRROR_H
+
+#include <cstdint>
+#include <type_traits>
+#include <vector>
+
+#include "verilated.h"
+
+/* The C type Verilator gives a port of W bits */
+template <unsigned W>
+using mirror_port_t = std::conditional_t<
+    (W <= 8), uint8_t,
+    std::conditional_t<(W <= 16), uint16_t,
+                       std::conditional_t<(W <= 32), uint32_t,
+                                          std::conditional_t<(W <= 64), uint64_t, VlWide<(W + 31) / 32>>>>>;
+
+/* ceiling(log2(x + 1)), the RTL's clogb2() */
+constexpr unsigned mirror_clogb2(unsigned x)
+{
+    return x ? 1 + mirror_clogb2(x >> 1) : 0;
+}
+
+template <unsigned C_M_AXI_DATA_WIDTH, unsigned C_M_AXI_BURST_LEN, unsigned C_M_MAX_OUTSTANDING = 4,
+          unsigned C_M_TXN_BURSTS = 0, unsigned C_M_AXI_ID_WIDTH = 1, uint32_t C_M_TARGET_SLAVE_BASE_ADDR = 0>
+class wrapper_mirror {
+    static constexpr unsigned C_BURST_NUM = mirror_clogb2(C_M_AXI_BURST_LEN - 1);
+    static constexpr unsigned SLOTS = C_M_MAX_OUTSTANDING;
+    static constexpr unsigned SLOT_W = mirror_clogb2(SLOTS - 1);
+    static constexpr unsigned NUM_IDS = ((1u << C_M_AXI_ID_WIDTH) < SLOTS) ? (1u << C_M_AXI_ID_WIDTH) : SLOTS;
+    static constexpr unsigned ID_W = mirror_clogb2(NUM_IDS - 1);
+    static constexpr uint32_t BURST_SIZE_BYTES = C_M_AXI_BURST_LEN * (C_M_AXI_DATA_WIDTH / 8);
+    static constexpr unsigned LAST_BEAT = C_M_AXI_BURST_LEN - 1;
+    enum : unsigned { IDLE = 0, RUN = 1, FLUSH = 2, DONE = 3 };
+
+    static_assert(C_M_AXI_BURST_LEN >= 2 && C_M_AXI_BURST_LEN <= 256, "burst length is 2 to 256 beats");
+    static_assert(SLOTS >= 2 && (SLOTS & (SLOTS - 1)) == 0, "outstanding bursts are a power of two >= 2");
+
+    using data_t = mirror_port_t<C_M_AXI_DATA_WIDTH>;
+
+    static constexpr unsigned mask(unsigned bits) { return (1u << bits) - 1; }
+
+public:
+    // Control
+    uint8_t INIT_AXI_TXN = 0, TXN_DONE = 0, ERROR = 0;
+    // Clock / reset
+    uint8_t M_AXI_ACLK = 0, M_AXI_ARESETN = 0;
+    // AXI Read Address Channel
+    mirror_port_t<C_M_AXI_ID_WIDTH> M_AXI_ARID = 0;
+    uint32_t M_AXI_ARADDR = 0;
+    uint8_t M_AXI_ARLEN = C_M_AXI_BURST_LEN - 1, M_AXI_ARSIZE = mirror_clogb2(C_M_AXI_DATA_WIDTH / 8 - 1);
+    uint8_t M_AXI_ARBURST = 1, M_AXI_ARLOCK = 0, M_AXI_ARCACHE = 2, M_AXI_ARPROT = 0, M_AXI_ARQOS = 0;
+    uint8_t M_AXI_ARUSER = 1, M_AXI_ARVALID = 0, M_AXI_ARREADY = 0;
+    // AXI Read Data Channel
+    mirror_port_t<C_M_AXI_ID_WIDTH> M_AXI_RID = 0;
+    data_t M_AXI_RDATA{};
+    uint8_t M_AXI_RRESP = 0, M_AXI_RLAST = 0, M_AXI_RUSER = 0, M_AXI_RVALID = 0, M_AXI_RREADY = 0;
+    // AXI4-Stream output
+    data_t M_AXIS_TDATA{};
+    uint8_t M_AXIS_TLAST = 0, M_AXIS_TVALID = 0, M_AXIS_TREADY = 0;
+
+    wrapper_mirror(VerilatedContext *, const char *)
+        : rx_slot(NUM_IDS), rx_beat(NUM_IDS), fill(SLOTS), rob((std::size_t)SLOTS << C_BURST_NUM)
+    {
+        outputs();
+    }
+
+    void eval()
+    {
+        if (M_AXI_ACLK && !aclk) posedge();
+        aclk = M_AXI_ACLK;
+        outputs();
+    }
+
+    void final() {}
+
+private:
+    struct regs {
+        unsigned state_read = IDLE;
+        bool axi_arvalid_reg = false;
+        uint32_t axi_araddr = 0;
+        bool init_ff = false, init_ff2 = false;
+        uint32_t bursts_issued = 0, bursts_streamed = 0;
+        unsigned issue_slot = 0, slots_used = 0, pending = 0;
+        unsigned out_slot = 0, out_beat = 0;
+        bool rd_vld = false, rd_last = false;
+        data_t ob_data0{}, ob_data1{};
+        bool ob_last0 = false, ob_last1 = false;
+        unsigned ob_cnt = 0;
+        bool error = false;
+    };
+
+    void posedge()
+    {
+        const regs &q = r;
+        regs d = r;
+        std::vector<unsigned> rx_slot_d = rx_slot, rx_beat_d = rx_beat, fill_d = fill;
+
+        // Handshake helpers
+        const bool init_pulse = q.init_ff && !q.init_ff2;
+        const bool ar_fire = q.axi_arvalid_reg && M_AXI_ARREADY;
+        const bool rnext = M_AXI_RVALID && q.pending != 0;
+        const bool pop = q.ob_cnt != 0 && M_AXIS_TREADY;
+
+        const unsigned rx_id = (unsigned)M_AXI_RID & mask(ID_W);
+        const unsigned rx_wslot = rx_slot[rx_id], rx_wbeat = rx_beat[rx_id];
+        const bool rx_known = M_AXI_RID < NUM_IDS && (q.pending >> rx_wslot & 1);
+        const bool rx_end = rnext && rx_known && (rx_wbeat == LAST_BEAT || M_AXI_RLAST);
+        const bool rx_err = rnext && ((M_AXI_RRESP & 2) || !rx_known || (M_AXI_RLAST != 0) != (rx_wbeat == LAST_BEAT));
+
+        const bool rd_en = q.state_read == RUN && q.out_beat < fill[q.out_slot] && q.ob_cnt + q.rd_vld < 2u + pop;
+        const bool slot_free = rd_en && q.out_beat == LAST_BEAT;
+
+        const unsigned slots_next = (q.slots_used + ar_fire - slot_free) & mask(SLOT_W + 1);
+        const uint32_t issued_next = q.bursts_issued + ar_fire;
+        const bool can_issue = slots_next < SLOTS && !rx_err && (C_M_TXN_BURSTS == 0 || issued_next < C_M_TXN_BURSTS);
+
+        // init pulse generate
+        d.init_ff = M_AXI_ARESETN && INIT_AXI_TXN;
+        d.init_ff2 = M_AXI_ARESETN && q.init_ff;
+
+        // Reorder buffer, one write and one registered read port; the read sees the old contents
+        const data_t rob_q_was = rob_q;
+        if (rd_en) rob_q = rob[q.out_slot << C_BURST_NUM | q.out_beat];
+        if (rnext && rx_known) rob[rx_wslot << C_BURST_NUM | rx_wbeat] = M_AXI_RDATA;
+
+        if (!M_AXI_ARESETN) {
+            d.state_read = IDLE;
+            d.axi_arvalid_reg = false;
+            d.axi_araddr = 0;
+            d.issue_slot = 0;
+            d.slots_used = 0;
+            d.pending = 0;
+            d.rd_vld = false;
+            d.ob_cnt = 0;
+            d.error = false;
+            r = d;
+            return;
+        }
+
+        // Address channel
+        if (ar_fire) {
+            d.axi_araddr = q.axi_araddr + BURST_SIZE_BYTES;
+            d.issue_slot = (q.issue_slot + 1) & mask(SLOT_W);
+            d.bursts_issued = issued_next;
+        }
+        if (q.axi_arvalid_reg && !M_AXI_ARREADY)
+            d.axi_arvalid_reg = true;
+        else
+            d.axi_arvalid_reg = q.state_read == RUN && can_issue;
+        d.slots_used = slots_next;
+
+        // Read data channel
+        if (rnext && rx_known) {
+            fill_d[rx_wslot] = fill[rx_wslot] + 1;
+            if (rx_end) {
+                rx_beat_d[rx_id] = 0;
+                rx_slot_d[rx_id] = (rx_wslot + NUM_IDS) & mask(SLOT_W);
+            } else {
+                rx_beat_d[rx_id] = rx_wbeat + 1;
+            }
+        }
+        d.pending = (q.pending | (ar_fire ? 1u << q.issue_slot : 0)) & ~(rx_end ? 1u << rx_wslot : 0);
+
+        // Stream side
+        if (rd_en) {
+            d.rd_last = q.out_beat == LAST_BEAT;
+            if (q.out_beat == LAST_BEAT) {
+                fill_d[q.out_slot] = 0;
+                d.out_slot = (q.out_slot + 1) & mask(SLOT_W);
+                d.out_beat = 0;
+            } else {
+                d.out_beat = q.out_beat + 1;
+            }
+        }
+        d.rd_vld = rd_en;
+        if (pop) {
+            d.ob_data0 = q.ob_data1;
+            d.ob_last0 = q.ob_last1;
+        }
+        if (q.rd_vld) {
+            if (q.ob_cnt - pop == 0) {
+                d.ob_data0 = rob_q_was;
+                d.ob_last0 = q.rd_last;
+            } else {
+                d.ob_data1 = rob_q_was;
+                d.ob_last1 = q.rd_last;
+            }
+        }
+        d.ob_cnt = (q.ob_cnt - pop + q.rd_vld) & 3;
+        if (pop && q.ob_last0) d.bursts_streamed = q.bursts_streamed + 1;
+
+        switch (q.state_read) {
+        case IDLE:
+        case DONE:
+            if (init_pulse) {
+                d.state_read = RUN;
+                d.error = false;
+                d.axi_araddr = 0;
+                d.issue_slot = 0;
+                d.slots_used = 0;
+                d.bursts_issued = 0;
+                d.bursts_streamed = 0;
+                d.out_slot = 0;
+                d.out_beat = 0;
+                for (unsigned i = 0; i < NUM_IDS; i++) {
+                    rx_slot_d[i] = i;
+                    rx_beat_d[i] = 0;
+                }
+                for (unsigned i = 0; i < SLOTS; i++) fill_d[i] = 0;
+            }
+            break;
+        case RUN:
+            if (rx_err) {
+                d.error = true;
+                d.state_read = FLUSH;
+            } else if (C_M_TXN_BURSTS != 0 && q.bursts_streamed == C_M_TXN_BURSTS) {
+                d.state_read = DONE;
+            }
+            break;
+        case FLUSH:
+            if (!q.axi_arvalid_reg && q.pending == 0 && !q.rd_vld && q.ob_cnt == 0) d.state_read = IDLE;
+            break;
+        }
+
+        r = d;
+        rx_slot = rx_slot_d;
+        rx_beat = rx_beat_d;
+        fill = fill_d;
+    }
+
+    void outputs()
+    {
+        M_AXI_ARID = (mirror_port_t<C_M_AXI_ID_WIDTH>)(r.issue_slot & mask(ID_W));
+        M_AXI_ARADDR = C_M_TARGET_SLAVE_BASE_ADDR + r.axi_araddr;
+        M_AXI_ARVALID = r.axi_arvalid_reg;
+        M_AXI_RREADY = r.pending != 0;
+        M_AXIS_TDATA = r.ob_data0;
+        M_AXIS_TLAST = r.ob_last0;
+        M_AXIS_TVALID = r.ob_cnt != 0;
+        TXN_DONE = r.state_read == DONE;
+        ERROR = r.error;
+    }
+
+    bool aclk = false;
+    regs r;
+    std::vector<unsigned> rx_slot, rx_beat, fill;   // per ID, per ID, per slot
+    std::vector<data_t> rob;
+    data_t rob_q{};
+};
+
+#endif /* WRAPPER_MIRROR_H */
@@ -0,0 +1,231 @@
+/* wrapper_bench.cpp
+ * Throughput of accelector_wrapper against axi_mem_model, for every data
+ * width and burst length built into this bench (see CMakeLists.txt) and a
+ * set of memory and stream-sink behaviours.
+ *
+ *   wrapper_bench [cycles] [profile]
+ *
+ * Built with BENCH_MIRROR, the models are the C++ mirror in mirror/ and the
+ * table says so on its first line.
+ *
+ * INIT_AXI_TXN is held high so the wrapper reads back to back, and the bench
+ * is the stream sink: TREADY is high except for the profile's share of
+ * random stall cycles.  When ERROR rises the bench resets the wrapper and the
+ * memory and carries on, or, for a profile that recovers by INIT, drops
+ * INIT_AXI_TXN, waits for the wrapper to drain (ARVALID, RREADY and TVALID
+ * low, nothing outstanding at the memory) and raises it again; ERROR has to
+ * clear within REARM_CYCLES, which only happens from IDLE.  A wrapper that
+ * never drains, or where nothing moves on any channel for WATCHDOG cycles, is
+ * reset and counted as a watchdog.  Every stream beat is checked against the
+ * memory contents at the next address (lane 0) and TLAST against the burst
+ * length.  Per run it reports stream beats per cycle, the idle cycles between
+ * one burst's RLAST and the next burst's first beat on the read channel, and
+ * the stall, reorder, early RLAST, error and protocol counts from both sides.
+ */
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+
+#include "verilated.h"
+
+#include "axi_mem_model.h"
+#include "bench_models.h"
+
+static const unsigned WATCHDOG = 1024;
+static const unsigned RESET_CYCLES = 4;
+static const unsigned REARM_CYCLES = 8;
+
+struct profile {
+    const char *name;
+    axi_mem_config cfg;
+    double tready_low;                  // share of cycles the stream sink stalls
+    bool rearm = false;                 // recover from ERROR with a new INIT_AXI_TXN edge, not a reset
+};
+
+static const profile PROFILES[] = {
+    { "ideal", { 0, 1, 4, 0, 1, 0.0, 0.0, 1 }, 0.0 },
+    { "ar-latency-3", { 3, 1, 4, 0, 1, 0.0, 0.0, 1 }, 0.0 },
+    { "r-latency-8", { 0, 8, 4, 0, 1, 0.0, 0.0, 1 }, 0.0 },
+    { "gap-every-16", { 0, 1, 4, 16, 1, 0.0, 0.0, 1 }, 0.0 },
+    { "random-gaps-5%", { 0, 1, 4, 0, 1, 0.05, 0.0, 1 }, 0.0 },
+    { "reorder-ids", { 0, 4, 4, 0, 1, 0.0, 0.5, 1 }, 0.0 },
+    { "sink-stall-10%", { 0, 1, 4, 0, 1, 0.0, 0.0, 1 }, 0.10 },
+    { "ddr-like", { 2, 12, 2, 64, 4, 0.02, 0.0, 1 }, 0.0 },
+    { "early-rlast", { 0, 4, 4, 0, 1, 0.0, 0.5, 1, 64 }, 0.05, true },
+};
+
+/* RDATA of any width from the model's 64-bit words */
+template <typename T> static void put_rdata(T &port, const axi_mem_model &m) { port = (T)m.rword(0); }
+
+template <std::size_t N> static void put_rdata(VlWide<N> &port, const axi_mem_model &m)
+{
+    for (std::size_t i = 0; i < N; i++) port[i] = (uint32_t)(m.rword((unsigned)(i / 2)) >> (32 * (i % 2)));
+}
+
+/* Lane 0 of TDATA, for the data check */
+template <typename T> static unsigned lane0(const T &port) { return (unsigned)((uint64_t)port & 0xffff); }
+
+template <std::size_t N> static unsigned lane0(const VlWide<N> &port) { return port[0] & 0xffff; }
+
+static void accumulate(axi_mem_stats &to, const axi_mem_stats &s)
+{
+    to.cycles += s.cycles;
+    to.ar += s.ar;
+    to.beats += s.beats;
+    to.bursts += s.bursts;
+    to.early_rlast += s.early_rlast;
+    to.reordered += s.reordered;
+    to.r_stall += s.r_stall;
+    to.r_starve += s.r_starve;
+    to.addr_errors += s.addr_errors;
+    to.protocol_errors += s.protocol_errors;
+}
+
+struct run_result {
+    uint64_t cycles = 0, beats = 0, bursts = 0;
+    uint64_t gaps = 0, gap_cycles = 0, gap_max = 0;
+    uint64_t errors = 0, watchdogs = 0, data_errors = 0;
+    axi_mem_stats mem;                  // summed over the memories of every recovery
+};
+
+template <typename M>
+static run_result run(unsigned width, unsigned len, const profile &p, uint64_t cycles)
+{
+    const axi_mem_config &cfg = p.cfg;
+    VerilatedContext ctx;
+    M top(&ctx, "accelector_wrapper");
+    std::unique_ptr<axi_mem_model> mem(new axi_mem_model(cfg, width / 8));
+    run_result r;
+
+    enum { RUNNING, DRAINING, REARMED } phase = RUNNING;
+    unsigned in_reset = RESET_CYCLES, quiet = 0, rearm_left = 0;
+    uint64_t last_rlast = 0, expect = 0, rng = cfg.seed * 2 + 1;
+    bool have_rlast = false, was_error = false;
+
+    top.M_AXI_ACLK = 0;
+    top.M_AXI_RRESP = 0;
+    top.M_AXI_RUSER = 0;
+    for (uint64_t c = 0; c < cycles; c++) {
+        rng = rng * 6364136223846793005ULL + 1442695040888963407ULL;
+        top.M_AXI_ARESETN = in_reset ? 0 : 1;
+        top.INIT_AXI_TXN = in_reset || phase == DRAINING ? 0 : 1;
+        top.M_AXI_ARREADY = mem->arready();
+        top.M_AXI_RVALID = mem->rvalid();
+        top.M_AXI_RLAST = mem->rlast();
+        top.M_AXI_RID = mem->rid();
+        put_rdata(top.M_AXI_RDATA, *mem);
+        top.M_AXIS_TREADY = (double)(rng >> 11) * 0x1.0p-53 >= p.tready_low;
+
+        top.M_AXI_ACLK = 0;
+        top.eval();
+        const bool arvalid = top.M_AXI_ARVALID, rready = top.M_AXI_RREADY;
+        const uint64_t araddr = top.M_AXI_ARADDR;
+        const unsigned arid = top.M_AXI_ARID, arlen = top.M_AXI_ARLEN, arsize = top.M_AXI_ARSIZE,
+                       arburst = top.M_AXI_ARBURST;
+        const bool ar_fire = arvalid && mem->arready(), r_fire = rready && mem->rvalid();
+        const bool first_beat = r_fire && have_rlast, last_beat = r_fire && mem->rlast();
+        const bool t_fire = top.M_AXIS_TVALID && top.M_AXIS_TREADY;
+        const unsigned tdata = lane0(top.M_AXIS_TDATA);
+        const bool tlast = top.M_AXIS_TLAST;
+
+        top.M_AXI_ACLK = 1;
+        top.eval();
+        ctx.timeInc(1);
+        mem->clock(arvalid, arid, araddr, arlen, arsize, arburst, rready);
+
+        if (in_reset) {
+            in_reset--;
+            continue;
+        }
+        if (t_fire) {
+            /* The wrapper starts from address 0 after every reset */
+            if (tdata != ((expect * width / 16) & 0xffff) || tlast != (expect % len == len - 1)) r.data_errors++;
+            expect++;
+            r.beats++;
+        }
+        if (first_beat) {
+            uint64_t gap = c - last_rlast - 1;
+            r.gaps++;
+            r.gap_cycles += gap;
+            r.gap_max = std::max(r.gap_max, gap);
+            have_rlast = false;
+        }
+        if (last_beat) {
+            last_rlast = c;
+            have_rlast = true;
+        }
+
+        const bool error = top.ERROR, rising = error && !was_error;
+        bool hung = false;
+        quiet = (ar_fire || r_fire || t_fire) ? 0 : quiet + 1;
+        if (rising) r.errors++;
+        if (rising && p.rearm) {
+            phase = DRAINING;
+        } else if (phase == DRAINING && !top.M_AXI_ARVALID && !top.M_AXI_RREADY && !top.M_AXIS_TVALID &&
+                   !mem->outstanding()) {
+            /* Drained: the next INIT_AXI_TXN edge starts over from address 0 */
+            phase = REARMED;
+            rearm_left = REARM_CYCLES;
+            mem->restart();
+            expect = 0;
+            have_rlast = false;
+        } else if (phase == REARMED) {
+            if (!error) phase = RUNNING;
+            else hung = --rearm_left == 0;
+        }
+        if ((rising && !p.rearm) || hung || quiet >= WATCHDOG) {
+            if (hung || quiet >= WATCHDOG) r.watchdogs++;
+            accumulate(r.mem, mem->stats());
+            mem.reset(new axi_mem_model(cfg, width / 8));
+            phase = RUNNING;
+            in_reset = RESET_CYCLES;
+            quiet = 0;
+            expect = 0;
+            have_rlast = false;
+        }
+        was_error = error;
+    }
+    top.final();
+
+    accumulate(r.mem, mem->stats());
+    r.cycles = cycles;
+    r.bursts = r.mem.bursts;
+    return r;
+}
+
+template <typename M> static void run_model(unsigned width, unsigned len, uint64_t cycles, const char *only)
+{
+    for (const profile &p : PROFILES) {
+        if (only && std::strcmp(only, p.name)) continue;
+        run_result r = run<M>(width, len, p, cycles);
+        std::printf("%5u %4u  %-15s %6.3f %8llu %8.1f %6llu %8llu %8llu %6llu %6llu %6llu %5llu %5llu %5llu %5llu\n",
+                    width, len, p.name, (double)r.beats / (double)r.cycles, (unsigned long long)r.bursts,
+                    r.gaps ? (double)r.gap_cycles / (double)r.gaps : 0.0, (unsigned long long)r.gap_max,
+                    (unsigned long long)r.mem.r_starve, (unsigned long long)r.mem.r_stall,
+                    (unsigned long long)r.mem.reordered, (unsigned long long)r.mem.early_rlast, (unsigned long long)r.errors,
+                    (unsigned long long)r.watchdogs, (unsigned long long)r.data_errors,
+                    (unsigned long long)r.mem.addr_errors, (unsigned long long)r.mem.protocol_errors);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    uint64_t cycles = (argc > 1) ? std::strtoull(argv[1], nullptr, 0) : 200000;
+    const char *only = (argc > 2) ? argv[2] : nullptr;
+    Verilated::commandArgs(1, argv);
+
+#ifdef BENCH_MIRROR
+    std::printf("# models: the C++ mirror of accelector_wrapper.v in mirror/, not the Verilated RTL\n");
+#endif
+
+    std::printf("%5s %4s  %-15s %6s %8s %8s %6s %8s %8s %6s %6s %6s %5s %5s %5s %5s\n", "width", "len",
+                "profile", "beat/c", "bursts", "gap mean", "max", "starve", "stall", "reord", "early", "error", "wdog",
+                "data", "addr", "proto");
+#define RUN_MODEL(w, l) run_model<Vwrap_w##w##_l##l>(w, l, cycles, only);
+    BENCH_MODELS(RUN_MODEL)
+#undef RUN_MODEL
+    return 0;
+}
@@ -1,5 +1,18 @@
 `timescale 1ns/1ps
+/*
+Testbench for accelector_wrapper
 
+Reset is held for the first few cycles and then released for good; with
+M_AXI_ARESETN low the wrapper does nothing.  INIT_AXI_TXN is tied high, so
+the first cycle out of reset starts a continuous transaction.
+
+The slave takes up to AR_DEPTH read requests and answers them in order, one
+beat per cycle, with RID = ARID and RLAST on beat ARLEN; beat b of every
+burst is mem[b].  The stream is checked against the same memory, with TLAST
+on the last beat of every burst, and the run ends after TB_BURSTS bursts.
+The DUT gets the parameters below, so the IDs it issues (slot % NUM_IDS)
+are the ones the slave echoes.
+*/
 module tb ();
 
     logic m_axi_aclk, m_axi_arestn;
@@ -17,11 +30,15 @@ module tb ();
         m_axi_aclk <= 1'b0;
         m_axi_arestn = 1'b0;
         #15;
+        repeat (4) @(posedge m_axi_aclk);
+        m_axi_arestn <= 1'b1;
     end
 
     //DUT spec section
     // Burst length (beats per burst)
     parameter integer C_M_AXI_BURST_LEN   = 256;
+    // Bursts in flight
+    parameter integer C_M_MAX_OUTSTANDING = 4;
     // Widths
     parameter integer C_M_AXI_ID_WIDTH    = 1;
     parameter integer C_M_AXI_ADDR_WIDTH  = 32;
@@ -31,7 +48,7 @@ module tb ();
     parameter integer C_M_AXI_RUSER_WIDTH  = 0;
 
     //input logics
-    logic init_txn, axi_arready;
+    logic init_txn, axi_arready, m_axis_tready;
     logic [C_M_AXI_ID_WIDTH - 1: 0] axi_rid;
     logic [C_M_AXI_DATA_WIDTH - 1: 0] axi_rdata;
     rresp_state axi_rresp;
@@ -53,9 +70,10 @@ module tb ();
     logic [C_M_AXI_ARUSER_WIDTH-1:0] M_AXI_ARUSER;
     logic                          M_AXI_ARVALID;
     logic                          axi_rready;
+    logic [C_M_AXI_DATA_WIDTH-1:0] m_axis_tdata;
+    logic                          m_axis_tlast, m_axis_tvalid;
 
     int i;
-    logic [31:0] read_index;
     logic [C_M_AXI_DATA_WIDTH - 1:0] mem [0: C_M_AXI_BURST_LEN - 1];
     initial
     begin : assign_mem
@@ -63,30 +81,107 @@ module tb ();
         begin
             mem[i] = 16'hbeef - i;
         end
-        read_index = 0;
     end
 
     //assign input value
     assign init_txn = 1'b1;
-    assign axi_rlast = (read_index == C_M_AXI_BURST_LEN - 1);
     assign axi_rresp = OKAY;
-    assign axi_arready = 1'b1;
     assign axi_ruser = 'b1;
-    assign axi_rvalid = 1'b1;
-    assign axi_rid = 'b0;
+    assign m_axis_tready = 1'b1;
+
+    //Slave: queue of accepted read requests, answered in order
+    localparam integer AR_DEPTH = 8;
+    logic [C_M_AXI_ID_WIDTH - 1:0] ar_id [0: AR_DEPTH - 1];
+    logic [7:0] ar_len [0: AR_DEPTH - 1];
+    logic [3:0] ar_wr, ar_rd;           //one bit more than the index, to tell full from empty
+    logic [7:0] beat;                   //beat of the burst at the head of the queue
+
+    assign axi_arready = ((ar_wr - ar_rd) != AR_DEPTH);
+    assign axi_rvalid  = (ar_wr != ar_rd);
+    assign axi_rid     = ar_id[ar_rd[2:0]];
+    assign axi_rlast   = (beat == ar_len[ar_rd[2:0]]);
+    assign axi_rdata   = mem[beat];
 
     always @ (posedge m_axi_aclk)
     begin
-        if (axi_rready)
+        if (!m_axi_arestn)
+        begin
+            ar_wr <= 0;
+            ar_rd <= 0;
+            beat <= 0;
+        end
+        else
         begin
-            axi_rdata <= mem[read_index];
-            read_index <= read_index + 1;
-            if (axi_rlast)
-                read_index <= 0;
+            if (M_AXI_ARVALID && axi_arready)
+            begin
+                ar_id[ar_wr[2:0]] <= M_AXI_ARID;
+                ar_len[ar_wr[2:0]] <= M_AXI_ARLEN;
+                ar_wr <= ar_wr + 1;
+            end
+            if (axi_rvalid && axi_rready)
+            begin
+                if (axi_rlast)
+                begin
+                    beat <= 0;
+                    ar_rd <= ar_rd + 1;
+                end
+                else
+                    beat <= beat + 1;
+            end
         end
     end
 
-    accelector_wrapper DUT (
+    //Stream check: data in burst order, TLAST on every burst's last beat, no ERROR
+    localparam integer TB_BURSTS = 64;
+    int out_beat, bursts, errors;
+
+    always @ (posedge m_axi_aclk)
+    begin
+        if (!m_axi_arestn)
+        begin
+            out_beat <= 0;
+            bursts <= 0;
+            errors <= 0;
+        end
+        else
+        begin
+            if (error)
+            begin
+                $error("ERROR raised after %0d bursts", bursts);
+                errors <= errors + 1;
+            end
+            if (m_axis_tvalid && m_axis_tready)
+            begin
+                if (m_axis_tdata !== mem[out_beat] || m_axis_tlast !== (out_beat == C_M_AXI_BURST_LEN - 1))
+                begin
+                    $error("burst %0d beat %0d: data %h last %b", bursts, out_beat, m_axis_tdata, m_axis_tlast);
+                    errors <= errors + 1;
+                end
+                if (out_beat == C_M_AXI_BURST_LEN - 1)
+                begin
+                    out_beat <= 0;
+                    bursts <= bursts + 1;
+                end
+                else
+                    out_beat <= out_beat + 1;
+            end
+            if (bursts == TB_BURSTS)
+            begin
+                $display("tb: %0d bursts streamed, %0d errors", bursts, errors);
+                $finish;
+            end
+        end
+    end
+
+    accelector_wrapper #(
+    .C_M_AXI_BURST_LEN    (C_M_AXI_BURST_LEN),
+    .C_M_MAX_OUTSTANDING  (C_M_MAX_OUTSTANDING),
+    .C_M_AXI_ID_WIDTH     (C_M_AXI_ID_WIDTH),
+    .C_M_AXI_ADDR_WIDTH   (C_M_AXI_ADDR_WIDTH),
+    .C_M_AXI_DATA_WIDTH   (C_M_AXI_DATA_WIDTH),
+    .C_M_AXI_ARUSER_WIDTH (C_M_AXI_ARUSER_WIDTH),
+    .C_M_AXI_RUSER_WIDTH  (C_M_AXI_RUSER_WIDTH)
+    ) DUT (
     .INIT_AXI_TXN    (init_txn),
     .TXN_DONE        (txn_done),
     .ERROR           (error),
@@ -115,6 +210,12 @@ module tb ();
     .M_AXI_RLAST     (axi_rlast),
     .M_AXI_RUSER     (axi_ruser),
     .M_AXI_RVALID    (axi_rvalid),
-    .M_AXI_RREADY    (axi_rready)
+    .M_AXI_RREADY    (axi_rready),
+
+    // AXI4-Stream output
+    .M_AXIS_TDATA    (m_axis_tdata),
+    .M_AXIS_TLAST    (m_axis_tlast),
+    .M_AXIS_TVALID   (m_axis_tvalid),
+    .M_AXIS_TREADY   (m_axis_tready)
     );
 endmodule
\ No newline at end of file
@@ -0,0 +1,181 @@
+"""
+Real-time capture viewer, decoupled from acquisition through capture_ring.py
+
+Runs as its own process: at most VIEW_FPS times a second it takes the newest
+capture from the ring (older ones are skipped, never queued) and redraws
+only the data artists over a cached background (blitting).  Axes are
+rescaled, with a full redraw, only when the data leaves the current limits
+or shrinks well inside them, so a steady signal costs one blit per frame.
+
+Layout matches the old per-capture figure: time, spectrum and histogram
+for channels A and B.  The spectrum is one-sided in dBFS.
+
+    python adc_viewer.py /dev/shm/tiadc_ring_<pid>    # attach to a running ring
+
+Author : Jingling Hou
+"""
+
+import argparse
+import multiprocessing
+import time
+
+import matplotlib.pyplot as pyplt
+import numpy
+
+from capture_file import unpack_delay
+from capture_ring import CaptureRing
+
+## Start of User parameters
+VIEW_FPS = 15  # Upper bound on redraws per second
+ADC_CLK_HZ = 500000000  # --> ADC_SAMPLE_CLK_KHZ in main.c
+FULL_SCALE = 32768  # int16 samples
+HIST_BINS = 64
+SPECTRUM_FLOOR_DB = -120
+PLOT_FILE = "adc_sample.png"  # Last frame is saved here when the viewer exits
+
+
+class CaptureView:
+    """
+    The 3x2 figure and its animated artists
+    """
+
+    def __init__(self, ring: CaptureRing):
+        self.ring = ring
+        self.channels = (0, ring.M // 2) if ring.M > 1 else (0,)  # converter of channel A, of channel B
+        n = ring.samples
+        self.window = numpy.hanning(n)
+        self.freq_mhz = numpy.fft.rfftfreq(n, d=ring.dcm / ADC_CLK_HZ) / 1e6
+        self.bin_edges = numpy.linspace(-FULL_SCALE, FULL_SCALE, HIST_BINS + 1)
+
+        self.figure, axes = pyplt.subplots(3, 2)
+        self.time_lines, self.fft_lines, self.hist_bars = [], [], []
+        for col, name in enumerate("AB"):
+            ax_t, ax_f, ax_h = axes[0, col], axes[1, col], axes[2, col]
+            self.time_lines.append(ax_t.plot(numpy.arange(n), numpy.zeros(n), animated=True)[0])
+            ax_t.set_title(f"ADC Sample Plot (Channel {name})")
+            ax_t.set_xlabel("ADC Sample Index")
+            ax_t.set_ylabel("Digital Amplitude")
+            ax_t.set_xlim(0, n - 1)
+            ax_t.set_ylim(-FULL_SCALE, FULL_SCALE)
+
+            self.fft_lines.append(ax_f.plot(self.freq_mhz, numpy.full(len(self.freq_mhz), SPECTRUM_FLOOR_DB),
+                                            animated=True)[0])
+            ax_f.set_title(f"Spectrum (Channel {name})")
+            ax_f.set_xlabel("Frequency (MHz)")
+            ax_f.set_ylabel("dBFS")
+            ax_f.set_xlim(0, self.freq_mhz[-1])
+            ax_f.set_ylim(SPECTRUM_FLOOR_DB, 0)
+
+            self.hist_bars.append(ax_h.bar(self.bin_edges[:-1], numpy.zeros(HIST_BINS), align="edge",
+                                           width=numpy.diff(self.bin_edges), animated=True))
+            ax_h.set_title(f"ADC Sample Distribution (Channel {name})")
+            ax_h.set_xlim(-FULL_SCALE, FULL_SCALE)
+            ax_h.set_ylim(0, 1)
+        self.time_axes = [axes[0, 0], axes[0, 1]]
+        self.hist_axes = [axes[2, 0], axes[2, 1]]
+        self.status = self.figure.text(0.01, 0.005, "waiting for captures", fontsize=8, animated=True)
+        self.artists = self.time_lines + self.fft_lines + [r for bars in self.hist_bars for r in bars] + [self.status]
+
+        pyplt.tight_layout(rect=(0, 0.03, 1, 1))
+        self.background = None
+        self.figure.canvas.mpl_connect("draw_event", self._on_draw)
+
+    def _on_draw(self, _event):
+        """
+        Full redraw (first show, resize, rescale): recache the background
+        """
+        canvas = self.figure.canvas
+        self.background = canvas.copy_from_bbox(self.figure.bbox)
+        for artist in self.artists:
+            self.figure.draw_artist(artist)
+
+    @staticmethod
+    def _rescale(ax, lo: float, hi: float) -> bool:
+        """
+        Move the y limits only when [lo, hi] leaves them or uses under a quarter of them
+        :return: True when the limits changed (full redraw needed)
+        """
+        cur_lo, cur_hi = ax.get_ylim()
+        span = max(hi - lo, 1.0)
+        if lo >= cur_lo and hi <= cur_hi and span * 4 >= cur_hi - cur_lo:
+            return False
+        ax.set_ylim(lo - span * 0.1, hi + span * 0.1)
+        return True
+
+    def update(self, number: int, t_ns: int, delay: int, converters: numpy.ndarray):
+        rescaled = False
+        for i, c in enumerate(self.channels):
+            x = converters[c].astype(numpy.float64)
+            if (self.ring.invert_mask >> c) & 1:
+                x = -x
+            self.time_lines[i].set_ydata(x)
+            rescaled |= self._rescale(self.time_axes[i], x.min(), x.max())
+
+            spectrum = numpy.abs(numpy.fft.rfft((x - x.mean()) * self.window)) / (self.window.sum() / 2)
+            self.fft_lines[i].set_ydata(20 * numpy.log10(numpy.maximum(spectrum / FULL_SCALE, 1e-12)))
+
+            counts, _ = numpy.histogram(x, bins=self.bin_edges)
+            frac = counts / max(1, len(x))
+            for rect, h in zip(self.hist_bars[i], frac):
+                rect.set_height(h)
+            ax_h = self.hist_axes[i]
+            if frac.max() > ax_h.get_ylim()[1] or frac.max() * 4 < ax_h.get_ylim()[1]:
+                ax_h.set_ylim(0, min(1.0, frac.max() * 1.5 + 1e-3))
+                rescaled = True
+
+        mode, fine, super_fine, channel = unpack_delay(delay)
+        self.status.set_text(f"capture #{number}  {time.strftime('%H:%M:%S', time.localtime(t_ns / 1e9))}  "
+                             f"delay mode {mode} fine {fine} super fine {super_fine} channel {channel}")
+
+        canvas = self.figure.canvas
+        if rescaled or self.background is None:
+            canvas.draw_idle()  # _on_draw re-blits the artists
+            return
+        canvas.restore_region(self.background)
+        for artist in self.artists:
+            self.figure.draw_artist(artist)
+        canvas.blit(self.figure.bbox)
+
+
+def run_viewer(ring_path: str, fps: float = VIEW_FPS, plot_file: str = PLOT_FILE):
+    """
+    Viewer loop; returns when the window is closed or the ring owner closes the ring
+    """
+    ring = CaptureRing.attach(ring_path)
+    view = CaptureView(ring)
+    pyplt.show(block=False)
+    canvas = view.figure.canvas
+    period = 1.0 / fps
+    last = -1
+    try:
+        while pyplt.fignum_exists(view.figure.number) and not ring.closed:
+            t0 = time.perf_counter()
+            newest = ring.latest(last)
+            if newest is not None:
+                last = newest[0]
+                view.update(*newest)
+            # service GUI events for the rest of the frame without a full redraw
+            canvas.start_event_loop(max(0.001, period - (time.perf_counter() - t0)))
+    finally:
+        if pyplt.fignum_exists(view.figure.number) and last >= 0:
+            for artist in view.artists:
+                artist.set_animated(False)  # savefig skips animated artists
+            view.figure.savefig(plot_file)
+        ring.close()
+
+
+def start_viewer(ring: CaptureRing, fps: float = VIEW_FPS) -> multiprocessing.Process:
+    """
+    Start the viewer in its own process, so rendering never holds up acquisition
+    """
+    proc = multiprocessing.Process(target=run_viewer, args=(ring.path, fps), daemon=True)
+    proc.start()
+    return proc
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Attach a viewer to a capture ring")
+    parser.add_argument("ring", help="ring file, printed by the acquisition script")
+    parser.add_argument("--fps", type=float, default=VIEW_FPS)
+    args = parser.parse_args()
+    run_viewer(args.ring, args.fps)
@@ -0,0 +1,323 @@
+"""
+Chunked binary capture container (.tcap), replacing the adc_sample16bit.txt hex dumps
+
+File layout (all little-endian):
+    header   HEADER_BYTES, fixed: sample rate, JESD mode, channel layout,
+             clock delay settings, creation time, chunk count, index offset
+    payload  chunks back to back from HEADER_BYTES; a chunk is one capture
+             as int16, planar: M converters x <samples> each
+    index    chunk_count entries <offset, seq, t_ns, samples, delay>,
+             appended on close
+
+The payload starts page aligned and is never reformatted, so it maps straight
+into numpy (CaptureReader.uniform() -> shape (chunks, M, samples)) or C++
+(udp_rx/capture_file.h).  A file that was never closed has no index; the
+reader rebuilds it from the fixed chunk size in the header.
+
+    python capture_file.py info adc_capture.tcap
+    python capture_file.py convert adc_sample16bit.txt adc_sample16bit.tcap
+    python capture_file.py check                    # writer/reader self-check, incl. crash recovery
+
+Author : Jingling Hou
+"""
+
+import argparse
+import mmap
+import os
+import struct
+import time
+
+import numpy
+
+from jesd_modes import JESD_MODES, DEFAULT_MODE_ID, JesdMode
+
+## Start of User parameters
+ADC_CLK_HZ = 500000000  # --> ADC_SAMPLE_CLK_KHZ in main.c
+INVERT_MASK = 0x1  # Converters whose sign is flipped at the source (channel A, see the capture script)
+WRITE_BUFFER_BYTES = 4 << 20  # Userspace write buffer for streaming appends
+
+MAGIC = b"TIADCCAP"
+VERSION = 1
+HEADER_BYTES = 4096
+HEADER_FORMAT = "<8sIIQQQH6B8s8sB4B3xI4xQQQ256s"  # --> struct tcap_header in udp_rx/capture_file.h
+INDEX_FORMAT = "<QQQII"  # offset, seq, t_ns, samples, delay --> struct tcap_index_entry
+INDEX_DTYPE = numpy.dtype([("offset", "<u8"), ("seq", "<u8"), ("t_ns", "<u8"), ("samples", "<u4"), ("delay", "<u4")])
+NO_DELAY = (0, 0, 0, 3)  # delay mode, fine, super fine, channel index
+
+
+def pack_delay(delay) -> int:
+    """
+    (mode, fine, super fine, channel index) -> one u32, as stored per chunk
+    """
+    mode, fine, super_fine, channel = delay
+    return (mode & 0xFF) << 24 | (channel & 0xFF) << 16 | (fine & 0xFF) << 8 | (super_fine & 0xFF)
+
+
+def unpack_delay(word: int) -> tuple:
+    return (word >> 24) & 0xFF, (word >> 8) & 0xFF, word & 0xFF, (word >> 16) & 0xFF
+
+
+def channel_layout(mode: JesdMode) -> tuple:
+    """
+    Converter -> (ADC channel, kind) as bytes: first half of the converters is
+    channel A, kind R(eal) or I/Q for complex DDC outputs
+    """
+    channels = bytes(ord("A") if c < max(1, mode.M // 2) else ord("B") for c in range(mode.M))
+    kinds = bytes(b"IQ"[c & 1] if mode.complex else ord("R") for c in range(mode.M))
+    return channels, kinds
+
+
+class CaptureWriter:
+    """
+    Streaming writer: one append() per capture, index and counts on close()
+    """
+
+    def __init__(self, path: str, mode: JesdMode = JESD_MODES[DEFAULT_MODE_ID], delay=NO_DELAY,
+                 samples_per_chunk: int = None, note: str = "", invert_mask: int = INVERT_MASK,
+                 adc_clk_hz: int = ADC_CLK_HZ):
+        self.mode = mode
+        self.delay = delay
+        self.samples_per_chunk = samples_per_chunk or 0  # fixed by the first chunk when not given
+        self.entries = []
+        self.offset = HEADER_BYTES
+        self.header = dict(create_ns=time.time_ns(), sample_rate_hz=adc_clk_hz // mode.dcm, adc_clk_hz=adc_clk_hz,
+                           mode_id=JESD_MODES.index(mode), invert_mask=invert_mask, note=note)
+        self.file = open(path, "wb", buffering=WRITE_BUFFER_BYTES)
+        self.file.write(self._header_bytes(0, 0))
+
+    def _header_bytes(self, chunk_count: int, index_offset: int) -> bytes:
+        channels, kinds = channel_layout(self.mode)
+        h = self.header
+        raw = struct.pack(HEADER_FORMAT, MAGIC, VERSION, HEADER_BYTES, h["create_ns"], h["sample_rate_hz"],
+                          h["adc_clk_hz"], h["mode_id"], self.mode.L, self.mode.M, self.mode.NP, self.mode.dcm,
+                          self.mode.num_ddc, int(self.mode.complex), channels, kinds, h["invert_mask"],
+                          self.delay[0], self.delay[1], self.delay[2], self.delay[3], self.samples_per_chunk,
+                          chunk_count, index_offset, HEADER_BYTES, h["note"].encode("utf-8")[:255])
+        return raw.ljust(HEADER_BYTES, b"\0")
+
+    def append(self, capture, seq: int = None, t_ns: int = None, delay=None):
+        """
+        Add one capture as a chunk
+        :param capture: raw capture bytes in the link layout, or an (M, samples) int16 array
+        :param delay: clock delay settings in force for this capture, default the file's
+        """
+        if isinstance(capture, numpy.ndarray) and capture.ndim == 2:
+            planar = numpy.ascontiguousarray(capture, dtype="<i2")
+        else:
+            planar = numpy.ascontiguousarray(self.mode.unpack(capture), dtype="<i2")
+        samples = planar.shape[1]
+        if not self.samples_per_chunk:
+            # on disk before any payload: a file that is never closed is recovered from it
+            self.samples_per_chunk = samples
+            self.file.seek(0)
+            self.file.write(self._header_bytes(0, 0))
+        self.file.write(memoryview(planar).cast("B"))
+        self.entries.append((self.offset, len(self.entries) if seq is None else seq,
+                             time.time_ns() if t_ns is None else t_ns, samples,
+                             pack_delay(self.delay if delay is None else delay)))
+        self.offset += planar.nbytes
+
+    def close(self):
+        if self.file.closed:
+            return
+        index_offset = self.offset
+        for entry in self.entries:
+            self.file.write(struct.pack(INDEX_FORMAT, *entry))
+        self.file.seek(0)
+        self.file.write(self._header_bytes(len(self.entries), index_offset))
+        self.file.close()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+
+
+class CaptureReader:
+    """
+    Memory-mapped reader; chunk views share the page cache, nothing is copied
+    """
+
+    def __init__(self, path: str):
+        self.file = open(path, "rb")
+        self.map = mmap.mmap(self.file.fileno(), 0, access=mmap.ACCESS_READ)
+        fields = struct.unpack_from(HEADER_FORMAT, self.map, 0)
+        if fields[0] != MAGIC:
+            raise ValueError(f"{path}: not a capture file")
+        if fields[1] != VERSION:
+            raise ValueError(f"{path}: capture format version {fields[1]}, expected {VERSION}")
+        (_, _, header_bytes, create_ns, sample_rate_hz, adc_clk_hz, mode_id, L, M, NP, dcm, num_ddc, cplx,
+         channels, kinds, invert_mask, d_mode, d_fine, d_super_fine, d_channel, samples_per_chunk,
+         chunk_count, index_offset, payload_offset, note) = fields
+        self.mode = JESD_MODES[mode_id] if mode_id < len(JESD_MODES) else JesdMode(L, M, NP, num_ddc, dcm, bool(cplx))
+        self.M = M
+        self.header = dict(create_ns=create_ns, sample_rate_hz=sample_rate_hz, adc_clk_hz=adc_clk_hz,
+                           mode_id=mode_id, channels=channels[:M].decode(), kinds=kinds[:M].decode(),
+                           invert_mask=invert_mask, delay=(d_mode, d_fine, d_super_fine, d_channel),
+                           samples_per_chunk=samples_per_chunk, note=note.rstrip(b"\0").decode("utf-8"))
+        self.payload_offset = payload_offset
+
+        if index_offset:
+            self.index = numpy.frombuffer(self.map, dtype=INDEX_DTYPE, count=chunk_count, offset=index_offset)
+        else:
+            # never closed: fixed-size chunks up to the last complete one
+            chunk_bytes = M * samples_per_chunk * 2
+            count = (len(self.map) - payload_offset) // chunk_bytes if chunk_bytes else 0
+            self.index = numpy.zeros(count, dtype=INDEX_DTYPE)
+            self.index["offset"] = payload_offset + numpy.arange(count, dtype="<u8") * chunk_bytes
+            self.index["seq"] = numpy.arange(count)
+            self.index["samples"] = samples_per_chunk
+            self.index["delay"] = pack_delay(self.header["delay"])
+
+    def __len__(self) -> int:
+        return len(self.index)
+
+    def chunk(self, i: int) -> numpy.ndarray:
+        """
+        :return: read-only int16 view of chunk i, shape (M, samples)
+        """
+        e = self.index[i]
+        return numpy.frombuffer(self.map, dtype="<i2", count=self.M * int(e["samples"]),
+                                offset=int(e["offset"])).reshape(self.M, -1)
+
+    def uniform(self) -> numpy.ndarray:
+        """
+        :return: view of the whole payload, shape (chunks, M, samples); needs equal chunk sizes
+        """
+        n = len(self.index)
+        if n and numpy.any(self.index["samples"] != self.index["samples"][0]):
+            raise ValueError("chunks differ in size, use chunk(i)")
+        samples = int(self.index["samples"][0]) if n else 0
+        return numpy.frombuffer(self.map, dtype="<i2", count=n * self.M * samples,
+                                offset=self.payload_offset).reshape(n, self.M, samples)
+
+    def converter(self, c: int, corrected: bool = True) -> numpy.ndarray:
+        """
+        :return: all samples of converter c, in capture order (copy); sign fixed per invert_mask
+        """
+        out = numpy.concatenate([self.chunk(i)[c] for i in range(len(self))]) if len(self) else numpy.zeros(0, "<i2")
+        if corrected and (self.header["invert_mask"] >> c) & 1:
+            out = -out
+        return out
+
+    def delay(self, i: int) -> tuple:
+        return unpack_delay(int(self.index[i]["delay"]))
+
+    def close(self):
+        """
+        Unmap the file; raises BufferError while chunk views are still alive
+        """
+        self.index = None
+        self.map.close()
+        self.file.close()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+
+
+def convert_legacy_hex(txt_path: str, out_path: str, mode: JesdMode = JESD_MODES[DEFAULT_MODE_ID]) -> int:
+    """
+    Convert a "#index : HHHH" dump (one 16-bit word per line, capture order) to a capture file
+    :return: number of words converted
+    """
+    words = []
+    with open(txt_path, "r", encoding="utf-8") as hex_file:
+        for line in hex_file:
+            if ":" in line:
+                words.append(int(line.split(":", 1)[1].strip(), 16))
+    raw = numpy.array(words, dtype="<u2").tobytes()
+    raw = raw[:len(raw) // mode.block_bytes * mode.block_bytes]
+    with CaptureWriter(out_path, mode, note=f"converted from {os.path.basename(txt_path)}") as writer:
+        writer.header["create_ns"] = int(os.path.getmtime(txt_path) * 1e9)
+        writer.append(raw, t_ns=writer.header["create_ns"])
+    return len(words)
+
+
+def print_info(path: str):
+    with CaptureReader(path) as reader:
+        h = reader.header
+        m = reader.mode
+        print(f"{path}: {len(reader)} chunks, JESD mode {h['mode_id']} (L={m.L} M={m.M} NP={m.NP}), "
+              f"{h['sample_rate_hz'] / 1e6:.3f} MSPS")
+        print(f"  converters {h['channels']} / {h['kinds']}, invert mask 0x{h['invert_mask']:x}, "
+              f"delay mode/fine/super fine/channel {h['delay']}")
+        print(f"  created {time.strftime('%Y-%m-%d %H:%M:%S', time.localtime(h['create_ns'] / 1e9))}"
+              f"{', ' + h['note'] if h['note'] else ''}")
+        if len(reader):
+            print(f"  {int(reader.index['samples'].sum())} samples per converter, "
+                  f"chunk 0: {reader.index['samples'][0]} samples, delay {reader.delay(0)}")
+
+
+def self_check(chunks: int = 20000, samples: int = 128, directory: str = None) -> bool:
+    """
+    Round-trip a closed file, then recover one whose writer process died without close()
+    :return: True when every chunk came back intact
+    """
+    import tempfile
+    mode = JESD_MODES[DEFAULT_MODE_ID]
+    base = numpy.arange(samples, dtype="<i2")
+
+    def write(path):
+        writer = CaptureWriter(path, mode, note="check")
+        for n in range(chunks):
+            writer.append(numpy.stack([base + n, base - n]).astype("<i2"), seq=n)
+        return writer
+
+    def intact(reader) -> int:
+        for n in range(len(reader)):
+            c = reader.chunk(n)
+            if c.shape != (2, samples) or numpy.any(c[0] != base + n) or numpy.any(c[1] != base - n):
+                return -1
+        return len(reader)
+
+    ok = True
+    with tempfile.TemporaryDirectory(dir=directory) as tmp:
+        closed, crashed = os.path.join(tmp, "closed.tcap"), os.path.join(tmp, "crashed.tcap")
+        write(closed).close()
+        with CaptureReader(closed) as reader:
+            n = intact(reader)
+        print(f"closed:  {n} of {chunks} chunks")
+        ok &= n == chunks
+
+        pid = os.fork()
+        if pid == 0:
+            try:
+                writer = write(crashed)  # still referenced, never closed; os._exit skips every finaliser
+                os._exit(0 if writer.entries else 1)
+            finally:
+                os._exit(1)
+        os.waitpid(pid, 0)
+        on_disk = (os.path.getsize(crashed) - HEADER_BYTES) // (2 * samples * 2)
+        with CaptureReader(crashed) as reader:
+            n = intact(reader)
+            spc = reader.header["samples_per_chunk"]
+        print(f"crashed: {n} chunks recovered of {on_disk} on disk, spc={spc}")
+        ok &= spc == samples and 0 < n == on_disk
+    print(f"capture_file: {'PASS' if ok else 'FAIL'}")
+    return ok
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Capture container tools")
+    sub = parser.add_subparsers(dest="cmd", required=True)
+    p_info = sub.add_parser("info", help="print header and chunk summary")
+    p_info.add_argument("path")
+    p_conv = sub.add_parser("convert", help="convert a legacy hex dump")
+    p_conv.add_argument("txt")
+    p_conv.add_argument("out")
+    p_conv.add_argument("--mode", type=int, default=DEFAULT_MODE_ID, help="JESD mode id (jesd -l)")
+    sub.add_parser("check", help="writer/reader self-check, including recovery of an unclosed file")
+    args = parser.parse_args()
+
+    if args.cmd == "info":
+        print_info(args.path)
+    elif args.cmd == "check":
+        raise SystemExit(0 if self_check() else 1)
+    else:
+        n = convert_legacy_hex(args.txt, args.out, JESD_MODES[args.mode])
+        print(f"{n} words -> {args.out}")
+        print_info(args.out)
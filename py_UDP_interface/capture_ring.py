@@ -0,0 +1,128 @@
+"""
+Shared-memory ring of recent captures, between the acquisition loop and the viewer
+
+One file-backed mmap (in /dev/shm where it exists) laid out as
+    header   <magic, version, slots, M, samples, dcm, invert_mask, closed, head u64>
+    meta     slots * <seq u64, t_ns u64, delay u32>
+    data     slots * M * samples int16 (per-converter, as JesdMode.unpack)
+
+The producer never waits: push() overwrites the oldest slot.  Each slot is
+guarded by its own sequence word (odd while being written), so a reader
+that loses the race to the producer just retries on the newest capture
+instead of taking a lock.
+
+Author : Jingling Hou
+"""
+
+import mmap
+import os
+import struct
+import tempfile
+import time
+
+import numpy
+
+## Start of User parameters
+RING_SLOTS = 16  # Captures kept; the viewer only ever shows the newest one
+RING_DIR = "/dev/shm" if os.path.isdir("/dev/shm") else tempfile.gettempdir()
+
+RING_MAGIC = 0x474E5254  # "TRNG"
+RING_VERSION = 1
+HEADER_FORMAT = "<IIIIIIIIQ"
+HEADER_BYTES = 64
+HEAD_OFFSET = struct.calcsize(HEADER_FORMAT) - 8
+CLOSED_OFFSET = HEAD_OFFSET - 4
+META_DTYPE = numpy.dtype([("seq", "<u8"), ("t_ns", "<u8"), ("delay", "<u4"), ("pad", "<u4")])
+
+
+class CaptureRing:
+    """
+    Use CaptureRing.create() in the acquisition process and CaptureRing.attach() in the viewer
+    """
+
+    def __init__(self, path: str, owner: bool):
+        self.path = path
+        self.owner = owner
+        self.file = open(path, "r+b")
+        self.map = mmap.mmap(self.file.fileno(), 0)
+        magic, version, self.slots, self.M, self.samples, self.dcm, self.invert_mask, _, _ = \
+            struct.unpack_from(HEADER_FORMAT, self.map, 0)
+        if magic != RING_MAGIC or version != RING_VERSION:
+            raise ValueError(f"{path}: not a capture ring")
+        self.head = numpy.frombuffer(self.map, dtype="<u8", count=1, offset=HEAD_OFFSET)
+        self.closed_flag = numpy.frombuffer(self.map, dtype="<u4", count=1, offset=CLOSED_OFFSET)
+        self.meta = numpy.frombuffer(self.map, dtype=META_DTYPE, count=self.slots, offset=HEADER_BYTES)
+        data_offset = HEADER_BYTES + (self.slots * META_DTYPE.itemsize + 63) // 64 * 64
+        self.data = numpy.frombuffer(self.map, dtype="<i2", count=self.slots * self.M * self.samples,
+                                     offset=data_offset).reshape(self.slots, self.M, self.samples)
+
+    @classmethod
+    def create(cls, M: int, samples: int, dcm: int = 1, invert_mask: int = 0, slots: int = RING_SLOTS):
+        """
+        Create a fresh ring sized for (M, samples) captures
+        """
+        path = os.path.join(RING_DIR, f"tiadc_ring_{os.getpid()}")
+        meta_bytes = (slots * META_DTYPE.itemsize + 63) // 64 * 64
+        with open(path, "wb") as ring_file:
+            ring_file.write(struct.pack(HEADER_FORMAT, RING_MAGIC, RING_VERSION, slots, M, samples, dcm,
+                                        invert_mask, 0, 0).ljust(HEADER_BYTES, b"\0"))
+            ring_file.truncate(HEADER_BYTES + meta_bytes + slots * M * samples * 2)
+        return cls(path, owner=True)
+
+    @classmethod
+    def attach(cls, path: str):
+        return cls(path, owner=False)
+
+    @property
+    def closed(self) -> bool:
+        return bool(self.closed_flag[0])
+
+    def push(self, converters: numpy.ndarray, t_ns: int = None, delay: int = 0):
+        """
+        Publish one capture, overwriting the oldest slot
+        :param converters: int16 array of shape (M, samples)
+        :param delay: packed delay tag, see capture_file.pack_delay
+        """
+        if converters.shape != (self.M, self.samples):
+            raise ValueError(f"capture shape {converters.shape}, ring holds {(self.M, self.samples)}")
+        n = int(self.head[0])
+        k = n % self.slots
+        self.meta["seq"][k] = 2 * n + 1
+        self.data[k] = converters
+        self.meta["t_ns"][k] = time.time_ns() if t_ns is None else t_ns
+        self.meta["delay"][k] = delay
+        self.meta["seq"][k] = 2 * n + 2
+        self.head[0] = n + 1
+
+    def latest(self, after: int = -1):
+        """
+        Copy out the newest capture
+        :param after: skip unless newer than this capture number
+        :return: (number, t_ns, delay, (M, samples) int16 copy) or None when nothing new
+        """
+        for _ in range(8):
+            n = int(self.head[0]) - 1
+            if n <= after:
+                return None
+            k = n % self.slots
+            if int(self.meta["seq"][k]) != 2 * n + 2:
+                continue  # already being overwritten
+            t_ns, delay = int(self.meta["t_ns"][k]), int(self.meta["delay"][k])
+            samples = self.data[k].copy()
+            if int(self.meta["seq"][k]) == 2 * n + 2:
+                return n, t_ns, delay, samples
+        return None
+
+    def close(self):
+        """
+        Owner: mark the ring closed (the viewer exits) and remove it
+        """
+        if self.map.closed:
+            return
+        if self.owner:
+            self.closed_flag[0] = 1
+        self.head = self.closed_flag = self.meta = self.data = None
+        self.map.close()
+        self.file.close()
+        if self.owner:
+            os.unlink(self.path)
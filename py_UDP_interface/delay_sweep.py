@@ -0,0 +1,366 @@
+"""
+Pipelined sweep over the AD9695 clock delay space (mode, fine, super fine, channel)
+
+Each point is one 6-byte sweep datagram (see ethernet.h): the board applies
+the delay, takes CAPTURES_PER_POINT fresh captures and sends them back, or
+sends nothing when the delay or the link did not come back valid.  Three
+stages overlap:
+    - the request for point N+1 goes out as soon as the first datagram of
+      point N arrives, so the board reconfigures while N is still streaming
+      and the host never idles between points
+    - point N streams in
+    - point N-1 is analysed on a worker thread
+Only one request is ever ahead of the data.  A point that never answers or
+arrives short is dropped; the host then discards everything until the board
+has been quiet for POINT_TIMEOUT_S and requests the next point afresh, so
+the tail of one point is never taken for the head of another.
+
+Points are ordered mode first (a mode change costs a link reset), then
+channel, then a serpentine over fine x super fine so consecutive points are
+one step apart.  --refine re-sweeps around the point with the smallest A/B
+skew at a quarter of the step, as often as asked.
+
+Skew, gain and their confidence bounds come from the native sine fit
+(mismatch.py, tiadc_dsp/) when it is built, else from a numpy cross
+spectrum without bounds.  Raw captures go to <out>.tcap (one chunk per
+point, delay tagged), results to <out>.npz as one array per column.
+
+    python delay_sweep.py --mode 4 --fine 0:192:8 --channel 2 --refine 2
+    python delay_sweep.py --simulate       # against a local fake board
+
+Author : Jingling Hou
+"""
+
+import argparse
+import concurrent.futures
+import socket
+import threading
+import time
+from typing import NamedTuple
+
+import numpy
+
+from capture_file import CaptureWriter, INVERT_MASK
+from jesd_modes import JESD_MODES, DEFAULT_MODE_ID
+
+try:
+    import mismatch  # native estimator, needs tiadc_dsp/ built
+except ImportError:
+    mismatch = None
+
+## Start of User parameters
+BOARD_IP = "192.168.1.10"  # Sender IP --> Configured in Vitis
+UDP_PORT = 5002  # Port --> Same as above
+PKT_MAX = 1024  # Max bytes per datagram --> UDP_CHUNK_MAX in ethernet.h
+JESD_MODE = JESD_MODES[DEFAULT_MODE_ID]  # --> "jesd -r" on the board
+CAPTURES_PER_POINT = 4  # Fresh captures per point, at most UDP_SWEEP_MAX_CAPTURES
+POINT_TIMEOUT_S = 0.5  # Longer than the worst reconf path (RECONF_SYNC_TIMEOUT_US) plus the captures
+SOCKET_RCVBUF_KB = 4096
+ADC_CLK_HZ = 500000000  # --> ADC_SAMPLE_CLK_KHZ in main.c
+FINE_STEP_PS = 1.725
+SUPER_FINE_STEP_PS = 0.25
+FINE_MAX = 192
+SUPER_FINE_MAX = 128
+UDP_CFG_CAPTURE = 0x01  # --> ethernet.h
+UDP_CFG_STAMP = 0x02  # --> ethernet.h
+OUT_PREFIX = time.strftime("delay_sweep_%Y%m%d_%H%M%S")
+
+METRICS = ("amp_a", "amp_b", "dc_a", "dc_b", "tone_mhz", "skew_ps", "skew_ci_ps", "gain_ci")
+
+
+class SweepPoint(NamedTuple):
+    mode: int  # AD9695_clk_delay_mode value
+    fine: int
+    super_fine: int
+    channel: int  # 1 = A, 2 = B, 3 = both
+
+    def request(self, captures: int, tag: int = None) -> bytes:
+        """
+        :param tag: when given, the board opens its reply with a udp_stamp carrying it (fleet.py)
+        """
+        if tag is None:
+            return bytes([self.mode, self.fine, self.super_fine, self.channel, UDP_CFG_CAPTURE, captures])
+        return bytes([self.mode, self.fine, self.super_fine, self.channel, UDP_CFG_CAPTURE | UDP_CFG_STAMP,
+                      captures]) + (tag & 0xFFFFFFFF).to_bytes(4, "little")
+
+    def delay_ps(self) -> float:
+        return self.fine * FINE_STEP_PS + self.super_fine * SUPER_FINE_STEP_PS
+
+
+def parse_range(text: str, top: int) -> range:
+    """
+    "start:stop:step" (stop inclusive), "start:stop", or a single value
+    """
+    parts = [int(v) for v in text.split(":")]
+    start, stop, step = (parts + parts[-1:] + [1])[:3] if len(parts) < 3 else parts
+    if not 0 <= start <= stop <= top or step < 1:
+        raise argparse.ArgumentTypeError(f"bad range {text} (0..{top})")
+    return range(start, stop + 1, step)
+
+
+def grid(modes, fines: range, super_fines: range, channels) -> list:
+    """
+    Sweep order: mode, channel, then a serpentine over fine x super fine
+    """
+    points = []
+    for mode in modes:
+        for channel in channels:
+            for i, fine in enumerate(fines):
+                row = super_fines if i % 2 == 0 else reversed(super_fines)
+                points.extend(SweepPoint(mode, fine, sf, channel) for sf in row)
+    return points
+
+
+def refine(points: list, skew_ps: numpy.ndarray, fines: range, super_fines: range) -> tuple:
+    """
+    Narrow both axes around the valid point with the smallest |skew|
+    :return: (points, fines, super_fines) of the next pass, or None when there is nothing to narrow
+    """
+    valid = numpy.flatnonzero(numpy.isfinite(skew_ps))
+    if not len(valid) or (fines.step == 1 and super_fines.step == 1):
+        return None
+    best = points[valid[numpy.argmin(numpy.abs(skew_ps[valid]))]]
+
+    def narrow(axis: range, centre: int, top: int) -> range:
+        if axis.step == 1:
+            return range(centre, centre + 1)
+        step = max(1, axis.step // 4)
+        return range(max(0, centre - axis.step), min(top, centre + axis.step) + 1, step)
+
+    fines = narrow(fines, best.fine, FINE_MAX)
+    super_fines = narrow(super_fines, best.super_fine, SUPER_FINE_MAX)
+    return grid([best.mode], fines, super_fines, [best.channel]), fines, super_fines
+
+
+def analyse(raw: bytes, mode=JESD_MODE) -> tuple:
+    """
+    Per-point metrics, averaged over the captures of the point
+    :return: (planar (M, captures * samples) int16, metric values in METRICS order)
+    """
+    planar = numpy.concatenate([mode.unpack(raw[i:i + mode.capture_bytes])
+                                for i in range(0, len(raw), mode.capture_bytes)], axis=1)
+    n = mode.capture_bytes // (mode.M * mode.NP // 8)
+    conv_b = max(1, mode.M // 2) if mode.M > 1 else 0
+    a = planar[0].reshape(-1, n).astype(numpy.float64) * (-1 if INVERT_MASK & 1 else 1)
+    b = planar[conv_b].reshape(-1, n).astype(numpy.float64)
+    fs = ADC_CLK_HZ / mode.dcm
+    window = numpy.hanning(n)
+    fa = numpy.fft.rfft((a - a.mean(axis=1, keepdims=True)) * window, axis=1)
+    fb = numpy.fft.rfft((b - b.mean(axis=1, keepdims=True)) * window, axis=1)
+    k = int(numpy.argmax(numpy.abs(fa[:, 1:]).sum(axis=0))) + 1  # common tone bin, DC excluded
+    tone_hz = k * fs / n
+    # B relative to A: the phase of the cross spectrum at the tone, averaged over the captures
+    phase = numpy.angle((fb[:, k] * numpy.conj(fa[:, k])).sum())
+    skew_ps = -phase / (2 * numpy.pi * tone_hz) * 1e12
+    skew_ci_ps = gain_ci = numpy.nan
+    if mismatch is not None:
+        # a sine fit per capture: the fitted tone instead of the bin centre, and bounds from the spread
+        e = mismatch.estimate(planar[0], planar[conv_b], fs, record_len=n, invert_a=bool(INVERT_MASK & 1),
+                              invert_b=bool((INVERT_MASK >> conv_b) & 1))
+        tone_hz, skew_ps, skew_ci_ps, gain_ci = e["tone_hz"], e["skew_ps"], e["skew_ci_ps"], e["gain_ci"]
+    scale = 2 / window.sum()
+    return planar, (numpy.abs(fa[:, k]).mean() * scale, numpy.abs(fb[:, k]).mean() * scale,
+                    a.mean(), b.mean(), tone_hz / 1e6, skew_ps, skew_ci_ps, gain_ci)
+
+
+class Board:
+    """
+    One socket for requests and captures, on the board's UDP port
+    """
+
+    def __init__(self, ip: str = BOARD_IP, port: int = UDP_PORT, local_port: int = UDP_PORT):
+        self.sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        self.sock.setsockopt(socket.SOL_SOCKET, socket.SO_RCVBUF, SOCKET_RCVBUF_KB * 1024)
+        self.sock.bind(("", local_port))
+        self.sock.connect((ip, port))
+        self.buf = bytearray(PKT_MAX)
+
+    def send(self, point: SweepPoint, captures: int):
+        self.sock.send(point.request(captures))
+
+    def wait_first(self, timeout: float) -> int:
+        """
+        Block until the first datagram of the next point
+        :return: bytes received, 0 on timeout
+        """
+        self.sock.settimeout(timeout)
+        try:
+            return self.sock.recv_into(self.buf)
+        except socket.timeout:
+            return 0
+
+    def receive_rest(self, have: int, nbytes: int, timeout: float) -> bool:
+        self.sock.settimeout(timeout)
+        view = memoryview(self.buf)
+        try:
+            while have < nbytes:
+                have += self.sock.recv_into(view[have:], nbytes - have)
+        except socket.timeout:
+            return False
+        return True
+
+    def drain(self, quiet: float):
+        """
+        Discard datagrams until none has arrived for quiet seconds: whatever was requested is over
+        """
+        self.sock.settimeout(quiet)
+        try:
+            while True:
+                self.sock.recv(PKT_MAX)
+        except socket.timeout:
+            pass
+
+    def close(self):
+        self.sock.close()
+
+
+def run_sweep(board: Board, points: list, writer: CaptureWriter, captures: int = CAPTURES_PER_POINT) -> dict:
+    """
+    Run the points through the three-stage pipeline
+    :return: columns: point fields, valid, t_ns, chunk and METRICS, one entry per point
+    """
+    nbytes = captures * JESD_MODE.capture_bytes
+    if len(board.buf) < nbytes + PKT_MAX:
+        board.buf = bytearray(nbytes + PKT_MAX)
+    cols = {name: numpy.zeros(len(points), numpy.int16) for name in ("mode", "fine", "super_fine", "channel")}
+    cols.update(valid=numpy.zeros(len(points), bool), t_ns=numpy.zeros(len(points), numpy.int64),
+                chunk=numpy.full(len(points), -1, numpy.int64))
+    cols.update({m: numpy.full(len(points), numpy.nan) for m in METRICS})
+    for i, p in enumerate(points):
+        cols["mode"][i], cols["fine"][i], cols["super_fine"][i], cols["channel"][i] = p
+
+    def finish(i: int, point: SweepPoint, t_ns: int, future: concurrent.futures.Future):
+        planar, metrics = future.result()
+        writer.append(planar, seq=i, t_ns=t_ns, delay=point)
+        cols["valid"][i] = True
+        cols["t_ns"][i] = t_ns
+        cols["chunk"][i] = len(writer.entries) - 1
+        for name, value in zip(METRICS, metrics):
+            cols[name][i] = value
+
+    pending = None
+    with concurrent.futures.ThreadPoolExecutor(max_workers=1) as worker:
+        if points:
+            board.send(points[0], captures)
+        for i, point in enumerate(points):
+            first = board.wait_first(POINT_TIMEOUT_S)
+            if i + 1 < len(points):
+                board.send(points[i + 1], captures)  # reconfigure while point i streams in
+            if not first or not board.receive_rest(first, nbytes, POINT_TIMEOUT_S):
+                # point i+1 is already requested and may be half in: let it finish, then ask again
+                board.drain(POINT_TIMEOUT_S)
+                if i + 1 < len(points):
+                    board.send(points[i + 1], captures)
+                continue
+            raw = bytes(board.buf[:nbytes])
+            if pending:
+                finish(*pending)  # point i-1, analysed while point i was in flight
+            pending = (i, point, time.time_ns(), worker.submit(analyse, raw))
+        if pending:
+            finish(*pending)
+    return cols
+
+
+def fake_board(port: int, stop: threading.Event, true_skew_ps: float = 137.0, tone_hz: float = 30.5e6,
+               latency_s: float = 0.0005, drop_every: int = 0, short_every: int = 0,
+               ready: threading.Event = None):
+    """
+    Stand-in for the board on 127.0.0.1: channel B lags A by true_skew_ps minus the delay applied
+    to B (plus the delay applied to A), channel A is sign-inverted like the hardware.  Every
+    drop_every-th point sends nothing, every short_every-th point only its first half.
+    """
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.bind(("127.0.0.1", port))
+    sock.settimeout(0.05)
+    if ready:
+        ready.set()
+    mode = JESD_MODE
+    n = mode.capture_bytes // (mode.M * mode.NP // 8)
+    rng = numpy.random.default_rng(7)
+    served = 0
+    while not stop.is_set():
+        try:
+            req, peer = sock.recvfrom(64)
+        except socket.timeout:
+            continue
+        if len(req) < 6 or not req[4] & UDP_CFG_CAPTURE:
+            continue
+        served += 1
+        time.sleep(latency_s)
+        if drop_every and served % drop_every == 0:
+            continue
+        point = SweepPoint(*req[:4])
+        delay_a = point.delay_ps() if point.channel & 1 else 0.0
+        delay_b = point.delay_ps() if point.channel & 2 else 0.0
+        payload = bytearray()
+        for _ in range(max(1, req[5])):
+            t = (numpy.arange(n) + rng.integers(0, 1 << 16)) / ADC_CLK_HZ
+            a = -20000 * numpy.sin(2 * numpy.pi * tone_hz * (t + delay_a * 1e-12))
+            b = 20000 * numpy.sin(2 * numpy.pi * tone_hz * (t - (true_skew_ps - delay_b) * 1e-12))
+            planar = numpy.stack([a, b] + [b] * (mode.M - 2)).round().astype("<i2")
+            payload += planar.reshape(mode.M, -1, mode.spc).transpose(1, 0, 2).tobytes()
+        if short_every and served % short_every == 0:
+            payload = payload[:len(payload) // 2]
+        for off in range(0, len(payload), PKT_MAX):
+            sock.sendto(payload[off:off + PKT_MAX], peer)
+    sock.close()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[1])
+    parser.add_argument("--mode", default="4", help="delay mode value(s), comma separated (4 = fine, 6 = super fine)")
+    parser.add_argument("--fine", type=lambda s: parse_range(s, FINE_MAX), default=parse_range("0:192:8", FINE_MAX))
+    parser.add_argument("--super-fine", type=lambda s: parse_range(s, SUPER_FINE_MAX), default=range(0, 1))
+    parser.add_argument("--channel", default="2", help="1 = A, 2 = B, 3 = both; comma separated")
+    parser.add_argument("--captures", type=int, default=CAPTURES_PER_POINT)
+    parser.add_argument("--refine", type=int, default=0, help="adaptive passes around the smallest |skew|")
+    parser.add_argument("--out", default=OUT_PREFIX, help="output prefix (.tcap and .npz)")
+    parser.add_argument("--simulate", action="store_true", help="sweep a local fake board")
+    args = parser.parse_args()
+
+    stop = threading.Event()
+    if args.simulate:
+        ready = threading.Event()
+        threading.Thread(target=fake_board, args=(15002, stop), kwargs=dict(ready=ready), daemon=True).start()
+        ready.wait()  # a request sent before the bind would come back as ECONNREFUSED
+        board = Board("127.0.0.1", 15002, 0)
+    else:
+        board = Board()
+
+    fines, super_fines = args.fine, args.super_fine
+    points = grid([int(m) for m in args.mode.split(",")], fines, super_fines, [int(c) for c in args.channel.split(",")])
+    all_cols = []
+    t0 = time.perf_counter()
+    with CaptureWriter(args.out + ".tcap", JESD_MODE, note="delay_sweep") as writer:
+        try:
+            for sweep_pass in range(args.refine + 1):
+                t_pass = time.perf_counter()
+                cols = run_sweep(board, points, writer, args.captures)
+                cols["sweep_pass"] = numpy.full(len(points), sweep_pass, numpy.int16)
+                all_cols.append(cols)
+                print(f"pass {sweep_pass}: {len(points)} points, {cols['valid'].sum()} valid, "
+                      f"{len(points) / (time.perf_counter() - t_pass):.0f} points/s")
+                nxt = refine(points, cols["skew_ps"], fines, super_fines) if sweep_pass < args.refine else None
+                if nxt is None:
+                    break
+                points, fines, super_fines = nxt
+        except KeyboardInterrupt:
+            print("User Abort")
+        finally:
+            stop.set()
+            board.close()
+
+    if all_cols:
+        results = {k: numpy.concatenate([c[k] for c in all_cols]) for k in all_cols[0]}
+        numpy.savez(args.out + ".npz", **results)
+        ok = numpy.flatnonzero(results["valid"])
+        if len(ok):
+            best = ok[numpy.argmin(numpy.abs(results["skew_ps"][ok]))]
+            print(f"best: mode {results['mode'][best]} fine {results['fine'][best]} super fine "
+                  f"{results['super_fine'][best]} channel {results['channel'][best]}, "
+                  f"skew {results['skew_ps'][best]:.2f} ps at {results['tone_mhz'][best]:.2f} MHz")
+        print(f"{len(results['valid'])} points in {time.perf_counter() - t0:.1f} s -> {args.out}.npz, {args.out}.tcap")
+
+
+if __name__ == "__main__":
+    main()
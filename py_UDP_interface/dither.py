@@ -0,0 +1,122 @@
+"""
+Python front end of the native RC dither generator (tiadc_dsp/dither.h)
+
+The dither family of MATLAB test1 (py_to_matlab_module), computed natively:
+period, time constant, amplitude, phase and number of periods, sampled at
+any rate, as float64 or as int16 codes.  The ideal per-sample reference of
+a capture record is memoised in the extension, so the estimators subtract
+it from every capture of a run without recomputing it.
+
+Build the extension first:
+    cmake -S tiadc_dsp -B tiadc_dsp/build && cmake --build tiadc_dsp/build
+
+Usage:
+    python dither.py --fs 500e6 --samples 65536 --out dither.f64            # float64 waveform
+    python dither.py --fs 1e9 --samples 65536 --codes 8000 --out dac.i16    # int16 DAC codes
+    python dither.py --test1                                                # test1's dither_plot.txt
+
+Author : Jingling Hou
+"""
+
+import argparse
+import os
+import sys
+
+import numpy
+
+from capture_file import INVERT_MASK, ADC_CLK_HZ
+
+## Start of User parameters
+PERIOD_S = 1e-6  # Drive high time; one dither cycle is 2 * PERIOD_S
+TAU_S = 0.217 * PERIOD_S  # RC time constant, TIME_CONSTANTS of test1
+AMPLITUDE = 2.0  # Level the RC charges towards
+PERIODS = 0  # Drive cycles, 0 = free running
+ADC_CODES_PER_UNIT = 1.0  # ADC codes per unit of AMPLITUDE at the converter input, from the injection path's gain
+CACHE_MIB = 64  # Reference cache budget
+BUILD_DIR = os.environ.get("TIADC_DSP_BUILD", os.path.join(os.path.dirname(os.path.abspath(__file__)), "tiadc_dsp", "build"))
+
+sys.path.insert(0, BUILD_DIR)
+import _tiadc_dsp  # noqa: E402  (built by CMake into BUILD_DIR)
+
+_tiadc_dsp.dither_cache(budget=CACHE_MIB << 20)
+
+
+def waveform(samples: int, fs: float, t0: float = 0.0, period: float = PERIOD_S, tau: float = TAU_S,
+             amplitude: float = AMPLITUDE, t_start: float = 0.0, phase: float = 0.0, periods: int = PERIODS,
+             codes_per_unit: float = None, memo: bool = True) -> numpy.ndarray:
+    """
+    Dither sampled at t0 + i / fs
+    :param phase: radians of one 2 * period cycle, moves the waveform earlier
+    :param codes_per_unit: None for float64, else int16 codes of this scale
+    :param memo: through the extension's reference cache; False for one-off exports
+    """
+    out = numpy.empty(samples, dtype=numpy.float64 if codes_per_unit is None else numpy.int16)
+    _tiadc_dsp.dither(out, float(fs), float(t0), period, tau, amplitude=amplitude, t_start=t_start, phase=phase,
+                      periods=periods, codes_per_unit=1.0 if codes_per_unit is None else codes_per_unit, memo=memo)
+    return out
+
+
+def reference(samples: int, fs: float = ADC_CLK_HZ, M: int = 2, t0: float = 0.0, interleaved: bool = False,
+              invert_mask: int = INVERT_MASK, codes_per_unit: float = ADC_CODES_PER_UNIT, **dither) -> numpy.ndarray:
+    """
+    Ideal dither of one capture record, per converter, as the capture carries it
+    :param t0: dither time of the record's first channel A sample
+    :param interleaved: channel B (converters M // 2 and up) samples half a period after A
+    :return: int16 array (M, samples), inverted where invert_mask says the capture is
+    """
+    half = M // 2 if M > 1 else 1
+    a = waveform(samples, fs, t0, codes_per_unit=codes_per_unit, **dither)
+    b = waveform(samples, fs, t0 + 0.5 / fs, codes_per_unit=codes_per_unit, **dither) if interleaved else a
+    ref = numpy.empty((M, samples), dtype=numpy.int16)
+    for conv in range(M):
+        src = a if conv < half else b
+        ref[conv] = -src if (invert_mask >> conv) & 1 else src
+    return ref
+
+
+def subtract(captures, fs: float = ADC_CLK_HZ, t0=0.0, **kwargs) -> numpy.ndarray:
+    """
+    Captures with their ideal dither removed, for the estimators
+    :param captures: int16 array (records, M, samples) or (M, samples)
+    :param t0: dither time of each record's start, scalar (dither locked to the capture trigger) or per record
+    :param kwargs: as reference()
+    """
+    data = numpy.asarray(captures, dtype=numpy.int16)
+    squeeze = data.ndim == 2
+    if squeeze:
+        data = data[numpy.newaxis]
+    records, M, samples = data.shape
+    starts = numpy.broadcast_to(numpy.asarray(t0, dtype=numpy.float64), (records,))
+    out = numpy.empty_like(data)
+    for r in range(records):
+        ref = reference(samples, fs, M, float(starts[r]), **kwargs)
+        out[r] = numpy.clip(data[r].astype(numpy.int32) - ref, -32768, 32767)
+    return out[0] if squeeze else out
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="RC dither waveform export")
+    parser.add_argument("--fs", type=float, default=ADC_CLK_HZ, help="sample rate in Hz")
+    parser.add_argument("--samples", type=int, default=65536)
+    parser.add_argument("--t0", type=float, default=0.0, help="time of the first sample in s")
+    parser.add_argument("--period", type=float, default=PERIOD_S)
+    parser.add_argument("--tau", type=float, default=TAU_S)
+    parser.add_argument("--amplitude", type=float, default=AMPLITUDE)
+    parser.add_argument("--phase", type=float, default=0.0, help="radians of one cycle")
+    parser.add_argument("--periods", type=int, default=PERIODS, help="drive cycles, 0 = free running")
+    parser.add_argument("--codes", type=float, default=None, help="write int16 codes, this many per unit")
+    parser.add_argument("--out", default="dither.bin", help="raw little-endian samples")
+    parser.add_argument("--test1", action="store_true", help="write test1's dither_plot.txt instead")
+    args = parser.parse_args()
+
+    if args.test1:
+        # test1: PERIOD = 100, TIME_CONSTANTS = 0.217 * PERIOD, 3000 points over [900, 1300]
+        plot = waveform(3000, 2999 / 400, 900.0, 100, 21.7, t_start=900.0, periods=1, memo=False)
+        numpy.savetxt("dither_plot.txt", plot, fmt="%.3f", delimiter="\t", header="t\ty", comments="")
+        sys.exit(0)
+
+    wave = waveform(args.samples, args.fs, args.t0, args.period, args.tau, args.amplitude, phase=args.phase,
+                    periods=args.periods, codes_per_unit=args.codes, memo=False)
+    wave.astype(wave.dtype.newbyteorder("<"), copy=False).tofile(args.out)
+    print(f"{args.out}: {len(wave)} {wave.dtype} samples at {args.fs:g} Hz, "
+          f"range {wave.min():g} .. {wave.max():g}")
@@ -0,0 +1,180 @@
+"""
+Client of the tiadc_dspd compute service (tiadc_dsp/tiadc_dspd.cpp)
+
+The service keeps the dither model and the analysis kernels loaded and
+memoises every answer, so a script asks over a Unix socket and gets a reply
+in well under a millisecond for anything it (or another script) asked
+before, instead of starting a MATLAB engine per run.  The first client to
+find no service starts one; it keeps running for the next.
+
+Build the service first:
+    cmake -S tiadc_dsp -B tiadc_dsp/build && cmake --build tiadc_dsp/build
+
+Usage:
+    python dspd_client.py              # ping, time a few requests
+    python dspd_client.py --quit       # stop the service
+
+Author : Jingling Hou
+"""
+
+import argparse
+import os
+import socket
+import subprocess
+import time
+
+import numpy
+
+from capture_file import INVERT_MASK, ADC_CLK_HZ
+
+## Start of User parameters
+SOCKET_PATH = os.environ.get("TIADC_DSPD_SOCK", "/tmp/tiadc_dspd.sock")  # --> DEFAULT_SOCKET in tiadc_dspd.cpp
+CACHE_MIB = 256  # Reply cache of a service started from here
+SPAWN_TIMEOUT_S = 2.0
+BUILD_DIR = os.environ.get("TIADC_DSP_BUILD", os.path.join(os.path.dirname(os.path.abspath(__file__)), "tiadc_dsp", "build"))
+DAEMON = os.path.join(BUILD_DIR, "tiadc_dspd")
+
+
+class DspError(RuntimeError):
+    pass
+
+
+class DspClient:
+    """
+    One connection to the service; requests on it are answered in order
+    """
+
+    def __init__(self, path: str = SOCKET_PATH, spawn: bool = True):
+        self.sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        try:
+            self.sock.connect(path)
+        except (FileNotFoundError, ConnectionRefusedError):
+            if not spawn:
+                raise
+            self.sock = self._spawn(path)
+        self.rfile = self.sock.makefile("rb")
+
+    @staticmethod
+    def _spawn(path: str) -> socket.socket:
+        subprocess.Popen([DAEMON, path, str(CACHE_MIB)], stdout=subprocess.DEVNULL, start_new_session=True)
+        deadline = time.monotonic() + SPAWN_TIMEOUT_S
+        while True:
+            sock = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+            try:
+                sock.connect(path)
+                return sock
+            except (FileNotFoundError, ConnectionRefusedError):
+                sock.close()
+                if time.monotonic() > deadline:
+                    raise DspError(f"tiadc_dspd did not come up on {path}")
+                time.sleep(0.01)
+
+    def call(self, op: str, payload: bytes = b"", **params) -> tuple:
+        """
+        One request
+        :return: (reply fields as str -> str dict, reply payload bytes)
+        """
+        head = " ".join([op] + [f"{k}={v}" for k, v in params.items()] + [f"bytes={len(payload)}"])
+        self.sock.sendall(head.encode() + b"\n" + payload)
+        line = self.rfile.readline().decode().rstrip("\n")
+        if not line:
+            raise DspError("connection closed by tiadc_dspd")
+        status, _, rest = line.partition(" ")
+        if status != "ok":
+            raise DspError(rest)
+        fields = dict(item.split("=", 1) for item in rest.split())
+        nbytes = int(fields.pop("bytes", 0))
+        data = self.rfile.read(nbytes) if nbytes else b""
+        return fields, data
+
+    def ping(self) -> dict:
+        fields, _ = self.call("ping")
+        return {k: float(v) for k, v in fields.items()}
+
+    def dither(self, period: float, tau: float, t_start: float, t_end: float, points: int,
+               amplitude: float = 2.0, phase: float = 0.0, periods: int = 1) -> numpy.ndarray:
+        """
+        RC dither over [t_start, t_end] (both included), see tiadc_dsp/dither.h
+        """
+        _, data = self.call("dither", period=period, tau=tau, t_start=t_start, t_end=t_end, points=points,
+                            amplitude=amplitude, phase=phase, periods=periods)
+        return numpy.frombuffer(data, dtype=numpy.float64)
+
+    def dither_samples(self, period: float, tau: float, fs: float, samples: int, t0: float = 0.0,
+                       amplitude: float = 2.0, t_start: float = 0.0, phase: float = 0.0, periods: int = 0,
+                       codes_per_unit: float = None) -> numpy.ndarray:
+        """
+        RC dither at t0 + i / fs, float64 or (codes_per_unit given) int16 codes
+        """
+        fmt = "f64" if codes_per_unit is None else "i16"
+        _, data = self.call("dither", period=period, tau=tau, fs=fs, samples=samples, t0=t0, amplitude=amplitude,
+                            t_start=t_start, phase=phase, periods=periods, format=fmt,
+                            codes_per_unit=1.0 if codes_per_unit is None else codes_per_unit)
+        return numpy.frombuffer(data, dtype=numpy.float64 if codes_per_unit is None else numpy.int16)
+
+    def spectral(self, captures, fs: float = ADC_CLK_HZ, interleaved: bool = False, conv_b: int = None,
+                 invert_mask: int = INVERT_MASK, window: str = "blackman_harris") -> dict:
+        """
+        As spectral.analyse(), computed by the service
+        """
+        data = numpy.ascontiguousarray(captures, dtype=numpy.int16)
+        if data.ndim == 2:
+            data = data[numpy.newaxis]
+        records, M, samples = data.shape
+        conv_b = (M // 2 if M > 1 else 0) if conv_b is None else conv_b
+        fields, out = self.call("spectral", data.tobytes(), records=records, M=M, samples=samples, fs=fs,
+                                interleaved=int(interleaved), conv_b=conv_b, invert_mask=invert_mask, window=window)
+        names = fields["names"].split(",")
+        table = numpy.frombuffer(out, dtype=numpy.float64).reshape(records, len(names))
+        return {name: table[:, i] for i, name in enumerate(names)}
+
+    def mismatch(self, a, b, fs: float = ADC_CLK_HZ, method: str = "sine_fit", record_len: int = 0,
+                 invert_a: bool = bool(INVERT_MASK & 1), invert_b: bool = False, **params) -> dict:
+        """
+        As mismatch.estimate(), computed by the service
+        """
+        a = numpy.ascontiguousarray(a, dtype=numpy.int16)
+        b = numpy.ascontiguousarray(b, dtype=numpy.int16)
+        if a.shape != b.shape:
+            raise ValueError(f"channel lengths differ: {a.shape} vs {b.shape}")
+        fields, _ = self.call("mismatch", a.tobytes() + b.tobytes(), fs=fs, method=method, record_len=record_len,
+                              invert_a=int(invert_a), invert_b=int(invert_b), **params)
+        return {k: float(v) for k, v in fields.items()}
+
+    def close(self):
+        self.rfile.close()
+        self.sock.close()
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
+
+
+def timed(label: str, fn, repeat: int = 100):
+    fn()
+    t0 = time.perf_counter()
+    for _ in range(repeat):
+        fn()
+    print(f"  {label:<40} {(time.perf_counter() - t0) / repeat * 1e6:8.1f} us")
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="tiadc_dspd ping and latency check")
+    parser.add_argument("--quit", action="store_true", help="stop the service")
+    args = parser.parse_args()
+
+    t0 = time.perf_counter()
+    with DspClient(spawn=not args.quit) as dsp:
+        print(f"connected in {(time.perf_counter() - t0) * 1e3:.1f} ms")
+        if args.quit:
+            dsp.call("quit")
+        else:
+            timed("ping", dsp.ping)
+            timed("dither, 3000 points (cached)", lambda: dsp.dither(100, 21.7, 900, 1300, 3000))
+            rng = numpy.random.default_rng(0)
+            caps = (8000 * numpy.sin(numpy.arange(128) * 0.37) + rng.normal(0, 4, (32, 2, 128))).astype(numpy.int16)
+            timed("spectral, 32 captures (cached)", lambda: dsp.spectral(caps))
+            timed("spectral, 32 captures (fresh)", lambda: (dsp.call("flush"), dsp.spectral(caps)), 20)
+            print(dsp.ping())
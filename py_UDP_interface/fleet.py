@@ -0,0 +1,189 @@
+"""
+Sweep several boards at once and record them into synchronised capture files
+
+Every sweep point goes to all boards in BOARDS as a stamped sweep datagram
+(UDP_CFG_STAMP, see ethernet.h) under one tag, the point's index, so each
+board opens its reply with a struct udp_stamp: its board ID, the tag, the
+delay it applied and its clock at the first capture.  The native recorder
+(udp_rx/udp_rx_fleet.cpp) takes the replies of all boards on one port,
+groups them by tag, puts the board clocks on one time base and writes
+<out>_b<id>.tcap per board, chunk i of every file from the same point.
+
+Points are paced at POINT_INTERVAL_S rather than on the data, since the
+replies go to the recorder; the interval has to cover the slowest board's
+reconf path plus the captures, or a board drops the earlier request.
+
+Build the recorder first:
+    cmake -S udp_rx -B udp_rx/build && cmake --build udp_rx/build
+
+    python fleet.py --fine 0:192:8 --channel 2
+    python fleet.py --simulate --boards 4       # against local fake boards
+
+Author : Jingling Hou
+"""
+
+import argparse
+import os
+import signal
+import socket
+import struct
+import subprocess
+import threading
+import time
+
+import numpy
+
+from capture_file import CaptureReader
+from delay_sweep import (SweepPoint, grid, parse_range, FINE_MAX, SUPER_FINE_MAX, ADC_CLK_HZ, UDP_CFG_CAPTURE,
+                         UDP_CFG_STAMP)
+from jesd_modes import JESD_MODES, DEFAULT_MODE_ID
+
+## Start of User parameters
+BOARDS = {0: "192.168.1.10", 1: "192.168.1.11"}  # board ID -> IP, 192.168.1.(10 + BOARD_ID) --> ethernet.h
+UDP_PORT = 5002  # Port --> SERVER_PORT in ethernet.h
+PKT_MAX = 1024  # Max bytes per datagram --> UDP_CHUNK_MAX in ethernet.h
+JESD_MODE_ID = DEFAULT_MODE_ID  # --> "jesd -r" on every board
+CAPTURES_PER_POINT = 4  # Fresh captures per point, at most UDP_SWEEP_MAX_CAPTURES
+POINT_INTERVAL_S = 0.02  # Time between points --> RECONF_SYNC_TIMEOUT_US plus the captures
+SETTLE_S = 0.5  # Wait for the last point before stopping the recorder
+RECEIVE_QUEUES = 2  # Recorder threads, one SO_REUSEPORT socket each
+BUILD_DIR = os.environ.get("UDP_RX_BUILD", os.path.join(os.path.dirname(os.path.abspath(__file__)), "udp_rx", "build"))
+RECORDER = os.path.join(BUILD_DIR, "udp_rx_fleet")
+OUT_PREFIX = time.strftime("fleet_%Y%m%d_%H%M%S")
+
+STAMP = struct.Struct("<IHBBIIQI4B")  # --> struct udp_stamp in ethernet.h
+STAMP_MAGIC = 0x504D5453  # --> UDP_STAMP_MAGIC in ethernet.h
+COUNTS_PER_SECOND = 99999000  # XTime rate on the ZynqMP
+
+
+def send_point(sock: socket.socket, boards: dict, port: int, point: SweepPoint, captures: int, tag: int):
+    request = point.request(captures, tag)
+    for ip in boards.values():
+        sock.sendto(request, (ip, port))
+
+
+def start_recorder(prefix: str, boards: dict, port: int, mode_id: int, queues: int) -> subprocess.Popen:
+    """
+    Start udp_rx_fleet and wait until its sockets are bound
+    """
+    m = JESD_MODES[mode_id]
+    board_list = ",".join(f"{i}={ip}" for i, ip in boards.items())
+    mode = f"{mode_id},{m.L},{m.M},{m.NP},{m.dcm},{m.num_ddc},{int(m.complex)}"
+    proc = subprocess.Popen([RECORDER, prefix, board_list, "0", mode, str(port), str(queues)],
+                            stdout=subprocess.PIPE, text=True)
+    first = proc.stdout.readline()  # "recording ..." once rx.start() returned
+    if not first.startswith("recording"):
+        proc.wait()
+        raise RuntimeError(f"udp_rx_fleet did not start: {first.strip()}")
+    print(first.strip())
+    return proc
+
+
+def check_files(prefix: str, boards: dict) -> int:
+    """
+    Confirm the per-board files line up: same chunk count, same tags in the same order
+    :return: number of synchronised chunks
+    """
+    readers = [CaptureReader(f"{prefix}_b{i}.tcap") for i in boards]
+    try:
+        tags = [numpy.array(r.index["seq"]) for r in readers]
+        times = numpy.stack([numpy.array(r.index["t_ns"], numpy.int64) for r in readers]) if tags[0].size else None
+        for i, t in zip(boards, tags[1:]):
+            if len(t) != len(tags[0]) or numpy.any(t != tags[0]):
+                raise RuntimeError(f"{prefix}_b{i}.tcap is not aligned with {prefix}_b{next(iter(boards))}.tcap")
+        if times is not None:
+            spread = (times.max(axis=0) - times.min(axis=0)) / 1e3
+            print(f"{len(tags[0])} synchronised chunks per board, capture time spread median "
+                  f"{numpy.median(spread):.1f} us, max {spread.max():.1f} us")
+        return len(tags[0])
+    finally:
+        for r in readers:
+            r.close()
+
+
+def fake_stamped_board(board_id: int, ip: str, port: int, host: tuple, stop: threading.Event,
+                       ready: threading.Event, tone_hz: float = 30.5e6):
+    """
+    Stand-in for one board on a loopback address: answers stamped sweep datagrams the way
+    udp_send_sweep() does, a udp_stamp then the captures, with a clock a few seconds off the host's
+    """
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.bind((ip, port))
+    sock.settimeout(0.05)
+    ready.set()
+    mode = JESD_MODES[JESD_MODE_ID]
+    n = mode.capture_bytes // (mode.M * mode.NP // 8)
+    clock_shift_ns = (board_id + 1) * 3_000_000_000
+    rng = numpy.random.default_rng(board_id)
+    while not stop.is_set():
+        try:
+            req = sock.recv(64)
+        except socket.timeout:
+            continue
+        if len(req) < 10 or (req[4] & (UDP_CFG_CAPTURE | UDP_CFG_STAMP)) != (UDP_CFG_CAPTURE | UDP_CFG_STAMP):
+            continue
+        captures = max(1, req[5])
+        tag = int.from_bytes(req[6:10], "little")
+        t_counts = (time.monotonic_ns() + clock_shift_ns) * COUNTS_PER_SECOND // 1_000_000_000
+        payload = bytearray()
+        for _ in range(captures):
+            t = (numpy.arange(n) + rng.integers(0, 1 << 16)) / ADC_CLK_HZ
+            a = 20000 * numpy.sin(2 * numpy.pi * tone_hz * t)
+            planar = numpy.stack([-a] + [a] * (mode.M - 1)).round().astype("<i2")
+            payload += planar.reshape(mode.M, -1, mode.spc).transpose(1, 0, 2).tobytes()
+        sock.sendto(STAMP.pack(STAMP_MAGIC, board_id, captures, req[4], tag, mode.capture_bytes, t_counts,
+                               COUNTS_PER_SECOND, *req[:4]), host)
+        for off in range(0, len(payload), PKT_MAX):
+            sock.sendto(payload[off:off + PKT_MAX], host)
+    sock.close()
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[1])
+    parser.add_argument("--mode", default="4", help="delay mode value(s), comma separated (4 = fine, 6 = super fine)")
+    parser.add_argument("--fine", type=lambda s: parse_range(s, FINE_MAX), default=parse_range("0:192:8", FINE_MAX))
+    parser.add_argument("--super-fine", type=lambda s: parse_range(s, SUPER_FINE_MAX), default=range(0, 1))
+    parser.add_argument("--channel", default="2", help="1 = A, 2 = B, 3 = both; comma separated")
+    parser.add_argument("--captures", type=int, default=CAPTURES_PER_POINT)
+    parser.add_argument("--interval", type=float, default=POINT_INTERVAL_S, help="seconds between points")
+    parser.add_argument("--out", default=OUT_PREFIX, help="output prefix (<out>_b<id>.tcap)")
+    parser.add_argument("--simulate", action="store_true", help="sweep local fake boards")
+    parser.add_argument("--boards", type=int, default=2, help="number of fake boards with --simulate")
+    args = parser.parse_args()
+
+    boards, port, record_port = BOARDS, UDP_PORT, UDP_PORT
+    stop = threading.Event()
+    if args.simulate:
+        boards = {i: f"127.0.0.{2 + i}" for i in range(args.boards)}
+        port, record_port = 15002, 15003
+        for i, ip in boards.items():
+            ready = threading.Event()
+            threading.Thread(target=fake_stamped_board, args=(i, ip, port, ("127.0.0.1", record_port), stop, ready),
+                             daemon=True).start()
+            ready.wait()
+
+    points = grid([int(m) for m in args.mode.split(",")], args.fine, args.super_fine,
+                  [int(c) for c in args.channel.split(",")])
+    recorder = start_recorder(args.out, boards, record_port, JESD_MODE_ID, RECEIVE_QUEUES)
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)  # ephemeral port, the replies go to the recorder
+    t0 = time.perf_counter()
+    try:
+        for tag, point in enumerate(points):
+            send_point(sock, boards, port, point, args.captures, tag)
+            time.sleep(max(0.0, t0 + (tag + 1) * args.interval - time.perf_counter()))
+        time.sleep(SETTLE_S)
+    except KeyboardInterrupt:
+        print("User Abort")
+    finally:
+        recorder.send_signal(signal.SIGINT)
+        print(recorder.communicate()[0].rstrip())
+        stop.set()
+        sock.close()
+
+    print(f"{len(points)} points to {len(boards)} boards in {time.perf_counter() - t0:.1f} s")
+    if recorder.returncode == 0:
+        check_files(args.out, boards)
+
+
+if __name__ == "__main__":
+    main()
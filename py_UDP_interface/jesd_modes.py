@@ -0,0 +1,121 @@
+"""
+JESD204 link modes and capture unpackers, host side of bjesdmode.c
+
+The table below has the same rows, in the same order, as jesd_modes[] in the
+firmware, so the mode id printed by "jesd -l" (and the jesd_mode gauge in the
+stats registry) indexes it directly.
+
+Capture layout: a block is L*32 bits of link data (or M*NP bits when a single
+sample of every converter does not fit); converter c owns the c-th contiguous
+slice of a block, holding spc samples of NP bits, oldest first.
+
+Author : Jingling Hou
+"""
+
+from dataclasses import dataclass
+
+import numpy
+
+CAPTURE_SAMPLES = 128  # per converter, one "dma -w" --> JESDMODE_CAPTURE_SAMPLES
+
+
+@dataclass(frozen=True)
+class JesdMode:
+    L: int
+    M: int
+    NP: int
+    num_ddc: int  # 0 = full bandwidth
+    dcm: int  # chip decimation
+    complex: bool  # DDC I/Q outputs
+
+    @property
+    def S(self) -> int:
+        return max(1, (8 * self.L) // (self.M * self.NP))
+
+    @property
+    def F(self) -> int:
+        return self.M * self.NP * self.S // (8 * self.L)
+
+    @property
+    def spc(self) -> int:
+        """Samples per converter per block"""
+        return max(1, (32 * self.L) // (self.M * self.NP))
+
+    @property
+    def block_bytes(self) -> int:
+        return self.M * self.spc * self.NP // 8
+
+    @property
+    def capture_bytes(self) -> int:
+        return (CAPTURE_SAMPLES // self.spc) * self.block_bytes
+
+    def lane_rate_kbps(self, adc_clk_khz: int = 500000) -> int:
+        return self.M * self.NP * 10 * adc_clk_khz // (self.dcm * self.L * 8)
+
+    def unpack(self, raw) -> numpy.ndarray:
+        """
+        Split raw capture bytes into per-converter samples
+        :return: int16 array of shape (M, samples); 8-bit samples are scaled to the 16-bit range
+        """
+        return UNPACK_KERNELS[self.NP](self, raw)
+
+
+def _unpack16(mode: JesdMode, raw) -> numpy.ndarray:
+    nblk = len(raw) // mode.block_bytes
+    words = numpy.frombuffer(raw, dtype="<i2", count=nblk * mode.block_bytes // 2)
+    # (block, converter, sample) -> (converter, block, sample): one strided copy
+    return words.reshape(nblk, mode.M, mode.spc).transpose(1, 0, 2).reshape(mode.M, -1)
+
+
+def _unpack8(mode: JesdMode, raw) -> numpy.ndarray:
+    nblk = len(raw) // mode.block_bytes
+    octets = numpy.frombuffer(raw, dtype="i1", count=nblk * mode.block_bytes)
+    samples = octets.reshape(nblk, mode.M, mode.spc).transpose(1, 0, 2).reshape(mode.M, -1)
+    return samples.astype("<i2") << 8
+
+
+UNPACK_KERNELS = {16: _unpack16, 8: _unpack8}
+
+# Same order as jesd_modes[] in bjesdmode.c
+JESD_MODES = [
+    JesdMode(1, 1, 8, 0, 1, False),
+    JesdMode(1, 1, 16, 1, 2, False),
+    JesdMode(2, 1, 8, 0, 1, False),
+    JesdMode(2, 1, 16, 0, 1, False),
+    JesdMode(4, 1, 8, 0, 1, False),  # 1.25 Gbps, rejected by the firmware
+    JesdMode(4, 1, 16, 0, 1, False),
+    JesdMode(1, 2, 8, 2, 2, False),
+    JesdMode(1, 2, 16, 2, 4, False),
+    JesdMode(2, 2, 8, 0, 1, False),
+    JesdMode(2, 2, 16, 2, 2, False),
+    JesdMode(4, 2, 8, 0, 1, False),
+    JesdMode(4, 2, 16, 0, 1, False),  # default
+    JesdMode(1, 4, 8, 2, 4, True),
+    JesdMode(1, 4, 16, 2, 8, True),
+    JesdMode(2, 4, 8, 2, 2, True),
+    JesdMode(2, 4, 16, 2, 4, True),
+    JesdMode(4, 4, 8, 2, 2, True),
+    JesdMode(4, 4, 16, 2, 2, True),
+    JesdMode(1, 8, 8, 4, 8, True),
+    JesdMode(1, 8, 16, 4, 16, True),
+    JesdMode(2, 8, 8, 4, 4, True),
+    JesdMode(2, 8, 16, 4, 8, True),
+    JesdMode(4, 8, 8, 4, 2, True),
+    JesdMode(4, 8, 16, 4, 4, True),
+]
+
+DEFAULT_MODE_ID = 11  # L=4 M=2 NP=16
+
+
+def find_mode(L: int, M: int, NP: int) -> JesdMode:
+    for mode in JESD_MODES:
+        if (mode.L, mode.M, mode.NP) == (L, M, NP):
+            return mode
+    raise ValueError(f"no JESD mode with L={L} M={M} NP={NP}")
+
+
+if __name__ == "__main__":
+    print(" id  L  M NP  F  S spc  kbps/lane  bytes/capture")
+    for i, m in enumerate(JESD_MODES):
+        print(f"{i:3d} {m.L:2d} {m.M:2d} {m.NP:2d} {m.F:2d} {m.S:2d} {m.spc:3d} "
+              f"{m.lane_rate_kbps():10d} {m.capture_bytes:14d}")
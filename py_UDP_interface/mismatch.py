@@ -0,0 +1,102 @@
+"""
+Python front end of the native mismatch estimators (tiadc_dsp/)
+
+Timing skew (ps), gain ratio and offsets of channel B against channel A,
+each with a 95 % confidence half-width, straight from the de-interleaved
+channel buffers: no MATLAB engine start-up and no marshalling, a million
+samples per channel in milliseconds.  Methods (see tiadc_dsp/mismatch.h):
+    sine_fit    one input tone (the delay sweep's case)
+    xcorr       any input within a channel's first Nyquist zone
+    dither      the calibration dither alone, input off
+
+Build the extension first:
+    cmake -S tiadc_dsp -B tiadc_dsp/build && cmake --build tiadc_dsp/build
+
+Usage:
+    python mismatch.py capture.tcap                    # sine fit, per delay setting
+    python mismatch.py capture.tcap --method xcorr
+
+Author : Jingling Hou
+"""
+
+import argparse
+import os
+import sys
+
+import numpy
+
+from capture_file import CaptureReader, unpack_delay, INVERT_MASK, ADC_CLK_HZ
+
+## Start of User parameters
+METHOD = "sine_fit"  # sine_fit, xcorr or dither
+SEGMENTS = 16  # Pieces of a contiguous buffer behind the confidence bounds
+DITHER_PERIOD_S = 0.0  # Period of the injected dither, needed by the dither method
+BUILD_DIR = os.environ.get("TIADC_DSP_BUILD", os.path.join(os.path.dirname(os.path.abspath(__file__)), "tiadc_dsp", "build"))
+
+sys.path.insert(0, BUILD_DIR)
+import _tiadc_dsp  # noqa: E402  (built by CMake into BUILD_DIR)
+
+
+def estimate(a, b, fs: float = ADC_CLK_HZ, method: str = METHOD, interleaved: bool = False, record_len: int = 0,
+             tone_hz: float = 0.0, dither_period: float = DITHER_PERIOD_S, invert_a: bool = bool(INVERT_MASK & 1),
+             invert_b: bool = False) -> dict:
+    """
+    Mismatch of channel B against channel A
+    :param a: channel A samples, int16 (raw, sign fixed by invert_a)
+    :param b: channel B samples, same length
+    :param interleaved: B nominally half a sample period after A, else both on the same instant
+    :param record_len: > 0 when the buffers are back-to-back captures of this length
+    :return: dict with skew_ps, gain, offset_a, offset_b, their *_ci bounds, tone_hz, residual_rms, segments
+    """
+    a = numpy.ascontiguousarray(a, dtype=numpy.int16)
+    b = numpy.ascontiguousarray(b, dtype=numpy.int16)
+    if a.shape != b.shape:
+        raise ValueError(f"channel lengths differ: {a.shape} vs {b.shape}")
+    return _tiadc_dsp.mismatch(a, b, float(fs), method=method, interleaved=interleaved, record_len=record_len,
+                               segments=SEGMENTS, tone_hz=tone_hz, dither_period=dither_period,
+                               invert_a=invert_a, invert_b=invert_b)
+
+
+def estimate_captures(captures, fs: float = ADC_CLK_HZ, invert_mask: int = INVERT_MASK, dither: dict = None,
+                      **kwargs) -> dict:
+    """
+    Mismatch over a batch of separate captures, each its own record
+    :param captures: int16 array (records, M, samples); A is converter 0, B converter M // 2
+    :param dither: when the calibration dither rides on the tone, dither.subtract() arguments to remove it first
+    """
+    captures = numpy.asarray(captures)
+    if dither is not None:
+        import dither as dither_ref  # --> dither.py
+        captures = dither_ref.subtract(captures, fs, invert_mask=invert_mask, **dither)
+    records, M, samples = captures.shape
+    conv_b = M // 2 if M > 1 else 0
+    return estimate(captures[:, 0, :].ravel(), captures[:, conv_b, :].ravel(), fs, record_len=samples,
+                    invert_a=bool(invert_mask & 1), invert_b=bool((invert_mask >> conv_b) & 1), **kwargs)
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="A/B mismatch of a capture file, per delay setting")
+    parser.add_argument("path")
+    parser.add_argument("--method", default=METHOD, choices=("sine_fit", "xcorr"))
+    parser.add_argument("--tone", type=float, default=0.0, help="true tone frequency in Hz (sine_fit), 0 = find it")
+    args = parser.parse_args()
+
+    with CaptureReader(args.path) as reader:
+        h = reader.header
+        chunks = numpy.array(reader.uniform())
+        delays = numpy.array(reader.index["delay"])
+        capture = reader.mode.capture_bytes * 8 // (reader.mode.M * reader.mode.NP)
+    # a chunk may hold several captures back to back (delay_sweep.py): split them into records
+    R, M, S = chunks.shape
+    per_chunk = S // capture if S % capture == 0 else 1
+    chunks = chunks.reshape(R, M, per_chunk, S // per_chunk).transpose(0, 2, 1, 3).reshape(-1, M, S // per_chunk)
+    delays = numpy.repeat(delays, per_chunk)
+    print(f"{len(chunks)} captures of {chunks.shape[2]} samples, {args.method}")
+    print(f"{'mode/fine/sf/ch':>16} {'n':>5} {'skew (ps)':>18} {'gain B/A':>20} {'offset B-A (LSB)':>18}")
+    for word in numpy.unique(delays):
+        sel = delays == word
+        e = estimate_captures(chunks[sel], h["sample_rate_hz"], h["invert_mask"], method=args.method,
+                              tone_hz=args.tone)
+        print(f"{'/'.join(str(v) for v in unpack_delay(int(word))):>16} {int(sel.sum()):>5} "
+              f"{e['skew_ps']:>9.2f} +- {e['skew_ci_ps']:<5.2f} {e['gain']:>10.5f} +- {e['gain_ci']:<7.5f} "
+              f"{e['offset_b'] - e['offset_a']:>9.2f} +- {e['offset_ci']:<5.2f}")
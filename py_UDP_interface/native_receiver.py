@@ -0,0 +1,145 @@
+"""
+Python front end of the native UDP capture receiver (udp_rx/)
+
+The C++ receive thread assembles whole transfers (NUM_OF_TX captures) into a
+preallocated ring with recvmmsg(); each completed transfer arrives here as a
+Capture whose memory is the ring slot itself.  numpy.frombuffer() on it is a
+view, not a copy, and the slot goes back to the receive thread once the
+Capture and every view of it are gone (or on capture.release()).
+
+Build the extension first:
+    cmake -S udp_rx -B udp_rx/build && cmake --build udp_rx/build
+
+Usage:
+    python native_receiver.py               # print per-transfer stats from the board
+    python native_receiver.py --loopback    # self-check against a local sender
+
+Author : Jingling Hou
+"""
+
+import argparse
+import os
+import socket
+import sys
+import time
+
+import numpy
+
+from jesd_modes import JESD_MODES, DEFAULT_MODE_ID
+
+## Start of User parameters
+BOARD_IP = "192.168.1.10"  # Sender IP --> Configured in Vitis
+UDP_PORT = 5002  # Port --> Same as above
+UDP_CHUNK_MAX = 1024  # Max bytes per datagram --> UDP_CHUNK_MAX in ethernet.h
+JESD_MODE = JESD_MODES[DEFAULT_MODE_ID]  # --> "jesd -r" on the board
+NUM_OF_TX = 32  # Capture repetitions per transfer --> NUM_OF_TX in ethernet.h
+RING_SLOTS = 64  # Transfers buffered between the receive thread and Python
+RCVBUF_BYTES = 64 << 20  # Socket RX buffer (capped by net.core.rmem_max without CAP_NET_ADMIN)
+RX_CPU = -1  # Pin the receive thread to this CPU, -1 = no pinning
+BUILD_DIR = os.environ.get("UDP_RX_BUILD", os.path.join(os.path.dirname(os.path.abspath(__file__)), "udp_rx", "build"))
+
+sys.path.insert(0, BUILD_DIR)
+import _udp_rx  # noqa: E402  (built by CMake into BUILD_DIR)
+
+
+def transfer_bytes(mode=JESD_MODE) -> int:
+    return NUM_OF_TX * mode.capture_bytes
+
+
+def datagram_bytes(mode=JESD_MODE) -> int:
+    return min(mode.capture_bytes, UDP_CHUNK_MAX)
+
+
+def open_receiver(mode=JESD_MODE, port=UDP_PORT, peer=BOARD_IP, bind="0.0.0.0"):
+    """
+    Create and start a receiver sized for one transfer of the given JESD mode
+    :return: a running _udp_rx.Receiver
+    """
+    rx = _udp_rx.Receiver(port=port, capture_bytes=transfer_bytes(mode), datagram_bytes=datagram_bytes(mode),
+                          slots=RING_SLOTS, rcvbuf=RCVBUF_BYTES, cpu=RX_CPU, peer=peer, bind=bind)
+    rx.start()
+    return rx
+
+
+def converters(capture, mode=JESD_MODE) -> numpy.ndarray:
+    """
+    Per-converter samples of the first capture of a transfer
+    :param capture: _udp_rx.Capture (or anything with the buffer protocol)
+    :return: int16 array of shape (M, samples), see JesdMode.unpack
+    """
+    return mode.unpack(memoryview(capture)[:mode.capture_bytes])
+
+
+def board_loop():
+    rx = open_receiver()
+    print(f"Listening {UDP_PORT}, {transfer_bytes()} bytes per transfer, rcvbuf {rx.stats()['rcvbuf']} bytes")
+    try:
+        while True:
+            cap = rx.get(1000)
+            if cap is None:
+                continue
+            samples = converters(cap)
+            print(f"[{cap.seq}] {cap.nbytes} bytes in {cap.datagrams} datagrams, "
+                  f"{(cap.t_last_ns - cap.t_first_ns) / 1e3:.0f} us, ch A mean {samples[0].mean():.1f}")
+            del samples
+            cap.release()
+    except KeyboardInterrupt:
+        print("User Abort")
+    finally:
+        print(rx.stats())
+        rx.stop()
+
+
+def loopback_check(transfers: int = 2000, port: int = 15002) -> bool:
+    """
+    Send ramp transfers to ourselves and check order, content and that the
+    numpy view really shares the ring slot
+    :return: True when every transfer came back intact
+    """
+    nbytes, dgram = transfer_bytes(), datagram_bytes()
+    rx = open_receiver(port=port, peer="127.0.0.1", bind="127.0.0.1")
+    tx = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    tx.connect(("127.0.0.1", port))
+    ramp = numpy.arange(nbytes // 2, dtype="<u2")
+    ok = True
+
+    t0 = time.perf_counter()
+    for n in range(transfers):
+        payload = (ramp + n).astype("<u2").tobytes()
+        for off in range(0, nbytes, dgram):
+            tx.send(payload[off:off + dgram])
+        cap = rx.get(2000)
+        if cap is None:
+            print(f"transfer {n}: timed out")
+            ok = False
+            break
+        view = numpy.frombuffer(cap, dtype="<u2")
+        if cap.seq != n or not numpy.array_equal(view, ramp + numpy.uint16(n)):
+            print(f"transfer {n}: bad content (seq {cap.seq})")
+            ok = False
+        try:
+            cap.release()
+            print("release() with a live view should have failed")
+            ok = False
+        except BufferError:
+            pass
+        del view
+        cap.release()
+    dt = time.perf_counter() - t0
+
+    stats = rx.stats()
+    rx.stop()
+    tx.close()
+    print(f"loopback: {transfers} transfers of {nbytes} bytes in {dt:.2f} s "
+          f"({transfers * nbytes / dt / 1e6:.1f} MB/s incl. Python sender), {stats}")
+    print(f"loopback: {'PASS' if ok else 'FAIL'}")
+    return ok
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[1])
+    parser.add_argument("--loopback", action="store_true", help="self-check against a local sender")
+    args = parser.parse_args()
+    if args.loopback:
+        sys.exit(0 if loopback_check() else 1)
+    board_loop()
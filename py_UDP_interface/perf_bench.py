@@ -0,0 +1,390 @@
+"""
+End-to-end performance benchmark of the acquisition chain, against stored baselines
+
+Stages, each a few named metrics:
+    board        sweep points of NUM_OF_TX fresh captures against the host-simulated
+                 firmware (test_platform/host_sim, started here) or a real board.  Board side,
+                 from its hot-path profiler ("P" on the stats port): DMA capture and cache
+                 flush (real board only) time per MB, UDP sender MB/s and datagrams/s.  Host
+                 side, through the native receiver: receive MB/s, points/s and the share of
+                 datagrams lost.
+    deinterleave numpy unpack of raw link blocks to per-converter samples (jesd_modes.py)
+    receiver     udp_rx_loopback: native sender to native receiver on 127.0.0.1
+    file         .tcap writes through CaptureWriter, unpack included
+    dsp          tiadc_dsp_check throughput lines (spectral batch, signal model) and the
+                 spectral.py batch path
+A stage whose build is missing is skipped and its metrics left out.
+
+Results go to a JSON file ({"meta": ..., "metrics": {name: value}}).  Every metric that
+is also in the baseline is compared: a metric worse than its baseline by more than its
+tolerance (METRICS, or "tolerance" in the baseline file) is flagged and the exit status
+is 1.  Baselines are per machine; --save-baseline records one.
+
+    python perf_bench.py                            # start host_sim, run, compare
+    python perf_bench.py --stages dsp,file          # only these stages
+    python perf_bench.py --save-baseline perf_baseline.json
+    python perf_bench.py --board 192.168.1.10       # a real board instead of host_sim
+
+Author : Jingling Hou
+"""
+
+import argparse
+import json
+import os
+import platform
+import re
+import socket
+import struct
+import subprocess
+import sys
+import tempfile
+import time
+
+import numpy
+
+from capture_file import CaptureWriter
+from jesd_modes import JESD_MODES, DEFAULT_MODE_ID, find_mode
+
+## Start of User parameters
+HERE = os.path.dirname(os.path.abspath(__file__))
+SIM_BIN = os.environ.get("HOST_SIM", os.path.join(HERE, "..", "test_platform", "host_sim", "build", "tiadc_fw_sim"))
+UDP_RX_BUILD = os.environ.get("UDP_RX_BUILD", os.path.join(HERE, "udp_rx", "build"))
+TIADC_DSP_BUILD = os.environ.get("TIADC_DSP_BUILD", os.path.join(HERE, "tiadc_dsp", "build"))
+BASELINE = os.path.join(HERE, "perf_baseline.json")
+SIM_BOARD_IP = "127.0.0.10"  # host_sim shim: board port p at p + SIM_PORT_OFFSET
+SIM_PORT_OFFSET = 10000  # --> SIM_PORT_OFFSET in host_sim/sim/sim.h
+UDP_PORT = 5002  # --> SERVER_PORT in ethernet.h
+STATS_PORT = 5003  # --> STATS_PORT in bstats.h
+UDP_CHUNK_MAX = 1024  # --> ethernet.h
+NUM_OF_TX = 32  # --> ethernet.h, captures per sweep point here
+UDP_CFG_CAPTURE = 0x01  # --> ethernet.h
+JESD_MODE = JESD_MODES[DEFAULT_MODE_ID]  # --> "jesd -r" on the board
+BOARD_POINTS = 300  # Sweep points timed in the board stage
+POINT_TIMEOUT_S = 0.5
+SIM_BOOT_TIMEOUT_S = 20.0
+DEINTERLEAVE_MB = 64
+LOOPBACK_CAPTURES = 20000
+FILE_MB = 64
+DSP_RECORDS, DSP_SAMPLES = 2048, 4096
+
+BPROF_MAGIC = 0x46525042  # "BPRF"
+BPROF_HDR = "<IHHI"
+BPROF_REGION = "<16sIIQQQQ"
+
+# name: (unit, better, relative tolerance, absolute tolerance); better is "higher" or "lower"
+METRICS = {
+    "board.dma_capture_us_per_mb": ("us/MB", "lower", 0.15, 0.0),
+    "board.dcache_flush_us_per_mb": ("us/MB", "lower", 0.50, 5.0),
+    "board.udp_send_mb_s": ("MB/s", "higher", 0.20, 0.0),
+    "board.udp_send_pkt_s": ("datagrams/s", "higher", 0.20, 0.0),
+    "board.points_s": ("points/s", "higher", 0.20, 0.0),
+    "host.rx_mb_s": ("MB/s", "higher", 0.20, 0.0),
+    "host.rx_loss_pct": ("%", "lower", 0.0, 0.5),
+    "deinterleave.np16_mb_s": ("MB/s", "higher", 0.20, 0.0),
+    "deinterleave.np8_mb_s": ("MB/s", "higher", 0.20, 0.0),
+    "receiver.loopback_mb_s": ("MB/s", "higher", 0.20, 0.0),
+    "receiver.loopback_loss": ("captures", "lower", 0.0, 0.0),
+    "file.tcap_write_mb_s": ("MB/s", "higher", 0.25, 0.0),
+    "dsp.spectral_records_s": ("records/s", "higher", 0.15, 0.0),
+    "dsp.spectral_msamples_s": ("MSamples/s", "higher", 0.15, 0.0),
+    "dsp.signal_model_gb_s": ("GB/s", "higher", 0.25, 0.01),
+    "dsp.spectral_py_records_s": ("records/s", "higher", 0.15, 0.0),
+}
+
+STAGES = ("board", "deinterleave", "receiver", "file", "dsp")
+
+
+def timed(fn, *args) -> float:
+    """
+    :return: seconds fn(*args) took
+    """
+    t0 = time.perf_counter()
+    fn(*args)
+    return time.perf_counter() - t0
+
+
+# ---------------------------------------------------------------- board --
+
+class BoardLink:
+    """
+    The board's command and stats ports, on host_sim's shim or the real addresses
+    """
+
+    def __init__(self, ip: str, offset: int):
+        self.cmd = (ip, UDP_PORT + offset)
+        self.stats = (ip, STATS_PORT + offset)
+        self.sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+        self.sock.settimeout(POINT_TIMEOUT_S)
+
+    def request(self, op: bytes) -> bytes:
+        self.sock.sendto(op, self.stats)
+        return self.sock.recv(2048)
+
+    def counters(self) -> dict:
+        names = self.request(b"N").rstrip(b"\0").decode("ascii").split(",")
+        reply = self.request(b"S")
+        count = struct.unpack_from("<IHHII", reply)[2]
+        return dict(zip(names, struct.unpack_from(f"<{count}Q", reply, struct.calcsize("<IHHII"))))
+
+    def profile(self, clear: bool = False) -> tuple:
+        """
+        :return: (cycles per us, {region: (count, total cycles, total bytes)}), None if compiled out
+        """
+        reply = self.request(b"p" if clear else b"P")
+        if len(reply) < struct.calcsize(BPROF_HDR):
+            return None
+        magic, _, count, cycles_per_us = struct.unpack_from(BPROF_HDR, reply)
+        if magic != BPROF_MAGIC:
+            raise ValueError(f"bad profile magic 0x{magic:08X}")
+        regions = {}
+        for i in range(count):
+            name, n, _, total, _, _, nbytes = struct.unpack_from(
+                BPROF_REGION, reply, struct.calcsize(BPROF_HDR) + i * struct.calcsize(BPROF_REGION))
+            regions[name.rstrip(b"\0").decode("ascii")] = (n, total, nbytes)
+        return cycles_per_us, regions
+
+    def sweep_point(self, captures: int):
+        self.sock.sendto(bytes([0, 0, 0, 0, UDP_CFG_CAPTURE, captures]), self.cmd)
+
+    def close(self):
+        self.sock.close()
+
+
+def start_sim(log_path: str) -> subprocess.Popen:
+    """
+    Start host_sim on the UDP shim; its stdin stays open so it keeps running
+    """
+    if not os.path.exists(SIM_BIN):
+        raise FileNotFoundError(f"{SIM_BIN} not built (cmake -S test_platform/host_sim -B test_platform/host_sim/build)")
+    log = open(log_path, "wb")
+    return subprocess.Popen([SIM_BIN], stdin=subprocess.PIPE, stdout=log, stderr=subprocess.STDOUT)
+
+
+def wait_ready(link: BoardLink, timeout: float):
+    end = time.monotonic() + timeout
+    while time.monotonic() < end:
+        try:
+            link.request(b"P")
+            return
+        except (socket.timeout, ConnectionRefusedError):
+            time.sleep(0.1)
+    raise TimeoutError("board did not answer on the stats port")
+
+
+def stage_board(args) -> dict:
+    sys.path.insert(0, UDP_RX_BUILD)
+    import _udp_rx
+
+    sim = None
+    if args.board:
+        link = BoardLink(args.board, 0)
+    else:
+        sim = start_sim(os.path.join(tempfile.gettempdir(), "perf_bench_sim.log"))
+        link = BoardLink(SIM_BOARD_IP, SIM_PORT_OFFSET)
+    transfer = NUM_OF_TX * JESD_MODE.capture_bytes
+    rx = _udp_rx.Receiver(port=UDP_PORT, capture_bytes=transfer, datagram_bytes=min(transfer, UDP_CHUNK_MAX),
+                          bind="0.0.0.0" if args.board else "127.0.0.1")
+    rx.start()
+    try:
+        wait_ready(link, SIM_BOOT_TIMEOUT_S)
+        for _ in range(3):  # the first point after boot may be held back by the link monitor
+            link.sweep_point(NUM_OF_TX)
+            cap = rx.get(int(POINT_TIMEOUT_S * 1000))
+            if cap is not None:
+                cap.release()
+        if link.profile(clear=True) is None:
+            raise RuntimeError("firmware profiler compiled out (BPROF_ENABLE=0)")
+        before, rx_before = link.counters(), rx.stats()["datagrams"]
+        got = 0
+        t0 = time.perf_counter()
+        for _ in range(args.points):
+            link.sweep_point(NUM_OF_TX)
+            cap = rx.get(int(POINT_TIMEOUT_S * 1000))
+            if cap is not None:
+                got += cap.nbytes
+                cap.release()
+        dt = time.perf_counter() - t0
+        after, rx_after = link.counters(), rx.stats()["datagrams"]
+        cycles_per_us, prof = link.profile()
+    finally:
+        rx.stop()
+        link.close()
+        if sim:
+            sim.stdin.close()
+            sim.terminate()
+            sim.wait()
+
+    def us(region):
+        return prof[region][1] / cycles_per_us
+
+    pkts = after["udp_tx_pkts"] - before["udp_tx_pkts"]  # udp_tx_bytes counts the headers too
+    dma_mb = prof["dma_capture"][2] / 1e6
+    out = {
+        "board.points_s": got / transfer / dt,
+        "host.rx_mb_s": got / 1e6 / dt,
+        "host.rx_loss_pct": 100.0 * (1.0 - (rx_after - rx_before) / pkts) if pkts else 100.0,
+    }
+    if dma_mb:
+        out["board.dma_capture_us_per_mb"] = us("dma_capture") / dma_mb
+        if args.board:  # host_sim's cache maintenance is a no-op, nothing to time
+            out["board.dcache_flush_us_per_mb"] = us("dcache_flush") / (prof["dcache_flush"][2] / 1e6)
+    if prof["udp_send_buf"][1]:
+        out["board.udp_send_mb_s"] = prof["udp_send_buf"][2] / us("udp_send_buf")
+        out["board.udp_send_pkt_s"] = pkts / (us("udp_send_buf") / 1e6)
+    return out
+
+
+# ---------------------------------------------------------------- host --
+
+def stage_deinterleave(args) -> dict:
+    out = {}
+    for NP in (16, 8):
+        mode = find_mode(JESD_MODE.L, JESD_MODE.M, NP)
+        raw = numpy.random.default_rng(1).integers(0, 256, DEINTERLEAVE_MB << 20, dtype=numpy.uint8).tobytes()
+        raw = raw[:len(raw) // mode.block_bytes * mode.block_bytes]
+        mode.unpack(raw[:mode.block_bytes * 64])
+        out[f"deinterleave.np{NP}_mb_s"] = len(raw) / 1e6 / timed(mode.unpack, raw)
+    return out
+
+
+def run_tool(path: str, *argv) -> str:
+    if not os.path.exists(path):
+        raise FileNotFoundError(f"{path} not built")
+    res = subprocess.run([path, *map(str, argv)], capture_output=True, text=True, timeout=600)
+    return res.stdout + res.stderr
+
+
+def stage_receiver(args) -> dict:
+    text = run_tool(os.path.join(UDP_RX_BUILD, "udp_rx_loopback"), LOOPBACK_CAPTURES,
+                    NUM_OF_TX * JESD_MODE.capture_bytes, min(JESD_MODE.capture_bytes, UDP_CHUNK_MAX), -1, 15102)
+    rate = re.search(r"loopback: (\d+) captures x \d+ bytes in [\d.]+ s, ([\d.]+) MB/s", text)
+    if not rate:
+        raise RuntimeError(f"unexpected udp_rx_loopback output:\n{text}")
+    return {"receiver.loopback_mb_s": float(rate.group(2)),
+            "receiver.loopback_loss": float(LOOPBACK_CAPTURES - int(rate.group(1)))}
+
+
+def stage_file(args) -> dict:
+    transfer = NUM_OF_TX * JESD_MODE.capture_bytes
+    raw = numpy.random.default_rng(2).integers(-2048, 2048, transfer // 2, dtype=numpy.int16).tobytes()
+    count = (FILE_MB << 20) // transfer
+    with tempfile.TemporaryDirectory() as tmp:
+        path = os.path.join(tmp, "perf.tcap")
+
+        def write():
+            with CaptureWriter(path, JESD_MODE) as writer:
+                for _ in range(count):
+                    writer.append(raw)
+            fd = os.open(path, os.O_RDONLY)
+            os.fsync(fd)
+            os.close(fd)
+
+        dt = timed(write)
+    return {"file.tcap_write_mb_s": count * transfer / 1e6 / dt}
+
+
+def stage_dsp(args) -> dict:
+    out = {}
+    text = run_tool(os.path.join(TIADC_DSP_BUILD, "tiadc_dsp_check"), DSP_RECORDS, DSP_SAMPLES)
+    batch = re.search(r"throughput: .* ([\d.]+) records/s, ([\d.]+) MSamples/s", text)
+    model = re.search(r"signal model stream: .* ([\d.]+) GB/s", text)
+    if not batch:
+        raise RuntimeError(f"unexpected tiadc_dsp_check output:\n{text}")
+    out["dsp.spectral_records_s"] = float(batch.group(1))
+    out["dsp.spectral_msamples_s"] = float(batch.group(2))
+    if model:
+        out["dsp.signal_model_gb_s"] = float(model.group(1))
+    try:
+        import spectral
+    except ImportError:
+        return out
+    data = numpy.random.default_rng(3).integers(-2048, 2048, (DSP_RECORDS, 2, DSP_SAMPLES), dtype=numpy.int16)
+    spectral.analyse(data[:8])
+    out["dsp.spectral_py_records_s"] = DSP_RECORDS / timed(spectral.analyse, data)
+    return out
+
+
+# ------------------------------------------------------------ baselines --
+
+def compare(metrics: dict, baseline: dict) -> list:
+    """
+    :return: (name, value, baseline, limit) of every metric worse than its baseline allows
+    """
+    flagged = []
+    tolerance = baseline.get("tolerance", {})
+    for name, base in baseline.get("metrics", {}).items():
+        if name not in metrics or name not in METRICS:
+            continue
+        _, better, rel, absolute = METRICS[name]
+        rel = tolerance.get(name, rel)
+        slack = max(abs(base) * rel, absolute)
+        limit = base - slack if better == "higher" else base + slack
+        if (better == "higher" and metrics[name] < limit) or (better == "lower" and metrics[name] > limit):
+            flagged.append((name, metrics[name], base, limit))
+    return flagged
+
+
+def git_rev() -> str:
+    try:
+        return subprocess.run(["git", "rev-parse", "--short", "HEAD"], cwd=HERE, capture_output=True,
+                              text=True).stdout.strip()
+    except OSError:
+        return ""
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[1])
+    parser.add_argument("--stages", default=",".join(STAGES), help=f"comma separated, from {','.join(STAGES)}")
+    parser.add_argument("--board", help="board IP; default: start host_sim")
+    parser.add_argument("--points", type=int, default=BOARD_POINTS, help="sweep points in the board stage")
+    parser.add_argument("--baseline", default=BASELINE, help="baseline to compare with")
+    parser.add_argument("--save-baseline", metavar="PATH", help="write the results as a baseline")
+    parser.add_argument("--out", default=time.strftime("perf_%Y%m%d_%H%M%S.json"), help="results file")
+    args = parser.parse_args()
+
+    stages = [s for s in args.stages.split(",") if s]
+    for s in stages:
+        if s not in STAGES:
+            parser.error(f"unknown stage {s}")
+
+    metrics, skipped = {}, {}
+    for s in stages:
+        try:
+            metrics.update(globals()[f"stage_{s}"](args))
+        except (FileNotFoundError, ImportError, RuntimeError, TimeoutError) as e:
+            skipped[s] = str(e)
+            print(f"{s}: skipped, {e}")
+
+    meta = dict(time=time.strftime("%Y-%m-%dT%H:%M:%S"), host=platform.node(), machine=platform.machine(),
+                cpus=os.cpu_count(), git=git_rev(), board=args.board or "host_sim", skipped=skipped)
+    result = {"meta": meta, "metrics": metrics}
+    with open(args.out, "w") as f:
+        json.dump(result, f, indent=2)
+
+    baseline = {}
+    if os.path.exists(args.baseline) and not args.save_baseline:
+        with open(args.baseline) as f:
+            baseline = json.load(f)
+    flagged = {name: limit for name, _, _, limit in compare(metrics, baseline)}
+
+    print(f"{'metric':<30} {'value':>12} {'baseline':>12}  unit")
+    for name, value in metrics.items():
+        unit = METRICS.get(name, ("",))[0]
+        base = baseline.get("metrics", {}).get(name)
+        mark = f"  SLOWER (limit {flagged[name]:.4g})" if name in flagged else ""
+        print(f"{name:<30} {value:12.4g} {'-' if base is None else format(base, '12.4g'):>12}  {unit}{mark}")
+    print(f"results: {args.out}")
+
+    if args.save_baseline:
+        with open(args.save_baseline, "w") as f:
+            json.dump(result, f, indent=2)
+        print(f"baseline saved: {args.save_baseline}")
+        return 0
+    if flagged:
+        print(f"{len(flagged)} metric(s) slower than the baseline allows")
+        return 1
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -5,21 +5,25 @@ Author : Jingling Hou
 """
 
 import socket
-import matplotlib.pyplot as pyplt
-import numpy  # Using numpy for high efficiency data organization and computation
 import time
 from enum import Enum
 
+from adc_viewer import start_viewer
+from capture_file import CaptureWriter, INVERT_MASK, pack_delay
+from capture_ring import CaptureRing
+from jesd_modes import JESD_MODES, DEFAULT_MODE_ID, CAPTURE_SAMPLES
+
 ## Start of User parameters
 BOARD_IP = "192.168.1.10"  # Sender IP --> Configured in Vitis
 UDP_PORT = 5002  # Port --> Same as above
 PKT_MAX = 1024  # Max bytes per datagram
-TOTAL_BYTES = 32 * 1024  # Capture size (32 KB)
+JESD_MODE = JESD_MODES[DEFAULT_MODE_ID]  # --> "jesd -r" on the board
+NUM_OF_TX = 32  # Capture repetitions per transfer --> NUM_OF_TX in ethernet.h
+TOTAL_BYTES = NUM_OF_TX * JESD_MODE.capture_bytes  # 16 KB in the default mode
 SOCKET_RCVBUF_KB = 512  # OS socket RX buffer size (KB)
 TIMEOUT_FIRST = 10  # Seconds to wait for very first packet
 WAIT_IDLE_MS = 200  # Stop if idle this long after buffer full
-PLOT_FILE = "adc_sample.png"
-HEX_FILE = "adc_sample16bit.txt"
+CAPTURE_FILE = time.strftime("adc_capture_%Y%m%d_%H%M%S.tcap")  # One chunk per capture, see capture_file.py
 DMA_RXBASE = 0x1300000
 
 
@@ -82,6 +86,9 @@ def main():
     adc_super_fine_delay = 0
     config_object = AD9695_Channel_index_select.CHANNEL_A  # default channel 1
     clk_cfg = [adc_clk_delay_mode, adc_fine_delay, adc_super_fine_delay, config_object]
+    capture_writer = CaptureWriter(CAPTURE_FILE, JESD_MODE, note="sampling_clk_config_script")
+    capture_ring = CaptureRing.create(JESD_MODE.M, CAPTURE_SAMPLES, JESD_MODE.dcm, INVERT_MASK)
+    viewer = start_viewer(capture_ring)
 
     try:
         while not abort_flag:
@@ -110,63 +117,13 @@ def main():
                     print(f"[{last_rx}] Received Package #{write_ptr // 1024}")
 
                 print(f"[✓] Captured {write_ptr} bytes")
-                print("Visualizing received data ...")
-                int16_t_array = numpy.frombuffer(capture_buffer, dtype="<i2")
-                figure, axes = pyplt.subplots(3, 2)
-                sample_channel_a = numpy.empty(128, dtype="<i2")
-                sample_channel_b = numpy.empty(128, dtype="<i2")
-                count = 0
-                for i in range(0, 127, 4):
-                    sample_channel_a[i : i + 4] = int16_t_array[count : count + 4]
-                    count += 4
-                    sample_channel_b[i : i + 4] = int16_t_array[count : count + 4]
-                    count += 4
-                #for some reason channel a samples are all reversed, need to correct it
-                sample_channel_a = -sample_channel_a
-                Ts = 1/500000000 #500Mhz sampling rate
-                ch_a_fft = numpy.fft.fft(sample_channel_a)
-                ch_b_fft = numpy.fft.fft(sample_channel_b)
-                ch_a_freq = numpy.fft.fftfreq(len(sample_channel_a), d=Ts)
-                ch_b_freq = numpy.fft.fftfreq(len(sample_channel_b), d=Ts)
-
-                axes[0, 0].plot(sample_channel_a)
-                axes[0, 0].set_title("ADC Sample Plot (Channel A)")
-                axes[0, 0].set_xlabel("ADC Sample Index")
-                axes[0, 0].set_ylabel("Digital Amplitude")
-
-                axes[0, 1].plot(ch_a_freq, numpy.abs(ch_a_fft))
-                axes[0, 1].set_title("FFT Plot (Channel A)")
-                axes[0, 1].set_xlabel("Frequency")
-                axes[0, 1].set_ylabel("Magnitude")
-
-                axes[1, 0].plot(sample_channel_b)
-                axes[1, 0].set_title("ADC Sample Plot (Channel B)")
-                axes[1, 0].set_xlabel("ADC Sample Index")
-                axes[1, 0].set_ylabel("Digital Amplitude")
-
-                axes[1, 1].plot(ch_b_freq, numpy.abs(ch_b_fft))
-                axes[1, 1].set_title("FFT Plot (Channel B)")
-                axes[1, 1].set_xlabel("Frequency")
-                axes[1, 1].set_ylabel("Magnitude")
-
-                axes[2, 0].hist(sample_channel_a)
-                axes[2, 0].set_title("ADC Sample Distribution (Channel A)")
-
-                axes[2, 1].hist(sample_channel_b)
-                axes[2, 1].set_title("ADC Sample Distribution (Channel B)")
-
-                pyplt.tight_layout()
-                print("Please close the window to proceed")
-                with open(HEX_FILE, "w", encoding="utf-8") as output_file:
-                    for i in range(0, 512, 2):
-                        block_128 = capture_buffer[i: i + 2][
-                                    ::-1]  # Write the bytes to the 128 bit block in Big endian
-                        # Step From i + 16 to i
-                        output_file.write(f"#{i // 2} : {block_128.hex().upper()}\n")
-
-                print(f"[i] Hex blocks saved → {HEX_FILE}")
-                pyplt.show()
-                figure.savefig(PLOT_FILE)
+                converters = JESD_MODE.unpack(capture_buffer[:JESD_MODE.capture_bytes])
+                delay = (clk_cfg[0].value, clk_cfg[1], clk_cfg[2], clk_cfg[3].value)
+                # hand the capture to the viewer process; the next capture starts right away
+                capture_ring.push(converters, delay=pack_delay(delay))
+                # tag the capture with the delay last sent to the board
+                capture_writer.append(converters, delay=delay)
+                print(f"[i] Capture #{len(capture_writer.entries) - 1} saved → {CAPTURE_FILE}")
 
 
 
@@ -254,6 +211,9 @@ def main():
     except KeyboardInterrupt:
         print("User Abort")
     finally:
+        capture_writer.close()
+        capture_ring.close()  # viewer saves its last frame and exits
+        viewer.join(timeout=5)
         socket_inst.close()
 
 if __name__ == "__main__":
@@ -0,0 +1,94 @@
+"""
+Python front end of the native spectral metrics engine (tiadc_dsp/)
+
+Windowed FFT metrics for batches of captures: SNR, SINAD, SFDR, THD, ENOB,
+and in the interleaved view (channel A and B merged at twice the converter
+rate) the mismatch image at fs/2 - fin and the offset spur at fs/2.  The
+batch is split over all CPUs with the GIL released and FFT plans cached, so
+a sweep's captures are analysed as fast as they arrive.
+
+Build the extension first:
+    cmake -S tiadc_dsp -B tiadc_dsp/build && cmake --build tiadc_dsp/build
+
+Usage:
+    python spectral.py capture.tcap                 # per-channel A metrics, per delay setting
+    python spectral.py capture.tcap --interleaved   # A/B interleaved, with the TI spurs
+
+Author : Jingling Hou
+"""
+
+import argparse
+import os
+import sys
+
+import numpy
+
+from capture_file import CaptureReader, unpack_delay, INVERT_MASK, ADC_CLK_HZ
+
+## Start of User parameters
+WINDOW = "blackman_harris"  # rect, hann or blackman_harris
+HARMONICS = 5  # Highest harmonic counted as distortion
+FULL_SCALE = 32768.0  # Sine amplitude of 0 dBFS (16-bit samples)
+THREADS = 0  # Worker threads, 0 = one per CPU
+BUILD_DIR = os.environ.get("TIADC_DSP_BUILD", os.path.join(os.path.dirname(os.path.abspath(__file__)), "tiadc_dsp", "build"))
+
+sys.path.insert(0, BUILD_DIR)
+import _tiadc_dsp  # noqa: E402  (built by CMake into BUILD_DIR)
+
+METRICS = _tiadc_dsp.metric_names
+
+
+def analyse(captures, fs: float = ADC_CLK_HZ, interleaved: bool = False, conv_a: int = 0, conv_b: int = None,
+            invert_mask: int = INVERT_MASK, window: str = WINDOW, threads: int = THREADS) -> dict:
+    """
+    Metrics of every capture of a batch
+    :param captures: int16 array (records, M, samples) or (M, samples), e.g. CaptureReader.uniform()
+    :param fs: per-converter sample rate in Hz; the interleaved view runs at 2 fs
+    :param conv_b: channel B converter, default M // 2 as in the capture layout
+    :return: {metric name: float64 array (records,)}, NaN where a metric does not apply
+    """
+    data = numpy.ascontiguousarray(captures, dtype=numpy.int16)
+    if data.ndim == 2:
+        data = data[numpy.newaxis]
+    records, M, samples = data.shape
+    if conv_b is None:
+        conv_b = M // 2 if M > 1 else 0
+    out = numpy.empty((records, len(METRICS)), dtype=numpy.float64)
+    _tiadc_dsp.spectral(data, out, records, M, samples, float(fs), interleaved=interleaved, conv_a=conv_a,
+                        conv_b=conv_b, invert_mask=invert_mask, window=window, harmonics=HARMONICS,
+                        full_scale=FULL_SCALE, threads=threads)
+    return {name: out[:, i] for i, name in enumerate(METRICS)}
+
+
+def analyse_file(path: str, interleaved: bool = False, window: str = WINDOW) -> tuple:
+    """
+    Metrics of every chunk of a capture file
+    :return: (metrics dict as analyse(), packed delay word per chunk)
+    """
+    with CaptureReader(path) as reader:
+        h = reader.header
+        metrics = analyse(reader.uniform(), h["sample_rate_hz"], interleaved,
+                          invert_mask=h["invert_mask"], window=window)
+        delays = numpy.array(reader.index["delay"])
+    return metrics, delays
+
+
+def _mean(values: numpy.ndarray) -> float:
+    finite = values[~numpy.isnan(values)]
+    return float(finite.mean()) if len(finite) else numpy.nan
+
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description="Spectral metrics of a capture file")
+    parser.add_argument("path")
+    parser.add_argument("--interleaved", action="store_true", help="merge channel A and B at twice the rate")
+    parser.add_argument("--window", default=WINDOW, choices=("rect", "hann", "blackman_harris"))
+    args = parser.parse_args()
+
+    metrics, delays = analyse_file(args.path, args.interleaved, args.window)
+    print(f"{len(delays)} captures, {'interleaved' if args.interleaved else 'channel A'} view, {args.window} window")
+    print(f"{'mode/fine/sf/ch':>16} {'n':>5} " + " ".join(f"{name:>11}" for name in METRICS))
+    for word in numpy.unique(delays):
+        sel = delays == word
+        means = " ".join(f"{_mean(metrics[name][sel]):>11.2f}" for name in METRICS)
+        print(f"{'/'.join(str(v) for v in unpack_delay(int(word))):>16} {int(sel.sum()):>5} {means}")
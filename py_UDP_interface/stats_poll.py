@@ -0,0 +1,171 @@
+"""
+Python script for polling the firmware statistics registry over UDP
+
+The board answers on STATS_PORT:
+    "N" -> comma separated counter / gauge names (ID order)
+    "S" -> binary snapshot: <magic u32, version u16, count u16, seq u32, uptime_ms u32> + count * u64
+    "E" -> JESD link event timeline: <magic u32, total u32, count u16, state u16>
+           + count * <t_us u64, type u16, lane u16, arg u32>
+    "P" -> hot-path profile: <magic u32, version u16, count u16, cycles_per_us u32>
+           + count * <name 16s, count u32, reserved u32, total u64, min u64, max u64, bytes u64>
+    "p" -> as "P", then the profile is cleared
+"""
+
+import argparse
+import socket
+import struct
+import time
+
+## Start of User parameters
+BOARD_IP = "192.168.1.10"  # Sender IP --> Configured in Vitis
+STATS_PORT = 5003  # Port --> STATS_PORT in bstats.h
+TIMEOUT_S = 1.0  # Seconds to wait for a reply
+
+BSTATS_MAGIC = 0x41545342  # "BSTA"
+HDR_FORMAT = "<IHHII"
+HDR_SIZE = struct.calcsize(HDR_FORMAT)
+
+JESDMON_MAGIC = 0x4D445342  # "BSDM"
+EV_HDR_FORMAT = "<IIHH"
+EV_FORMAT = "<QHHI"
+EV_NAMES = ["monitor start", "link up", "link down", "lane errors", "rx buffer shift",
+            "phy pll unlock", "adc pll unlock", "re-link start", "re-link ok",
+            "re-link fail", "capture flagged", "reset issued"]  # --> jesdmon_event_t
+LINK_STATES = ["idle", "up", "down", "settling"]  # --> jesdmon_state_t
+
+BPROF_MAGIC = 0x46525042  # "BPRF"
+PROF_HDR_FORMAT = "<IHHI"
+PROF_FORMAT = "<16sIIQQQQ"
+
+
+def request(socket_inst, op: bytes) -> bytes:
+    """
+    Send a one byte request to the board and return the reply payload
+    """
+    socket_inst.sendto(op, (BOARD_IP, STATS_PORT))
+    reply, _ = socket_inst.recvfrom(2048)
+    return reply
+
+
+def fetch_names(socket_inst) -> list:
+    """
+    Fetch the registry entry names, in the same order as the snapshot values
+    """
+    return request(socket_inst, b"N").rstrip(b"\0").decode("ascii").split(",")
+
+
+def fetch_snapshot(socket_inst) -> tuple:
+    """
+    Fetch and decode one snapshot
+    :return: (seq, uptime_ms, list of u64 values)
+    """
+    reply = request(socket_inst, b"S")
+    magic, version, count, seq, uptime_ms = struct.unpack_from(HDR_FORMAT, reply)
+    if magic != BSTATS_MAGIC:
+        raise ValueError(f"bad snapshot magic 0x{magic:08X}")
+    values = struct.unpack_from(f"<{count}Q", reply, HDR_SIZE)
+    return seq, uptime_ms, list(values)
+
+
+def fetch_timeline(socket_inst) -> tuple:
+    """
+    Fetch the JESD link event timeline, oldest event first
+    :return: (link state name, total events logged, list of (t_us, name, lane, arg))
+    """
+    reply = request(socket_inst, b"E")
+    magic, total, count, state = struct.unpack_from(EV_HDR_FORMAT, reply)
+    if magic != JESDMON_MAGIC:
+        raise ValueError(f"bad timeline magic 0x{magic:08X}")
+    events = []
+    for idx in range(count):
+        t_us, ev_type, lane, arg = struct.unpack_from(
+            EV_FORMAT, reply, struct.calcsize(EV_HDR_FORMAT) + idx * struct.calcsize(EV_FORMAT))
+        name = EV_NAMES[ev_type] if ev_type < len(EV_NAMES) else f"event{ev_type}"
+        events.append((t_us, name, lane, arg))
+    state_name = LINK_STATES[state] if state < len(LINK_STATES) else str(state)
+    return state_name, total, events
+
+
+def fetch_profile(socket_inst, clear: bool = False) -> tuple:
+    """
+    Fetch the hot-path profile; an empty reply means the firmware has it compiled out
+    :return: (cycles per us, list of (name, count, total, min, max, bytes)), None if compiled out
+    """
+    reply = request(socket_inst, b"p" if clear else b"P")
+    if len(reply) < struct.calcsize(PROF_HDR_FORMAT):
+        return None
+    magic, _, count, cycles_per_us = struct.unpack_from(PROF_HDR_FORMAT, reply)
+    if magic != BPROF_MAGIC:
+        raise ValueError(f"bad profile magic 0x{magic:08X}")
+    regions = []
+    for idx in range(count):
+        name, n, _, total, lo, hi, nbytes = struct.unpack_from(
+            PROF_FORMAT, reply, struct.calcsize(PROF_HDR_FORMAT) + idx * struct.calcsize(PROF_FORMAT))
+        regions.append((name.rstrip(b"\0").decode("ascii"), n, total, lo, hi, nbytes))
+    return cycles_per_us, regions
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Poll the firmware statistics registry")
+    parser.add_argument("-i", "--interval", type=float, default=0.0,
+                        help="poll period in seconds (0 = single snapshot)")
+    parser.add_argument("-d", "--delta", action="store_true",
+                        help="print only entries that changed since the previous poll")
+    parser.add_argument("-e", "--events", action="store_true",
+                        help="print the JESD link event timeline and exit")
+    parser.add_argument("-p", "--profile", action="store_true",
+                        help="print the hot-path profile and exit")
+    parser.add_argument("--clear", action="store_true",
+                        help="with -p, clear the profile after reading it")
+    args = parser.parse_args()
+
+    socket_inst = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    socket_inst.settimeout(TIMEOUT_S)
+
+    if args.events:
+        state, total, events = fetch_timeline(socket_inst)
+        print(f"link {state}, {total} events logged")
+        for t_us, name, lane, arg in events:
+            print(f"{t_us / 1000:12.3f} ms  {name:<16} lane {lane}  0x{arg:08X}")
+        socket_inst.close()
+        return
+
+    if args.profile:
+        profile = fetch_profile(socket_inst, args.clear)
+        socket_inst.close()
+        if profile is None:
+            print("profiler compiled out (BPROF_ENABLE=0)")
+            return
+        cycles_per_us, regions = profile
+        for name, n, total, lo, hi, nbytes in regions:
+            if n == 0:
+                continue
+            us = total / cycles_per_us
+            rate = f"  {nbytes / us:8.1f} MB/s" if nbytes and us else ""
+            print(f"{name:<16} {n:8d} calls  avg {us / n:10.2f} us  "
+                  f"min {lo / cycles_per_us:10.2f}  max {hi / cycles_per_us:10.2f}{rate}")
+        return
+
+    names = fetch_names(socket_inst)
+    previous = None
+    try:
+        while True:
+            seq, uptime_ms, values = fetch_snapshot(socket_inst)
+            print(f"--- snapshot #{seq} @ {uptime_ms / 1000:.3f} s ---")
+            for idx, value in enumerate(values):
+                name = names[idx] if idx < len(names) else f"id{idx}"
+                if args.delta and previous is not None and previous[idx] == value:
+                    continue
+                print(f"{name:<20} {value}")
+            previous = values
+            if args.interval <= 0:
+                break
+            time.sleep(args.interval)
+    except KeyboardInterrupt:
+        print("User Abort")
+    finally:
+        socket_inst.close()
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,147 @@
+#include "dither.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <string>
+
+namespace tiadc_dsp {
+
+namespace {
+
+constexpr double INF = std::numeric_limits<double>::infinity();
+constexpr size_t BLOCK = 64;                // samples per exact exp in rc_dither_render
+constexpr size_t DEFAULT_CACHE_BYTES = size_t(64) << 20;
+
+/* One exponential stretch of the waveform: v(t) = target + (v0 - target) exp(-(t - ts) / tau), ts <= t < te */
+struct segment {
+    double target, v0, ts, te;
+};
+
+void check(const rc_dither &d)
+{
+    if (!(d.tau > 0.0) || !(d.period > 0.0)) throw std::invalid_argument("dither: period and tau must be positive");
+}
+
+segment segment_at(const rc_dither &d, double t)
+{
+    const double P = d.period, C = 2.0 * P;
+    const double shift = d.phase / (2.0 * M_PI) * C;
+    const double origin = d.t_start - shift;            // t of x = 0
+    const double x = t - origin;
+    const double e = std::exp(-P / d.tau);
+    const double v_ss = d.amplitude * e / (1.0 + e);     // cycle start value in steady state
+
+    double k = std::floor(x / C);
+    double vk = v_ss;
+    if (d.periods) {
+        if (x < 0.0) return segment{ 0.0, 0.0, -INF, origin };
+        if (k >= (double)d.periods) {
+            double n = (double)d.periods;
+            return segment{ 0.0, v_ss * (1.0 - std::exp(-2.0 * n * P / d.tau)), origin + C * n, INF };
+        }
+        vk = v_ss * (1.0 - std::exp(-2.0 * k * P / d.tau));
+    }
+    double cs = origin + C * k;
+    if (x - C * k < P) return segment{ d.amplitude, vk, cs, cs + P };
+    return segment{ 0.0, d.amplitude + (vk - d.amplitude) * e, cs + P, cs + C };
+}
+
+lru_cache<std::vector<double>> &reference_cache()
+{
+    static lru_cache<std::vector<double>> cache(DEFAULT_CACHE_BYTES);
+    return cache;
+}
+
+} // namespace
+
+double rc_dither_value(const rc_dither &d, double t)
+{
+    segment s = segment_at(d, t);
+    if (s.v0 == s.target) return s.target;
+    return s.target + (s.v0 - s.target) * std::exp(-(t - s.ts) / d.tau);
+}
+
+void rc_dither_sample(const rc_dither &d, double t0, double t1, size_t points, double *out)
+{
+    check(d);
+    if (points == 1) {
+        out[0] = rc_dither_value(d, t0);
+        return;
+    }
+    double step = (t1 - t0) / (double)(points - 1);
+    for (size_t i = 0; i < points; i++) out[i] = rc_dither_value(d, t0 + step * (double)i);
+}
+
+void rc_dither_render(const rc_dither &d, double fs, double t0, size_t n, double *out)
+{
+    check(d);
+    if (!(fs > 0.0)) throw std::invalid_argument("dither: fs must be positive");
+
+    double decay[BLOCK];
+    for (size_t j = 0; j < BLOCK; j++) decay[j] = std::exp(-(double)j / (fs * d.tau));
+
+    size_t i = 0;
+    while (i < n) {
+        segment s = segment_at(d, t0 + (double)i / fs);
+        size_t end = n;
+        if (s.te < INF) {
+            double e = std::ceil((s.te - t0) * fs);
+            end = e >= (double)n ? n : std::max(i + 1, (size_t)e);
+        }
+        if (s.v0 == s.target) {
+            std::fill(out + i, out + end, s.target);
+            i = end;
+            continue;
+        }
+        for (; i < end; i += BLOCK) {
+            const size_t m = std::min(BLOCK, end - i);
+            const double base = (s.v0 - s.target) * std::exp(-(t0 + (double)i / fs - s.ts) / d.tau);
+            double *o = out + i;
+            for (size_t j = 0; j < m; j++) o[j] = s.target + base * decay[j];
+        }
+        i = end;
+    }
+}
+
+void dither_to_codes(const double *v, size_t n, double codes_per_unit, int16_t *out)
+{
+    for (size_t i = 0; i < n; i++) out[i] = (int16_t)std::clamp(std::nearbyint(v[i] * codes_per_unit), -32768.0, 32767.0);
+}
+
+void rc_dither_codes(const rc_dither &d, double fs, double t0, size_t n, double codes_per_unit, int16_t *out)
+{
+    constexpr size_t CHUNK = 4096;
+    double buf[CHUNK];
+    for (size_t i = 0; i < n; i += CHUNK) {
+        const size_t m = std::min(CHUNK, n - i);
+        rc_dither_render(d, fs, t0 + (double)i / fs, m, buf);
+        dither_to_codes(buf, m, codes_per_unit, out + i);
+    }
+}
+
+std::shared_ptr<const std::vector<double>> rc_dither_reference(const rc_dither &d, double fs, double t0, size_t n)
+{
+    const double params[] = { d.period, d.tau, d.amplitude, d.t_start, d.phase, (double)d.periods, fs, t0, (double)n };
+    std::string key(reinterpret_cast<const char *>(params), sizeof(params));
+
+    lru_cache<std::vector<double>> &cache = reference_cache();
+    if (auto hit = cache.get(key)) return hit;
+    auto ref = std::make_shared<std::vector<double>>(n);
+    rc_dither_render(d, fs, t0, n, ref->data());
+    cache.put(key, ref, n * sizeof(double) + key.size());
+    return ref;
+}
+
+void set_dither_cache_budget(size_t bytes)
+{
+    reference_cache().set_budget(bytes);
+}
+
+cache_stats dither_cache_stats()
+{
+    return reference_cache().stats();
+}
+
+} // namespace tiadc_dsp
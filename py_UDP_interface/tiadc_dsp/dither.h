@@ -0,0 +1,67 @@
+/* dither.h
+ * The RC-shaped calibration dither, as modelled in MATLAB (test1 of the
+ * py_to_matlab_module example), and the family around it.  The dither is an
+ * RC low-pass driven by a pulse train: from t_start the drive is high for
+ * period (charging towards amplitude with time constant tau), then low for
+ * period (discharging), and so on for `periods` cycles of 2 period; after
+ * the last cycle the dither discharges for good.
+ *
+ *   cycle k (x = t - t_start - 2 k period, v_k its start value)
+ *     v(x) = A + (v_k - A) exp(-x / tau)                  0 <= x < period
+ *          = v_hk exp(-(x - period) / tau)                period <= x < 2 period
+ *     v_hk = A + (v_k - A) e,   v_k = A e / (1 + e) (1 - e^2k),   e = exp(-period / tau)
+ *
+ * periods = 1 is test1 exactly; periods = 0 is the free-running dither,
+ * already in its periodic steady state for all t.  phase (radians of a
+ * 2 period cycle) moves the waveform earlier, as in sin(w t + phase).
+ * Times are in whatever unit period and tau share, sample rates in its
+ * reciprocal.
+ */
+
+#ifndef TIADC_DSP_DITHER_H
+#define TIADC_DSP_DITHER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include "lru_cache.h"
+
+namespace tiadc_dsp {
+
+struct rc_dither {
+    double period;
+    double tau;
+    double amplitude = 2.0;
+    double t_start = 0.0;
+    double phase = 0.0;                 // radians of one 2 period cycle
+    unsigned periods = 1;               // 0 = free running
+};
+
+double rc_dither_value(const rc_dither &d, double t);
+
+/* out[points] at points evenly spaced over [t0, t1], both ends included (MATLAB linspace) */
+void rc_dither_sample(const rc_dither &d, double t0, double t1, size_t points, double *out);
+
+/* out[n] at t0 + i / fs: one exp per block of samples, the rest multiplies */
+void rc_dither_render(const rc_dither &d, double fs, double t0, size_t n, double *out);
+
+/* v[n] scaled by codes_per_unit, rounded and saturated to int16 */
+void dither_to_codes(const double *v, size_t n, double codes_per_unit, int16_t *out);
+
+/* rc_dither_render as int16 codes, in chunks: DAC codes, or the ADC codes the
+ * dither shows up as in a capture */
+void rc_dither_codes(const rc_dither &d, double fs, double t0, size_t n, double codes_per_unit, int16_t *out);
+
+/* Memoised rc_dither_render: the ideal per-sample reference of one capture
+ * record, computed once per (dither, fs, t0, n) and then shared by every
+ * caller, until the byte budget evicts it */
+std::shared_ptr<const std::vector<double>> rc_dither_reference(const rc_dither &d, double fs, double t0, size_t n);
+
+void set_dither_cache_budget(size_t bytes);
+cache_stats dither_cache_stats();
+
+} // namespace tiadc_dsp
+
+#endif /* TIADC_DSP_DITHER_H */
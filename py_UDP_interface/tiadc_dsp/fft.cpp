@@ -0,0 +1,96 @@
+#include "fft.h"
+
+#include <cmath>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+
+namespace tiadc_dsp {
+
+bool is_pow2(size_t n)
+{
+    return n && !(n & (n - 1));
+}
+
+fft_plan::fft_plan(size_t n) : n_(n)
+{
+    if (n < 4 || !is_pow2(n)) throw std::invalid_argument("fft: length " + std::to_string(n) + " is not a power of two >= 4");
+
+    size_t h = n / 2;
+    unsigned bits = 0;
+    while ((size_t(1) << bits) < h) bits++;
+
+    bitrev_.resize(h);
+    for (size_t i = 0; i < h; i++) {
+        unsigned r = 0;
+        for (unsigned b = 0; b < bits; b++) r |= ((i >> b) & 1u) << (bits - 1 - b);
+        bitrev_[i] = r;
+    }
+    twiddle_.resize(h / 2 ? h / 2 : 1);
+    for (size_t k = 0; k < twiddle_.size(); k++) twiddle_[k] = std::polar(1.0, -2.0 * M_PI * (double)k / (double)h);
+    post_.resize(h + 1);
+    for (size_t k = 0; k <= h; k++) post_[k] = std::polar(1.0, -2.0 * M_PI * (double)k / (double)n);
+}
+
+/* In-place iterative radix-2, input in natural order */
+void fft_plan::complex_fft(cplx *z) const
+{
+    size_t h = n_ / 2;
+
+    for (size_t i = 0; i < h; i++) {
+        size_t r = bitrev_[i];
+        if (r > i) std::swap(z[i], z[r]);
+    }
+    for (size_t len = 2; len <= h; len <<= 1) {
+        size_t half = len / 2, stride = h / len;
+        for (size_t base = 0; base < h; base += len) {
+            for (size_t j = 0; j < half; j++) {
+                cplx t = z[base + j + half] * twiddle_[j * stride];
+                z[base + j + half] = z[base + j] - t;
+                z[base + j] += t;
+            }
+        }
+    }
+}
+
+/*
+ * Pack the even / odd samples as one complex sequence of length n/2,
+ * transform it, then split: X[k] = E[k] + W^k O[k], where
+ * E[k] = (Z[k] + conj Z[h-k]) / 2 and O[k] = (Z[k] - conj Z[h-k]) / 2i.
+ */
+void fft_plan::forward(const double *x, cplx *X, cplx *z) const
+{
+    size_t h = n_ / 2;
+
+    for (size_t i = 0; i < h; i++) z[i] = cplx(x[2 * i], x[2 * i + 1]);
+    complex_fft(z);
+
+    for (size_t k = 0; k <= h; k++) {
+        cplx a = z[k % h], b = std::conj(z[(h - k) % h]);
+        cplx e = 0.5 * (a + b);
+        cplx o = cplx(0.0, -0.5) * (a - b);
+        X[k] = e + post_[k] * o;
+    }
+}
+
+const fft_plan &plan_for(size_t n)
+{
+    static std::mutex lock;
+    static std::map<size_t, std::unique_ptr<fft_plan>> plans;
+
+    std::lock_guard<std::mutex> guard(lock);
+    std::unique_ptr<fft_plan> &p = plans[n];
+    if (!p) {
+        try {
+            p.reset(new fft_plan(n));
+        } catch (...) {
+            plans.erase(n);
+            throw;
+        }
+    }
+    return *p;
+}
+
+} // namespace tiadc_dsp
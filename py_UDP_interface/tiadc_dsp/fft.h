@@ -0,0 +1,49 @@
+/* fft.h
+ * Real-input FFT with cached plans.
+ *
+ * A plan holds everything that depends only on the length: the bit-reversal
+ * permutation, the twiddles of the half-length complex FFT and the post-
+ * processing twiddles that turn it into an N-point real FFT.  Plans are
+ * built once per length and shared, immutable, by every thread; callers
+ * bring their own scratch, so one plan serves a whole batch in parallel.
+ *
+ * Lengths must be powers of two (>= 4).
+ */
+
+#ifndef TIADC_DSP_FFT_H
+#define TIADC_DSP_FFT_H
+
+#include <complex>
+#include <cstddef>
+#include <vector>
+
+namespace tiadc_dsp {
+
+using cplx = std::complex<double>;
+
+class fft_plan {
+public:
+    explicit fft_plan(size_t n);
+
+    size_t size() const { return n_; }
+
+    /* X[0..n/2] of the real sequence x[0..n-1]; scratch must hold n/2 values */
+    void forward(const double *x, cplx *X, cplx *scratch) const;
+
+private:
+    void complex_fft(cplx *z) const;
+
+    size_t n_;
+    std::vector<unsigned> bitrev_;      // n/2-point permutation
+    std::vector<cplx> twiddle_;         // exp(-2 pi i k / (n/2)), k < n/4
+    std::vector<cplx> post_;            // exp(-2 pi i k / n), k <= n/2
+};
+
+/* Shared plan for length n, built on first use; throws std::invalid_argument */
+const fft_plan &plan_for(size_t n);
+
+bool is_pow2(size_t n);
+
+} // namespace tiadc_dsp
+
+#endif /* TIADC_DSP_FFT_H */
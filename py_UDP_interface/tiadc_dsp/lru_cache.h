@@ -0,0 +1,110 @@
+/* lru_cache.h
+ * Byte-budgeted LRU map from a string key to an immutable shared value.
+ *
+ * Thread-safe.  Values go in and come out as shared_ptr<const V>, so an
+ * eviction never pulls data from under a caller still holding it; the
+ * budget counts what the caller says an entry costs.
+ */
+
+#ifndef TIADC_DSP_LRU_CACHE_H
+#define TIADC_DSP_LRU_CACHE_H
+
+#include <cstddef>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+namespace tiadc_dsp {
+
+struct cache_stats {
+    size_t entries, bytes, budget;
+    size_t hits, misses, evictions;
+};
+
+template <typename V> class lru_cache {
+public:
+    explicit lru_cache(size_t budget_bytes) : budget_(budget_bytes) {}
+
+    /* Entry for key, now most recent; nullptr on a miss */
+    std::shared_ptr<const V> get(const std::string &key)
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        auto it = index_.find(key);
+        if (it == index_.end()) {
+            misses_++;
+            return nullptr;
+        }
+        hits_++;
+        order_.splice(order_.begin(), order_, it->second);
+        return it->second->value;
+    }
+
+    /* Insert or replace; entries larger than the whole budget are not kept */
+    void put(const std::string &key, std::shared_ptr<const V> value, size_t bytes)
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        auto it = index_.find(key);
+        if (it != index_.end()) {
+            bytes_ -= it->second->bytes;
+            order_.erase(it->second);
+            index_.erase(it);
+        }
+        if (bytes > budget_) return;
+        order_.push_front(entry{ key, std::move(value), bytes });
+        index_[key] = order_.begin();
+        bytes_ += bytes;
+        trim();
+    }
+
+    /* New budget; shrinking evicts least recently used entries until it fits */
+    void set_budget(size_t budget_bytes)
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        budget_ = budget_bytes;
+        trim();
+    }
+
+    void clear()
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        order_.clear();
+        index_.clear();
+        bytes_ = 0;
+    }
+
+    cache_stats stats() const
+    {
+        std::lock_guard<std::mutex> guard(lock_);
+        return cache_stats{ index_.size(), bytes_, budget_, hits_, misses_, evictions_ };
+    }
+
+private:
+    void trim()
+    {
+        while (bytes_ > budget_) {
+            const entry &old = order_.back();
+            bytes_ -= old.bytes;
+            index_.erase(old.key);
+            order_.pop_back();
+            evictions_++;
+        }
+    }
+
+    struct entry {
+        std::string key;
+        std::shared_ptr<const V> value;
+        size_t bytes;
+    };
+
+    mutable std::mutex lock_;
+    std::list<entry> order_;            // front = most recently used
+    std::unordered_map<std::string, typename std::list<entry>::iterator> index_;
+    size_t budget_, bytes_ = 0;
+    size_t hits_ = 0, misses_ = 0, evictions_ = 0;
+};
+
+} // namespace tiadc_dsp
+
+#endif /* TIADC_DSP_LRU_CACHE_H */
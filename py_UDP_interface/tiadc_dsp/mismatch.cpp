@@ -0,0 +1,635 @@
+#include "mismatch.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "fft.h"
+
+namespace tiadc_dsp {
+
+const char *const mismatch_field_names[NUM_MISMATCH_FIELDS] = {
+    "skew_ps", "gain", "offset_a", "offset_b", "skew_ci_ps", "gain_ci", "offset_ci", "tone_hz", "residual_rms",
+    "segments",
+};
+
+static constexpr double NaN = std::numeric_limits<double>::quiet_NaN();
+
+namespace {
+
+struct channel {
+    const int16_t *p;
+    double sign;
+    double operator[](size_t i) const { return sign * p[i]; }
+};
+
+struct piece {
+    size_t first, last;
+    size_t size() const { return last - first; }
+};
+
+/* Per-piece values of one quantity, for the bounds */
+struct spread {
+    std::vector<double> skew_ps, gain, offset_diff;
+
+    void add(double skew, double g, double doff)
+    {
+        skew_ps.push_back(skew);
+        gain.push_back(g);
+        offset_diff.push_back(doff);
+    }
+};
+
+/* Records, or the contiguous buffers cut into opt.segments pieces (remainder to the last) */
+std::vector<piece> split(size_t n, const mismatch_options &opt)
+{
+    std::vector<piece> out;
+    if (opt.record_len) {
+        for (size_t f = 0; f + opt.record_len <= n; f += opt.record_len) out.push_back({ f, f + opt.record_len });
+    } else {
+        size_t k = std::max(1u, opt.segments), len = n / k;
+        for (size_t s = 0; s < k; s++) out.push_back({ s * len, s + 1 == k ? n : (s + 1) * len });
+    }
+    return out;
+}
+
+/* 95 % half-width of the mean of the finite values */
+double ci95(const std::vector<double> &v)
+{
+    double sum = 0.0, sq = 0.0;
+    size_t k = 0;
+    for (double x : v) {
+        if (std::isfinite(x)) {
+            sum += x;
+            k++;
+        }
+    }
+    if (k < 2) return NaN;
+    double mean = sum / (double)k;
+    for (double x : v) {
+        if (std::isfinite(x)) sq += (x - mean) * (x - mean);
+    }
+    return 1.96 * std::sqrt(sq / (double)(k - 1) / (double)k);
+}
+
+double mean_of(const std::vector<double> &v)
+{
+    double sum = 0.0;
+    size_t k = 0;
+    for (double x : v) {
+        if (std::isfinite(x)) {
+            sum += x;
+            k++;
+        }
+    }
+    return k ? sum / (double)k : NaN;
+}
+
+void set_bounds(mismatch_estimate &e, const spread &s)
+{
+    e.skew_ci_ps = ci95(s.skew_ps);
+    e.gain_ci = ci95(s.gain);
+    e.offset_ci = ci95(s.offset_diff);
+    e.segments = (double)s.gain.size();
+}
+
+mismatch_estimate blank()
+{
+    mismatch_estimate e;
+    e.skew_ps = e.gain = e.offset_a = e.offset_b = NaN;
+    e.skew_ci_ps = e.gain_ci = e.offset_ci = NaN;
+    e.tone_hz = e.residual_rms = e.segments = NaN;
+    return e;
+}
+
+size_t leading_pow2(size_t n)
+{
+    size_t p = 1;
+    while (p * 2 <= n) p *= 2;
+    return p;
+}
+
+/* ---------------------------------------------------------------------- */
+/*  Least squares on a few columns, by normal equations                    */
+/* ---------------------------------------------------------------------- */
+struct normal_eq {
+    double S[4][4] = {};                // upper triangle only until solve()
+    double r[4] = {};
+    double yy = 0.0;
+    size_t n = 0;
+
+    void add(const double *col, unsigned k, double y)
+    {
+        for (unsigned i = 0; i < k; i++) {
+            for (unsigned j = i; j < k; j++) S[i][j] += col[i] * col[j];
+            r[i] += col[i] * y;
+        }
+        yy += y * y;
+        n++;
+    }
+
+    void merge(const normal_eq &o)
+    {
+        for (unsigned i = 0; i < 4; i++) {
+            for (unsigned j = 0; j < 4; j++) S[i][j] += o.S[i][j];
+            r[i] += o.r[i];
+        }
+        yy += o.yy;
+        n += o.n;
+    }
+
+    /* Gaussian elimination with partial pivoting; false when singular */
+    bool solve(unsigned k, double *p) const
+    {
+        double A[4][5];
+        for (unsigned i = 0; i < k; i++) {
+            for (unsigned j = 0; j < k; j++) A[i][j] = i <= j ? S[i][j] : S[j][i];
+            A[i][k] = r[i];
+        }
+        for (unsigned c = 0; c < k; c++) {
+            unsigned piv = c;
+            for (unsigned i = c + 1; i < k; i++) {
+                if (std::fabs(A[i][c]) > std::fabs(A[piv][c])) piv = i;
+            }
+            if (!(std::fabs(A[piv][c]) > 0.0)) return false;
+            for (unsigned j = 0; j <= k; j++) std::swap(A[c][j], A[piv][j]);
+            for (unsigned i = c + 1; i < k; i++) {
+                double f = A[i][c] / A[c][c];
+                for (unsigned j = c; j <= k; j++) A[i][j] -= f * A[c][j];
+            }
+        }
+        for (unsigned i = k; i-- > 0;) {
+            double v = A[i][k];
+            for (unsigned j = i + 1; j < k; j++) v -= A[i][j] * p[j];
+            p[i] = v / A[i][i];
+        }
+        return true;
+    }
+
+    /* Sum of squared residuals at p */
+    double residual(unsigned k, const double *p) const
+    {
+        double v = yy;
+        for (unsigned i = 0; i < k; i++) {
+            v -= 2.0 * p[i] * r[i];
+            for (unsigned j = 0; j < k; j++) v += p[i] * (i <= j ? S[i][j] : S[j][i]) * p[j];
+        }
+        return std::max(0.0, v);
+    }
+};
+
+/*
+ * f(j, cos w t, sin w t) over t = t0 + j / fs, j < len: a rotation per
+ * sample, re-anchored exactly every 256 samples.
+ */
+template <typename F> void for_each_phase(double w, double t0, double fs, size_t len, F f)
+{
+    const double cs = std::cos(w / fs), sn = std::sin(w / fs);
+    for (size_t j0 = 0; j0 < len; j0 += 256) {
+        double ph = w * (t0 + (double)j0 / fs), c = std::cos(ph), s = std::sin(ph);
+        size_t end = std::min(len, j0 + 256);
+        for (size_t j = j0; j < end; j++) {
+            f(j, c, s);
+            double c2 = c * cs - s * sn;
+            s = s * cs + c * sn;
+            c = c2;
+        }
+    }
+}
+
+/* ---------------------------------------------------------------------- */
+/*  Sine fit                                                               */
+/* ---------------------------------------------------------------------- */
+struct sine {
+    double amp, phase, offset;          // amp cos(w t + phase) + offset
+};
+
+/* Three-parameter fit (cos, sin, 1) at a known w; the hot loop, so the sums are kept in registers */
+void fit3(const channel &x, piece pc, double w, double fs, double t0, normal_eq &eq)
+{
+    double cc = 0, cs = 0, c1 = 0, ss = 0, s1 = 0, cy = 0, sy = 0, y1 = 0, yy = 0;
+    const int16_t *p = x.p + pc.first;
+
+    for_each_phase(w, t0, fs, pc.size(), [&](size_t j, double c, double s) {
+        double y = p[j];
+        cc += c * c;
+        cs += c * s;
+        c1 += c;
+        ss += s * s;
+        s1 += s;
+        cy += c * y;
+        sy += s * y;
+        y1 += y;
+        yy += y * y;
+    });
+    eq.S[0][0] += cc;
+    eq.S[0][1] += cs;
+    eq.S[0][2] += c1;
+    eq.S[1][1] += ss;
+    eq.S[1][2] += s1;
+    eq.S[2][2] += (double)pc.size();
+    eq.r[0] += x.sign * cy;
+    eq.r[1] += x.sign * sy;
+    eq.r[2] += x.sign * y1;
+    eq.yy += yy;
+    eq.n += pc.size();
+}
+
+bool solve_sine(const normal_eq &eq, sine &out, double *resid = nullptr)
+{
+    double p[3];
+    if (!eq.solve(3, p)) return false;
+    out.amp = std::hypot(p[0], p[1]);
+    out.phase = std::atan2(-p[1], p[0]);
+    out.offset = p[2];
+    if (resid) *resid = eq.residual(3, p);
+    return true;
+}
+
+/* Tone frequency from the interpolated FFT peak of the first len samples (both channels when interleaved) */
+double coarse_tone(const channel &a, const channel &b, size_t len, const mismatch_options &opt)
+{
+    double rate = opt.interleaved ? 2.0 * opt.fs : opt.fs;
+    size_t total = opt.interleaved ? 2 * len : len, n = std::min<size_t>(leading_pow2(total), 65536);
+    if (n < 16) throw std::invalid_argument("mismatch: need at least 16 samples to find the tone");
+
+    std::vector<double> x(n);
+    double mean = 0.0;
+    for (size_t i = 0; i < n; i++) {
+        x[i] = opt.interleaved ? ((i & 1) ? b[i / 2] : a[i / 2]) : a[i];
+        mean += x[i];
+    }
+    mean /= (double)n;
+    for (size_t i = 0; i < n; i++) x[i] = (x[i] - mean) * (0.5 - 0.5 * std::cos(2.0 * M_PI * (double)i / (double)n));
+
+    std::vector<cplx> X(n / 2 + 1), z(n / 2);
+    plan_for(n).forward(x.data(), X.data(), z.data());
+    size_t k0 = 2;
+    for (size_t k = 2; k < n / 2; k++) {
+        if (std::norm(X[k]) > std::norm(X[k0])) k0 = k;
+    }
+    double lm = std::log(std::abs(X[k0 - 1]) + 1e-30), l0 = std::log(std::abs(X[k0]) + 1e-30),
+           lp = std::log(std::abs(X[k0 + 1]) + 1e-30), den = lm - 2.0 * l0 + lp;
+    double d = den != 0.0 ? 0.5 * (lm - lp) / den : 0.0;
+    return ((double)k0 + std::max(-0.5, std::min(0.5, d))) * rate / (double)n;
+}
+
+/*
+ * Four-parameter (IEEE 1057) Gauss-Newton steps on channel A.  The
+ * frequency column is written against centred, normalised time so the
+ * normal equations stay well conditioned over a million samples.
+ */
+double refine_tone(const channel &a, size_t len, double fs, double w, unsigned iterations)
+{
+    piece pc{ 0, len };
+    double half = 0.5 * (double)len;
+
+    for (unsigned it = 0; it < iterations; it++) {
+        normal_eq e3;
+        fit3(a, pc, w, fs, 0.0, e3);
+        double p3[3];
+        if (!e3.solve(3, p3)) break;
+
+        /* Only the frequency column is new: the other nine sums are e3's */
+        double dc = 0, ds = 0, d1 = 0, dd = 0, dy = 0;
+        const double inv_len = 1.0 / (double)len;
+        for_each_phase(w, 0.0, fs, len, [&](size_t j, double c, double s) {
+            double d = ((double)j - half) * inv_len * (p3[1] * c - p3[0] * s), y = a.p[j];
+            dc += d * c;
+            ds += d * s;
+            d1 += d;
+            dd += d * d;
+            dy += d * y;
+        });
+        normal_eq e4 = e3;
+        e4.S[0][3] = dc;
+        e4.S[1][3] = ds;
+        e4.S[2][3] = d1;
+        e4.S[3][3] = dd;
+        e4.r[3] = a.sign * dy;
+        double p4[4];
+        if (!e4.solve(4, p4)) break;
+        double dw = p4[3] * fs / (double)len;
+        w += dw;
+        if (std::fabs(dw) * (double)len / fs < 1e-6) break;
+    }
+    return w;
+}
+
+mismatch_estimate sine_fit(const channel &a, const channel &b, size_t n, const mismatch_options &opt,
+                           const std::vector<piece> &pieces)
+{
+    const double fs = opt.fs, off = opt.interleaved ? 0.5 / fs : 0.0;
+    const size_t first_len = opt.record_len ? opt.record_len : n;
+
+    double w = 2.0 * M_PI * opt.tone_hz;
+    if (opt.tone_hz <= 0.0) {
+        w = 2.0 * M_PI * coarse_tone(a, b, first_len, opt);
+        /* 64 k samples pin w far below what moves the A/B phase difference; more only costs time */
+        w = refine_tone(a, std::min<size_t>(first_len, 65536), fs, w, 4);
+    }
+
+    mismatch_estimate e = blank();
+    normal_eq total_a, total_b;
+    spread sp;
+    std::vector<double> offs_a, offs_b;
+    double resid = 0.0;
+    size_t resid_n = 0;
+
+    for (const piece &pc : pieces) {
+        double t0 = opt.record_len ? 0.0 : (double)pc.first / fs, ra = 0.0, rb = 0.0;
+        normal_eq ea, eb;
+        fit3(a, pc, w, fs, t0, ea);
+        fit3(b, pc, w, fs, t0 + off, eb);
+        total_a.merge(ea);
+        total_b.merge(eb);
+
+        sine sa, sb;
+        if (!solve_sine(ea, sa, &ra) || !solve_sine(eb, sb, &rb) || sa.amp <= 0.0) {
+            sp.add(NaN, NaN, NaN);
+            offs_a.push_back(NaN);
+            offs_b.push_back(NaN);
+            continue;
+        }
+        sp.add(std::remainder(sa.phase - sb.phase, 2.0 * M_PI) / w * 1e12, sb.amp / sa.amp, sb.offset - sa.offset);
+        offs_a.push_back(sa.offset);
+        offs_b.push_back(sb.offset);
+        resid += ra + rb;
+        resid_n += 2 * pc.size();
+    }
+
+    if (opt.record_len) {
+        /* Records are separate captures with their own phase: average them */
+        e.skew_ps = mean_of(sp.skew_ps);
+        e.gain = mean_of(sp.gain);
+        e.offset_a = mean_of(offs_a);
+        e.offset_b = mean_of(offs_b);
+    } else {
+        /* Pieces share one time base, so their normal equations add up to the whole-buffer fit */
+        sine sa, sb;
+        if (solve_sine(total_a, sa) && solve_sine(total_b, sb) && sa.amp > 0.0) {
+            e.skew_ps = std::remainder(sa.phase - sb.phase, 2.0 * M_PI) / w * 1e12;
+            e.gain = sb.amp / sa.amp;
+            e.offset_a = sa.offset;
+            e.offset_b = sb.offset;
+        }
+    }
+    e.tone_hz = w / (2.0 * M_PI);
+    e.residual_rms = resid_n ? std::sqrt(resid / (double)resid_n) : NaN;
+    set_bounds(e, sp);
+    return e;
+}
+
+/* ---------------------------------------------------------------------- */
+/*  Cross spectrum                                                         */
+/* ---------------------------------------------------------------------- */
+struct cross_spectra {
+    std::vector<cplx> ab;               // sum B conj(A)
+    std::vector<double> aa, bb;
+    double sum_a = 0.0, sum_b = 0.0;
+    size_t count = 0;
+
+    explicit cross_spectra(size_t bins) : ab(bins), aa(bins), bb(bins) {}
+
+    void merge(const cross_spectra &o)
+    {
+        for (size_t k = 0; k < ab.size(); k++) {
+            ab[k] += o.ab[k];
+            aa[k] += o.aa[k];
+            bb[k] += o.bb[k];
+        }
+        sum_a += o.sum_a;
+        sum_b += o.sum_b;
+        count += o.count;
+    }
+};
+
+/* Skew from the phase slope and gain from |S_ab| / S_aa over the coherent bins (DC lobe left out) */
+void from_cross(const cross_spectra &s, size_t block, const mismatch_options &opt, double &skew_ps, double &gain)
+{
+    const double off = opt.interleaved ? 0.5 / opt.fs : 0.0;
+    double num = 0.0, den = 0.0, mag = 0.0, pa = 0.0;
+
+    for (size_t k = 3; k + 1 < s.ab.size(); k++) {
+        double cross = std::abs(s.ab[k]);
+        if (!(s.aa[k] > 0.0 && s.bb[k] > 0.0) || cross * cross < 0.5 * s.aa[k] * s.bb[k]) continue;
+        double w = 2.0 * M_PI * (double)k * opt.fs / (double)block;
+        double theta = std::arg(s.ab[k] * std::polar(1.0, -w * off));
+        num += cross * theta * w;
+        den += cross * w * w;
+        mag += cross;
+        pa += s.aa[k];
+    }
+    skew_ps = den > 0.0 ? -num / den * 1e12 : NaN;
+    gain = pa > 0.0 ? mag / pa : NaN;
+}
+
+mismatch_estimate xcorr(const channel &a, const channel &b, size_t n, const mismatch_options &opt,
+                        const std::vector<piece> &pieces)
+{
+    size_t block = opt.record_len ? leading_pow2(opt.record_len)
+                                  : std::min<size_t>(4096, leading_pow2(n / std::max(1u, opt.segments)));
+    if (block < 32) throw std::invalid_argument("mismatch: xcorr needs blocks of at least 32 samples");
+
+    const fft_plan &plan = plan_for(block);
+    const size_t bins = block / 2 + 1;
+    std::vector<double> win(block), xa(block), xb(block);
+    for (size_t i = 0; i < block; i++) win[i] = 0.5 - 0.5 * std::cos(2.0 * M_PI * (double)i / (double)block);
+    std::vector<cplx> XA(bins), XB(bins), z(block / 2);
+
+    mismatch_estimate e = blank();
+    cross_spectra total(bins);
+    spread sp;
+
+    for (const piece &pc : pieces) {
+        cross_spectra s(bins);
+        for (size_t i = pc.first; i < pc.last; i++) {
+            s.sum_a += a[i];
+            s.sum_b += b[i];
+        }
+        s.count = pc.size();
+        for (size_t f = pc.first; f + block <= pc.last; f += block) {
+            for (size_t i = 0; i < block; i++) {
+                xa[i] = a[f + i] * win[i];
+                xb[i] = b[f + i] * win[i];
+            }
+            plan.forward(xa.data(), XA.data(), z.data());
+            plan.forward(xb.data(), XB.data(), z.data());
+            for (size_t k = 0; k < bins; k++) {
+                s.ab[k] += XB[k] * std::conj(XA[k]);
+                s.aa[k] += std::norm(XA[k]);
+                s.bb[k] += std::norm(XB[k]);
+            }
+        }
+        double skew, gain;
+        from_cross(s, block, opt, skew, gain);
+        sp.add(skew, gain, (s.sum_b - s.sum_a) / (double)s.count);
+        total.merge(s);
+    }
+
+    from_cross(total, block, opt, e.skew_ps, e.gain);
+    e.offset_a = total.sum_a / (double)total.count;
+    e.offset_b = total.sum_b / (double)total.count;
+    set_bounds(e, sp);
+    return e;
+}
+
+/* ---------------------------------------------------------------------- */
+/*  Dither folding                                                         */
+/* ---------------------------------------------------------------------- */
+struct folded {
+    std::vector<double> sum_a, sum_b;
+    std::vector<uint32_t> cnt_a, cnt_b;
+
+    explicit folded(size_t g) : sum_a(g), sum_b(g), cnt_a(g), cnt_b(g) {}
+
+    void merge(const folded &o)
+    {
+        for (size_t g = 0; g < sum_a.size(); g++) {
+            sum_a[g] += o.sum_a[g];
+            sum_b[g] += o.sum_b[g];
+            cnt_a[g] += o.cnt_a[g];
+            cnt_b[g] += o.cnt_b[g];
+        }
+    }
+};
+
+/* Add samples [pc) to the grid, at dither phase (i / fs + t_off) / period */
+void fold(const channel &x, piece pc, const mismatch_options &opt, double t_off, std::vector<double> &sum,
+          std::vector<uint32_t> &cnt)
+{
+    const size_t G = sum.size();
+    const double step = 1.0 / (opt.fs * opt.dither_period_s);
+
+    for (size_t i0 = pc.first; i0 < pc.last; i0 += 4096) {
+        double ph = std::fmod(((double)i0 / opt.fs + t_off) / opt.dither_period_s, 1.0);
+        size_t end = std::min(pc.last, i0 + 4096);
+        for (size_t i = i0; i < end; i++) {
+            size_t g = std::min(G - 1, (size_t)(ph * (double)G));
+            sum[g] += x[i];
+            cnt[g]++;
+            ph += step;
+            ph -= std::floor(ph);
+        }
+    }
+}
+
+/* Mean per bin, empty bins filled circularly from their neighbours; false when too many are empty */
+bool wave_of(const std::vector<double> &sum, const std::vector<uint32_t> &cnt, std::vector<double> &wave)
+{
+    const size_t G = sum.size();
+    size_t empty = 0;
+    wave.assign(G, NaN);
+    for (size_t g = 0; g < G; g++) {
+        if (cnt[g]) wave[g] = sum[g] / cnt[g];
+        else empty++;
+    }
+    if (empty * 4 > G) return false;
+    for (size_t g = 0; g < G && empty; g++) {
+        if (!std::isnan(wave[g])) continue;
+        size_t lo = 1, hi = 1;
+        while (std::isnan(wave[(g + G - lo) % G])) lo++;
+        while (std::isnan(wave[(g + hi) % G])) hi++;
+        wave[g] = (wave[(g + G - lo) % G] * (double)hi + wave[(g + hi) % G] * (double)lo) / (double)(lo + hi);
+    }
+    return true;
+}
+
+/* Floor (mean of the lowest quarter) and interpolated peak height of a folded dither */
+void floor_and_peak(const std::vector<double> &wave, double &floor_level, double &peak)
+{
+    const size_t G = wave.size();
+    std::vector<double> sorted(wave);
+    std::nth_element(sorted.begin(), sorted.begin() + G / 4, sorted.end());
+    floor_level = 0.0;
+    for (size_t g = 0; g < G / 4; g++) floor_level += sorted[g];
+    floor_level /= (double)(G / 4);
+
+    size_t k = (size_t)(std::max_element(wave.begin(), wave.end()) - wave.begin());
+    double vm = wave[(k + G - 1) % G], v0 = wave[k], vp = wave[(k + 1) % G], den = vm - 2.0 * v0 + vp;
+    peak = den < 0.0 ? v0 - (vm - vp) * (vm - vp) / (8.0 * den) : v0;
+}
+
+bool from_folded(const folded &f, const mismatch_options &opt, double &skew_ps, double &gain, double &floor_a,
+                 double &floor_b)
+{
+    const size_t G = f.sum_a.size();
+    std::vector<double> wa, wb;
+    if (!wave_of(f.sum_a, f.cnt_a, wa) || !wave_of(f.sum_b, f.cnt_b, wb)) return false;
+
+    double peak_a, peak_b;
+    floor_and_peak(wa, floor_a, peak_a);
+    floor_and_peak(wb, floor_b, peak_b);
+    gain = peak_a > floor_a ? (peak_b - floor_b) / (peak_a - floor_a) : NaN;
+
+    /* B's folded dither is A's delayed by the skew: the harmonics' phases fall by 2 pi m skew / period */
+    double num = 0.0, den = 0.0;
+    for (unsigned m = 1; m <= 8 && m < G / 2; m++) {
+        cplx ca = 0.0, cb = 0.0;
+        for (size_t g = 0; g < G; g++) {
+            cplx r = std::polar(1.0, -2.0 * M_PI * (double)m * ((double)g + 0.5) / (double)G);
+            ca += wa[g] * r;
+            cb += wb[g] * r;
+        }
+        double wgt = std::abs(ca) * std::abs(cb);
+        num += wgt * m * std::arg(cb * std::conj(ca));
+        den += wgt * m * m;
+    }
+    skew_ps = den > 0.0 ? -num / den * opt.dither_period_s / (2.0 * M_PI) * 1e12 : NaN;
+    return true;
+}
+
+mismatch_estimate dither(const channel &a, const channel &b, size_t n, const mismatch_options &opt,
+                         const std::vector<piece> &pieces)
+{
+    if (opt.record_len) throw std::invalid_argument("mismatch: dither needs one contiguous record");
+    if (!(opt.dither_period_s > 0.0)) throw std::invalid_argument("mismatch: dither needs dither_period_s");
+
+    /* About 32 samples per grid bin in each piece */
+    size_t G = 64;
+    while (G < 4096 && G * 2 * 32 * pieces.size() <= n) G *= 2;
+
+    const double off = opt.interleaved ? 0.5 / opt.fs : 0.0;
+    mismatch_estimate e = blank();
+    folded total(G);
+    spread sp;
+
+    for (const piece &pc : pieces) {
+        folded f(G);
+        fold(a, pc, opt, 0.0, f.sum_a, f.cnt_a);
+        fold(b, pc, opt, off, f.sum_b, f.cnt_b);
+        double skew, gain, fa, fb;
+        if (from_folded(f, opt, skew, gain, fa, fb)) sp.add(skew, gain, fb - fa);
+        else sp.add(NaN, NaN, NaN);
+        total.merge(f);
+    }
+
+    if (!from_folded(total, opt, e.skew_ps, e.gain, e.offset_a, e.offset_b))
+        throw std::invalid_argument("mismatch: samples do not cover the dither period (commensurate with fs?)");
+    e.tone_hz = 1.0 / opt.dither_period_s;
+    set_bounds(e, sp);
+    return e;
+}
+
+} // namespace
+
+mismatch_estimate estimate_mismatch(const int16_t *a, const int16_t *b, size_t n, const mismatch_options &opt)
+{
+    if (!(opt.fs > 0.0)) throw std::invalid_argument("mismatch: fs must be positive");
+    if (opt.record_len > n) throw std::invalid_argument("mismatch: record_len longer than the buffers");
+    std::vector<piece> pieces = split(n, opt);
+    if (pieces.empty() || pieces[0].size() < 16)
+        throw std::invalid_argument("mismatch: pieces shorter than 16 samples (fewer segments or longer records)");
+
+    channel ca{ a, opt.invert_a ? -1.0 : 1.0 }, cb{ b, opt.invert_b ? -1.0 : 1.0 };
+    switch (opt.method) {
+    case mismatch_method::sine_fit: return sine_fit(ca, cb, n, opt, pieces);
+    case mismatch_method::xcorr: return xcorr(ca, cb, n, opt, pieces);
+    case mismatch_method::dither: return dither(ca, cb, n, opt, pieces);
+    }
+    throw std::invalid_argument("mismatch: unknown method");
+}
+
+} // namespace tiadc_dsp
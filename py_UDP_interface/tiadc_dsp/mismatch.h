@@ -0,0 +1,77 @@
+/* mismatch.h
+ * Timing skew, gain and offset of channel B against channel A, from the
+ * de-interleaved sample buffers of the two channels.
+ *
+ * Three estimators:
+ *   sine_fit  one input tone.  The frequency is found (FFT peak, then a
+ *             four-parameter Gauss-Newton fit on the first 64 k samples of
+ *             A) unless given, then both channels get a three-parameter fit
+ *             at that frequency, each on its own time base.  Skew is the
+ *             phase difference over w.
+ *             Channels see the tone at its true frequency: pass tone_hz
+ *             when the tone sits above the first Nyquist zone of a channel
+ *             and the channels are not interleaved.
+ *   xcorr     any signal within the first Nyquist zone of a channel.  The
+ *             cross spectrum of A and B over Hann-windowed blocks gives the
+ *             skew as the slope of its phase against frequency, and the gain
+ *             as |S_ab| / S_aa, both over the coherent bins only.
+ *   dither    the calibration dither alone (input off).  Both channels are
+ *             folded onto one dither period (equivalent-time sampling), the
+ *             skew comes from the phase slope over the first harmonics of the
+ *             folded waveforms, the gain from the peak heights above the
+ *             floor, and the offset is the floor itself (the dither idles
+ *             at 0).  Needs one contiguous record.
+ *
+ * B's nominal sampling instant is A's (two channels on one clock, as on the
+ * board) or half a sample period later (2x time-interleaved).  skew_ps is
+ * how far B's samples lag that nominal instant's signal, the convention of
+ * delay_sweep.py: positive when B sees the input late.
+ *
+ * Confidence bounds are 95 % half-widths from the spread of the estimate
+ * over segments of the buffers (or over the records), normal approximation.
+ */
+
+#ifndef TIADC_DSP_MISMATCH_H
+#define TIADC_DSP_MISMATCH_H
+
+#include <cstddef>
+#include <cstdint>
+
+namespace tiadc_dsp {
+
+enum class mismatch_method { sine_fit, xcorr, dither };
+
+struct mismatch_options {
+    mismatch_method method = mismatch_method::sine_fit;
+    double fs = 500e6;                  // per-channel sample rate
+    bool interleaved = false;           // B nominally half a period after A, else simultaneous
+    size_t record_len = 0;              // > 0: the buffers hold independent records (captures) of this length
+    unsigned segments = 16;             // contiguous buffers: pieces for the confidence bounds
+    double tone_hz = 0.0;               // sine_fit: true input frequency, 0 = find it
+    double dither_period_s = 0.0;       // dither: period of the injected dither
+    bool invert_a = false;              // sign-flip a channel first (INVERT_MASK)
+    bool invert_b = false;
+};
+
+struct mismatch_estimate {              // NaN where a quantity does not apply
+    double skew_ps;
+    double gain;                        // B / A
+    double offset_a;                    // LSB
+    double offset_b;
+    double skew_ci_ps;                  // 95 % half-widths
+    double gain_ci;
+    double offset_ci;                   // of offset_b - offset_a
+    double tone_hz;                     // sine_fit: fitted tone; dither: 1 / period
+    double residual_rms;                // sine_fit: rms fit residual of A and B, LSB
+    double segments;                    // segments (or records) behind the bounds
+};
+
+static constexpr size_t NUM_MISMATCH_FIELDS = sizeof(mismatch_estimate) / sizeof(double);
+extern const char *const mismatch_field_names[NUM_MISMATCH_FIELDS];
+
+/* a[n], b[n]; throws std::invalid_argument on bad options or too little data */
+mismatch_estimate estimate_mismatch(const int16_t *a, const int16_t *b, size_t n, const mismatch_options &opt);
+
+} // namespace tiadc_dsp
+
+#endif /* TIADC_DSP_MISMATCH_H */
@@ -0,0 +1,261 @@
+#include "signal_model.h"
+
+#include <algorithm>
+#include <cmath>
+#include <complex>
+#include <cstring>
+#include <stdexcept>
+#include <thread>
+
+namespace tiadc_dsp {
+
+namespace {
+
+constexpr size_t SEG = 1024;                // samples per exact tone phase and per noise seed
+constexpr size_t CHUNK = 16 * SEG;          // samples per channel rendered at once by render_dma
+constexpr size_t LANES = 8;                 // independent tone phasors, for the vector units
+constexpr double ROUND = 6755399441055744.0;    // 1.5 * 2^52: (x + ROUND) - ROUND rounds x to nearest even
+
+uint64_t splitmix64(uint64_t &x)
+{
+    uint64_t z = (x += 0x9E3779B97F4A7C15ULL);
+    z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+    return z ^ (z >> 31);
+}
+
+/* Marsaglia and Tsang's ziggurat for the standard normal, 128 layers */
+struct ziggurat {
+    uint32_t kn[128];
+    double wn[128], fn[128];
+
+    ziggurat()
+    {
+        const double m1 = 2147483648.0, vn = 9.91256303526217e-3;
+        double dn = 3.442619855899, tn = dn;
+        const double q = vn / std::exp(-0.5 * dn * dn);
+        kn[0] = (uint32_t)(dn / q * m1);
+        kn[1] = 0;
+        wn[0] = q / m1;
+        wn[127] = dn / m1;
+        fn[0] = 1.0;
+        fn[127] = std::exp(-0.5 * dn * dn);
+        for (int i = 126; i >= 1; i--) {
+            dn = std::sqrt(-2.0 * std::log(vn / dn + std::exp(-0.5 * dn * dn)));
+            kn[i + 1] = (uint32_t)(dn / tn * m1);
+            tn = dn;
+            fn[i] = std::exp(-0.5 * dn * dn);
+            wn[i] = dn / m1;
+        }
+    }
+};
+
+const ziggurat &zig()
+{
+    static const ziggurat z;
+    return z;
+}
+
+/* xoshiro256+ under the ziggurat: normals for one segment of one channel */
+class gauss {
+public:
+    gauss(uint64_t seed, int ch, uint64_t seg) : z_(zig())
+    {
+        uint64_t x = seed ^ (seg * 2 + (uint64_t)ch) * 0xD1B54A32D192ED03ULL;
+        for (uint64_t &w : s_) w = splitmix64(x);
+    }
+
+    void fill(double *out, size_t n)
+    {
+        for (size_t i = 0; i < n; i += 2) {
+            uint64_t r = next();
+            out[i] = normal((int32_t)(uint32_t)r);
+            if (i + 1 < n) out[i + 1] = normal((int32_t)(uint32_t)(r >> 32));
+        }
+    }
+
+private:
+    double normal(int32_t hz)
+    {
+        for (;;) {
+            uint32_t iz = (uint32_t)hz & 127;
+            uint32_t mag = hz < 0 ? 0u - (uint32_t)hz : (uint32_t)hz;
+            if (mag < z_.kn[iz]) return (double)hz * z_.wn[iz];
+            if (iz == 0) {                  // the tail beyond the base layer
+                const double r = 3.442619855899;
+                double x, y;
+                do {
+                    x = -std::log(uniform()) / r;
+                    y = -std::log(uniform());
+                } while (y + y < x * x);
+                return hz > 0 ? r + x : -r - x;
+            }
+            double x = (double)hz * z_.wn[iz];
+            if (z_.fn[iz] + uniform() * (z_.fn[iz - 1] - z_.fn[iz]) < std::exp(-0.5 * x * x)) return x;
+            hz = (int32_t)(uint32_t)next();
+        }
+    }
+
+    double uniform() { return ((double)(next() >> 11) + 0.5) * 0x1.0p-53; }
+
+    uint64_t next()
+    {
+        uint64_t r = s_[0] + s_[3], t = s_[1] << 17;
+        s_[2] ^= s_[0];
+        s_[3] ^= s_[1];
+        s_[1] ^= s_[2];
+        s_[0] ^= s_[3];
+        s_[2] ^= t;
+        s_[3] = (s_[3] << 45) | (s_[3] >> 19);
+        return r;
+    }
+
+    const ziggurat &z_;
+    uint64_t s_[4];
+};
+
+/* 2 pi frac(x), for phases of streams many cycles long */
+double wrap_phase(long double cycles)
+{
+    return (double)(2.0L * (long double)M_PI * (cycles - std::floor(cycles)));
+}
+
+} // namespace
+
+tiadc_source::tiadc_source(const tiadc_model &m) : m_(m)
+{
+    if (!(m.fs > 0.0)) throw std::invalid_argument("signal model: fs must be positive");
+    if (m.bits < 1 || m.bits > 16) throw std::invalid_argument("signal model: bits must be 1..16");
+    if (m.jitter_s < 0.0 || m.noise < 0.0) throw std::invalid_argument("signal model: jitter and noise are rms values");
+    if (m.dither_codes != 0.0) rc_dither_value(m.dither, 0.0);  // validates the dither
+
+    for (int ch = 0; ch < 2; ch++) {
+        const channel_model &c = ch ? m.b : m.a;
+        channel_plan p;
+        p.t0 = (ch && m.interleaved ? 0.5 / m.fs : 0.0) + c.skew_s;
+        p.gain = c.gain;
+        p.offset = c.offset;
+        p.sign = c.invert ? -1.0 : 1.0;
+        for (const tone &t : m.tones) {
+            if (!(t.freq_hz >= 0.0)) throw std::invalid_argument("signal model: tone frequency must be >= 0");
+            std::complex<double> h = c.bandwidth_hz > 0.0 ? 1.0 / std::complex<double>(1.0, t.freq_hz / c.bandwidth_hz)
+                                                          : std::complex<double>(1.0);
+            p.amp.push_back(t.amplitude * std::abs(h) * c.gain);
+            p.phase.push_back(t.phase + std::arg(h));
+            p.cycles.push_back(t.freq_hz / m.fs);
+        }
+        plan_.push_back(std::move(p));
+    }
+}
+
+void tiadc_source::render_channel(int ch, uint64_t first, size_t n, int16_t *out) const
+{
+    const channel_plan &p = plan_[ch];
+    const double step = (double)(1U << (16 - m_.bits));
+    const double hi = 32768.0 - step, inv_step = 1.0 / step;
+    const bool jitter = m_.jitter_s > 0.0 && !p.amp.empty();
+    double v[SEG], d[SEG], g[SEG];
+
+    for (uint64_t seg = first / SEG; seg * SEG < first + n; seg++) {
+        const uint64_t k0 = seg * SEG;
+
+        std::fill(v, v + SEG, p.offset);
+        std::fill(d, d + SEG, 0.0);
+        for (size_t i = 0; i < p.amp.size(); i++) {
+            /* LANES phasors a sample apart, each stepped LANES samples at a time */
+            const double ph = wrap_phase((long double)p.cycles[i] * (long double)k0 +
+                                         (long double)p.t0 * (long double)p.cycles[i] * (long double)m_.fs) + p.phase[i];
+            const double w = 2.0 * M_PI * p.cycles[i];
+            const double rr = std::cos(LANES * w), ri = std::sin(LANES * w);
+            const double amp = p.amp[i], slope = amp * w * m_.fs;
+            double zr[LANES], zi[LANES];
+            for (size_t l = 0; l < LANES; l++) {
+                zr[l] = std::cos(ph + (double)l * w);
+                zi[l] = std::sin(ph + (double)l * w);
+            }
+            for (size_t j = 0; j < SEG; j += LANES) {
+                for (size_t l = 0; l < LANES; l++) {
+                    v[j + l] += amp * zi[l];
+                    d[j + l] += slope * zr[l];
+                    double t = zr[l] * rr - zi[l] * ri;
+                    zi[l] = zr[l] * ri + zi[l] * rr;
+                    zr[l] = t;
+                }
+            }
+        }
+        if (m_.dither_codes != 0.0) {
+            rc_dither_render(m_.dither, m_.fs, (double)k0 / m_.fs + p.t0, SEG, g);
+            for (size_t j = 0; j < SEG; j++) v[j] += p.gain * m_.dither_codes * g[j];
+        }
+        if (jitter || m_.noise > 0.0) {
+            /* Jitter and noise are independent normals: one draw of their combined rms */
+            gauss(m_.seed, ch, seg).fill(g, SEG);
+            if (jitter) {
+                const double nn = m_.noise * m_.noise;
+                for (size_t j = 0; j < SEG; j++) {
+                    double dj = d[j] * m_.jitter_s;
+                    v[j] += std::sqrt(dj * dj + nn) * g[j];
+                }
+            } else {
+                for (size_t j = 0; j < SEG; j++) v[j] += m_.noise * g[j];
+            }
+        }
+
+        size_t lo = (size_t)(std::max(first, k0) - k0), end = (size_t)(std::min(first + n, k0 + SEG) - k0);
+        int16_t *dst = out + (k0 + lo - first);
+        for (size_t j = lo; j < end; j++) {
+            double q = p.sign * step * ((v[j] * inv_step + ROUND) - ROUND);
+            *dst++ = (int16_t)std::min(hi, std::max(-32768.0, q));
+        }
+    }
+}
+
+void tiadc_source::render(uint64_t first, size_t n, int16_t *a, int16_t *b) const
+{
+    render_channel(0, first, n, a);
+    render_channel(1, first, n, b);
+}
+
+void tiadc_source::render_dma(uint64_t first, size_t n, unsigned spc, unsigned np, uint8_t *out,
+                              unsigned threads) const
+{
+    if (spc == 0 || SEG % spc) throw std::invalid_argument("signal model: spc must divide 1024");
+    if (np != 16 && np != 8) throw std::invalid_argument("signal model: NP must be 16 or 8");
+    if (first % spc || n % spc) throw std::invalid_argument("signal model: first and n must be whole blocks");
+
+    const size_t bytes_per_sample = np / 8;
+    auto work = [&](size_t lo, size_t hi) {
+        std::vector<int16_t> a(CHUNK), b(CHUNK);
+        for (size_t c = lo; c < hi; c += CHUNK) {
+            size_t len = std::min(CHUNK, hi - c);
+            render(first + c, len, a.data(), b.data());
+            uint8_t *dst = out + c * 2 * bytes_per_sample;
+            for (size_t blk = 0; blk < len; blk += spc) {
+                if (np == 16) {
+                    std::memcpy(dst, a.data() + blk, spc * 2);
+                    std::memcpy(dst + spc * 2, b.data() + blk, spc * 2);
+                    dst += spc * 4;
+                } else {
+                    for (unsigned s = 0; s < spc; s++) *dst++ = (uint8_t)(a[blk + s] >> 8);
+                    for (unsigned s = 0; s < spc; s++) *dst++ = (uint8_t)(b[blk + s] >> 8);
+                }
+            }
+        }
+    };
+
+    threads = threads ? threads : std::max(1u, std::thread::hardware_concurrency());
+    threads = (unsigned)std::min<size_t>(threads, (n + CHUNK - 1) / CHUNK);
+    if (threads <= 1) {
+        work(0, n);
+        return;
+    }
+    std::vector<std::thread> pool;
+    size_t per = (n / threads + CHUNK - 1) / CHUNK * CHUNK;
+    for (unsigned t = 0; t < threads; t++) {
+        size_t lo = std::min(n, t * per), hi = t + 1 == threads ? n : std::min(n, lo + per);
+        if (lo < hi) pool.emplace_back(work, lo, hi);
+    }
+    for (std::thread &th : pool) th.join();
+}
+
+} // namespace tiadc_dsp
@@ -0,0 +1,93 @@
+/* signal_model.h
+ * Synthetic 2-channel TI-ADC data: what the board's capture path would
+ * deliver for a known input and known converter mismatches, for testing
+ * the receiver, the DSP kernels and the calibration without hardware.
+ *
+ * Channel c samples the input at its k-th instant
+ *     t = k / fs + nominal_c + skew_c + jitter
+ * (nominal_B = 1 / (2 fs) when interleaved, else 0), through a first-order
+ * front end of bandwidth bw_c, then
+ *     v = gain_c (tones(t) + dither_codes * dither(t)) + offset_c + noise
+ * is quantised to the converter's resolution (left-justified in 16 bits)
+ * and saturated, and stored sign-flipped when invert_c is set (channel A on
+ * the board).  The front end filters the tones only; the dither is far
+ * inside its band.  Jitter is applied to the tones to first order.
+ *
+ * Every sample is a function of the model and its index alone (noise comes
+ * from a generator seeded per segment of the stream), so any range can be
+ * rendered on its own, in any order and on any number of threads, with the
+ * same result.
+ */
+
+#ifndef TIADC_DSP_SIGNAL_MODEL_H
+#define TIADC_DSP_SIGNAL_MODEL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "dither.h"
+
+namespace tiadc_dsp {
+
+struct tone {
+    double freq_hz;
+    double amplitude;                   // codes, 16-bit full scale is 32768
+    double phase = 0.0;                 // radians at t = 0
+};
+
+struct channel_model {
+    double skew_s = 0.0;                // sampling instant late by this
+    double gain = 1.0;
+    double offset = 0.0;                // codes
+    double bandwidth_hz = 0.0;          // front end -3 dB point, 0 = unlimited
+    bool invert = false;                // stored sign-flipped
+};
+
+struct tiadc_model {
+    double fs = 500e6;                  // per channel
+    bool interleaved = false;           // B half a sample period after A, else simultaneous
+    std::vector<tone> tones;
+    channel_model a{ 0.0, 1.0, 0.0, 0.0, true };
+    channel_model b;
+    double jitter_s = 0.0;              // rms aperture jitter, independent per sample and channel
+    double noise = 0.0;                 // rms codes at the converter input
+    unsigned bits = 14;                 // converter resolution
+    rc_dither dither{ 1e-6, 1e-7 };     // times in seconds
+    double dither_codes = 0.0;          // codes per dither unit, 0 = no dither
+    uint64_t seed = 1;
+};
+
+class tiadc_source {
+public:
+    explicit tiadc_source(const tiadc_model &m);    // throws std::invalid_argument on a bad model
+
+    const tiadc_model &model() const { return m_; }
+
+    /* Samples first .. first + n - 1 of each channel, planar */
+    void render(uint64_t first, size_t n, int16_t *a, int16_t *b) const;
+
+    /* The same samples as the S2MM stream writes them to DDR: per link block
+     * spc samples of A then spc of B, NP bits each (16, or 8 = the top byte),
+     * little endian; a 128-bit beat is one block in the L = 4, NP = 16 modes.
+     * first and n are multiples of spc; out holds 2 n NP / 8 bytes. */
+    void render_dma(uint64_t first, size_t n, unsigned spc, unsigned np, uint8_t *out, unsigned threads = 1) const;
+
+private:
+    struct channel_plan {
+        double t0;                      // nominal + skew, s
+        double gain, offset, sign;
+        std::vector<double> amp;        // per tone, through the front end and gain
+        std::vector<double> phase;
+        std::vector<double> cycles;     // per sample
+    };
+
+    void render_channel(int ch, uint64_t first, size_t n, int16_t *out) const;
+
+    tiadc_model m_;
+    std::vector<channel_plan> plan_;
+};
+
+} // namespace tiadc_dsp
+
+#endif /* TIADC_DSP_SIGNAL_MODEL_H */
@@ -0,0 +1,264 @@
+#include "spectral.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+
+namespace tiadc_dsp {
+
+const char *const spectral_metric_names[NUM_SPECTRAL_METRICS] = {
+    "fin_hz", "signal_dbfs", "snr_db", "sinad_db", "sfdr_dbc", "thd_dbc", "enob", "image_dbc", "offset_dbfs",
+};
+
+static constexpr double NaN = std::numeric_limits<double>::quiet_NaN();
+
+enum : uint8_t { BIN_FREE = 0, BIN_DC, BIN_SIGNAL, BIN_HARMONIC, BIN_TI };
+
+/* ---------------------------------------------------------------------- */
+/*  Windows, cached like the FFT plans                                     */
+/* ---------------------------------------------------------------------- */
+struct window_table {
+    std::vector<double> w;
+    double sum_sq;                      // sum w^2, for the power normalisation
+    size_t span;                        // main-lobe half width in bins
+};
+
+static size_t window_span(window_kind kind)
+{
+    return kind == window_kind::rect ? 1 : kind == window_kind::hann ? 2 : 4;
+}
+
+/*
+ * Shortest record the window can analyse: the DC group, a fundamental with
+ * its full lobe on either side and room to look for it, all in n/2 + 1 bins.
+ * A power of two, so any longer record's leading power of two also fits.
+ */
+static size_t min_record(window_kind kind)
+{
+    size_t need = 2 * (2 * window_span(kind) + 2), n = 4;
+    while (n < need) n *= 2;
+    return n;
+}
+
+static void check_record(size_t len, window_kind kind)
+{
+    if (len < min_record(kind))
+        throw std::invalid_argument("spectral: record shorter than " + std::to_string(min_record(kind)) +
+                                    " samples for this window");
+}
+
+static const window_table &window_for(size_t n, window_kind kind)
+{
+    static std::mutex lock;
+    static std::map<std::pair<size_t, int>, std::unique_ptr<window_table>> tables;
+
+    std::lock_guard<std::mutex> guard(lock);
+    std::unique_ptr<window_table> &t = tables[{n, (int)kind}];
+    if (!t) {
+        t.reset(new window_table);
+        t->w.resize(n);
+        for (size_t i = 0; i < n; i++) {
+            double p = 2.0 * M_PI * (double)i / (double)n;
+            switch (kind) {
+            case window_kind::rect: t->w[i] = 1.0; break;
+            case window_kind::hann: t->w[i] = 0.5 - 0.5 * std::cos(p); break;
+            case window_kind::blackman_harris:
+                t->w[i] = 0.35875 - 0.48829 * std::cos(p) + 0.14128 * std::cos(2 * p) - 0.01168 * std::cos(3 * p);
+                break;
+            }
+        }
+        t->sum_sq = 0.0;
+        for (double v : t->w) t->sum_sq += v * v;
+        t->span = window_span(kind);
+    }
+    return *t;
+}
+
+static double db(double ratio)
+{
+    return ratio > 0.0 ? 10.0 * std::log10(ratio) : -std::numeric_limits<double>::infinity();
+}
+
+/*
+ * Power of the bins within span of centre that are still free, marking them
+ * with tag; *bins counts them so the noise under the group can be removed.
+ */
+static double take_group(spectral_scratch &s, size_t h, double centre, size_t span, uint8_t tag,
+                         size_t *bins = nullptr)
+{
+    long c = std::lround(centre), lo = std::max(0L, c - (long)span), hi = std::min((long)h, c + (long)span);
+    double p = 0.0;
+
+    for (long k = lo; k <= hi; k++) {
+        if (s.used[k] != BIN_FREE) continue;
+        s.used[k] = tag;
+        p += s.P[k];
+        if (bins) (*bins)++;
+    }
+    return p;
+}
+
+/* Bin of frequency f (in bins of an n-point FFT) folded into [0, n/2] */
+static double fold(double f, size_t n)
+{
+    f = std::fmod(f, (double)n);
+    if (f < 0) f += (double)n;
+    return f > (double)n / 2 ? (double)n - f : f;
+}
+
+spectral_metrics analyse_record(const double *x, size_t len, double fs, bool ti_spurs,
+                                const spectral_options &opt, spectral_scratch &s)
+{
+    check_record(len, opt.window);
+    size_t n = 4;
+    while (n * 2 <= len) n *= 2;
+
+    if (!s.plan || s.plan->size() != n || s.kind != opt.window) {
+        s.plan = &plan_for(n);
+        s.win = &window_for(n, opt.window);
+        s.kind = opt.window;
+    }
+    const fft_plan &plan = *s.plan;
+    const window_table &win = *s.win;
+    size_t h = n / 2, span = win.span;
+
+    s.x.resize(n);
+    s.X.resize(h + 1);
+    s.z.resize(h);
+    s.P.resize(h + 1);
+    s.used.assign(h + 1, BIN_FREE);
+
+    for (size_t i = 0; i < n; i++) s.x[i] = x[i] * win.w[i];
+    plan.forward(s.x.data(), s.X.data(), s.z.data());
+    for (size_t k = 0; k <= h; k++) s.P[k] = std::norm(s.X[k]) * ((k == 0 || k == h) ? 1.0 : 2.0) / ((double)n * win.sum_sq);
+
+    spectral_metrics m;
+    double fs_power = opt.full_scale * opt.full_scale / 2.0;
+
+    take_group(s, h, 0.0, span, BIN_DC);
+
+    /* Fundamental: the largest bin outside DC, located by its power centroid */
+    size_t k0 = span + 1;
+    for (size_t k = span + 1; k <= h; k++) {
+        if (s.P[k] > s.P[k0]) k0 = k;
+    }
+    double num = 0.0, den = 0.0;
+    for (size_t k = (k0 > span ? k0 - span : 0); k <= std::min(h, k0 + span); k++) {
+        num += (double)k * s.P[k];
+        den += s.P[k];
+    }
+    double kc = den > 0.0 ? num / den : (double)k0;
+    double p_sig = take_group(s, h, (double)k0, span, BIN_SIGNAL);
+
+    size_t harm_bins = 0, image_bins = 0, offset_bins = 0;
+    double p_harm = 0.0;
+    for (unsigned hn = 2; hn <= opt.harmonics; hn++)
+        p_harm += take_group(s, h, fold(hn * kc, n), span, BIN_HARMONIC, &harm_bins);
+
+    double p_image = NaN, p_offset = NaN;
+    if (ti_spurs) {
+        /* An image on top of the fundamental (fin near fs/4) cannot be told apart */
+        double image_bin = (double)h - kc;
+        if (std::fabs(image_bin - kc) > 2.0 * span) p_image = take_group(s, h, image_bin, span, BIN_TI, &image_bins);
+        p_offset = take_group(s, h, (double)h, span, BIN_TI, &offset_bins);
+    }
+
+    /* Noise from the free bins, scaled to every bin but DC */
+    double p_free = 0.0;
+    size_t n_free = 0, n_band = 0;
+    double spur_peak = 0.0;
+    for (size_t k = 0; k <= h; k++) {
+        if (s.used[k] == BIN_DC) continue;
+        n_band++;
+        if (s.used[k] == BIN_FREE) {
+            p_free += s.P[k];
+            n_free++;
+        }
+        if (s.used[k] != BIN_SIGNAL) spur_peak = std::max(spur_peak, s.P[k]);
+    }
+    double p_bin = n_free ? p_free / (double)n_free : 0.0;
+    double p_noise = p_bin * (double)n_band;
+
+    /* SINAD takes the spur groups as they are; THD and the spur levels drop the noise under them */
+    double p_spurs = p_harm + (std::isnan(p_image) ? 0.0 : p_image) + (std::isnan(p_offset) ? 0.0 : p_offset);
+    double noise_in_spurs = p_bin * (double)(harm_bins + image_bins + offset_bins);
+    p_harm = std::max(0.0, p_harm - p_bin * (double)harm_bins);
+    if (!std::isnan(p_image)) p_image = std::max(0.0, p_image - p_bin * (double)image_bins);
+    if (!std::isnan(p_offset)) p_offset = std::max(0.0, p_offset - p_bin * (double)offset_bins);
+
+    m.fin_hz = kc * fs / (double)n;
+    m.signal_dbfs = db(p_sig / fs_power);
+    m.snr_db = db(p_sig / p_noise);
+    m.sinad_db = db(p_sig / (p_noise - noise_in_spurs + p_spurs));
+    m.sfdr_dbc = db(s.P[k0] / spur_peak);
+    m.thd_dbc = db(p_harm / p_sig);
+    m.enob = (m.sinad_db - 1.76) / 6.02;
+    m.image_dbc = std::isnan(p_image) ? NaN : db(p_image / p_sig);
+    m.offset_dbfs = std::isnan(p_offset) ? NaN : db(p_offset / fs_power);
+    return m;
+}
+
+/* ---------------------------------------------------------------------- */
+/*  Batches                                                                */
+/* ---------------------------------------------------------------------- */
+static void analyse_range(const int16_t *data, const batch_spec &spec, size_t first, size_t last,
+                          spectral_metrics *out)
+{
+    spectral_scratch s;
+    std::vector<double> rec(spec.interleaved ? 2 * spec.samples : spec.samples);
+    double sign_a = ((spec.invert_mask >> spec.conv_a) & 1) ? -1.0 : 1.0;
+    double sign_b = ((spec.invert_mask >> spec.conv_b) & 1) ? -1.0 : 1.0;
+
+    for (size_t r = first; r < last; r++) {
+        const int16_t *a = data + (r * spec.M + spec.conv_a) * spec.samples;
+        if (spec.interleaved) {
+            const int16_t *b = data + (r * spec.M + spec.conv_b) * spec.samples;
+            for (size_t i = 0; i < spec.samples; i++) {
+                rec[2 * i] = sign_a * a[i];
+                rec[2 * i + 1] = sign_b * b[i];
+            }
+            out[r] = analyse_record(rec.data(), rec.size(), 2.0 * spec.fs, true, spec.opt, s);
+        } else {
+            for (size_t i = 0; i < spec.samples; i++) rec[i] = sign_a * a[i];
+            out[r] = analyse_record(rec.data(), rec.size(), spec.fs, false, spec.opt, s);
+        }
+    }
+}
+
+void analyse_batch(const int16_t *data, const batch_spec &spec, spectral_metrics *out)
+{
+    if (spec.conv_a >= spec.M || (spec.interleaved && spec.conv_b >= spec.M))
+        throw std::invalid_argument("spectral: converter index out of range");
+    check_record(spec.interleaved ? 2 * spec.samples : spec.samples, spec.opt.window);
+    if (!spec.records) return;
+
+    /* Build the shared plan and window before the workers race for them */
+    size_t len = spec.interleaved ? 2 * spec.samples : spec.samples, n = 4;
+    while (n * 2 <= len) n *= 2;
+    plan_for(n);
+    window_for(n, spec.opt.window);
+
+    unsigned threads = spec.threads ? spec.threads : std::max(1u, std::thread::hardware_concurrency());
+    threads = (unsigned)std::min<size_t>(threads, spec.records);
+    if (threads <= 1) {
+        analyse_range(data, spec, 0, spec.records, out);
+        return;
+    }
+
+    std::vector<std::thread> pool;
+    size_t per = (spec.records + threads - 1) / threads;
+    for (unsigned t = 0; t < threads; t++) {
+        size_t first = t * per, last = std::min(spec.records, first + per);
+        if (first >= last) break;
+        pool.emplace_back(analyse_range, data, std::cref(spec), first, last, out);
+    }
+    for (std::thread &th : pool) th.join();
+}
+
+} // namespace tiadc_dsp
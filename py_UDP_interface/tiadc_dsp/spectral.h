@@ -0,0 +1,89 @@
+/* spectral.h
+ * Spectral metrics of ADC captures: SNR, SINAD, SFDR, THD, ENOB and the
+ * two time-interleaving spurs.
+ *
+ * A record is windowed (Blackman-Harris by default), transformed with a
+ * cached real FFT plan and read as a one-sided power spectrum normalised so
+ * that summing a tone's main lobe gives its mean-square power.  The
+ * fundamental is the largest bin outside DC; harmonics 2..H are folded
+ * into the first Nyquist zone.  With two interleaved channels the record
+ * also carries the mismatch image at fs/2 - fin (gain / timing skew) and
+ * the offset spur at fs/2.  SNR leaves out harmonics and those spurs,
+ * SINAD counts everything but DC, and the noise found in the free bins is
+ * scaled up to the whole band.
+ *
+ * Records that are not a power of two long use their leading power of two.
+ * The shortest record is 8 samples with the rectangular window, 16 with
+ * Hann and 32 with Blackman-Harris; shorter ones throw std::invalid_argument.
+ */
+
+#ifndef TIADC_DSP_SPECTRAL_H
+#define TIADC_DSP_SPECTRAL_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "fft.h"
+
+namespace tiadc_dsp {
+
+enum class window_kind { rect, hann, blackman_harris };
+
+struct spectral_options {
+    window_kind window = window_kind::blackman_harris;
+    unsigned harmonics = 5;             // highest harmonic counted as distortion
+    double full_scale = 32768.0;        // sine amplitude of 0 dBFS
+};
+
+struct spectral_metrics {               // NaN where a quantity does not apply
+    double fin_hz;
+    double signal_dbfs;
+    double snr_db;
+    double sinad_db;
+    double sfdr_dbc;
+    double thd_dbc;
+    double enob;
+    double image_dbc;                   // fs/2 - fin, interleaved only
+    double offset_dbfs;                 // fs/2, interleaved only
+};
+
+static constexpr size_t NUM_SPECTRAL_METRICS = sizeof(spectral_metrics) / sizeof(double);
+extern const char *const spectral_metric_names[NUM_SPECTRAL_METRICS];
+
+struct window_table;
+
+/* Per-thread working memory; grows to the largest record seen */
+struct spectral_scratch {
+    const fft_plan *plan = nullptr;     // last plan / window used, skips the cache lookup
+    const window_table *win = nullptr;
+    window_kind kind = window_kind::rect;
+    std::vector<double> x;
+    std::vector<cplx> X, z;
+    std::vector<double> P;
+    std::vector<uint8_t> used;
+};
+
+spectral_metrics analyse_record(const double *x, size_t n, double fs, bool ti_spurs,
+                                const spectral_options &opt, spectral_scratch &s);
+
+/* A batch of captures laid out (records, M, samples) int16, as a .tcap file */
+struct batch_spec {
+    size_t records = 0;
+    size_t M = 2;
+    size_t samples = 0;                 // per converter per record
+    double fs = 500e6;                  // per-converter sample rate
+    bool interleaved = false;           // conv_a / conv_b merged at 2 fs, else conv_a alone at fs
+    unsigned conv_a = 0;
+    unsigned conv_b = 1;
+    unsigned invert_mask = 0;           // converters to sign-flip first
+    unsigned threads = 0;               // 0 = one per CPU
+    spectral_options opt;
+};
+
+/* out[records]; throws std::invalid_argument on a bad spec */
+void analyse_batch(const int16_t *data, const batch_spec &spec, spectral_metrics *out);
+
+} // namespace tiadc_dsp
+
+#endif /* TIADC_DSP_SPECTRAL_H */
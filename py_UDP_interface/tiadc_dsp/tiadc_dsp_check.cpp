@@ -0,0 +1,405 @@
+/* tiadc_dsp_check.cpp
+ * Self-check of the native kernels against signals with known answers,
+ * plus throughput figures for the spectral batch path, the mismatch
+ * estimators, the dither generator and the synthetic signal model.
+ *
+ *   tiadc_dsp_check [records] [samples] [threads]
+ *
+ * The accuracy checks always use CHECK_SAMPLES per converter; records and
+ * samples only size the throughput run.  Exits non-zero when any figure is
+ * off by more than its tolerance.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+#include "dither.h"
+#include "fft.h"
+#include "mismatch.h"
+#include "signal_model.h"
+#include "spectral.h"
+
+using namespace tiadc_dsp;
+
+static const size_t CHECK_SAMPLES = 4096;
+
+static int failures = 0;
+
+static void expect(const char *what, double got, double want, double tol)
+{
+    bool ok = std::fabs(got - want) <= tol;
+    std::printf("  %-34s %10.3f  (want %8.3f +- %.3f)  %s\n", what, got, want, tol, ok ? "ok" : "FAIL");
+    if (!ok) failures++;
+}
+
+static void check_fft()
+{
+    const size_t n = 64;
+    std::vector<double> x(n);
+    std::vector<cplx> X(n / 2 + 1), z(n / 2);
+    std::mt19937 rng(1);
+    std::normal_distribution<double> g;
+    for (double &v : x) v = g(rng);
+
+    plan_for(n).forward(x.data(), X.data(), z.data());
+    double err = 0.0;
+    for (size_t k = 0; k <= n / 2; k++) {
+        cplx ref = 0.0;
+        for (size_t i = 0; i < n; i++) ref += x[i] * std::polar(1.0, -2.0 * M_PI * (double)(k * i) / (double)n);
+        err = std::max(err, std::abs(ref - X[k]));
+    }
+    std::printf("fft against a direct DFT, n = %zu\n", n);
+    expect("max |error|", err, 0.0, 1e-9);
+}
+
+/*
+ * records x 2 converters x samples: a tone sampled at 2 fs, even samples to
+ * converter 0 (sign-inverted, like channel A) and odd ones to converter 1,
+ * which has gain (1 + gain_err) and offset -offset against +offset on 0.
+ */
+static std::vector<int16_t> make_batch(size_t records, size_t samples, double amp, double cycles, double noise,
+                                       double hd3, double gain_err, double offset)
+{
+    std::vector<int16_t> data(records * 2 * samples);
+    std::mt19937 rng(7);
+    std::normal_distribution<double> g(0.0, noise);
+    std::uniform_real_distribution<double> ph(0.0, 2.0 * M_PI);
+
+    for (size_t r = 0; r < records; r++) {
+        double p0 = ph(rng);
+        for (size_t i = 0; i < 2 * samples; i++) {
+            double w = 2.0 * M_PI * cycles * (double)i / (double)(2 * samples);
+            double v = amp * std::sin(w + p0) + hd3 * amp * std::sin(3 * (w + p0)) + g(rng);
+            if (i & 1) v = v * (1.0 + gain_err) - offset;
+            else v = -(v + offset);
+            data[(r * 2 + (i & 1)) * samples + i / 2] = (int16_t)std::lround(v);
+        }
+    }
+    return data;
+}
+
+/*
+ * The two channels of a TI-ADC sampling signal(t): A at i / fs, B at its
+ * nominal instant minus skew, with B's gain and both offsets applied.  A is
+ * stored sign-inverted, like channel A on the board.
+ */
+template <typename F>
+static void make_pair(size_t n, const mismatch_options &opt, double skew_ps, double gain, double off_a, double off_b,
+                      double noise, F signal, std::vector<int16_t> &a, std::vector<int16_t> &b)
+{
+    std::mt19937 rng(11);
+    std::normal_distribution<double> g(0.0, noise);
+    double nominal = opt.interleaved ? 0.5 / opt.fs : 0.0;
+    a.resize(n);
+    b.resize(n);
+    for (size_t i = 0; i < n; i++) {
+        double t = (double)i / opt.fs;
+        a[i] = (int16_t)std::lround(-(signal(t) + off_a + g(rng)));
+        b[i] = (int16_t)std::lround(gain * signal(t + nominal - skew_ps * 1e-12) + off_b + g(rng));
+    }
+}
+
+static mismatch_estimate timed_estimate(const char *what, const std::vector<int16_t> &a, const std::vector<int16_t> &b,
+                                        const mismatch_options &opt)
+{
+    auto t0 = std::chrono::steady_clock::now();
+    mismatch_estimate e = estimate_mismatch(a.data(), b.data(), a.size(), opt);
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+    std::printf("%s, %zu samples per channel: %.1f ms\n", what, a.size(), ms);
+    return e;
+}
+
+static void check_mismatch(size_t n)
+{
+    const double skew_ps = 1.5, gain = 1.01, off_a = 10.0, off_b = -20.0;
+    mismatch_options opt;
+    opt.invert_a = true;
+
+    /* 2x interleaved, tone in the second Nyquist zone of each channel */
+    {
+        opt.interleaved = true;
+        std::vector<int16_t> a, b;
+        make_pair(n, opt, skew_ps, gain, off_a, off_b, 3.0,
+                  [](double t) { return 12000.0 * std::sin(2.0 * M_PI * 310.7e6 * t + 0.3); }, a, b);
+        mismatch_estimate e = timed_estimate("sine fit, interleaved", a, b, opt);
+        expect("tone (MHz)", e.tone_hz / 1e6, 310.7, 1e-4);
+        expect("skew (ps)", e.skew_ps, skew_ps, 0.01);
+        expect("gain", e.gain, gain, 1e-4);
+        expect("offset A (LSB)", e.offset_a, off_a, 0.05);
+        expect("offset B (LSB)", e.offset_b, off_b, 0.05);
+        expect("skew bound covers the error", std::fabs(e.skew_ps - skew_ps) <= 4.0 * e.skew_ci_ps, 1.0, 0.0);
+        expect("residual rms (LSB)", e.residual_rms, std::sqrt(9.0 + 1.0 / 12.0), 0.1);
+    }
+
+    /* The sweep's case: simultaneous channels, 128-sample captures */
+    {
+        opt.interleaved = false;
+        opt.record_len = 128;
+        std::vector<int16_t> a, b;
+        make_pair(128 * 64, opt, 137.0, gain, off_a, off_b, 3.0,
+                  [](double t) { return 20000.0 * std::sin(2.0 * M_PI * 30.5e6 * t); }, a, b);
+        mismatch_estimate e = timed_estimate("sine fit, 64 records of 128", a, b, opt);
+        expect("skew (ps)", e.skew_ps, 137.0, 0.5);
+        expect("gain", e.gain, gain, 1e-3);
+        opt.record_len = 0;
+    }
+
+    /* Cross spectrum on three tones */
+    {
+        opt.interleaved = false;
+        std::vector<int16_t> a, b;
+        make_pair(n, opt, 2.5, gain, off_a, off_b, 3.0,
+                  [](double t) {
+                      return 6000.0 * std::sin(2.0 * M_PI * 31.3e6 * t) + 5000.0 * std::sin(2.0 * M_PI * 77.1e6 * t + 1.0) +
+                             4000.0 * std::sin(2.0 * M_PI * 143.9e6 * t + 2.0);
+                  },
+                  a, b);
+        opt.method = mismatch_method::xcorr;
+        mismatch_estimate e = timed_estimate("cross spectrum, three tones", a, b, opt);
+        expect("skew (ps)", e.skew_ps, 2.5, 0.05);
+        expect("gain", e.gain, gain, 1e-3);
+        expect("offset B - A (LSB)", e.offset_b - e.offset_a, off_b - off_a, 0.2);
+    }
+
+    /* The RC dither alone: half a period charging, half discharging, tau = 0.1085 period */
+    {
+        const double period = 1.0 / 1.234567e6, tau = 0.1085, peak = 8000.0;
+        auto wave = [=](double t) {
+            double x = t / period - std::floor(t / period);
+            double top = peak * (1.0 - std::exp(-0.5 / tau)), bottom = top * std::exp(-0.5 / tau);
+            return x < 0.5 ? top - (top - bottom) * std::exp(-x / tau) : top * std::exp(-(x - 0.5) / tau);
+        };
+        /* What "floor" means for this waveform: mean of its lowest quarter */
+        std::vector<double> ideal(4096);
+        for (size_t g = 0; g < ideal.size(); g++) ideal[g] = wave(((double)g + 0.5) / 4096.0 * period);
+        std::sort(ideal.begin(), ideal.end());
+        double floor_level = 0.0;
+        for (size_t g = 0; g < 1024; g++) floor_level += ideal[g] / 1024.0;
+
+        opt.method = mismatch_method::dither;
+        opt.dither_period_s = period;
+        std::vector<int16_t> a, b;
+        make_pair(n, opt, 3.0, 0.98, off_a, off_b, 3.0, wave, a, b);
+        for (int16_t &v : a) v = (int16_t)-v;   // the dither is measured on the corrected A
+        opt.invert_a = false;
+        mismatch_estimate e = timed_estimate("dither fold", a, b, opt);
+        expect("skew (ps)", e.skew_ps, 3.0, 0.2);
+        expect("gain", e.gain, 0.98, 2e-3);
+        expect("floor A (LSB)", e.offset_a, floor_level + off_a, 1.0);
+        expect("floor B (LSB)", e.offset_b, 0.98 * floor_level + off_b, 1.0);
+    }
+}
+
+/* Dither: test1's peak, block rendering against the exact value, the free-running steady state, the memo */
+static void check_dither()
+{
+    rc_dither d;
+    d.period = 100.0;
+    d.tau = 21.7;
+    d.t_start = 900.0;
+    std::printf("rc dither, test1 (period 100, tau 21.7)\n");
+    expect("peak at t_start + period", rc_dither_value(d, 1000.0), 2.0 * (1.0 - std::exp(-100.0 / 21.7)), 1e-12);
+    expect("before t_start", rc_dither_value(d, 899.0), 0.0, 0.0);
+
+    d.period = 1e-6;
+    d.tau = 0.217e-6;
+    d.t_start = 0.0;
+    d.phase = 0.3;
+    d.periods = 0;
+    const size_t n = size_t(1) << 22;
+    const double fs = 500e6;
+    std::vector<double> w(n);
+    auto t0 = std::chrono::steady_clock::now();
+    rc_dither_render(d, fs, 0.0, n, w.data());
+    double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    double err = 0.0, hi = 0.0;
+    for (size_t i = 0; i < n; i += 997) err = std::max(err, std::fabs(w[i] - rc_dither_value(d, (double)i / fs)));
+    for (double v : w) hi = std::max(hi, v);
+    double e = std::exp(-d.period / d.tau);
+    std::printf("free-running dither at 500 MS/s, %zu samples in %.1f ms\n", n, secs * 1e3);
+    expect("render vs value, max |error| (ppb)", err * 1e9, 0.0, 1.0);
+    expect("steady-state peak", hi, d.amplitude / (1.0 + e), 1e-3);
+
+    cache_stats before = dither_cache_stats();
+    auto r1 = rc_dither_reference(d, fs, 0.0, 4096);
+    auto r2 = rc_dither_reference(d, fs, 0.0, 4096);
+    cache_stats after = dither_cache_stats();
+    expect("reference memoised (hits)", (double)(after.hits - before.hits), 1.0, 0.0);
+    expect("reference shared", r1 == r2 ? 1.0 : 0.0, 1.0, 0.0);
+}
+
+/* Signal model: DMA beat layout and polarity, thread independence, mismatches recovered, stream rate */
+static void check_signal_model(unsigned threads)
+{
+    tiadc_model m;
+    m.tones.push_back({ 97.3e6, 9000.0, 0.4 });
+    m.bits = 16;
+    std::printf("signal model\n");
+
+    /* Same instants, no noise: stored A is exactly -B; blocks are 4 A then 4 B */
+    {
+        tiadc_source src(m);
+        const size_t n = 4096;
+        std::vector<int16_t> a(n), b(n);
+        std::vector<uint8_t> beats(4 * n);
+        src.render(1000, n, a.data(), b.data());
+        src.render_dma(1000, n, 4, 16, beats.data());
+        double inv = 0.0, lay = 0.0;
+        for (size_t i = 0; i < n; i++) {
+            int16_t sa, sb;
+            std::memcpy(&sa, &beats[(i / 4) * 16 + (i % 4) * 2], 2);
+            std::memcpy(&sb, &beats[(i / 4) * 16 + 8 + (i % 4) * 2], 2);
+            inv = std::max(inv, std::fabs((double)a[i] + (double)b[i]));
+            lay = std::max(lay, std::fabs((double)(sa - a[i])) + std::fabs((double)(sb - b[i])));
+        }
+        expect("max |A + B|", inv, 0.0, 0.0);
+        expect("beat layout, max |error|", lay, 0.0, 0.0);
+    }
+
+    /* Interleaved with the mismatch check's parameters: the estimator finds them */
+    m.interleaved = true;
+    m.tones = { { 310.7e6, 12000.0, 0.3 } };
+    m.a.offset = 10.0;
+    m.b.offset = -20.0;
+    m.b.gain = 1.01;
+    m.b.skew_s = -1.5e-12;      // the estimator's skew is B early
+    m.noise = 3.0;
+    {
+        tiadc_source src(m);
+        const size_t n = size_t(1) << 20;
+        std::vector<uint8_t> one(4 * n), many(4 * n);
+        src.render_dma(0, n, 4, 16, one.data(), 1);
+        src.render_dma(0, n, 4, 16, many.data(), 4);
+        expect("1 vs 4 threads, identical", one == many ? 1.0 : 0.0, 1.0, 0.0);
+
+        std::vector<int16_t> a(n), b(n);
+        src.render(0, n, a.data(), b.data());
+        mismatch_options opt;
+        opt.interleaved = true;
+        opt.invert_a = true;
+        mismatch_estimate e = estimate_mismatch(a.data(), b.data(), n, opt);
+        expect("skew (ps)", e.skew_ps, 1.5, 0.01);
+        expect("gain", e.gain, 1.01, 1e-4);
+        expect("offset A (LSB)", e.offset_a, 10.0, 0.05);
+        expect("offset B (LSB)", e.offset_b, -20.0, 0.05);
+        expect("residual rms (LSB)", e.residual_rms, std::sqrt(9.0 + 1.0 / 12.0), 0.1);
+    }
+
+    /* Stream rate with jitter, dither and 14-bit quantisation on */
+    {
+        m.bits = 14;
+        m.jitter_s = 100e-15;
+        m.dither_codes = 4000.0;
+        m.a.bandwidth_hz = 1.4e9;
+        m.b.bandwidth_hz = 1.38e9;
+        tiadc_source src(m);
+        const size_t n = size_t(1) << 25;
+        std::vector<uint8_t> out(4 * n);
+        auto t0 = std::chrono::steady_clock::now();
+        src.render_dma(0, n, 4, 16, out.data(), threads);
+        double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        std::printf("signal model stream: %zu MB in %.3f s, %.2f GB/s\n", out.size() >> 20, secs,
+                    (double)out.size() / secs / 1e9);
+    }
+}
+
+int main(int argc, char **argv)
+{
+    size_t records = (argc > 1) ? std::strtoul(argv[1], nullptr, 0) : 2048;
+    size_t samples = (argc > 2) ? std::strtoul(argv[2], nullptr, 0) : 4096;
+    unsigned threads = (argc > 3) ? (unsigned)std::atoi(argv[3]) : 0;
+
+    check_fft();
+    check_mismatch(1 << 20);
+    check_dither();
+    check_signal_model(threads);
+
+    /* Per channel: 57 dB SNR from the noise, -70 dBc third harmonic (averaged over the records) */
+    {
+        const double amp = 16384.0, noise = 16.384;
+        const size_t n_rec = 16;
+        std::vector<int16_t> d = make_batch(n_rec, CHECK_SAMPLES, amp, 2 * 401.3, noise, std::pow(10.0, -70.0 / 20.0), 0.0, 0.0);
+        batch_spec spec;
+        spec.records = n_rec;
+        spec.samples = CHECK_SAMPLES;
+        spec.invert_mask = 1;
+        std::vector<spectral_metrics> m(n_rec);
+        analyse_batch(d.data(), spec, m.data());
+        double thd = 0.0;
+        for (const spectral_metrics &r : m) thd += std::pow(10.0, r.thd_dbc / 10.0) / (double)n_rec;
+        double want_snr = 10.0 * std::log10(amp * amp / 2.0 / (noise * noise + 1.0 / 12.0));
+        std::printf("per-channel view, %zu samples\n", CHECK_SAMPLES);
+        expect("fin (MHz)", m[0].fin_hz / 1e6, 1000.0 * 2 * 401.3 / (double)(2 * CHECK_SAMPLES), 0.05);
+        expect("signal (dBFS)", m[0].signal_dbfs, 20.0 * std::log10(0.5), 0.05);
+        expect("SNR (dB)", m[0].snr_db, want_snr, 0.5);
+        expect("THD (dBc)", 10.0 * std::log10(thd), -70.0, 0.5);
+        expect("SFDR (dBc)", m[0].sfdr_dbc, 70.0, 1.5);
+        expect("ENOB from SINAD", m[0].enob, (m[0].sinad_db - 1.76) / 6.02, 1e-9);
+    }
+
+    /* Interleaved: 1 % gain mismatch -> image at 20 log(g / 2); +-32 LSB offsets -> fs/2 spur */
+    {
+        const double amp = 16384.0, gain_err = 0.01, offset = 32.0;
+        std::vector<int16_t> d = make_batch(4, CHECK_SAMPLES, amp, 2 * 401.3, 4.0, 0.0, gain_err, offset);
+        batch_spec spec;
+        spec.records = 4;
+        spec.samples = CHECK_SAMPLES;
+        spec.interleaved = true;
+        spec.invert_mask = 1;
+        std::vector<spectral_metrics> m(4);
+        analyse_batch(d.data(), spec, m.data());
+        std::printf("interleaved view, 2 x %zu samples\n", CHECK_SAMPLES);
+        expect("fin (MHz)", m[0].fin_hz / 1e6, 1000.0 * 2 * 401.3 / (double)(2 * CHECK_SAMPLES), 0.05);
+        expect("image (dBc)", m[0].image_dbc, 20.0 * std::log10(gain_err / 2.0), 0.3);
+        expect("offset spur (dBFS)", m[0].offset_dbfs, 10.0 * std::log10(offset * offset / (32768.0 * 32768.0 / 2.0)), 0.3);
+        expect("SFDR = image (dBc)", m[0].sfdr_dbc, -20.0 * std::log10(gain_err / 2.0), 1.5);
+    }
+
+    /* Records too short for the window's lobes are refused, not read past the spectrum */
+    {
+        const window_kind kinds[] = { window_kind::rect, window_kind::hann, window_kind::blackman_harris };
+        const size_t shortest[] = { 8, 16, 32 };
+        std::vector<int16_t> d = make_batch(1, 64, 16384.0, 5.3, 0.0, 0.0, 0.0, 0.0);
+        std::vector<spectral_metrics> m(1);
+        std::printf("short records\n");
+        for (size_t i = 0; i < 3; i++) {
+            batch_spec spec;
+            spec.records = 1;
+            spec.opt.window = kinds[i];
+            double refused = 0.0, taken = 1.0;
+            spec.samples = shortest[i] - 1;
+            try { analyse_batch(d.data(), spec, m.data()); } catch (const std::invalid_argument &) { refused = 1.0; }
+            spec.samples = shortest[i];
+            try { analyse_batch(d.data(), spec, m.data()); } catch (const std::invalid_argument &) { taken = 0.0; }
+            char what[64];
+            std::snprintf(what, sizeof(what), "%zu refused, %zu taken", shortest[i] - 1, shortest[i]);
+            expect(what, refused + taken, 2.0, 0.0);
+        }
+    }
+
+    /* Throughput of the batch path */
+    {
+        std::vector<int16_t> d = make_batch(records, samples, 16384.0, 2 * 401.3, 16.0, 0.0, 0.001, 0.0);
+        batch_spec spec;
+        spec.records = records;
+        spec.samples = samples;
+        spec.interleaved = true;
+        spec.threads = threads;
+        std::vector<spectral_metrics> m(records);
+        auto t0 = std::chrono::steady_clock::now();
+        analyse_batch(d.data(), spec, m.data());
+        double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        std::printf("throughput: %zu interleaved records of 2 x %zu samples in %.3f s, %.0f records/s, %.1f MSamples/s\n",
+                    records, samples, secs, (double)records / secs, (double)records * 2 * (double)samples / secs / 1e6);
+    }
+
+    std::printf("tiadc_dsp_check: %s\n", failures ? "FAIL" : "PASS");
+    return failures ? 1 : 0;
+}
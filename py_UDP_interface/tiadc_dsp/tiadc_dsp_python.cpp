@@ -0,0 +1,324 @@
+/* tiadc_dsp_python.cpp
+ * CPython binding of the tiadc_dsp kernels.  Arrays cross as plain buffers
+ * (no numpy headers needed); spectral.py does the shaping and allocation.
+ *
+ *   _tiadc_dsp.spectral(data, out, records, M, samples, fs, interleaved=False,
+ *                       conv_a=0, conv_b=1, invert_mask=0, window="blackman_harris",
+ *                       harmonics=5, full_scale=32768.0, threads=0)
+ *       data  C-contiguous int16, records x M x samples
+ *       out   writable C-contiguous float64, records x len(metric_names)
+ *
+ *   _tiadc_dsp.mismatch(a, b, fs, method="sine_fit", interleaved=False, record_len=0,
+ *                       segments=16, tone_hz=0.0, dither_period=0.0, invert_a=False,
+ *                       invert_b=False) -> {field: value}
+ *       a, b  C-contiguous int16 channel buffers of equal length
+ *
+ *   _tiadc_dsp.dither(out, fs, t0, period, tau, amplitude=2.0, t_start=0.0, phase=0.0, periods=1,
+ *                     codes_per_unit=1.0, memo=True)
+ *       out   writable C-contiguous float64 (the waveform) or int16 (codes, scaled
+ *             by codes_per_unit), one item per sample at t0 + i / fs
+ *       memo  go through the shared reference cache (see dither.h) instead of
+ *             rendering afresh
+ *
+ *   _tiadc_dsp.dither_cache(budget=-1) -> {entries, bytes, budget, hits, misses, evictions}
+ *       budget >= 0 sets the reference cache budget in bytes first
+ *
+ * The GIL is released while the batch runs.
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include <climits>
+#include <cstring>
+#include <stdexcept>
+#include <string>
+
+#include "dither.h"
+#include "mismatch.h"
+#include "spectral.h"
+
+namespace {
+
+bool parse_window(const char *name, tiadc_dsp::window_kind &kind)
+{
+    if (!std::strcmp(name, "rect")) kind = tiadc_dsp::window_kind::rect;
+    else if (!std::strcmp(name, "hann")) kind = tiadc_dsp::window_kind::hann;
+    else if (!std::strcmp(name, "blackman_harris")) kind = tiadc_dsp::window_kind::blackman_harris;
+    else return false;
+    return true;
+}
+
+/* True if the view holds native-order items of struct code c ("h" int16, "d" float64) */
+bool item_is(const Py_buffer *view, char c)
+{
+    const char *f = view->format ? view->format : "B";
+    if (*f == '@' || *f == '=' || (*f == '<' && PY_LITTLE_ENDIAN)) f++;
+    return f[0] == c && f[1] == '\0';
+}
+
+/* Contiguous buffer of at least need bytes of int16 (itemsize 2) or float64 (itemsize 8) items */
+bool get_buffer(PyObject *obj, Py_buffer *view, int flags, Py_ssize_t itemsize, Py_ssize_t need, const char *what)
+{
+    if (PyObject_GetBuffer(obj, view, flags | PyBUF_C_CONTIGUOUS) < 0) return false;
+    if (!item_is(view, itemsize == 8 ? 'd' : 'h')) {
+        PyErr_Format(PyExc_ValueError, "%s: need %s items, got format \"%s\"", what,
+                     itemsize == 8 ? "float64" : "int16", view->format ? view->format : "B");
+        PyBuffer_Release(view);
+        return false;
+    }
+    if (view->itemsize != itemsize || view->len < need) {
+        PyErr_Format(PyExc_ValueError, "%s: need %zd bytes of %zd-byte items, got %zd bytes of %zd-byte items",
+                     what, need, itemsize, view->len, view->itemsize);
+        PyBuffer_Release(view);
+        return false;
+    }
+    return true;
+}
+
+PyObject *py_spectral(PyObject *, PyObject *args, PyObject *kwds)
+{
+    static const char *kwlist[] = { "data", "out", "records", "M", "samples", "fs", "interleaved", "conv_a", "conv_b",
+                                    "invert_mask", "window", "harmonics", "full_scale", "threads", nullptr };
+    PyObject *data_obj, *out_obj;
+    Py_ssize_t records, M, samples;
+    double fs;
+    int interleaved = 0;
+    unsigned conv_a = 0, conv_b = 1, invert_mask = 0, harmonics = 5, threads = 0;
+    const char *window = "blackman_harris";
+    double full_scale = 32768.0;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "OOnnnd|pIIIsIdI", const_cast<char **>(kwlist), &data_obj, &out_obj,
+                                     &records, &M, &samples, &fs, &interleaved, &conv_a, &conv_b, &invert_mask,
+                                     &window, &harmonics, &full_scale, &threads))
+        return nullptr;
+    if (records < 0 || M <= 0 || samples <= 0) {
+        PyErr_SetString(PyExc_ValueError, "records, M and samples must be positive");
+        return nullptr;
+    }
+
+    tiadc_dsp::batch_spec spec;
+    spec.records = (size_t)records;
+    spec.M = (size_t)M;
+    spec.samples = (size_t)samples;
+    spec.fs = fs;
+    spec.interleaved = interleaved != 0;
+    spec.conv_a = conv_a;
+    spec.conv_b = conv_b;
+    spec.invert_mask = invert_mask;
+    spec.threads = threads;
+    spec.opt.harmonics = harmonics;
+    spec.opt.full_scale = full_scale;
+    if (!parse_window(window, spec.opt.window)) {
+        PyErr_Format(PyExc_ValueError, "unknown window \"%s\" (rect, hann, blackman_harris)", window);
+        return nullptr;
+    }
+
+    Py_buffer data, out;
+    if (!get_buffer(data_obj, &data, PyBUF_SIMPLE | PyBUF_FORMAT, 2, records * M * samples * 2, "data")) return nullptr;
+    if (!get_buffer(out_obj, &out, PyBUF_WRITABLE | PyBUF_FORMAT, 8,
+                    records * (Py_ssize_t)tiadc_dsp::NUM_SPECTRAL_METRICS * 8, "out")) {
+        PyBuffer_Release(&data);
+        return nullptr;
+    }
+
+    std::string error;
+    Py_BEGIN_ALLOW_THREADS
+    try {
+        tiadc_dsp::analyse_batch(static_cast<const int16_t *>(data.buf), spec,
+                                 static_cast<tiadc_dsp::spectral_metrics *>(out.buf));
+    } catch (const std::exception &e) {
+        error = e.what();
+    }
+    Py_END_ALLOW_THREADS
+
+    PyBuffer_Release(&data);
+    PyBuffer_Release(&out);
+    if (!error.empty()) {
+        PyErr_SetString(PyExc_ValueError, error.c_str());
+        return nullptr;
+    }
+    Py_RETURN_NONE;
+}
+
+bool parse_method(const char *name, tiadc_dsp::mismatch_method &method)
+{
+    if (!std::strcmp(name, "sine_fit")) method = tiadc_dsp::mismatch_method::sine_fit;
+    else if (!std::strcmp(name, "xcorr")) method = tiadc_dsp::mismatch_method::xcorr;
+    else if (!std::strcmp(name, "dither")) method = tiadc_dsp::mismatch_method::dither;
+    else return false;
+    return true;
+}
+
+PyObject *py_mismatch(PyObject *, PyObject *args, PyObject *kwds)
+{
+    static const char *kwlist[] = { "a", "b", "fs", "method", "interleaved", "record_len", "segments", "tone_hz",
+                                    "dither_period", "invert_a", "invert_b", nullptr };
+    PyObject *a_obj, *b_obj;
+    tiadc_dsp::mismatch_options opt;
+    const char *method = "sine_fit";
+    int interleaved = 0, invert_a = 0, invert_b = 0;
+    Py_ssize_t record_len = 0;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "OOd|spnIddpp", const_cast<char **>(kwlist), &a_obj, &b_obj, &opt.fs,
+                                     &method, &interleaved, &record_len, &opt.segments, &opt.tone_hz,
+                                     &opt.dither_period_s, &invert_a, &invert_b))
+        return nullptr;
+    if (!parse_method(method, opt.method)) {
+        PyErr_Format(PyExc_ValueError, "unknown method \"%s\" (sine_fit, xcorr, dither)", method);
+        return nullptr;
+    }
+    if (record_len < 0) {
+        PyErr_SetString(PyExc_ValueError, "record_len must not be negative");
+        return nullptr;
+    }
+    opt.interleaved = interleaved != 0;
+    opt.record_len = (size_t)record_len;
+    opt.invert_a = invert_a != 0;
+    opt.invert_b = invert_b != 0;
+
+    Py_buffer a, b;
+    if (!get_buffer(a_obj, &a, PyBUF_SIMPLE | PyBUF_FORMAT, 2, 0, "a")) return nullptr;
+    if (!get_buffer(b_obj, &b, PyBUF_SIMPLE | PyBUF_FORMAT, 2, a.len, "b")) {
+        PyBuffer_Release(&a);
+        return nullptr;
+    }
+
+    tiadc_dsp::mismatch_estimate e;
+    std::string error;
+    Py_BEGIN_ALLOW_THREADS
+    try {
+        e = tiadc_dsp::estimate_mismatch(static_cast<const int16_t *>(a.buf), static_cast<const int16_t *>(b.buf),
+                                         (size_t)(a.len / 2), opt);
+    } catch (const std::exception &ex) {
+        error = ex.what();
+    }
+    Py_END_ALLOW_THREADS
+
+    PyBuffer_Release(&a);
+    PyBuffer_Release(&b);
+    if (!error.empty()) {
+        PyErr_SetString(PyExc_ValueError, error.c_str());
+        return nullptr;
+    }
+
+    PyObject *out = PyDict_New();
+    if (!out) return nullptr;
+    const double *fields = reinterpret_cast<const double *>(&e);
+    for (size_t i = 0; i < tiadc_dsp::NUM_MISMATCH_FIELDS; i++) {
+        PyObject *v = PyFloat_FromDouble(fields[i]);
+        if (!v || PyDict_SetItemString(out, tiadc_dsp::mismatch_field_names[i], v) < 0) {
+            Py_XDECREF(v);
+            Py_DECREF(out);
+            return nullptr;
+        }
+        Py_DECREF(v);
+    }
+    return out;
+}
+
+PyObject *py_dither(PyObject *, PyObject *args, PyObject *kwds)
+{
+    static const char *kwlist[] = { "out", "fs", "t0", "period", "tau", "amplitude", "t_start", "phase", "periods",
+                                    "codes_per_unit", "memo", nullptr };
+    PyObject *out_obj;
+    double fs, t0, codes_per_unit = 1.0;
+    tiadc_dsp::rc_dither d;
+    Py_ssize_t periods = 1;
+    int memo = 1;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "Odddd|dddndp", const_cast<char **>(kwlist), &out_obj, &fs, &t0,
+                                     &d.period, &d.tau, &d.amplitude, &d.t_start, &d.phase, &periods,
+                                     &codes_per_unit, &memo))
+        return nullptr;
+    if (periods < 0 || (size_t)periods > UINT_MAX) {
+        PyErr_SetString(PyExc_ValueError, "periods: need 0 (free running) or a positive count");
+        return nullptr;
+    }
+    d.periods = (unsigned)periods;
+
+    Py_buffer out;
+    if (PyObject_GetBuffer(out_obj, &out, PyBUF_WRITABLE | PyBUF_FORMAT | PyBUF_C_CONTIGUOUS) < 0) return nullptr;
+    if (!(out.itemsize == 8 && item_is(&out, 'd')) && !(out.itemsize == 2 && item_is(&out, 'h'))) {
+        PyErr_SetString(PyExc_ValueError, "out: need float64 or int16 items");
+        PyBuffer_Release(&out);
+        return nullptr;
+    }
+    const size_t n = (size_t)(out.len / out.itemsize);
+
+    std::string error;
+    Py_BEGIN_ALLOW_THREADS
+    try {
+        if (memo) {
+            auto ref = tiadc_dsp::rc_dither_reference(d, fs, t0, n);
+            if (out.itemsize == 8) std::memcpy(out.buf, ref->data(), n * sizeof(double));
+            else tiadc_dsp::dither_to_codes(ref->data(), n, codes_per_unit, static_cast<int16_t *>(out.buf));
+        } else if (out.itemsize == 8) {
+            tiadc_dsp::rc_dither_render(d, fs, t0, n, static_cast<double *>(out.buf));
+        } else {
+            tiadc_dsp::rc_dither_codes(d, fs, t0, n, codes_per_unit, static_cast<int16_t *>(out.buf));
+        }
+    } catch (const std::exception &e) {
+        error = e.what();
+    }
+    Py_END_ALLOW_THREADS
+
+    PyBuffer_Release(&out);
+    if (!error.empty()) {
+        PyErr_SetString(PyExc_ValueError, error.c_str());
+        return nullptr;
+    }
+    Py_RETURN_NONE;
+}
+
+PyObject *py_dither_cache(PyObject *, PyObject *args, PyObject *kwds)
+{
+    static const char *kwlist[] = { "budget", nullptr };
+    Py_ssize_t budget = -1;
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|n", const_cast<char **>(kwlist), &budget)) return nullptr;
+    if (budget >= 0) tiadc_dsp::set_dither_cache_budget((size_t)budget);
+    tiadc_dsp::cache_stats st = tiadc_dsp::dither_cache_stats();
+    return Py_BuildValue("{s:n,s:n,s:n,s:n,s:n,s:n}", "entries", (Py_ssize_t)st.entries, "bytes", (Py_ssize_t)st.bytes,
+                         "budget", (Py_ssize_t)st.budget, "hits", (Py_ssize_t)st.hits, "misses", (Py_ssize_t)st.misses,
+                         "evictions", (Py_ssize_t)st.evictions);
+}
+
+PyMethodDef module_methods[] = {
+    { "spectral", (PyCFunction)(void (*)(void))py_spectral, METH_VARARGS | METH_KEYWORDS,
+      "spectral(data, out, records, M, samples, fs, ...) -> None; fills out with one metric row per record" },
+    { "mismatch", (PyCFunction)(void (*)(void))py_mismatch, METH_VARARGS | METH_KEYWORDS,
+      "mismatch(a, b, fs, method=\"sine_fit\", ...) -> dict; skew (ps), gain and offsets of B against A" },
+    { "dither", (PyCFunction)(void (*)(void))py_dither, METH_VARARGS | METH_KEYWORDS,
+      "dither(out, fs, t0, period, tau, ...) -> None; fills out with the RC dither sampled at fs" },
+    { "dither_cache", (PyCFunction)(void (*)(void))py_dither_cache, METH_VARARGS | METH_KEYWORDS,
+      "dither_cache(budget=-1) -> dict; reference cache counters, optionally setting its byte budget" },
+    { nullptr, nullptr, 0, nullptr }
+};
+
+PyModuleDef tiadc_dsp_module = {
+    PyModuleDef_HEAD_INIT, "_tiadc_dsp", "Native TI-ADC analysis kernels", -1,
+    module_methods, nullptr, nullptr, nullptr, nullptr
+};
+
+} // namespace
+
+PyMODINIT_FUNC PyInit__tiadc_dsp(void)
+{
+    PyObject *m = PyModule_Create(&tiadc_dsp_module);
+    if (!m) return nullptr;
+
+    PyObject *names = PyTuple_New((Py_ssize_t)tiadc_dsp::NUM_SPECTRAL_METRICS);
+    if (!names) {
+        Py_DECREF(m);
+        return nullptr;
+    }
+    for (size_t i = 0; i < tiadc_dsp::NUM_SPECTRAL_METRICS; i++)
+        PyTuple_SET_ITEM(names, (Py_ssize_t)i, PyUnicode_FromString(tiadc_dsp::spectral_metric_names[i]));
+    if (PyModule_AddObject(m, "metric_names", names) < 0) {
+        Py_DECREF(names);
+        Py_DECREF(m);
+        return nullptr;
+    }
+    return m;
+}
@@ -0,0 +1,497 @@
+/* tiadc_dspd.cpp
+ * Long-lived local compute service: the dither model and the analysis
+ * kernels stay loaded, and answers are memoised, so a tool asking for a
+ * waveform or a metric pays a socket round trip instead of an engine start.
+ *
+ *   tiadc_dspd [socket_path] [cache_mib]
+ *
+ * Socket path defaults to $TIADC_DSPD_SOCK or /tmp/tiadc_dspd.sock, the
+ * cache to 256 MiB.  One thread per client connection.
+ *
+ * Protocol, on a Unix stream socket, any number of requests per connection:
+ *   request   "<op> key=value key=value ... [bytes=N]\n" then N payload bytes
+ *   reply     "ok key=value ... bytes=N\n" then N payload bytes
+ *             "err <message>\n"
+ * Ops:
+ *   ping                                  uptime, request and cache counters
+ *   dither period= tau= t_start= [amplitude=2 phase=0 periods=1] and either
+ *            t_end= points=               float64[points] over [t_start, t_end], see dither.h
+ *            fs= samples= [t0=t_start format=f64|i16 codes_per_unit=1]
+ *                                         samples at t0 + i / fs, float64 or int16 codes
+ *   spectral records= M= samples= fs= [interleaved= conv_a= conv_b= invert_mask= window= harmonics=
+ *            full_scale=], payload int16 records x M x samples
+ *                                         float64 records x metrics, names=... in the reply
+ *   mismatch fs= [method= interleaved= record_len= segments= tone_hz= dither_period= invert_a=
+ *            invert_b=], payload int16 a then b, equal halves
+ *                                         fields of mismatch_estimate in the reply
+ *   flush                                 empty the cache
+ *   quit                                  stop the service
+ * Replies are cached by op, parameters and a hash of the payload.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <set>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <poll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+#include "dither.h"
+#include "lru_cache.h"
+#include "mismatch.h"
+#include "spectral.h"
+
+using namespace tiadc_dsp;
+
+static constexpr size_t HEADER_MAX = 4096;
+static constexpr size_t PAYLOAD_MAX = size_t(1) << 30;
+static constexpr const char *DEFAULT_SOCKET = "/tmp/tiadc_dspd.sock";
+
+static volatile std::sig_atomic_t stop_requested = 0;
+static std::atomic<uint64_t> requests_served{ 0 };
+
+/* Sockets of the running client threads, added by main before the thread
+ * starts and removed as it closes; main waits for the set to empty before
+ * it returns and static destructors run */
+static std::mutex live_mutex;
+static std::condition_variable live_cv;
+static std::set<int> live_fds;
+
+static void on_signal(int)
+{
+    stop_requested = 1;
+}
+
+struct request {
+    std::string op;
+    std::map<std::string, std::string> params;
+    std::vector<char> payload;
+};
+
+struct reply {
+    std::string fields;                 // "key=value ..." after "ok"
+    std::vector<char> payload;
+};
+
+/* ---------------------------------------------------------------------- */
+/*  Parameters                                                             */
+/* ---------------------------------------------------------------------- */
+static const std::string *find(const request &rq, const char *key)
+{
+    auto it = rq.params.find(key);
+    return it == rq.params.end() ? nullptr : &it->second;
+}
+
+static double num(const request &rq, const char *key)
+{
+    const std::string *v = find(rq, key);
+    if (!v) throw std::invalid_argument(std::string("missing parameter ") + key);
+    char *end = nullptr;
+    double d = std::strtod(v->c_str(), &end);
+    if (end == v->c_str() || *end) throw std::invalid_argument(std::string("bad number for ") + key);
+    return d;
+}
+
+static double num(const request &rq, const char *key, double dflt)
+{
+    return find(rq, key) ? num(rq, key) : dflt;
+}
+
+static size_t count(const request &rq, const char *key)
+{
+    double d = num(rq, key);
+    if (d < 0 || d != std::floor(d)) throw std::invalid_argument(std::string("bad count for ") + key);
+    return (size_t)d;
+}
+
+static size_t count(const request &rq, const char *key, size_t dflt)
+{
+    return find(rq, key) ? count(rq, key) : dflt;
+}
+
+static std::string text(const request &rq, const char *key, const char *dflt)
+{
+    const std::string *v = find(rq, key);
+    return v ? *v : dflt;
+}
+
+static std::string fmt(double v)
+{
+    char buf[32];
+    std::snprintf(buf, sizeof(buf), "%.17g", v);
+    return buf;
+}
+
+/* ---------------------------------------------------------------------- */
+/*  Ops                                                                    */
+/* ---------------------------------------------------------------------- */
+static std::chrono::steady_clock::time_point started;
+static lru_cache<reply> *cache;
+
+static reply op_ping(const request &)
+{
+    cache_stats s = cache->stats();
+    reply r;
+    r.fields = "uptime_s=" + fmt(std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count()) +
+               " requests=" + std::to_string(requests_served.load()) + " cache_entries=" + std::to_string(s.entries) +
+               " cache_bytes=" + std::to_string(s.bytes) + " cache_budget=" + std::to_string(s.budget) +
+               " cache_hits=" + std::to_string(s.hits) + " cache_misses=" + std::to_string(s.misses) +
+               " cache_evictions=" + std::to_string(s.evictions);
+    return r;
+}
+
+static reply op_dither(const request &rq)
+{
+    rc_dither d;
+    d.period = num(rq, "period");
+    d.tau = num(rq, "tau");
+    d.amplitude = num(rq, "amplitude", 2.0);
+    d.t_start = num(rq, "t_start");
+    d.phase = num(rq, "phase", 0.0);
+    d.periods = (unsigned)count(rq, "periods", 1);
+
+    reply r;
+    if (!find(rq, "fs")) {
+        size_t points = count(rq, "points");
+        if (!points || points > PAYLOAD_MAX / sizeof(double)) throw std::invalid_argument("points out of range");
+        r.payload.resize(points * sizeof(double));
+        rc_dither_sample(d, d.t_start, num(rq, "t_end"), points, reinterpret_cast<double *>(r.payload.data()));
+        r.fields = "points=" + std::to_string(points);
+        return r;
+    }
+
+    size_t samples = count(rq, "samples");
+    std::string format = text(rq, "format", "f64");
+    if (!samples || samples > PAYLOAD_MAX / sizeof(double)) throw std::invalid_argument("samples out of range");
+    double fs = num(rq, "fs"), t0 = num(rq, "t0", d.t_start);
+    if (format == "f64") {
+        r.payload.resize(samples * sizeof(double));
+        rc_dither_render(d, fs, t0, samples, reinterpret_cast<double *>(r.payload.data()));
+    } else if (format == "i16") {
+        r.payload.resize(samples * sizeof(int16_t));
+        rc_dither_codes(d, fs, t0, samples, num(rq, "codes_per_unit", 1.0), reinterpret_cast<int16_t *>(r.payload.data()));
+    } else {
+        throw std::invalid_argument("unknown format " + format);
+    }
+    r.fields = "samples=" + std::to_string(samples) + " format=" + format;
+    return r;
+}
+
+static window_kind window_of(const std::string &name)
+{
+    if (name == "rect") return window_kind::rect;
+    if (name == "hann") return window_kind::hann;
+    if (name == "blackman_harris") return window_kind::blackman_harris;
+    throw std::invalid_argument("unknown window " + name);
+}
+
+static reply op_spectral(const request &rq)
+{
+    batch_spec spec;
+    spec.records = count(rq, "records");
+    spec.M = count(rq, "M");
+    spec.samples = count(rq, "samples");
+    spec.fs = num(rq, "fs");
+    spec.interleaved = count(rq, "interleaved", 0) != 0;
+    spec.conv_a = (unsigned)count(rq, "conv_a", 0);
+    spec.conv_b = (unsigned)count(rq, "conv_b", 1);
+    spec.invert_mask = (unsigned)count(rq, "invert_mask", 0);
+    spec.opt.window = window_of(text(rq, "window", "blackman_harris"));
+    spec.opt.harmonics = (unsigned)count(rq, "harmonics", 5);
+    spec.opt.full_scale = num(rq, "full_scale", 32768.0);
+    size_t bytes;                       // records x M x samples x 2, refused if it wraps
+    if (!spec.M || __builtin_mul_overflow(spec.records, spec.M, &bytes) ||
+        __builtin_mul_overflow(bytes, spec.samples, &bytes) || __builtin_mul_overflow(bytes, sizeof(int16_t), &bytes) ||
+        rq.payload.size() != bytes)
+        throw std::invalid_argument("payload is not records x M x samples int16");
+
+    std::vector<spectral_metrics> out(spec.records);
+    analyse_batch(reinterpret_cast<const int16_t *>(rq.payload.data()), spec, out.data());
+
+    reply r;
+    r.payload.resize(out.size() * sizeof(spectral_metrics));
+    std::memcpy(r.payload.data(), out.data(), r.payload.size());
+    r.fields = "records=" + std::to_string(spec.records) + " names=";
+    for (size_t i = 0; i < NUM_SPECTRAL_METRICS; i++) r.fields += (i ? "," : "") + std::string(spectral_metric_names[i]);
+    return r;
+}
+
+static reply op_mismatch(const request &rq)
+{
+    mismatch_options opt;
+    std::string method = text(rq, "method", "sine_fit");
+    if (method == "sine_fit") opt.method = mismatch_method::sine_fit;
+    else if (method == "xcorr") opt.method = mismatch_method::xcorr;
+    else if (method == "dither") opt.method = mismatch_method::dither;
+    else throw std::invalid_argument("unknown method " + method);
+    opt.fs = num(rq, "fs");
+    opt.interleaved = count(rq, "interleaved", 0) != 0;
+    opt.record_len = count(rq, "record_len", 0);
+    opt.segments = (unsigned)count(rq, "segments", 16);
+    opt.tone_hz = num(rq, "tone_hz", 0.0);
+    opt.dither_period_s = num(rq, "dither_period", 0.0);
+    opt.invert_a = count(rq, "invert_a", 0) != 0;
+    opt.invert_b = count(rq, "invert_b", 0) != 0;
+    if (rq.payload.size() % (2 * sizeof(int16_t))) throw std::invalid_argument("payload is not two equal int16 halves");
+
+    size_t n = rq.payload.size() / (2 * sizeof(int16_t));
+    const int16_t *a = reinterpret_cast<const int16_t *>(rq.payload.data());
+    mismatch_estimate e = estimate_mismatch(a, a + n, n, opt);
+
+    reply r;
+    const double *fields = reinterpret_cast<const double *>(&e);
+    for (size_t i = 0; i < NUM_MISMATCH_FIELDS; i++)
+        r.fields += (i ? " " : "") + std::string(mismatch_field_names[i]) + "=" + fmt(fields[i]);
+    return r;
+}
+
+/* FNV-1a, enough to tell payloads apart in a cache key */
+static uint64_t fnv1a(const std::vector<char> &data)
+{
+    uint64_t h = 0xcbf29ce484222325ULL;
+    for (char c : data) {
+        h ^= (uint8_t)c;
+        h *= 0x100000001b3ULL;
+    }
+    return h;
+}
+
+static std::shared_ptr<const reply> handle(const request &rq)
+{
+    using handler = reply (*)(const request &);
+    static const std::map<std::string, handler> cached_ops = {
+        { "dither", op_dither }, { "spectral", op_spectral }, { "mismatch", op_mismatch },
+    };
+
+    if (rq.op == "ping") return std::make_shared<reply>(op_ping(rq));
+    if (rq.op == "flush") {
+        cache->clear();
+        return std::make_shared<reply>();
+    }
+    if (rq.op == "quit") {
+        stop_requested = 1;
+        return std::make_shared<reply>();
+    }
+    auto op = cached_ops.find(rq.op);
+    if (op == cached_ops.end()) throw std::invalid_argument("unknown op " + rq.op);
+
+    std::string key = rq.op;
+    for (const auto &kv : rq.params) key += " " + kv.first + "=" + kv.second;
+    char hash[24];
+    std::snprintf(hash, sizeof(hash), " #%016llx", (unsigned long long)fnv1a(rq.payload));
+    key += hash;
+
+    std::shared_ptr<const reply> r = cache->get(key);
+    if (!r) {
+        r = std::make_shared<reply>(op->second(rq));
+        cache->put(key, r, key.size() + r->fields.size() + r->payload.size());
+    }
+    return r;
+}
+
+/* ---------------------------------------------------------------------- */
+/*  Connections                                                            */
+/* ---------------------------------------------------------------------- */
+class connection {
+public:
+    explicit connection(int fd) : fd_(fd) {}
+    ~connection()
+    {
+        std::lock_guard<std::mutex> lock(live_mutex);
+        live_fds.erase(fd_);
+        ::close(fd_);
+        live_cv.notify_all();
+    }
+
+    /* One header line without the newline; false on EOF or an oversized line */
+    bool read_line(std::string &line)
+    {
+        line.clear();
+        for (;;) {
+            if (pos_ == len_ && !fill()) return false;
+            char *nl = static_cast<char *>(std::memchr(buf_ + pos_, '\n', len_ - pos_));
+            size_t take = nl ? (size_t)(nl - (buf_ + pos_)) : len_ - pos_;
+            line.append(buf_ + pos_, take);
+            pos_ += take;
+            if (line.size() > HEADER_MAX) return false;
+            if (nl) {
+                pos_++;
+                return true;
+            }
+        }
+    }
+
+    bool read_exact(char *dst, size_t n)
+    {
+        while (n) {
+            if (pos_ == len_ && !fill()) return false;
+            size_t take = std::min(n, len_ - pos_);
+            std::memcpy(dst, buf_ + pos_, take);
+            pos_ += take;
+            dst += take;
+            n -= take;
+        }
+        return true;
+    }
+
+    bool write_all(const char *src, size_t n)
+    {
+        while (n) {
+            ssize_t w = ::send(fd_, src, n, MSG_NOSIGNAL);
+            if (w <= 0) return false;
+            src += w;
+            n -= (size_t)w;
+        }
+        return true;
+    }
+
+private:
+    bool fill()
+    {
+        ssize_t r = ::recv(fd_, buf_, sizeof(buf_), 0);
+        if (r <= 0) return false;
+        pos_ = 0;
+        len_ = (size_t)r;
+        return true;
+    }
+
+    int fd_;
+    char buf_[65536];
+    size_t pos_ = 0, len_ = 0;
+};
+
+static bool parse_header(const std::string &line, request &rq, size_t &payload_bytes)
+{
+    size_t p = 0;
+    auto next_word = [&](std::string &w) {
+        while (p < line.size() && line[p] == ' ') p++;
+        size_t start = p;
+        while (p < line.size() && line[p] != ' ') p++;
+        w.assign(line, start, p - start);
+        return !w.empty();
+    };
+
+    if (!next_word(rq.op)) return false;
+    payload_bytes = 0;
+    std::string word;
+    while (next_word(word)) {
+        size_t eq = word.find('=');
+        if (eq == std::string::npos || eq == 0) return false;
+        std::string key = word.substr(0, eq), value = word.substr(eq + 1);
+        if (key == "bytes") payload_bytes = std::strtoull(value.c_str(), nullptr, 10);
+        else rq.params[key] = value;
+    }
+    return payload_bytes <= PAYLOAD_MAX;
+}
+
+static void serve(int fd)
+{
+    auto conn = std::make_unique<connection>(fd);
+    std::string line;
+
+    while (conn->read_line(line)) {
+        request rq;
+        size_t bytes = 0;
+        std::string head;
+        std::shared_ptr<const reply> r;
+
+        if (!parse_header(line, rq, bytes)) {
+            head = "err malformed request\n";
+            conn->write_all(head.data(), head.size());
+            return;                     // the payload length is unknown, the stream cannot be resynchronised
+        }
+        rq.payload.resize(bytes);
+        if (!conn->read_exact(rq.payload.data(), bytes)) return;
+
+        try {
+            r = handle(rq);
+            head = "ok" + (r->fields.empty() ? "" : " " + r->fields) + " bytes=" + std::to_string(r->payload.size()) + "\n";
+        } catch (const std::exception &e) {
+            head = std::string("err ") + e.what() + "\n";
+            r.reset();
+        }
+        requests_served++;
+        if (!conn->write_all(head.data(), head.size())) return;
+        if (r && !r->payload.empty() && !conn->write_all(r->payload.data(), r->payload.size())) return;
+    }
+}
+
+int main(int argc, char **argv)
+{
+    const char *env = std::getenv("TIADC_DSPD_SOCK");
+    std::string path = argc > 1 ? argv[1] : env ? env : DEFAULT_SOCKET;
+    size_t cache_mib = argc > 2 ? std::strtoul(argv[2], nullptr, 0) : 256;
+
+    sockaddr_un addr{};
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) {
+        std::fprintf(stderr, "socket path too long: %s\n", path.c_str());
+        return 2;
+    }
+    std::strcpy(addr.sun_path, path.c_str());
+
+    /* A live service on the path wins; a stale socket file is replaced */
+    int probe = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (::connect(probe, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) == 0) {
+        std::fprintf(stderr, "tiadc_dspd already running on %s\n", path.c_str());
+        ::close(probe);
+        return 1;
+    }
+    ::close(probe);
+    ::unlink(path.c_str());
+
+    int lfd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (lfd < 0 || ::bind(lfd, reinterpret_cast<sockaddr *>(&addr), sizeof(addr)) < 0 || ::listen(lfd, 16) < 0) {
+        std::perror("tiadc_dspd: listen");
+        return 1;
+    }
+
+    cache = new lru_cache<reply>(cache_mib << 20);
+    started = std::chrono::steady_clock::now();
+    std::signal(SIGINT, on_signal);
+    std::signal(SIGTERM, on_signal);
+    std::signal(SIGPIPE, SIG_IGN);
+    std::printf("tiadc_dspd: listening on %s, %zu MiB cache\n", path.c_str(), cache_mib);
+    std::fflush(stdout);
+
+    while (!stop_requested) {
+        pollfd pfd{ lfd, POLLIN, 0 };
+        if (::poll(&pfd, 1, 200) <= 0) continue;
+        int fd = ::accept(lfd, nullptr, nullptr);
+        if (fd < 0) continue;
+        {
+            std::lock_guard<std::mutex> lock(live_mutex);
+            live_fds.insert(fd);
+        }
+        std::thread(serve, fd).detach();
+    }
+
+    ::close(lfd);
+    ::unlink(path.c_str());
+
+    /* Wake idle clients out of their reads; a request in progress still
+     * gets its reply, then the thread sees EOF and leaves */
+    {
+        std::unique_lock<std::mutex> lock(live_mutex);
+        for (int fd : live_fds) ::shutdown(fd, SHUT_RD);
+        live_cv.wait(lock, [] { return live_fds.empty(); });
+    }
+    std::printf("tiadc_dspd: stopped after %llu requests\n", (unsigned long long)requests_served.load());
+    return 0;
+}
@@ -0,0 +1,251 @@
+#include "capture_file.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstddef>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace tcap {
+
+static constexpr size_t WRITE_BUFFER_BYTES = 4 << 20;  // WRITE_BUFFER_BYTES in capture_file.py
+static constexpr uint8_t INVERT_MASK = 0x1;            // channel A, INVERT_MASK in capture_file.py
+
+static size_t spc(const layout &m)
+{
+    return std::max<size_t>(1, (32u * m.L) / ((size_t)m.M * m.NP));
+}
+
+static size_t block_bytes(const layout &m)
+{
+    return (size_t)m.M * spc(m) * m.NP / 8;
+}
+
+header make_header(const layout &mode, uint64_t adc_clk_hz, uint32_t delay, const std::string &note)
+{
+    header h = {};
+    struct timespec ts;
+
+    clock_gettime(CLOCK_REALTIME, &ts);
+    std::memcpy(h.magic, "TIADCCAP", 8);
+    h.version = VERSION;
+    h.header_bytes = HEADER_BYTES;
+    h.create_ns = (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+    h.adc_clk_hz = adc_clk_hz;
+    h.sample_rate_hz = adc_clk_hz / std::max<uint8_t>(1, mode.dcm);
+    h.mode_id = mode.mode_id;
+    h.L = mode.L;
+    h.M = mode.M;
+    h.NP = mode.NP;
+    h.dcm = mode.dcm;
+    h.num_ddc = mode.num_ddc;
+    h.ddc_complex = mode.complex;
+    for (unsigned c = 0; c < mode.M && c < sizeof(h.conv_channel); c++) {
+        h.conv_channel[c] = (c < (unsigned)std::max(1, mode.M / 2)) ? 'A' : 'B';
+        h.conv_kind[c] = mode.complex ? "IQ"[c & 1] : 'R';
+    }
+    h.invert_mask = INVERT_MASK;
+    h.delay_mode = (uint8_t)(delay >> 24);
+    h.delay_channel = (uint8_t)(delay >> 16);
+    h.delay_fine = (uint8_t)(delay >> 8);
+    h.delay_super_fine = (uint8_t)delay;
+    h.payload_offset = HEADER_BYTES;
+    std::strncpy(h.note, note.c_str(), sizeof(h.note) - 1);
+    return h;
+}
+
+/* ---------------------------------------------------------------------- */
+/*  writer                                                                 */
+/* ---------------------------------------------------------------------- */
+writer::~writer()
+{
+    try {
+        close();
+    } catch (...) {
+    }
+}
+
+void writer::open(const std::string &path, const header &hdr)
+{
+    close();
+    fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+    if (fd_ < 0) throw std::system_error(errno, std::generic_category(), "tcap: open " + path);
+
+    hdr_ = hdr;
+    hdr_.chunk_count = 0;
+    hdr_.index_offset = 0;
+    index_.clear();
+    buf_.resize(WRITE_BUFFER_BYTES);
+    fill_ = 0;
+    offset_ = 0;
+
+    std::vector<uint8_t> first(HEADER_BYTES, 0);
+    std::memcpy(first.data(), &hdr_, sizeof(hdr_));
+    put(first.data(), first.size());
+}
+
+void writer::flush()
+{
+    for (size_t done = 0; done < fill_; ) {
+        ssize_t r = ::write(fd_, buf_.data() + done, fill_ - done);
+        if (r < 0) {
+            if (errno == EINTR) continue;
+            throw std::system_error(errno, std::generic_category(), "tcap: write");
+        }
+        done += (size_t)r;
+    }
+    fill_ = 0;
+}
+
+void writer::put(const void *p, size_t n)
+{
+    const uint8_t *src = static_cast<const uint8_t *>(p);
+
+    /* Large chunks skip the buffer once it is drained */
+    if (n >= buf_.size()) {
+        flush();
+        for (size_t done = 0; done < n; ) {
+            ssize_t r = ::write(fd_, src + done, n - done);
+            if (r < 0) {
+                if (errno == EINTR) continue;
+                throw std::system_error(errno, std::generic_category(), "tcap: write");
+            }
+            done += (size_t)r;
+        }
+    } else {
+        if (fill_ + n > buf_.size()) flush();
+        std::memcpy(buf_.data() + fill_, src, n);
+        fill_ += n;
+    }
+    offset_ += n;
+}
+
+/* Overwrite header bytes, wherever they are: still in the write buffer or already on disk */
+void writer::patch_header(size_t at, const void *p, size_t n)
+{
+    const uint64_t on_disk = offset_ - fill_;
+
+    if (at >= on_disk) {
+        std::memcpy(buf_.data() + (at - on_disk), p, n);
+    } else if (::pwrite(fd_, p, n, (off_t)at) != (ssize_t)n) {
+        throw std::system_error(errno, std::generic_category(), "tcap: header");
+    }
+}
+
+void writer::append(const int16_t *planar, uint32_t samples, uint64_t seq, uint64_t t_ns, uint32_t delay)
+{
+    if (fd_ < 0) throw std::logic_error("tcap: append on a closed writer");
+    if (!hdr_.samples_per_chunk) {
+        /* The chunk size must reach the file before any payload: a file that
+         * is never closed is recovered from it */
+        hdr_.samples_per_chunk = samples;
+        patch_header(offsetof(header, samples_per_chunk), &hdr_.samples_per_chunk, sizeof(hdr_.samples_per_chunk));
+    }
+
+    index_.push_back({offset_, seq, t_ns, samples, delay});
+    put(planar, (size_t)hdr_.M * samples * sizeof(int16_t));
+}
+
+void writer::close()
+{
+    if (fd_ < 0) return;
+
+    hdr_.index_offset = offset_;
+    hdr_.chunk_count = index_.size();
+    put(index_.data(), index_.size() * sizeof(index_entry));
+    flush();
+    if (::pwrite(fd_, &hdr_, sizeof(hdr_), 0) != (ssize_t)sizeof(hdr_)) {
+        int err = errno;
+        ::close(fd_);
+        fd_ = -1;
+        throw std::system_error(err, std::generic_category(), "tcap: header");
+    }
+    ::close(fd_);
+    fd_ = -1;
+}
+
+/* ---------------------------------------------------------------------- */
+/*  reader                                                                 */
+/* ---------------------------------------------------------------------- */
+reader::reader(const std::string &path)
+{
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    struct stat st;
+
+    if (fd < 0) throw std::system_error(errno, std::generic_category(), "tcap: open " + path);
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < HEADER_BYTES) {
+        ::close(fd);
+        throw std::runtime_error("tcap: " + path + " is too short");
+    }
+    len_ = (size_t)st.st_size;
+    void *p = mmap(nullptr, len_, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) throw std::system_error(errno, std::generic_category(), "tcap: mmap " + path);
+    map_ = static_cast<const uint8_t *>(p);
+
+    const header &h = hdr();
+    auto fail = [&](const std::string &why) {
+        munmap(const_cast<uint8_t *>(map_), len_);
+        map_ = nullptr;
+        throw std::runtime_error("tcap: " + path + " " + why);
+    };
+    if (std::memcmp(h.magic, "TIADCCAP", 8) != 0 || h.version != VERSION) fail("is not a version 1 capture file");
+
+    /* Every offset comes from the file: a truncated or corrupt one must not send chunk() outside the map */
+    if (h.payload_offset < HEADER_BYTES || h.payload_offset > len_) fail("has its payload outside the file");
+    if (h.index_offset) {
+        if (h.index_offset < h.payload_offset || h.index_offset > len_ ||
+            h.chunk_count > (len_ - h.index_offset) / sizeof(index_entry))
+            fail("has its index outside the file");
+        const index_entry *e = reinterpret_cast<const index_entry *>(map_ + h.index_offset);
+        index_.assign(e, e + h.chunk_count);
+        for (const index_entry &x : index_) {
+            uint64_t bytes = (uint64_t)h.M * x.samples * sizeof(int16_t);
+            if (x.offset < h.payload_offset || x.offset > h.index_offset || bytes > h.index_offset - x.offset)
+                fail("has a chunk outside its payload");
+        }
+    } else {
+        /* never closed: fixed-size chunks up to the last complete one */
+        size_t chunk = (size_t)h.M * h.samples_per_chunk * sizeof(int16_t);
+        size_t count = chunk ? (len_ - h.payload_offset) / chunk : 0;
+        uint32_t delay = pack_delay(h.delay_mode, h.delay_fine, h.delay_super_fine, h.delay_channel);
+        for (size_t i = 0; i < count; i++)
+            index_.push_back({h.payload_offset + i * chunk, i, 0, h.samples_per_chunk, delay});
+    }
+}
+
+reader::~reader()
+{
+    if (map_) munmap(const_cast<uint8_t *>(map_), len_);
+}
+
+/* ---------------------------------------------------------------------- */
+/*  unpack                                                                 */
+/* ---------------------------------------------------------------------- */
+void unpack(const layout &mode, const uint8_t *raw, size_t nbytes, int16_t *planar)
+{
+    size_t n = spc(mode), bb = block_bytes(mode);
+    size_t nblk = nbytes / bb, per_conv = nblk * n;
+
+    for (size_t b = 0; b < nblk; b++) {
+        const uint8_t *blk = raw + b * bb;
+        for (unsigned c = 0; c < mode.M; c++) {
+            int16_t *dst = planar + c * per_conv + b * n;
+            if (mode.NP == 16) {
+                std::memcpy(dst, blk + c * n * 2, n * 2);
+            } else {
+                const int8_t *src = reinterpret_cast<const int8_t *>(blk + c * n);
+                for (size_t i = 0; i < n; i++) dst[i] = (int16_t)(src[i] * 256);
+            }
+        }
+    }
+}
+
+} // namespace tcap
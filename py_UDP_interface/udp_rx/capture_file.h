@@ -0,0 +1,125 @@
+/* capture_file.h
+ * C++ side of the .tcap capture container (see capture_file.py for the
+ * layout).  A fixed HEADER_BYTES header, then one chunk per capture as
+ * planar little-endian int16 (M converters x samples), then an index of
+ * chunk_count entries written on close.  The writer streams through a
+ * large userspace buffer with plain write(), the reader maps the whole
+ * file and hands out pointers into the page cache.
+ *
+ * Both ends assume a little-endian host, which every target here is.
+ */
+
+#ifndef UDP_RX_CAPTURE_FILE_H
+#define UDP_RX_CAPTURE_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace tcap {
+
+static constexpr size_t HEADER_BYTES = 4096;
+static constexpr uint32_t VERSION = 1;
+
+#pragma pack(push, 1)
+struct header {                         // HEADER_FORMAT in capture_file.py
+    char magic[8];                      // "TIADCCAP"
+    uint32_t version;
+    uint32_t header_bytes;
+    uint64_t create_ns;                 // CLOCK_REALTIME
+    uint64_t sample_rate_hz;
+    uint64_t adc_clk_hz;
+    uint16_t mode_id;                   // row of jesd_modes[] / JESD_MODES
+    uint8_t L, M, NP, dcm, num_ddc, ddc_complex;
+    char conv_channel[8];               // 'A' / 'B' per converter
+    char conv_kind[8];                  // 'R', or 'I' / 'Q' for complex DDC outputs
+    uint8_t invert_mask;                // converters sign-flipped at the source
+    uint8_t delay_mode, delay_fine, delay_super_fine, delay_channel;
+    uint8_t pad0[3];
+    uint32_t samples_per_chunk;
+    uint8_t pad1[4];
+    uint64_t chunk_count;               // 0 until close()
+    uint64_t index_offset;              // 0 until close()
+    uint64_t payload_offset;
+    char note[256];
+};
+
+struct index_entry {                    // INDEX_FORMAT in capture_file.py
+    uint64_t offset;
+    uint64_t seq;
+    uint64_t t_ns;                      // CLOCK_REALTIME
+    uint32_t samples;                   // per converter
+    uint32_t delay;                     // see pack_delay()
+};
+#pragma pack(pop)
+
+static_assert(sizeof(header) == 360, "header layout must match capture_file.py");
+static_assert(sizeof(index_entry) == 32, "index layout must match capture_file.py");
+
+struct layout {                         // one row of the JESD mode table
+    uint16_t mode_id = 11;
+    uint8_t L = 4, M = 2, NP = 16, dcm = 1, num_ddc = 0;
+    bool complex = false;
+};
+
+inline uint32_t pack_delay(uint8_t mode, uint8_t fine, uint8_t super_fine, uint8_t channel)
+{
+    return (uint32_t)mode << 24 | (uint32_t)channel << 16 | (uint32_t)fine << 8 | super_fine;
+}
+
+/* Default header for a mode: rate, converter layout, channel A inverted */
+header make_header(const layout &mode, uint64_t adc_clk_hz, uint32_t delay, const std::string &note);
+
+class writer {
+public:
+    writer() = default;
+    ~writer();
+    writer(const writer &) = delete;
+    writer &operator=(const writer &) = delete;
+
+    void open(const std::string &path, const header &hdr);   // throws std::system_error
+    /* One chunk: samples per converter, converter c at planar + c * samples */
+    void append(const int16_t *planar, uint32_t samples, uint64_t seq, uint64_t t_ns, uint32_t delay);
+    void close();                                            // index + header patch, idempotent
+
+    uint64_t chunks() const { return index_.size(); }
+    uint64_t bytes() const { return offset_; }
+
+private:
+    void put(const void *p, size_t n);
+    void flush();
+    void patch_header(size_t at, const void *p, size_t n);
+
+    int fd_ = -1;
+    header hdr_ = {};
+    uint64_t offset_ = 0;
+    std::vector<uint8_t> buf_;
+    size_t fill_ = 0;
+    std::vector<index_entry> index_;
+};
+
+class reader {
+public:
+    explicit reader(const std::string &path);                // throws on a bad file
+    ~reader();
+    reader(const reader &) = delete;
+    reader &operator=(const reader &) = delete;
+
+    const header &hdr() const { return *reinterpret_cast<const header *>(map_); }
+    size_t size() const { return index_.size(); }
+    const index_entry &entry(size_t i) const { return index_[i]; }
+    const int16_t *chunk(size_t i) const { return reinterpret_cast<const int16_t *>(map_ + index_[i].offset); }
+
+private:
+    const uint8_t *map_ = nullptr;
+    size_t len_ = 0;
+    std::vector<index_entry> index_;
+};
+
+/* Split raw link-layout capture bytes into planar int16 (NP = 8 scaled x256), as JesdMode.unpack */
+void unpack(const layout &mode, const uint8_t *raw, size_t nbytes, int16_t *planar);
+
+} // namespace tcap
+
+#endif /* UDP_RX_CAPTURE_FILE_H */
@@ -0,0 +1,158 @@
+/* capture_file_check.cpp
+ * Self-check of the .tcap writer and reader: a closed file round-trips
+ * every chunk through the index, and a writer that dies without close()
+ * (a child process that _exit()s, like a killed recorder) leaves a file the
+ * reader recovers from the fixed chunk size in the header.  Copies of the
+ * closed file with an index entry, the chunk count or the payload offset
+ * pointing outside the file must be refused.
+ *
+ *   capture_file_check [chunks] [samples] [dir]
+ *
+ * Exits non-zero when a chunk is missing or its content is wrong, or a
+ * corrupt file opens.
+ */
+
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include "capture_file.h"
+
+/* Sample i of converter c in chunk n */
+static int16_t pattern_sample(uint64_t n, unsigned c, size_t i)
+{
+    return (int16_t)(n * 7919 + c * 104729 + i);
+}
+
+static void write_chunks(tcap::writer &w, const tcap::layout &mode, uint64_t chunks, uint32_t samples)
+{
+    std::vector<int16_t> planar((size_t)mode.M * samples);
+
+    for (uint64_t n = 0; n < chunks; n++) {
+        for (unsigned c = 0; c < mode.M; c++)
+            for (size_t i = 0; i < samples; i++) planar[c * samples + i] = pattern_sample(n, c, i);
+        w.append(planar.data(), samples, n, n, tcap::pack_delay(0, 0, 0, 3));
+    }
+}
+
+/* Chunks the reader sees, each checked against the pattern; -1 on a bad chunk */
+static long check_chunks(const tcap::reader &r, const tcap::layout &mode, uint32_t samples)
+{
+    for (size_t n = 0; n < r.size(); n++) {
+        const int16_t *p = r.chunk(n);
+        if (r.entry(n).samples != samples) return -1;
+        for (unsigned c = 0; c < mode.M; c++)
+            for (size_t i = 0; i < samples; i++)
+                if (p[c * samples + i] != pattern_sample(n, c, i)) return -1;
+    }
+    return (long)r.size();
+}
+
+/* A copy of src with the 8 bytes at offset at set to v; true if the reader refuses it */
+static bool refused(const std::string &src, const std::string &path, size_t at, uint64_t v)
+{
+    std::ifstream in(src, std::ios::binary);
+    std::vector<char> bytes((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+    if (at + sizeof(v) > bytes.size()) return false;
+    std::memcpy(bytes.data() + at, &v, sizeof(v));
+    std::ofstream(path, std::ios::binary | std::ios::trunc).write(bytes.data(), (std::streamsize)bytes.size());
+    try {
+        tcap::reader r(path);
+    } catch (const std::runtime_error &) {
+        return true;
+    }
+    return false;
+}
+
+int main(int argc, char **argv)
+{
+    uint64_t chunks = (argc > 1) ? std::strtoull(argv[1], nullptr, 0) : 20000;
+    uint32_t samples = (argc > 2) ? (uint32_t)std::strtoul(argv[2], nullptr, 0) : 128;
+    std::string dir = (argc > 3) ? argv[3] : "/tmp";
+    std::string closed_path = dir + "/capture_file_check_closed.tcap";
+    std::string crashed_path = dir + "/capture_file_check_crashed.tcap";
+    std::string corrupt_path = dir + "/capture_file_check_corrupt.tcap";
+    tcap::layout mode;
+    bool ok = true;
+
+    try {
+        /* Closed: every chunk comes back through the index */
+        {
+            tcap::writer w;
+            w.open(closed_path, tcap::make_header(mode, 500000000, tcap::pack_delay(0, 0, 0, 3), "check"));
+            write_chunks(w, mode, chunks, samples);
+            w.close();
+        }
+        {
+            tcap::reader r(closed_path);
+            long n = check_chunks(r, mode, samples);
+            std::printf("closed:  %ld of %llu chunks, chunk_count=%llu\n", n, (unsigned long long)chunks,
+                        (unsigned long long)r.hdr().chunk_count);
+            ok &= n == (long)chunks && r.hdr().chunk_count == chunks;
+        }
+
+        /* Corrupt copies of it: nothing may point outside the file */
+        {
+            tcap::reader r(closed_path);
+            size_t index = r.hdr().index_offset, len = index + chunks * sizeof(tcap::index_entry);
+            size_t entry = index + (chunks - 1) * sizeof(tcap::index_entry);
+            bool all = chunks > 0;
+            all &= refused(closed_path, corrupt_path, entry + offsetof(tcap::index_entry, offset), len);
+            all &= refused(closed_path, corrupt_path, entry + offsetof(tcap::index_entry, samples), 0xFFFFFFFFull | 8ull << 32);
+            all &= refused(closed_path, corrupt_path, offsetof(tcap::header, chunk_count), 1ull << 59);
+            all &= refused(closed_path, corrupt_path, offsetof(tcap::header, index_offset), len + 1);
+            all &= refused(closed_path, corrupt_path, offsetof(tcap::header, payload_offset), len + 1);
+            std::printf("corrupt: entry offset, entry samples, chunk count, index and payload offsets %s\n",
+                        all ? "refused" : "NOT refused");
+            ok &= all;
+        }
+
+        /* Crashed: the child never closes, whatever left the write buffer is recovered */
+        pid_t pid = fork();
+        if (pid == 0) {
+            try {
+                tcap::writer *w = new tcap::writer;     // leaked on purpose: no destructor, no close()
+                w->open(crashed_path, tcap::make_header(mode, 500000000, tcap::pack_delay(0, 0, 0, 3), "check"));
+                write_chunks(*w, mode, chunks, samples);
+            } catch (const std::exception &e) {
+                std::fprintf(stderr, "crashed writer: %s\n", e.what());
+                _exit(1);
+            }
+            _exit(0);
+        }
+        int status = 0;
+        if (pid < 0 || waitpid(pid, &status, 0) != pid || !WIFEXITED(status) || WEXITSTATUS(status) != 0) {
+            std::printf("crashed: writer process failed\n");
+            ok = false;
+        } else {
+            struct stat st;
+            stat(crashed_path.c_str(), &st);
+            size_t chunk_bytes = (size_t)mode.M * samples * sizeof(int16_t);
+            long expect = (long)(((size_t)st.st_size - tcap::HEADER_BYTES) / chunk_bytes);
+            tcap::reader r(crashed_path);
+            long n = check_chunks(r, mode, samples);
+            std::printf("crashed: %ld chunks recovered of %ld on disk, spc=%u\n", n, expect,
+                        r.hdr().samples_per_chunk);
+            ok &= r.hdr().chunk_count == 0 && r.hdr().samples_per_chunk == samples && n > 0 && n == expect;
+        }
+    } catch (const std::exception &e) {
+        std::printf("error: %s\n", e.what());
+        ok = false;
+    }
+    unlink(closed_path.c_str());
+    unlink(crashed_path.c_str());
+    unlink(corrupt_path.c_str());
+
+    std::printf("capture_file: %s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,375 @@
+#include "fleet_rx.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "udp_rx.h"
+
+namespace udp_rx {
+
+enum { FS_DATAGRAMS, FS_BYTES, FS_SYSCALLS, FS_CAPTURES, FS_RECORDS, FS_INCOMPLETE, FS_PARTIAL, FS_FOREIGN,
+       FS_DUPLICATES, FS_BAD_STAMPS, FS_UNSTAMPED };
+
+fleet_receiver::fleet_receiver(const fleet_config &cfg)
+    : cfg_(cfg), board_st_(cfg.boards.size())
+{
+    if (cfg_.boards.empty() || cfg_.queues == 0 || cfg_.capture_bytes == 0 || cfg_.datagram_bytes == 0 ||
+        cfg_.batch == 0 || cfg_.clock_window == 0 || cfg_.max_pending == 0 || cfg_.max_capture_bytes == 0)
+        throw std::invalid_argument("fleet_rx: boards, queues, capture_bytes, datagram_bytes, batch, clock_window, "
+                                    "max_pending and max_capture_bytes must be non-zero");
+    for (size_t b = 0; b < cfg_.boards.size(); b++) {
+        struct in_addr ip;
+        if (inet_pton(AF_INET, cfg_.boards[b].addr.c_str(), &ip) != 1)
+            throw std::invalid_argument("fleet_rx: bad board address " + cfg_.boards[b].addr);
+        if (!board_of_.emplace(ip.s_addr, b).second)
+            throw std::invalid_argument("fleet_rx: board address " + cfg_.boards[b].addr + " given twice");
+    }
+    asm_.resize((size_t)cfg_.queues * cfg_.boards.size());
+    clocks_.resize(cfg_.boards.size());
+
+    stop_fd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (stop_fd_ < 0) throw std::system_error(errno, std::generic_category(), "fleet_rx: eventfd");
+}
+
+fleet_receiver::~fleet_receiver()
+{
+    stop();
+    if (stop_fd_ >= 0) close(stop_fd_);
+}
+
+void fleet_receiver::start()
+{
+    struct sockaddr_in addr = {};
+    socklen_t len = sizeof(rcvbuf_);
+    int one = 1;
+
+    if (running_.load()) return;
+
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(cfg_.port);
+    if (inet_pton(AF_INET, cfg_.bind_addr.c_str(), &addr.sin_addr) != 1)
+        throw std::invalid_argument("fleet_rx: bad bind address " + cfg_.bind_addr);
+
+    for (unsigned q = 0; q < cfg_.queues; q++) {
+        int fd = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC | SOCK_NONBLOCK, 0);
+        if (fd < 0) {
+            int err = errno;
+            stop();
+            throw std::system_error(err, std::generic_category(), "fleet_rx: socket");
+        }
+        setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+        setsockopt(fd, SOL_SOCKET, SO_REUSEPORT, &one, sizeof(one));
+        /* SO_RCVBUFFORCE needs CAP_NET_ADMIN; fall back to what rmem_max allows */
+        if (setsockopt(fd, SOL_SOCKET, SO_RCVBUFFORCE, &cfg_.rcvbuf_bytes, sizeof(cfg_.rcvbuf_bytes)) != 0)
+            setsockopt(fd, SOL_SOCKET, SO_RCVBUF, &cfg_.rcvbuf_bytes, sizeof(cfg_.rcvbuf_bytes));
+        getsockopt(fd, SOL_SOCKET, SO_RCVBUF, &rcvbuf_, &len);
+        if (bind(fd, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) != 0) {
+            int err = errno;
+            close(fd);
+            stop();
+            throw std::system_error(err, std::generic_category(), "fleet_rx: bind port " + std::to_string(cfg_.port));
+        }
+        fds_.push_back(fd);
+    }
+
+    running_.store(true);
+    for (unsigned q = 0; q < cfg_.queues; q++) {
+        threads_.emplace_back(&fleet_receiver::rx_loop, this, q);
+        if (q < cfg_.cpus.size() && cfg_.cpus[q] >= 0) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cfg_.cpus[q], &set);
+            int err = pthread_setaffinity_np(threads_.back().native_handle(), sizeof(set), &set);
+            if (err)
+                std::fprintf(stderr, "fleet_rx: cannot pin queue %u to CPU %d: %s\n", q, cfg_.cpus[q], std::strerror(err));
+        }
+    }
+}
+
+void fleet_receiver::stop()
+{
+    uint64_t one = 1;
+
+    running_.store(false);
+    (void)!write(stop_fd_, &one, sizeof(one));
+    for (std::thread &t : threads_)
+        if (t.joinable()) t.join();
+    threads_.clear();
+    for (int fd : fds_) close(fd);
+    fds_.clear();
+    (void)!read(stop_fd_, &one, sizeof(one));
+    ready_cv_.notify_all();
+}
+
+bool fleet_receiver::next(fleet_record &out, int timeout_ms)
+{
+    using clock = std::chrono::steady_clock;
+    const auto deadline = clock::now() + std::chrono::milliseconds(timeout_ms < 0 ? 0 : timeout_ms);
+    std::unique_lock<std::mutex> guard(lock_);
+
+    for (;;) {
+        expire(monotonic_ns());
+        if (!ready_.empty()) {
+            out = std::move(ready_.front());
+            ready_.pop_front();
+            return true;
+        }
+        if (timeout_ms >= 0 && clock::now() >= deadline) return false;
+        /* wake now and then to time out records whose last board never comes */
+        auto wake = clock::now() + std::chrono::milliseconds(std::max(1, cfg_.record_timeout_ms / 4));
+        ready_cv_.wait_until(guard, timeout_ms >= 0 ? std::min(wake, deadline) : wake);
+    }
+}
+
+int64_t fleet_receiver::clock_offset(size_t b) const
+{
+    std::lock_guard<std::mutex> guard(lock_);
+    return b < clocks_.size() ? clocks_[b].offset : 0;
+}
+
+fleet_stats fleet_receiver::get_stats() const
+{
+    fleet_stats s;
+    s.datagrams       = st_[FS_DATAGRAMS].load(std::memory_order_relaxed);
+    s.bytes           = st_[FS_BYTES].load(std::memory_order_relaxed);
+    s.syscalls        = st_[FS_SYSCALLS].load(std::memory_order_relaxed);
+    s.captures        = st_[FS_CAPTURES].load(std::memory_order_relaxed);
+    s.records         = st_[FS_RECORDS].load(std::memory_order_relaxed);
+    s.incomplete      = st_[FS_INCOMPLETE].load(std::memory_order_relaxed);
+    s.partial_dropped = st_[FS_PARTIAL].load(std::memory_order_relaxed);
+    s.foreign         = st_[FS_FOREIGN].load(std::memory_order_relaxed);
+    s.duplicates      = st_[FS_DUPLICATES].load(std::memory_order_relaxed);
+    s.bad_stamps      = st_[FS_BAD_STAMPS].load(std::memory_order_relaxed);
+    s.unstamped       = st_[FS_UNSTAMPED].load(std::memory_order_relaxed);
+    for (const auto &c : board_st_) s.board_captures.push_back(c.load(std::memory_order_relaxed));
+    return s;
+}
+
+void fleet_receiver::rx_loop(unsigned q)
+{
+    const size_t slot = std::max(cfg_.datagram_bytes, sizeof(board_stamp));
+    const size_t nb = cfg_.boards.size();
+    const uint64_t idle_ns = (uint64_t)cfg_.idle_reset_ms * 1000000ULL;
+    std::vector<uint8_t> buf((size_t)cfg_.batch * slot);
+    std::vector<struct mmsghdr> msgs(cfg_.batch);
+    std::vector<struct iovec> iovs(cfg_.batch);
+    std::vector<struct sockaddr_in> from(cfg_.batch);
+    struct epoll_event ev = {}, evs[2];
+
+    int ep = epoll_create1(EPOLL_CLOEXEC);
+    if (ep < 0) {
+        std::perror("fleet_rx: epoll_create1");
+        return;
+    }
+    ev.events = EPOLLIN;
+    ev.data.fd = fds_[q];
+    epoll_ctl(ep, EPOLL_CTL_ADD, fds_[q], &ev);
+    ev.data.fd = stop_fd_;
+    epoll_ctl(ep, EPOLL_CTL_ADD, stop_fd_, &ev);
+
+    while (running_.load(std::memory_order_relaxed)) {
+        int n = epoll_wait(ep, evs, 2, std::max(10, cfg_.idle_reset_ms / 2));
+        uint64_t now = monotonic_ns();
+
+        for (size_t b = 0; b < nb; b++) {
+            assembly &a = asm_[(size_t)q * nb + b];
+            if ((a.active || a.discard) && now - a.cap.t_last_ns > idle_ns) {
+                if (a.active) st_[FS_PARTIAL].fetch_add(1, std::memory_order_relaxed);
+                a.active = false;
+                a.discard = false;
+            }
+        }
+        if (n <= 0) continue;
+
+        /* Level-triggered: drain until a short batch, epoll reports whatever arrives after */
+        for (;;) {
+            for (unsigned k = 0; k < cfg_.batch; k++) {
+                iovs[k].iov_base = buf.data() + (size_t)k * slot;
+                iovs[k].iov_len = slot;
+                std::memset(&msgs[k].msg_hdr, 0, sizeof(msgs[k].msg_hdr));
+                msgs[k].msg_hdr.msg_iov = &iovs[k];
+                msgs[k].msg_hdr.msg_iovlen = 1;
+                msgs[k].msg_hdr.msg_name = &from[k];
+                msgs[k].msg_hdr.msg_namelen = sizeof(from[k]);
+            }
+            int r = recvmmsg(fds_[q], msgs.data(), cfg_.batch, MSG_DONTWAIT, nullptr);
+            if (r <= 0) break;
+
+            now = monotonic_ns();
+            st_[FS_SYSCALLS].fetch_add(1, std::memory_order_relaxed);
+            st_[FS_DATAGRAMS].fetch_add((uint64_t)r, std::memory_order_relaxed);
+            for (int k = 0; k < r; k++) {
+                size_t got = msgs[k].msg_len;
+                st_[FS_BYTES].fetch_add(got, std::memory_order_relaxed);
+                auto it = board_of_.find(from[k].sin_addr.s_addr);
+                if (it == board_of_.end()) {
+                    st_[FS_FOREIGN].fetch_add(1, std::memory_order_relaxed);
+                    continue;
+                }
+                assembly &a = asm_[(size_t)q * nb + it->second];
+                if (msgs[k].msg_hdr.msg_flags & MSG_TRUNC) {
+                    /* the stream does not line up with the capture: start over */
+                    if (a.active) st_[FS_PARTIAL].fetch_add(1, std::memory_order_relaxed);
+                    a.active = false;
+                    continue;
+                }
+                on_datagram(q, it->second, static_cast<const uint8_t *>(iovs[k].iov_base), got, now);
+            }
+            if ((unsigned)r < cfg_.batch) break;
+        }
+        if (!running_.load(std::memory_order_relaxed)) break;
+    }
+    close(ep);
+}
+
+void fleet_receiver::on_datagram(unsigned q, size_t b, const uint8_t *p, size_t len, uint64_t now)
+{
+    assembly &a = asm_[(size_t)q * cfg_.boards.size() + b];
+    board_stamp s;
+
+    if (len == sizeof(s)) std::memcpy(&s, p, sizeof(s));
+    if (len == sizeof(s) && s.magic == STAMP_MAGIC) {
+        if (a.active) st_[FS_PARTIAL].fetch_add(1, std::memory_order_relaxed);
+        a.active = false;
+        a.cap.t_last_ns = now;
+        /* the sizes come off the wire: an empty or oversized set would swallow data or exhaust memory */
+        a.discard = s.captures == 0 || s.capture_bytes == 0 || s.capture_bytes > cfg_.max_capture_bytes;
+        if (a.discard) {
+            st_[FS_BAD_STAMPS].fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        a.active = true;
+        a.cap.board_id = cfg_.boards[b].id;
+        a.cap.tag = s.tag;
+        a.cap.stamped = true;
+        a.cap.captures = s.captures;
+        a.cap.capture_bytes = s.capture_bytes;
+        std::memcpy(a.cap.delay, s.delay, sizeof(s.delay));
+        a.cap.board_ns = s.counts_per_second
+                             ? (uint64_t)((unsigned __int128)s.t_capture * 1000000000u / s.counts_per_second)
+                             : 0;
+        a.cap.t_first_ns = now;
+        a.expected = (size_t)s.captures * s.capture_bytes;
+        a.cap.data.clear();
+        a.cap.data.reserve(a.expected);
+        return;
+    }
+
+    if (a.discard) {
+        a.cap.t_last_ns = now;
+        return;
+    }
+    if (!a.active) {
+        if (cfg_.boards.size() > 1) {
+            st_[FS_UNSTAMPED].fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+        a.active = true;
+        a.cap.board_id = cfg_.boards[b].id;
+        a.cap.tag = a.next_count++;
+        a.cap.stamped = false;
+        a.cap.captures = 1;
+        a.cap.capture_bytes = (uint32_t)cfg_.capture_bytes;
+        std::memset(a.cap.delay, 0, sizeof(a.cap.delay));
+        a.cap.board_ns = 0;
+        a.cap.t_first_ns = now;
+        a.expected = cfg_.capture_bytes;
+        a.cap.data.clear();
+        a.cap.data.reserve(a.expected);
+    }
+    a.cap.data.insert(a.cap.data.end(), p, p + std::min(len, a.expected - a.cap.data.size()));
+    a.cap.t_last_ns = now;
+    if (a.cap.data.size() < a.expected) return;
+
+    a.active = false;
+    st_[FS_CAPTURES].fetch_add(1, std::memory_order_relaxed);
+    board_st_[b].fetch_add(1, std::memory_order_relaxed);
+    deliver(b, std::move(a.cap));
+    a.cap = board_capture{};
+}
+
+void fleet_receiver::deliver(size_t b, board_capture &&cap)
+{
+    const size_t nb = cfg_.boards.size();
+    uint64_t now = monotonic_ns();
+    std::lock_guard<std::mutex> guard(lock_);
+
+    if (cap.stamped) {
+        clock_track &c = clocks_[b];
+        c.diffs.push_back((int64_t)cap.t_first_ns - (int64_t)cap.board_ns);
+        if (c.diffs.size() > cfg_.clock_window) c.diffs.pop_front();
+        c.offset = *std::min_element(c.diffs.begin(), c.diffs.end());
+        cap.t_aligned_ns = (int64_t)cap.board_ns + c.offset;
+    } else {
+        cap.t_aligned_ns = (int64_t)cap.t_first_ns;
+    }
+
+    expire(now);
+    auto it = pending_.find(cap.tag);
+    if (it == pending_.end()) {
+        if (pending_.size() >= cfg_.max_pending) {
+            auto oldest = std::min_element(pending_.begin(), pending_.end(), [](const auto &x, const auto &y) {
+                return x.second.t_created_ns < y.second.t_created_ns;
+            });
+            pending_.erase(oldest);
+            st_[FS_INCOMPLETE].fetch_add(1, std::memory_order_relaxed);
+        }
+        it = pending_.emplace(cap.tag, pending{}).first;
+        it->second.parts.resize(nb);
+        it->second.have.assign(nb, false);
+        it->second.t_created_ns = now;
+    }
+    pending &pd = it->second;
+    if (pd.have[b]) {
+        st_[FS_DUPLICATES].fetch_add(1, std::memory_order_relaxed);
+    } else {
+        pd.have[b] = true;
+        pd.count++;
+    }
+    pd.parts[b] = std::move(cap);
+    if (pd.count < nb) return;
+
+    fleet_record rec;
+    rec.tag = it->first;
+    rec.parts = std::move(pd.parts);
+    int64_t lo = rec.parts[0].t_aligned_ns, hi = lo;
+    for (const board_capture &p : rec.parts) {
+        lo = std::min(lo, p.t_aligned_ns);
+        hi = std::max(hi, p.t_aligned_ns);
+    }
+    rec.spread_ns = hi - lo;
+    pending_.erase(it);
+    ready_.push_back(std::move(rec));
+    st_[FS_RECORDS].fetch_add(1, std::memory_order_relaxed);
+    ready_cv_.notify_one();
+}
+
+void fleet_receiver::expire(uint64_t now)
+{
+    const int64_t limit = (int64_t)cfg_.record_timeout_ms * 1000000LL;
+    for (auto it = pending_.begin(); it != pending_.end();) {
+        /* signed: a receive thread may have stamped the entry after the caller read now */
+        if ((int64_t)(now - it->second.t_created_ns) > limit) {
+            it = pending_.erase(it);
+            st_[FS_INCOMPLETE].fetch_add(1, std::memory_order_relaxed);
+        } else {
+            ++it;
+        }
+    }
+}
+
+} // namespace udp_rx
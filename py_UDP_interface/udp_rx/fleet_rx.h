@@ -0,0 +1,184 @@
+/* fleet_rx.h
+ * Multi-board receiver: N boards stream to one host port, each from its own
+ * address (BOARD_ID in ethernet.h), and come out as synchronised records,
+ * one capture set per board.
+ *
+ * Receive side: one thread per NIC queue, each with its own SO_REUSEPORT
+ * socket on the shared port, so the kernel spreads the boards' flows over
+ * the queues and a board always lands on the same one.  Each thread waits
+ * in epoll and drains its socket with recvmmsg() batches, sorting the
+ * datagrams by source address into per-board assemblies.
+ *
+ * Stamped sweep points (UDP_CFG_STAMP) open with a struct udp_stamp datagram
+ * carrying the host's tag, the delay applied and the board time of the
+ * first capture; captures of all boards with the same tag form one record.
+ * A stamp announcing no captures or captures over max_capture_bytes is
+ * refused, and its data dropped up to the next stamp or idle gap.
+ *
+ * Unstamped datagrams carry no header, so a lost one cannot be told from
+ * the next capture's; they are taken, tagged by capture count, only from a
+ * fleet of one board, and dropped and counted from a larger fleet, where a
+ * single loss would pair every later capture with the wrong record.
+ *
+ * Alignment: board clocks are free running, so each board's offset to
+ * CLOCK_MONOTONIC is tracked as the smallest (arrival - board time) over
+ * its recent stamps, which takes out the network's queueing delay; a
+ * capture's board time plus that offset puts every board on one time base.
+ * Records missing a board after record_timeout_ms are dropped and counted.
+ */
+
+#ifndef UDP_RX_FLEET_RX_H
+#define UDP_RX_FLEET_RX_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace udp_rx {
+
+static constexpr uint32_t STAMP_MAGIC = 0x504D5453u;   // UDP_STAMP_MAGIC in ethernet.h
+
+struct board_stamp {                    // struct udp_stamp in ethernet.h
+    uint32_t magic;
+    uint16_t board_id;
+    uint8_t captures;
+    uint8_t flags;
+    uint32_t tag;
+    uint32_t capture_bytes;
+    uint64_t t_capture;
+    uint32_t counts_per_second;
+    uint8_t delay[4];
+};
+static_assert(sizeof(board_stamp) == 32, "board_stamp must match struct udp_stamp");
+
+struct board {
+    uint16_t id;
+    std::string addr;
+};
+
+struct fleet_config {
+    std::string bind_addr = "0.0.0.0";
+    uint16_t port = 5002;               // SERVER_PORT in ethernet.h
+    std::vector<board> boards;
+    size_t capture_bytes = 512;         // one capture, jesdmode_capture_bytes(); unstamped unit
+    size_t datagram_bytes = 1024;       // UDP_CHUNK_MAX in ethernet.h
+    unsigned queues = 1;                // receive threads, one SO_REUSEPORT socket each
+    std::vector<int> cpus;              // pin queue q to cpus[q], empty = leave to the scheduler
+    unsigned batch = 64;                // datagrams per recvmmsg()
+    int rcvbuf_bytes = 64 << 20;
+    int idle_reset_ms = 100;            // drop a board's partial capture set after this idle time
+    int record_timeout_ms = 500;        // drop a record still missing a board after this
+    size_t max_pending = 1024;          // records waiting for their last board
+    size_t clock_window = 32;           // stamps behind each board's offset estimate
+    size_t max_capture_bytes = 1 << 16; // largest capture_bytes a stamp may announce
+};
+
+struct board_capture {
+    uint16_t board_id;
+    uint32_t tag;                       // the host's tag, or the board's capture count unstamped
+    bool stamped;
+    uint32_t captures;                  // captures in data, back to back
+    uint32_t capture_bytes;             // per capture: the stamp's, or fleet_config::capture_bytes unstamped
+    uint8_t delay[4];                   // from the stamp, zero unstamped
+    uint64_t board_ns;                  // board time of the first capture, board clock
+    uint64_t t_first_ns, t_last_ns;     // CLOCK_MONOTONIC arrival of the first / last datagram
+    int64_t t_aligned_ns;               // capture time on CLOCK_MONOTONIC, arrival time unstamped
+    std::vector<uint8_t> data;
+};
+
+struct fleet_record {
+    uint32_t tag;
+    std::vector<board_capture> parts;   // in fleet_config::boards order
+    int64_t spread_ns;                  // latest minus earliest t_aligned_ns
+};
+
+struct fleet_stats {
+    uint64_t datagrams;
+    uint64_t bytes;
+    uint64_t syscalls;                  // recvmmsg() calls that returned data
+    uint64_t captures;                  // completed board capture sets
+    uint64_t records;
+    uint64_t incomplete;                // records dropped with a board missing
+    uint64_t partial_dropped;           // capture sets cut short (idle, new stamp)
+    uint64_t foreign;                   // datagram from an address not in the fleet
+    uint64_t duplicates;                // second capture set of a board for one tag
+    uint64_t bad_stamps;                // stamps refused: no captures, or capture_bytes out of range
+    uint64_t unstamped;                 // datagrams without a stamp from a fleet of several boards
+    std::vector<uint64_t> board_captures;
+};
+
+class fleet_receiver {
+public:
+    explicit fleet_receiver(const fleet_config &cfg);
+    ~fleet_receiver();
+
+    fleet_receiver(const fleet_receiver &) = delete;
+    fleet_receiver &operator=(const fleet_receiver &) = delete;
+
+    void start();                       // throws std::system_error on socket failure
+    void stop();
+
+    /* Next complete record, false after timeout_ms (-1 waits forever) */
+    bool next(fleet_record &out, int timeout_ms);
+
+    /* Board b's current offset board -> CLOCK_MONOTONIC in ns, 0 before its first stamp */
+    int64_t clock_offset(size_t b) const;
+
+    const fleet_config &cfg() const { return cfg_; }
+    int actual_rcvbuf() const { return rcvbuf_; }
+    fleet_stats get_stats() const;
+
+private:
+    struct assembly {
+        bool active = false;
+        board_capture cap;
+        bool discard = false;           // after a refused stamp: drop data until the next stamp or idle gap
+        size_t expected = 0;
+        uint32_t next_count = 0;        // unstamped capture count, one-board fleets only
+    };
+    struct pending {
+        std::vector<board_capture> parts;
+        std::vector<bool> have;
+        size_t count = 0;
+        uint64_t t_created_ns = 0;
+    };
+    struct clock_track {
+        std::deque<int64_t> diffs;
+        int64_t offset = 0;
+    };
+
+    void rx_loop(unsigned q);
+    void on_datagram(unsigned q, size_t b, const uint8_t *p, size_t len, uint64_t now);
+    void deliver(size_t b, board_capture &&cap);
+    void expire(uint64_t now);          // lock_ held
+
+    fleet_config cfg_;
+    std::vector<int> fds_;
+    int stop_fd_ = -1;
+    int rcvbuf_ = 0;
+    std::unordered_map<uint32_t, size_t> board_of_;     // source IP (network order) -> board index
+    std::vector<assembly> asm_;                         // queue q, board b at q * boards + b
+
+    mutable std::mutex lock_;
+    std::condition_variable ready_cv_;
+    std::map<uint32_t, pending> pending_;
+    std::deque<fleet_record> ready_;
+    std::vector<clock_track> clocks_;
+
+    std::vector<std::thread> threads_;
+    std::atomic<bool> running_{false};
+    std::atomic<uint64_t> st_[11] = {};
+    std::vector<std::atomic<uint64_t>> board_st_;
+};
+
+} // namespace udp_rx
+
+#endif /* UDP_RX_FLEET_RX_H */
@@ -0,0 +1,317 @@
+#include "udp_rx.h"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <stdexcept>
+#include <system_error>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <poll.h>
+#include <pthread.h>
+#include <sched.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <time.h>
+#include <unistd.h>
+
+namespace udp_rx {
+
+enum { ST_DATAGRAMS, ST_BYTES, ST_SYSCALLS, ST_CAPTURES, ST_PARTIAL, ST_OVERRUNS, ST_TRUNCATED, ST_FOREIGN };
+
+static constexpr size_t SLOT_ALIGN = 4096;
+
+uint64_t monotonic_ns()
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+/* ---------------------------------------------------------------------- */
+/*  spsc_queue                                                             */
+/* ---------------------------------------------------------------------- */
+static size_t round_pow2(size_t n)
+{
+    size_t p = 1;
+    while (p < n) p <<= 1;
+    return p;
+}
+
+spsc_queue::spsc_queue(size_t capacity)
+    : buf_(round_pow2(capacity + 1)), mask_(buf_.size() - 1)
+{
+}
+
+bool spsc_queue::push(uint32_t v)
+{
+    size_t h = head_.load(std::memory_order_relaxed);
+    if (h - tail_.load(std::memory_order_acquire) > mask_) return false;
+    buf_[h & mask_] = v;
+    head_.store(h + 1, std::memory_order_release);
+    return true;
+}
+
+bool spsc_queue::pop(uint32_t &v)
+{
+    size_t t = tail_.load(std::memory_order_relaxed);
+    if (t == head_.load(std::memory_order_acquire)) return false;
+    v = buf_[t & mask_];
+    tail_.store(t + 1, std::memory_order_release);
+    return true;
+}
+
+/* ---------------------------------------------------------------------- */
+/*  receiver                                                               */
+/* ---------------------------------------------------------------------- */
+receiver::receiver(const config &cfg)
+    : cfg_(cfg), free_q_(cfg.slots), ready_q_(cfg.slots)
+{
+    if (cfg_.slots == 0 || cfg_.capture_bytes == 0 || cfg_.datagram_bytes == 0 || cfg_.batch == 0)
+        throw std::invalid_argument("udp_rx: slots, capture_bytes, datagram_bytes and batch must be non-zero");
+
+    slot_stride_ = (cfg_.capture_bytes + SLOT_ALIGN - 1) / SLOT_ALIGN * SLOT_ALIGN;
+    ring_ = static_cast<uint8_t *>(std::aligned_alloc(SLOT_ALIGN, slot_stride_ * cfg_.slots));
+    if (!ring_) throw std::bad_alloc();
+    std::memset(ring_, 0, slot_stride_ * cfg_.slots);      // fault the pages in now, not on the hot path
+
+    scratch_.resize((size_t)cfg_.batch * cfg_.datagram_bytes);
+    info_.resize(cfg_.slots);
+    for (uint32_t s = 0; s < cfg_.slots; s++) free_q_.push(s);
+
+    efd_ = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (efd_ < 0) {
+        std::free(ring_);
+        throw std::system_error(errno, std::generic_category(), "udp_rx: eventfd");
+    }
+}
+
+receiver::~receiver()
+{
+    stop();
+    if (efd_ >= 0) close(efd_);
+    std::free(ring_);
+}
+
+void receiver::start()
+{
+    struct sockaddr_in addr = {};
+    struct timeval tv = {};
+    socklen_t len = sizeof(rcvbuf_);
+    int one = 1;
+    int idle_ms = std::max(10, cfg_.idle_reset_ms / 2);
+
+    if (running()) return;
+
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(cfg_.port);
+    if (inet_pton(AF_INET, cfg_.bind_addr.c_str(), &addr.sin_addr) != 1)
+        throw std::invalid_argument("udp_rx: bad bind address " + cfg_.bind_addr);
+    peer_ip_ = 0;
+    if (!cfg_.peer_addr.empty()) {
+        struct in_addr peer;
+        if (inet_pton(AF_INET, cfg_.peer_addr.c_str(), &peer) != 1)
+            throw std::invalid_argument("udp_rx: bad peer address " + cfg_.peer_addr);
+        peer_ip_ = peer.s_addr;
+    }
+
+    fd_ = socket(AF_INET, SOCK_DGRAM | SOCK_CLOEXEC, 0);
+    if (fd_ < 0) throw std::system_error(errno, std::generic_category(), "udp_rx: socket");
+    setsockopt(fd_, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+    /* SO_RCVBUFFORCE needs CAP_NET_ADMIN; fall back to what rmem_max allows */
+    if (setsockopt(fd_, SOL_SOCKET, SO_RCVBUFFORCE, &cfg_.rcvbuf_bytes, sizeof(cfg_.rcvbuf_bytes)) != 0)
+        setsockopt(fd_, SOL_SOCKET, SO_RCVBUF, &cfg_.rcvbuf_bytes, sizeof(cfg_.rcvbuf_bytes));
+    getsockopt(fd_, SOL_SOCKET, SO_RCVBUF, &rcvbuf_, &len);
+    tv.tv_sec = idle_ms / 1000;
+    tv.tv_usec = (idle_ms % 1000) * 1000;
+    setsockopt(fd_, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+
+    if (bind(fd_, reinterpret_cast<struct sockaddr *>(&addr), sizeof(addr)) != 0) {
+        int err = errno;
+        close(fd_);
+        fd_ = -1;
+        throw std::system_error(err, std::generic_category(), "udp_rx: bind port " + std::to_string(cfg_.port));
+    }
+
+    running_.store(true);
+    thread_ = std::thread(&receiver::rx_loop, this);
+
+    if (cfg_.cpu >= 0) {
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(cfg_.cpu, &set);
+        int err = pthread_setaffinity_np(thread_.native_handle(), sizeof(set), &set);
+        if (err) std::fprintf(stderr, "udp_rx: cannot pin receive thread to CPU %d: %s\n", cfg_.cpu, std::strerror(err));
+    }
+}
+
+void receiver::stop()
+{
+    if (!running_.exchange(false)) return;
+    if (thread_.joinable()) thread_.join();
+    if (fd_ >= 0) close(fd_);
+    fd_ = -1;
+}
+
+int receiver::acquire(int timeout_ms)
+{
+    uint64_t deadline = (timeout_ms > 0) ? monotonic_ns() + (uint64_t)timeout_ms * 1000000ULL : 0;
+    uint32_t slot;
+    uint64_t cnt;
+
+    for (;;) {
+        if (ready_q_.pop(slot)) return (int)slot;
+        if (timeout_ms == 0) return -1;
+
+        int wait_ms = -1;
+        if (timeout_ms > 0) {
+            uint64_t now = monotonic_ns();
+            if (now >= deadline) return -1;
+            wait_ms = (int)((deadline - now + 999999) / 1000000);
+        }
+        struct pollfd pfd = { efd_, POLLIN, 0 };
+        if (poll(&pfd, 1, wait_ms) > 0) (void)!read(efd_, &cnt, sizeof(cnt));
+    }
+}
+
+void receiver::release(int slot)
+{
+    if (slot < 0 || (size_t)slot >= cfg_.slots) return;
+    free_q_.push((uint32_t)slot);
+}
+
+stats receiver::get_stats() const
+{
+    stats s;
+    s.datagrams       = st_[ST_DATAGRAMS].load(std::memory_order_relaxed);
+    s.bytes           = st_[ST_BYTES].load(std::memory_order_relaxed);
+    s.syscalls        = st_[ST_SYSCALLS].load(std::memory_order_relaxed);
+    s.captures        = st_[ST_CAPTURES].load(std::memory_order_relaxed);
+    s.partial_dropped = st_[ST_PARTIAL].load(std::memory_order_relaxed);
+    s.overruns        = st_[ST_OVERRUNS].load(std::memory_order_relaxed);
+    s.truncated       = st_[ST_TRUNCATED].load(std::memory_order_relaxed);
+    s.foreign         = st_[ST_FOREIGN].load(std::memory_order_relaxed);
+    return s;
+}
+
+bool receiver::next_slot()
+{
+    uint32_t slot;
+
+    if (!free_q_.pop(slot)) return false;
+    cur_ = (int)slot;
+    fill_ = 0;
+    info_[slot] = capture_info{};
+    return true;
+}
+
+void receiver::finish_slot(uint64_t now_ns)
+{
+    uint64_t one = 1;
+
+    info_[cur_].seq = seq_++;
+    info_[cur_].t_last_ns = now_ns;
+    info_[cur_].bytes = (uint32_t)fill_;
+    ready_q_.push((uint32_t)cur_);      // cannot fail: the ring holds every slot at most once
+    (void)!write(efd_, &one, sizeof(one));
+    st_[ST_CAPTURES].fetch_add(1, std::memory_order_relaxed);
+    cur_ = -1;
+    fill_ = 0;
+}
+
+void receiver::rx_loop()
+{
+    const size_t dgram = cfg_.datagram_bytes;
+    std::vector<struct mmsghdr> msgs(cfg_.batch);
+    std::vector<struct iovec> iovs(cfg_.batch);
+    std::vector<struct sockaddr_in> from(cfg_.batch);
+
+    while (running_.load(std::memory_order_relaxed)) {
+        uint64_t now = monotonic_ns();
+        uint8_t *dst;
+        size_t remain;
+        unsigned nmsg;
+
+        if (now - last_rx_ns_ > (uint64_t)cfg_.idle_reset_ms * 1000000ULL) {
+            if (cur_ >= 0 && fill_) {
+                st_[ST_PARTIAL].fetch_add(1, std::memory_order_relaxed);
+                fill_ = 0;
+                info_[cur_] = capture_info{};
+            }
+            resync_ = false;
+        }
+        if (cur_ < 0) next_slot();
+
+        /* Lay the batch out back to back in the slot, or in scratch on overrun */
+        if (cur_ >= 0 && !resync_) {
+            dst = ring_ + (size_t)cur_ * slot_stride_ + fill_;
+            remain = cfg_.capture_bytes - fill_;
+            nmsg = (unsigned)std::min<size_t>(cfg_.batch, (remain + dgram - 1) / dgram);
+        } else {
+            dst = scratch_.data();
+            remain = scratch_.size();
+            nmsg = cfg_.batch;
+        }
+        for (unsigned k = 0; k < nmsg; k++) {
+            iovs[k].iov_base = dst + (size_t)k * dgram;
+            iovs[k].iov_len = std::min(dgram, remain - (size_t)k * dgram);
+            std::memset(&msgs[k].msg_hdr, 0, sizeof(msgs[k].msg_hdr));
+            msgs[k].msg_hdr.msg_iov = &iovs[k];
+            msgs[k].msg_hdr.msg_iovlen = 1;
+            msgs[k].msg_hdr.msg_name = &from[k];
+            msgs[k].msg_hdr.msg_namelen = sizeof(from[k]);
+        }
+
+        int n = recvmmsg(fd_, msgs.data(), nmsg, MSG_WAITFORONE, nullptr);
+        if (n <= 0) continue;           // timeout (idle check above) or EINTR
+
+        now = monotonic_ns();
+        last_rx_ns_ = now;
+        st_[ST_SYSCALLS].fetch_add(1, std::memory_order_relaxed);
+        st_[ST_DATAGRAMS].fetch_add((uint64_t)n, std::memory_order_relaxed);
+        size_t bytes = 0;
+        for (int k = 0; k < n; k++) bytes += msgs[k].msg_len;
+        st_[ST_BYTES].fetch_add(bytes, std::memory_order_relaxed);
+
+        /* An overrun loses the rest of the transfer; a slot freed meanwhile
+         * must not open on its tail, so drop until the next idle gap */
+        if (cur_ < 0) {
+            st_[ST_OVERRUNS].fetch_add((uint64_t)n, std::memory_order_relaxed);
+            if (!resync_) st_[ST_PARTIAL].fetch_add(1, std::memory_order_relaxed);
+            resync_ = true;
+            continue;
+        }
+        if (resync_) continue;
+
+        /* Normally every datagram is full size and already in place; compact otherwise */
+        size_t out = 0;
+        for (int k = 0; k < n; k++) {
+            size_t got = msgs[k].msg_len;
+            if (peer_ip_ && from[k].sin_addr.s_addr != peer_ip_) {
+                st_[ST_FOREIGN].fetch_add(1, std::memory_order_relaxed);
+                continue;
+            }
+            if (msgs[k].msg_hdr.msg_flags & MSG_TRUNC) {
+                /* the stream does not line up with the capture: start over */
+                st_[ST_TRUNCATED].fetch_add(1, std::memory_order_relaxed);
+                st_[ST_PARTIAL].fetch_add(1, std::memory_order_relaxed);
+                fill_ = 0;
+                out = 0;
+                dst = ring_ + (size_t)cur_ * slot_stride_;
+                info_[cur_] = capture_info{};
+                continue;
+            }
+            if (dst + out != iovs[k].iov_base) std::memmove(dst + out, iovs[k].iov_base, got);
+            if (fill_ + out == 0) info_[cur_].t_first_ns = now;
+            out += got;
+            info_[cur_].datagrams++;
+        }
+        fill_ += out;
+        if (fill_ >= cfg_.capture_bytes) finish_slot(now);
+    }
+}
+
+} // namespace udp_rx
@@ -0,0 +1,133 @@
+/* udp_rx.h
+ * High-throughput UDP capture receiver, host side of udp_send_mem().
+ *
+ * The board streams a transfer as NUM_OF_TX repetitions of the DMA capture,
+ * split into datagrams of at most UDP_CHUNK_MAX bytes, with no header.  A
+ * dedicated receive thread (optionally pinned to one CPU) pulls datagrams in
+ * batches with recvmmsg() straight into a preallocated ring of capture
+ * slots, so the payload is written once by the kernel and never copied
+ * again.  A slot is complete after capture_bytes; a partial capture that
+ * sits idle for idle_reset_ms is dropped so the next transfer starts
+ * aligned, the same rule the Python scripts apply on socket timeout.
+ *
+ * Completed slots are handed to one consumer thread through a lock-free
+ * single-producer / single-consumer queue and come back through a second
+ * one on release.  With no free slot the receive thread keeps draining the
+ * socket into a scratch buffer and counts an overrun, so the kernel queue
+ * never backs up; the rest of that transfer is dropped up to the next
+ * idle_reset_ms gap, so no capture is built from two transfers.
+ */
+
+#ifndef UDP_RX_H
+#define UDP_RX_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace udp_rx {
+
+struct config {
+    std::string bind_addr = "0.0.0.0";
+    std::string peer_addr;              // accept only this sender, "" = any
+    uint16_t port = 5002;               // SERVER_PORT in ethernet.h
+    size_t capture_bytes = 32 * 512;    // NUM_OF_TX * capture bytes of the JESD mode
+    size_t datagram_bytes = 512;        // min(capture bytes, UDP_CHUNK_MAX)
+    size_t slots = 64;
+    unsigned batch = 64;                // datagrams per recvmmsg()
+    int rcvbuf_bytes = 64 << 20;
+    int cpu = -1;                       // pin the receive thread, -1 = leave to the scheduler
+    int idle_reset_ms = 100;
+};
+
+struct capture_info {
+    uint64_t seq;                       // completed captures before this one
+    uint64_t t_first_ns;                // CLOCK_MONOTONIC, first / last datagram
+    uint64_t t_last_ns;
+    uint32_t datagrams;
+    uint32_t bytes;
+};
+
+struct stats {
+    uint64_t datagrams;
+    uint64_t bytes;
+    uint64_t syscalls;                  // recvmmsg() calls that returned data
+    uint64_t captures;
+    uint64_t partial_dropped;           // idle reset with a partial capture, or a transfer cut by an overrun
+    uint64_t overruns;                  // datagrams drained with no free slot
+    uint64_t truncated;                 // datagram larger than expected
+    uint64_t foreign;                   // datagram from another sender
+};
+
+/* Bounded single-producer / single-consumer queue of slot indices */
+class spsc_queue {
+public:
+    explicit spsc_queue(size_t capacity);
+    bool push(uint32_t v);
+    bool pop(uint32_t &v);
+
+private:
+    std::vector<uint32_t> buf_;
+    size_t mask_;
+    alignas(64) std::atomic<size_t> head_{0};
+    alignas(64) std::atomic<size_t> tail_{0};
+};
+
+class receiver {
+public:
+    explicit receiver(const config &cfg);
+    ~receiver();
+
+    receiver(const receiver &) = delete;
+    receiver &operator=(const receiver &) = delete;
+
+    void start();                       // throws std::system_error on socket failure
+    void stop();
+    bool running() const { return running_.load(std::memory_order_relaxed); }
+
+    /* Next completed slot, or -1 after timeout_ms (-1 waits forever, 0 polls) */
+    int acquire(int timeout_ms);
+    void release(int slot);
+
+    const uint8_t *data(int slot) const { return ring_ + (size_t)slot * slot_stride_; }
+    const capture_info &info(int slot) const { return info_[slot]; }
+    const config &cfg() const { return cfg_; }
+    int actual_rcvbuf() const { return rcvbuf_; }
+    stats get_stats() const;
+
+private:
+    void rx_loop();
+    bool next_slot();
+    void finish_slot(uint64_t now_ns);
+
+    config cfg_;
+    int fd_ = -1;
+    int efd_ = -1;                      // eventfd, counts ready slots for acquire()
+    int rcvbuf_ = 0;
+    uint32_t peer_ip_ = 0;              // network order, 0 = any
+    uint8_t *ring_ = nullptr;
+    size_t slot_stride_ = 0;
+    std::vector<uint8_t> scratch_;
+    std::vector<capture_info> info_;
+    spsc_queue free_q_, ready_q_;
+
+    /* receive thread state */
+    int cur_ = -1;
+    size_t fill_ = 0;
+    uint64_t seq_ = 0;
+    uint64_t last_rx_ns_ = 0;
+    bool resync_ = false;               // overrun: drop until the next idle gap
+
+    std::thread thread_;
+    std::atomic<bool> running_{false};
+    std::atomic<uint64_t> st_[8] = {};
+};
+
+uint64_t monotonic_ns();
+
+} // namespace udp_rx
+
+#endif /* UDP_RX_H */
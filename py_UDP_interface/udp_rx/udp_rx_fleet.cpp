@@ -0,0 +1,189 @@
+/* udp_rx_fleet.cpp
+ * Record several boards at once into synchronised capture files: one
+ * <prefix>_b<id>.tcap per board, written only for records every board
+ * delivered, so chunk i of each file belongs to the same record.  A chunk's
+ * seq is the record tag (the sweep point's, or the capture count of a single
+ * board that is not stamping) and its time the aligned capture time.  A
+ * record with a stamp whose capture size is not the mode's is left out of
+ * every file and counted as mismatched.
+ *
+ *   udp_rx_fleet <prefix> <id=addr>[,<id=addr>...] [seconds] [mode_id,L,M,NP,dcm,num_ddc,complex] [port] [queues]
+ *
+ * e.g. udp_rx_fleet run1 0=192.168.1.10,1=192.168.1.11 0 11,4,2,16,1,0,0 5002 2
+ * Stops after the given seconds (0 = until SIGINT).  Trigger the boards
+ * with fleet.py, which sends each point to all of them under one tag.
+ */
+
+#include <algorithm>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <time.h>
+
+#include "capture_file.h"
+#include "fleet_rx.h"
+#include "udp_rx.h"
+
+static constexpr size_t NUM_OF_TX = 32;                // NUM_OF_TX in ethernet.h
+static constexpr size_t UDP_CHUNK_MAX = 1024;          // UDP_CHUNK_MAX in ethernet.h
+static constexpr size_t CAPTURE_SAMPLES = 128;         // JESDMODE_CAPTURE_SAMPLES
+static constexpr uint64_t ADC_CLK_HZ = 500000000ULL;   // ADC_SAMPLE_CLK_KHZ in main.c
+
+static volatile std::sig_atomic_t stop_requested = 0;
+
+static void on_sigint(int)
+{
+    stop_requested = 1;
+}
+
+static bool parse_mode(const char *s, tcap::layout &m)
+{
+    unsigned v[7];
+    if (std::sscanf(s, "%u,%u,%u,%u,%u,%u,%u", &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6]) != 7) return false;
+    if (v[2] == 0 || v[2] > 8 || (v[3] != 8 && v[3] != 16)) return false;
+    m.mode_id = (uint16_t)v[0];
+    m.L = (uint8_t)v[1];
+    m.M = (uint8_t)v[2];
+    m.NP = (uint8_t)v[3];
+    m.dcm = (uint8_t)v[4];
+    m.num_ddc = (uint8_t)v[5];
+    m.complex = v[6] != 0;
+    return true;
+}
+
+static bool parse_boards(const char *s, std::vector<udp_rx::board> &boards)
+{
+    std::string list(s);
+    size_t pos = 0;
+    while (pos <= list.size()) {
+        size_t end = list.find(',', pos);
+        std::string item = list.substr(pos, end == std::string::npos ? std::string::npos : end - pos);
+        size_t eq = item.find('=');
+        if (eq == std::string::npos || eq == 0) return false;
+        boards.push_back({ (uint16_t)std::atoi(item.substr(0, eq).c_str()), item.substr(eq + 1) });
+        if (end == std::string::npos) break;
+        pos = end + 1;
+    }
+    return !boards.empty();
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 3) {
+        std::fprintf(stderr, "usage: %s <prefix> <id=addr>[,<id=addr>...] [seconds] "
+                             "[mode_id,L,M,NP,dcm,num_ddc,complex] [port] [queues]\n", argv[0]);
+        return 2;
+    }
+    udp_rx::fleet_config cfg;
+    if (!parse_boards(argv[2], cfg.boards)) {
+        std::fprintf(stderr, "bad board list \"%s\"\n", argv[2]);
+        return 2;
+    }
+    double seconds = (argc > 3) ? std::atof(argv[3]) : 0.0;
+    tcap::layout mode;
+    if (argc > 4 && !parse_mode(argv[4], mode)) {
+        std::fprintf(stderr, "bad mode \"%s\"\n", argv[4]);
+        return 2;
+    }
+    cfg.port = (argc > 5) ? (uint16_t)std::atoi(argv[5]) : cfg.port;
+    cfg.queues = (argc > 6) ? (unsigned)std::max(1, std::atoi(argv[6])) : 1;
+
+    /* Stamped points carry their own size; an unstamped transfer is NUM_OF_TX captures, as udp_rx_record */
+    size_t spc = std::max<size_t>(1, (32u * mode.L) / ((size_t)mode.M * mode.NP));
+    size_t capture_bytes = (CAPTURE_SAMPLES / spc) * (mode.M * spc * mode.NP / 8);
+    size_t capture_samples = (CAPTURE_SAMPLES / spc) * spc;
+    cfg.capture_bytes = NUM_OF_TX * capture_bytes;
+    cfg.datagram_bytes = UDP_CHUNK_MAX;                 // sweep replies pack captures into full datagrams
+
+    std::vector<std::unique_ptr<tcap::writer>> out;
+    udp_rx::fleet_receiver rx(cfg);
+    try {
+        for (const udp_rx::board &b : cfg.boards) {
+            std::string path = std::string(argv[1]) + "_b" + std::to_string(b.id) + ".tcap";
+            std::string note = "udp_rx_fleet board " + std::to_string(b.id) + " (" + b.addr + ") of " +
+                               std::to_string(cfg.boards.size());
+            out.emplace_back(new tcap::writer);
+            out.back()->open(path, tcap::make_header(mode, ADC_CLK_HZ, tcap::pack_delay(0, 0, 0, 3), note));
+        }
+        rx.start();
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+    std::signal(SIGINT, on_sigint);
+
+    /* Aligned times are CLOCK_MONOTONIC, the file wants wall time */
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    int64_t wall_offset = (int64_t)((uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec) -
+                          (int64_t)udp_rx::monotonic_ns();
+
+    std::vector<int16_t> planar;
+    std::vector<int64_t> spreads;
+    uint64_t mismatched = 0;
+    uint64_t t0 = udp_rx::monotonic_ns(), deadline = t0 + (uint64_t)(seconds * 1e9);
+    int rc = 0;
+    std::printf("recording %zu boards on port %u over %u queues -> %s_b<id>.tcap\n", cfg.boards.size(), cfg.port,
+                cfg.queues, argv[1]);
+    std::fflush(stdout);                                // fleet.py waits for this line before the first point
+
+    while (!stop_requested && rc == 0 && (seconds <= 0 || udp_rx::monotonic_ns() < deadline)) {
+        udp_rx::fleet_record rec;
+        if (!rx.next(rec, 100)) continue;
+        /* Unpacked with the mode's capture size, so a board that captured in another mode cannot be stored */
+        if (std::any_of(rec.parts.begin(), rec.parts.end(), [&](const udp_rx::board_capture &p) {
+                return p.stamped && p.capture_bytes != capture_bytes;
+            })) {
+            mismatched++;
+            continue;
+        }
+        spreads.push_back(rec.spread_ns);
+        for (size_t b = 0; b < rec.parts.size() && rc == 0; b++) {
+            const udp_rx::board_capture &p = rec.parts[b];
+            uint32_t samples = (uint32_t)(p.data.size() / capture_bytes * capture_samples);
+            planar.resize((size_t)mode.M * samples);
+            tcap::unpack(mode, p.data.data(), p.data.size() / capture_bytes * capture_bytes, planar.data());
+            try {
+                out[b]->append(planar.data(), samples, rec.tag, (uint64_t)(p.t_aligned_ns + wall_offset),
+                               tcap::pack_delay(p.delay[0], p.delay[1], p.delay[2], p.delay[3]));
+            } catch (const std::exception &e) {
+                std::fprintf(stderr, "%s\n", e.what());
+                rc = 1;
+            }
+        }
+    }
+    uint64_t t1 = udp_rx::monotonic_ns();
+    rx.stop();
+    for (auto &w : out) {
+        try {
+            w->close();
+        } catch (const std::exception &e) {
+            std::fprintf(stderr, "%s\n", e.what());
+            rc = 1;
+        }
+    }
+
+    udp_rx::fleet_stats s = rx.get_stats();
+    double secs = (double)(t1 - t0) / 1e9;
+    std::sort(spreads.begin(), spreads.end());
+    std::printf("recorded %llu records, %.1f MB in %.2f s; incomplete %llu, partial %llu, foreign %llu, duplicates %llu\n",
+                (unsigned long long)(s.records - mismatched), (double)s.bytes / 1e6, secs,
+                (unsigned long long)s.incomplete, (unsigned long long)s.partial_dropped, (unsigned long long)s.foreign,
+                (unsigned long long)s.duplicates);
+    if (mismatched || s.bad_stamps || s.unstamped)
+        std::printf("  dropped: %llu records off the mode's capture size, %llu bad stamps, %llu unstamped datagrams%s\n",
+                    (unsigned long long)mismatched, (unsigned long long)s.bad_stamps, (unsigned long long)s.unstamped,
+                    s.unstamped ? " (several boards need UDP_CFG_STAMP)" : "");
+    if (!spreads.empty())
+        std::printf("capture time spread across boards: median %.1f us, max %.1f us\n",
+                    (double)spreads[spreads.size() / 2] / 1e3, (double)spreads.back() / 1e3);
+    for (size_t b = 0; b < cfg.boards.size(); b++)
+        std::printf("  board %u (%s): %llu capture sets, clock offset %.6f s\n", cfg.boards[b].id,
+                    cfg.boards[b].addr.c_str(), (unsigned long long)s.board_captures[b], (double)rx.clock_offset(b) / 1e9);
+    return rc;
+}
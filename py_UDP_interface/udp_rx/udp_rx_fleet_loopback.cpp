@@ -0,0 +1,278 @@
+/* udp_rx_fleet_loopback.cpp
+ * Loopback self-check of the multi-board receiver: one sender thread per
+ * simulated board, each from its own address (127.0.0.2, .3, ...) and with
+ * its own free-running clock, sends stamped capture sets for every tag to
+ * one port; the main thread checks that every record is complete, carries
+ * the right bytes from the right board, and that the board clock offsets
+ * are recovered.
+ *
+ *   udp_rx_fleet_loopback [records] [boards] [queues] [captures] [port]
+ *
+ * Senders keep a bounded number of records in flight, so nothing may be
+ * lost.  The last PACED records are sent the way a sweep triggers the
+ * boards, all together and one record at a time, so the clock offsets and
+ * the aligned spread are judged without a receive backlog in the latency.
+ * Then stamps announcing no captures or an oversized capture, and with
+ * several boards an unstamped datagram, must be refused without disturbing
+ * the next record.  Exits non-zero on any lost, incomplete or corrupt
+ * record, an offset off by more than a millisecond, or a refusal missed.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "fleet_rx.h"
+#include "udp_rx.h"
+
+static constexpr uint32_t COUNTS_PER_SECOND = 99999000;   // XTime rate on the ZynqMP
+static constexpr size_t CAPTURE_BYTES = 512;               // jesd mode 11
+static constexpr size_t DATAGRAM_BYTES = 512;
+static constexpr uint32_t PACED = 64;                      // more than fleet_config::clock_window
+
+/* 16-bit word i of board b's capture set for tag n */
+static uint16_t pattern_word(size_t b, uint32_t n, size_t i)
+{
+    return (uint16_t)(b * 40503 + n * 7919 + i);
+}
+
+/* Board b's clock: CLOCK_MONOTONIC shifted by a few seconds per board, in XTime counts */
+static int64_t board_offset_ns(size_t b)
+{
+    return (int64_t)(b + 1) * 3000000000LL + (int64_t)b * 12345;
+}
+
+static int board_socket(size_t b, const udp_rx::fleet_config &cfg)
+{
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    struct sockaddr_in src = {}, dst = {};
+
+    src.sin_family = AF_INET;
+    src.sin_addr.s_addr = htonl(INADDR_LOOPBACK + 1 + (uint32_t)b);
+    dst.sin_family = AF_INET;
+    dst.sin_port = htons(cfg.port);
+    dst.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (fd < 0 || bind(fd, reinterpret_cast<struct sockaddr *>(&src), sizeof(src)) != 0 ||
+        connect(fd, reinterpret_cast<struct sockaddr *>(&dst), sizeof(dst)) != 0) {
+        std::perror("fleet loopback sender");
+        if (fd >= 0) close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+/*
+ * Board b's capture set for tag n: the stamp, announcing stamp_captures x
+ * stamp_bytes, then captures x CAPTURE_BYTES of pattern; no stamp when
+ * stamp_captures and stamp_bytes are both zero.
+ */
+static bool send_set(int fd, size_t b, const udp_rx::fleet_config &cfg, uint32_t n, uint8_t captures,
+                     uint8_t stamp_captures, uint32_t stamp_bytes)
+{
+    size_t bytes = (size_t)captures * CAPTURE_BYTES;
+    std::vector<uint8_t> buf(bytes);
+    size_t ndgram = (bytes + DATAGRAM_BYTES - 1) / DATAGRAM_BYTES + 1;
+    std::vector<struct mmsghdr> msgs(ndgram);
+    std::vector<struct iovec> iovs(ndgram);
+    udp_rx::board_stamp st = {};
+
+    st.magic = udp_rx::STAMP_MAGIC;
+    st.board_id = cfg.boards[b].id;
+    st.captures = stamp_captures;
+    st.capture_bytes = stamp_bytes;
+    st.counts_per_second = COUNTS_PER_SECOND;
+    st.delay[0] = 2;
+    st.delay[1] = (uint8_t)n;
+    st.delay[3] = 3;
+    st.tag = n;
+    int64_t board_ns = (int64_t)udp_rx::monotonic_ns() + board_offset_ns(b);
+    st.t_capture = (uint64_t)((unsigned __int128)board_ns * COUNTS_PER_SECOND / 1000000000u);
+
+    uint16_t *w = reinterpret_cast<uint16_t *>(buf.data());
+    for (size_t i = 0; i < bytes / 2; i++) w[i] = pattern_word(b, n, i);
+
+    iovs[0].iov_base = &st;
+    iovs[0].iov_len = sizeof(st);
+    for (size_t k = 1; k < ndgram; k++) {
+        iovs[k].iov_base = buf.data() + (k - 1) * DATAGRAM_BYTES;
+        iovs[k].iov_len = std::min(DATAGRAM_BYTES, bytes - (k - 1) * DATAGRAM_BYTES);
+    }
+    for (size_t k = 0; k < ndgram; k++) {
+        std::memset(&msgs[k].msg_hdr, 0, sizeof(msgs[k].msg_hdr));
+        msgs[k].msg_hdr.msg_iov = &iovs[k];
+        msgs[k].msg_hdr.msg_iovlen = 1;
+    }
+    size_t first = (stamp_captures || stamp_bytes) ? 0 : 1;
+    for (size_t sent = first; sent < ndgram; ) {
+        int r = sendmmsg(fd, msgs.data() + sent, (unsigned)(ndgram - sent), 0);
+        if (r < 0) {
+            std::perror("sendmmsg");
+            return false;
+        }
+        sent += (size_t)r;
+    }
+    return true;
+}
+
+static void send_board(size_t b, const udp_rx::fleet_config &cfg, uint32_t records, uint8_t captures, size_t window,
+                       const std::atomic<uint64_t> &consumed, std::atomic<bool> &failed)
+{
+    int fd = board_socket(b, cfg);
+
+    if (fd < 0) {
+        failed = true;
+        return;
+    }
+    for (uint32_t n = 0; n < records && !failed; n++) {
+        size_t ahead = (n + PACED >= records) ? 1 : window;
+        while (n >= consumed.load(std::memory_order_acquire) + ahead && !failed) std::this_thread::yield();
+        if (!send_set(fd, b, cfg, n, captures, captures, CAPTURE_BYTES)) failed = true;
+    }
+    close(fd);
+}
+
+/*
+ * Stamps announcing no captures or an oversized capture are refused with
+ * their data, and unstamped data is refused from a fleet of several boards;
+ * a good record for tag n afterwards must still come out whole.
+ */
+static bool check_refused(udp_rx::fleet_receiver &rx, const udp_rx::fleet_config &cfg, uint32_t n, uint8_t captures)
+{
+    size_t nboards = cfg.boards.size();
+    udp_rx::fleet_stats before = rx.get_stats();
+    bool ok = true;
+
+    int fd = board_socket(0, cfg);
+    if (fd < 0) return false;
+    ok = ok && send_set(fd, 0, cfg, n, captures, 0, CAPTURE_BYTES);
+    ok = ok && send_set(fd, 0, cfg, n, captures, captures, 0x40000000u);
+    std::this_thread::sleep_for(std::chrono::milliseconds(2 * cfg.idle_reset_ms));
+    if (nboards > 1) ok = ok && send_set(fd, 0, cfg, n, 1, 0, 0);
+    std::this_thread::sleep_for(std::chrono::milliseconds(2 * cfg.idle_reset_ms));
+    close(fd);
+
+    for (size_t b = 0; b < nboards && ok; b++) {
+        fd = board_socket(b, cfg);
+        ok = fd >= 0 && send_set(fd, b, cfg, n, captures, captures, CAPTURE_BYTES);
+        if (fd >= 0) close(fd);
+    }
+
+    udp_rx::fleet_record rec;
+    if (ok && !rx.next(rec, 2000)) {
+        std::fprintf(stderr, "refused stamps: no record after them\n");
+        ok = false;
+    }
+    for (size_t b = 0; ok && b < rec.parts.size(); b++) {
+        const udp_rx::board_capture &p = rec.parts[b];
+        const uint16_t *w = reinterpret_cast<const uint16_t *>(p.data.data());
+        ok = rec.tag == n && p.capture_bytes == CAPTURE_BYTES && p.data.size() == (size_t)captures * CAPTURE_BYTES;
+        for (size_t i = 0; ok && i < p.data.size() / 2; i++) ok = w[i] == pattern_word(b, n, i);
+    }
+    udp_rx::fleet_stats after = rx.get_stats();
+    uint64_t bad_stamps = after.bad_stamps - before.bad_stamps, unstamped = after.unstamped - before.unstamped;
+    if (bad_stamps != 2 || (nboards > 1 && unstamped != 1) || after.records != before.records + 1) ok = false;
+    std::printf("  refused: %llu bad stamps, %llu unstamped datagrams, then tag %u %s\n",
+                (unsigned long long)bad_stamps, (unsigned long long)unstamped, n, ok ? "whole" : "FAIL");
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    udp_rx::fleet_config cfg;
+    uint32_t records = (argc > 1) ? (uint32_t)std::strtoul(argv[1], nullptr, 0) : 5000;
+    size_t nboards   = (argc > 2) ? std::strtoul(argv[2], nullptr, 0) : 4;
+    cfg.queues       = (argc > 3) ? (unsigned)std::atoi(argv[3]) : 2;
+    uint8_t captures = (uint8_t)((argc > 4) ? std::atoi(argv[4]) : 4);
+    cfg.port         = (argc > 5) ? (uint16_t)std::atoi(argv[5]) : 15003;
+    cfg.bind_addr = "127.0.0.1";
+    cfg.capture_bytes = CAPTURE_BYTES;
+    cfg.datagram_bytes = DATAGRAM_BYTES;
+    for (size_t b = 0; b < nboards; b++) {
+        char addr[32];
+        std::snprintf(addr, sizeof(addr), "127.0.0.%zu", b + 2);
+        cfg.boards.push_back({ (uint16_t)(b + 10), addr });
+    }
+
+    udp_rx::fleet_receiver rx(cfg);
+    try {
+        rx.start();
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+
+    /* Keep the bytes in flight well inside one socket buffer (skb overhead included) */
+    size_t per_record = nboards * ((size_t)captures * CAPTURE_BYTES + sizeof(udp_rx::board_stamp));
+    size_t window = std::max<size_t>(1, std::min<size_t>(64, (size_t)rx.actual_rcvbuf() / (4 * per_record)));
+    std::atomic<uint64_t> consumed{0};
+    std::atomic<bool> failed{false};
+    uint64_t bad = 0, out_of_order = 0;
+    std::vector<int64_t> spreads;
+
+    uint64_t t0 = udp_rx::monotonic_ns();
+    std::vector<std::thread> senders;
+    for (size_t b = 0; b < nboards; b++)
+        senders.emplace_back(send_board, b, std::cref(cfg), records, captures, window, std::cref(consumed),
+                             std::ref(failed));
+
+    for (uint32_t n = 0; n < records && !failed; n++) {
+        udp_rx::fleet_record rec;
+        if (!rx.next(rec, 2000)) {
+            std::fprintf(stderr, "record %u: timed out\n", n);
+            failed = true;
+            break;
+        }
+        if (rec.tag != n) out_of_order++;
+        for (size_t b = 0; b < rec.parts.size(); b++) {
+            const udp_rx::board_capture &p = rec.parts[b];
+            const uint16_t *w = reinterpret_cast<const uint16_t *>(p.data.data());
+            bool ok = p.board_id == cfg.boards[b].id && p.stamped && p.captures == captures &&
+                      p.data.size() == (size_t)captures * CAPTURE_BYTES && p.delay[1] == (uint8_t)rec.tag;
+            for (size_t i = 0; ok && i < p.data.size() / 2; i++) ok = w[i] == pattern_word(b, rec.tag, i);
+            if (!ok) bad++;
+        }
+        if (n + PACED >= records) spreads.push_back(rec.spread_ns);
+        consumed.store(n + 1, std::memory_order_release);
+    }
+    for (std::thread &t : senders) t.join();
+    uint64_t t1 = udp_rx::monotonic_ns();
+
+    /* Each board's offset should come back as minus its clock shift, give or take the loopback latency */
+    double worst_offset_us = 0.0;
+    for (size_t b = 0; b < nboards; b++)
+        worst_offset_us = std::max(worst_offset_us, std::fabs((double)(rx.clock_offset(b) + board_offset_ns(b)) / 1e3));
+    udp_rx::fleet_stats s = rx.get_stats();
+
+    bool refused_ok = !failed && check_refused(rx, cfg, records, captures);
+    rx.stop();
+
+    double secs = (double)(t1 - t0) / 1e9;
+    std::sort(spreads.begin(), spreads.end());
+    std::printf("fleet loopback: %llu records from %zu boards over %u queues in %.3f s, %.1f MB/s, "
+                "%.1f datagrams per recvmmsg\n",
+                (unsigned long long)s.records, nboards, cfg.queues, secs, (double)s.bytes / secs / 1e6,
+                s.syscalls ? (double)s.datagrams / (double)s.syscalls : 0.0);
+    std::printf("  window %zu, incomplete %llu, partial %llu, foreign %llu, duplicates %llu, out of order %llu, "
+                "bad %llu\n", window, (unsigned long long)s.incomplete, (unsigned long long)s.partial_dropped,
+                (unsigned long long)s.foreign, (unsigned long long)s.duplicates, (unsigned long long)out_of_order,
+                (unsigned long long)bad);
+    if (!spreads.empty())
+        std::printf("  paced records: aligned spread median %.1f us, max %.1f us; worst clock offset error %.1f us\n",
+                    (double)spreads[spreads.size() / 2] / 1e3, (double)spreads.back() / 1e3, worst_offset_us);
+
+    bool ok = !failed && bad == 0 && s.records == records && s.incomplete == 0 && worst_offset_us < 1000.0 &&
+              refused_ok;
+    std::printf("fleet loopback: %s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
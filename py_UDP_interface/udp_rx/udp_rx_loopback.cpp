@@ -0,0 +1,239 @@
+/* udp_rx_loopback.cpp
+ * Loopback self-check of the receiver: a sender thread plays the board
+ * (capture-sized transfers split into datagrams, sendmmsg) to 127.0.0.1
+ * and the main thread checks every capture for order and content.
+ *
+ *   udp_rx_loopback [captures] [capture_bytes] [datagram_bytes] [cpu] [port]
+ *
+ * The sender keeps at most a socket buffer's worth of transfers in flight,
+ * so nothing may be lost; exits non-zero on any lost, reordered or corrupt
+ * capture.  Afterwards, with every slot held, a transfer is cut by an
+ * overrun and a slot freed halfway through it: nothing may come out until
+ * the next transfer after an idle gap, whole, with the cut counted as partial.
+ */
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+#include "udp_rx.h"
+
+/* 16-bit word i of capture n: a ramp starting at n, like the ADC ramp test pattern */
+static uint16_t pattern_word(uint64_t n, size_t i)
+{
+    return (uint16_t)(n * 7919 + i);
+}
+
+static int sender_socket(const udp_rx::config &cfg)
+{
+    int fd = socket(AF_INET, SOCK_DGRAM, 0);
+    struct sockaddr_in dst = {};
+
+    dst.sin_family = AF_INET;
+    dst.sin_port = htons(cfg.port);
+    dst.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (fd >= 0 && connect(fd, reinterpret_cast<struct sockaddr *>(&dst), sizeof(dst)) != 0) {
+        close(fd);
+        fd = -1;
+    }
+    if (fd < 0) std::perror("loopback sender");
+    return fd;
+}
+
+/* Datagrams [first, last) of transfer n */
+static bool send_transfer(int fd, const udp_rx::config &cfg, uint64_t n, size_t first, size_t last)
+{
+    std::vector<uint8_t> buf(cfg.capture_bytes);
+    std::vector<struct mmsghdr> msgs(last - first);
+    std::vector<struct iovec> iovs(last - first);
+
+    uint16_t *w = reinterpret_cast<uint16_t *>(buf.data());
+    for (size_t i = 0; i < cfg.capture_bytes / 2; i++) w[i] = pattern_word(n, i);
+
+    for (size_t k = first; k < last; k++) {
+        iovs[k - first].iov_base = buf.data() + k * cfg.datagram_bytes;
+        iovs[k - first].iov_len = std::min(cfg.datagram_bytes, cfg.capture_bytes - k * cfg.datagram_bytes);
+        std::memset(&msgs[k - first].msg_hdr, 0, sizeof(msgs[k - first].msg_hdr));
+        msgs[k - first].msg_hdr.msg_iov = &iovs[k - first];
+        msgs[k - first].msg_hdr.msg_iovlen = 1;
+    }
+    for (size_t sent = 0; sent < last - first; ) {
+        int r = sendmmsg(fd, msgs.data() + sent, (unsigned)(last - first - sent), 0);
+        if (r < 0) {
+            std::perror("sendmmsg");
+            return false;
+        }
+        sent += (size_t)r;
+    }
+    return true;
+}
+
+static void send_captures(const udp_rx::config &cfg, uint64_t count, size_t window,
+                          const std::atomic<uint64_t> &consumed, std::atomic<bool> &failed)
+{
+    size_t ndgram = (cfg.capture_bytes + cfg.datagram_bytes - 1) / cfg.datagram_bytes;
+    int fd = sender_socket(cfg);
+
+    if (fd < 0) {
+        failed = true;
+        return;
+    }
+    for (uint64_t n = 0; n < count && !failed; n++) {
+        while (n >= consumed.load(std::memory_order_acquire) + window && !failed) std::this_thread::yield();
+        if (!send_transfer(fd, cfg, n, 0, ndgram)) failed = true;
+    }
+    close(fd);
+}
+
+/* On a fresh receiver: transfer n is cut by an overrun, a slot comes free
+ * while its tail is still arriving and n + 1 follows back to back.  Both are
+ * dropped; n + 2, after an idle gap, must be the next capture, whole.
+ * Returns false on failure. */
+static bool check_overrun(udp_rx::receiver &rx, const udp_rx::config &cfg, uint64_t n)
+{
+    size_t ndgram = (cfg.capture_bytes + cfg.datagram_bytes - 1) / cfg.datagram_bytes;
+    std::vector<int> held;
+    bool ok = ndgram >= 4;
+    int fd = sender_socket(cfg);
+
+    if (fd < 0) return false;
+    udp_rx::stats before = rx.get_stats();
+
+    /* Fill every slot, then hold them */
+    for (size_t i = 0; i < cfg.slots && ok; i++) {
+        ok = send_transfer(fd, cfg, n, 0, ndgram);
+        int slot = ok ? rx.acquire(2000) : -1;
+        if (slot < 0) ok = false;
+        else held.push_back(slot);
+    }
+    uint64_t seq = held.size();
+
+    /* The head of n overruns; a slot is freed and one more datagram lets the
+     * receive thread pick it up before the tail of n and all of n + 1 arrive */
+    const auto pause = std::chrono::milliseconds(cfg.idle_reset_ms / 10);
+    ok = ok && send_transfer(fd, cfg, n, 0, ndgram / 2);
+    std::this_thread::sleep_for(pause);
+    if (!held.empty()) {
+        rx.release(held.back());
+        held.pop_back();
+    }
+    ok = ok && send_transfer(fd, cfg, n, ndgram / 2, ndgram / 2 + 1);
+    std::this_thread::sleep_for(pause);
+    ok = ok && send_transfer(fd, cfg, n, ndgram / 2 + 1, ndgram) && send_transfer(fd, cfg, n + 1, 0, ndgram);
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(2 * cfg.idle_reset_ms));
+    ok = ok && send_transfer(fd, cfg, n + 2, 0, ndgram);
+    int slot = ok ? rx.acquire(2000) : -1;
+    if (slot < 0) {
+        std::fprintf(stderr, "overrun: no capture after the idle gap\n");
+        ok = false;
+    } else {
+        const udp_rx::capture_info &info = rx.info(slot);
+        const uint16_t *w = reinterpret_cast<const uint16_t *>(rx.data(slot));
+        bool whole = info.seq == seq && info.bytes == cfg.capture_bytes;
+        for (size_t i = 0; whole && i < cfg.capture_bytes / 2; i++) whole = w[i] == pattern_word(n + 2, i);
+        if (!whole) std::fprintf(stderr, "overrun: capture after the cut is not transfer %llu\n",
+                                 (unsigned long long)(n + 2));
+        ok = whole;
+        rx.release(slot);
+    }
+    for (int s : held) rx.release(s);
+    close(fd);
+
+    udp_rx::stats after = rx.get_stats();
+    if (after.partial_dropped != before.partial_dropped + 1 || after.overruns == before.overruns) {
+        std::fprintf(stderr, "overrun: partial %llu, overruns %llu\n",
+                     (unsigned long long)(after.partial_dropped - before.partial_dropped),
+                     (unsigned long long)(after.overruns - before.overruns));
+        ok = false;
+    }
+    std::printf("overrun: %s\n", ok ? "PASS" : "FAIL");
+    return ok;
+}
+
+int main(int argc, char **argv)
+{
+    udp_rx::config cfg;
+    uint64_t count = (argc > 1) ? std::strtoull(argv[1], nullptr, 0) : 20000;
+    cfg.capture_bytes  = (argc > 2) ? std::strtoul(argv[2], nullptr, 0) : cfg.capture_bytes;
+    cfg.datagram_bytes = (argc > 3) ? std::strtoul(argv[3], nullptr, 0) : cfg.datagram_bytes;
+    cfg.cpu            = (argc > 4) ? std::atoi(argv[4]) : -1;
+    cfg.port           = (argc > 5) ? (uint16_t)std::atoi(argv[5]) : 15002;
+    cfg.bind_addr = "127.0.0.1";
+    cfg.peer_addr = "127.0.0.1";
+
+    udp_rx::receiver rx(cfg);
+    try {
+        rx.start();
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+
+    /* Keep the bytes in flight well inside the socket buffer (skb overhead included) */
+    size_t window = std::max<size_t>(1, std::min<size_t>(cfg.slots / 2, (size_t)rx.actual_rcvbuf() / (4 * cfg.capture_bytes)));
+    std::atomic<uint64_t> consumed{0};
+    std::atomic<bool> failed{false};
+    uint64_t bad = 0;
+
+    uint64_t t0 = udp_rx::monotonic_ns();
+    std::thread sender(send_captures, std::cref(cfg), count, window, std::cref(consumed), std::ref(failed));
+
+    for (uint64_t n = 0; n < count && !failed; n++) {
+        int slot = rx.acquire(2000);
+        if (slot < 0) {
+            std::fprintf(stderr, "capture %llu: timed out\n", (unsigned long long)n);
+            failed = true;
+            break;
+        }
+        const udp_rx::capture_info &info = rx.info(slot);
+        const uint16_t *w = reinterpret_cast<const uint16_t *>(rx.data(slot));
+        if (info.seq != n || info.bytes != cfg.capture_bytes) {
+            bad++;
+        } else {
+            for (size_t i = 0; i < cfg.capture_bytes / 2; i++) {
+                if (w[i] != pattern_word(n, i)) { bad++; break; }
+            }
+        }
+        rx.release(slot);
+        consumed.store(n + 1, std::memory_order_release);
+    }
+    sender.join();
+    uint64_t t1 = udp_rx::monotonic_ns();
+    rx.stop();
+    udp_rx::stats s = rx.get_stats();
+
+    bool overrun_ok = false;
+    if (!failed) {
+        udp_rx::receiver orx(cfg);
+        try {
+            orx.start();
+            overrun_ok = check_overrun(orx, cfg, count);
+        } catch (const std::exception &e) {
+            std::fprintf(stderr, "%s\n", e.what());
+        }
+        orx.stop();
+    }
+
+    double secs = (double)(t1 - t0) / 1e9;
+    std::printf("loopback: %llu captures x %zu bytes in %.3f s, %.1f MB/s, %.1f datagrams per recvmmsg\n",
+                (unsigned long long)s.captures, cfg.capture_bytes, secs, (double)s.bytes / secs / 1e6,
+                s.syscalls ? (double)s.datagrams / (double)s.syscalls : 0.0);
+    std::printf("  rcvbuf %d, window %zu, partial %llu, overruns %llu, truncated %llu, foreign %llu, bad %llu\n",
+                rx.actual_rcvbuf(), window, (unsigned long long)s.partial_dropped, (unsigned long long)s.overruns,
+                (unsigned long long)s.truncated, (unsigned long long)s.foreign, (unsigned long long)bad);
+
+    bool ok = !failed && bad == 0 && s.captures == count && overrun_ok;
+    std::printf("loopback: %s\n", ok ? "PASS" : "FAIL");
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,308 @@
+/* udp_rx_python.cpp
+ * CPython binding of udp_rx::receiver.
+ *
+ *   rx = _udp_rx.Receiver(port=5002, capture_bytes=16384, datagram_bytes=512)
+ *   rx.start()
+ *   cap = rx.get(timeout_ms)           # Capture or None
+ *   raw = numpy.frombuffer(cap, dtype="<i2")   # view of the ring slot, no copy
+ *   cap.release()                      # slot back to the receive thread
+ *
+ * A Capture exports its ring slot through the buffer protocol.  The slot
+ * returns to the receiver on release() or when the Capture is collected;
+ * release() refuses while a numpy view still points into the slot, and the
+ * view keeps the Capture (and the Receiver) alive on its own.
+ *
+ * get() and release() must come from one consumer at a time; the GIL takes
+ * care of that for Python callers.  __init__ on a Receiver that still has
+ * unreleased Captures raises RuntimeError.
+ */
+
+#define PY_SSIZE_T_CLEAN
+#include <Python.h>
+
+#include <memory>
+#include <system_error>
+
+#include "udp_rx.h"
+
+namespace {
+
+struct ReceiverObject {
+    PyObject_HEAD
+    udp_rx::receiver *rx;
+    Py_ssize_t captures;        // Captures still holding a slot of rx
+};
+
+struct CaptureObject {
+    PyObject_HEAD
+    ReceiverObject *owner;
+    int slot;                   // -1 once released
+    Py_ssize_t exports;
+};
+
+PyTypeObject ReceiverType = { PyVarObject_HEAD_INIT(nullptr, 0) };
+PyTypeObject CaptureType  = { PyVarObject_HEAD_INIT(nullptr, 0) };
+
+/* ---------------------------------------------------------------------- */
+/*  Capture                                                                */
+/* ---------------------------------------------------------------------- */
+void capture_give_back(CaptureObject *self)
+{
+    if (self->slot >= 0) {
+        self->owner->rx->release(self->slot);
+        self->slot = -1;
+        self->owner->captures--;
+    }
+}
+
+void Capture_dealloc(CaptureObject *self)
+{
+    capture_give_back(self);
+    Py_XDECREF(self->owner);
+    Py_TYPE(self)->tp_free(reinterpret_cast<PyObject *>(self));
+}
+
+int Capture_getbuffer(CaptureObject *self, Py_buffer *view, int flags)
+{
+    if (self->slot < 0) {
+        PyErr_SetString(PyExc_BufferError, "capture already released");
+        return -1;
+    }
+    const udp_rx::receiver &rx = *self->owner->rx;
+    int rc = PyBuffer_FillInfo(view, reinterpret_cast<PyObject *>(self), const_cast<uint8_t *>(rx.data(self->slot)),
+                               (Py_ssize_t)rx.info(self->slot).bytes, 1, flags);
+    if (rc == 0) self->exports++;
+    return rc;
+}
+
+void Capture_releasebuffer(CaptureObject *self, Py_buffer *)
+{
+    self->exports--;
+}
+
+PyObject *Capture_release(CaptureObject *self, PyObject *)
+{
+    if (self->exports > 0) {
+        PyErr_SetString(PyExc_BufferError, "capture is still viewed by an array, drop the views first");
+        return nullptr;
+    }
+    capture_give_back(self);
+    Py_RETURN_NONE;
+}
+
+PyObject *capture_info_field(CaptureObject *self, void *closure)
+{
+    if (self->slot < 0) {
+        PyErr_SetString(PyExc_ValueError, "capture already released");
+        return nullptr;
+    }
+    const udp_rx::capture_info &info = self->owner->rx->info(self->slot);
+    switch ((intptr_t)closure) {
+    case 0:  return PyLong_FromUnsignedLongLong(info.seq);
+    case 1:  return PyLong_FromUnsignedLongLong(info.t_first_ns);
+    case 2:  return PyLong_FromUnsignedLongLong(info.t_last_ns);
+    case 3:  return PyLong_FromUnsignedLong(info.datagrams);
+    default: return PyLong_FromUnsignedLong(info.bytes);
+    }
+}
+
+Py_ssize_t Capture_len(CaptureObject *self)
+{
+    return (self->slot < 0) ? 0 : (Py_ssize_t)self->owner->rx->info(self->slot).bytes;
+}
+
+PyMethodDef Capture_methods[] = {
+    { "release", (PyCFunction)Capture_release, METH_NOARGS, "Return the ring slot to the receiver" },
+    { nullptr, nullptr, 0, nullptr }
+};
+
+PyGetSetDef Capture_getset[] = {
+    { "seq",        (getter)capture_info_field, nullptr, "Capture sequence number",            (void *)0 },
+    { "t_first_ns", (getter)capture_info_field, nullptr, "CLOCK_MONOTONIC of the first datagram", (void *)1 },
+    { "t_last_ns",  (getter)capture_info_field, nullptr, "CLOCK_MONOTONIC of the last datagram",  (void *)2 },
+    { "datagrams",  (getter)capture_info_field, nullptr, "Datagrams in this capture",          (void *)3 },
+    { "nbytes",     (getter)capture_info_field, nullptr, "Capture size in bytes",              (void *)4 },
+    { nullptr, nullptr, nullptr, nullptr, nullptr }
+};
+
+PyBufferProcs Capture_as_buffer = { (getbufferproc)Capture_getbuffer, (releasebufferproc)Capture_releasebuffer };
+PySequenceMethods Capture_as_sequence = { (lenfunc)Capture_len };
+
+/* ---------------------------------------------------------------------- */
+/*  Receiver                                                               */
+/* ---------------------------------------------------------------------- */
+int Receiver_init(ReceiverObject *self, PyObject *args, PyObject *kwds)
+{
+    static const char *kwlist[] = { "port", "capture_bytes", "datagram_bytes", "slots", "batch", "rcvbuf",
+                                    "cpu", "peer", "bind", "idle_reset_ms", nullptr };
+    udp_rx::config cfg;
+    unsigned port = cfg.port, batch = cfg.batch;
+    Py_ssize_t capture_bytes = (Py_ssize_t)cfg.capture_bytes, datagram_bytes = (Py_ssize_t)cfg.datagram_bytes;
+    Py_ssize_t slots = (Py_ssize_t)cfg.slots;
+    const char *peer = "", *bind = cfg.bind_addr.c_str();
+
+    if (!PyArg_ParseTupleAndKeywords(args, kwds, "|InnnIiissi", const_cast<char **>(kwlist), &port, &capture_bytes,
+                                     &datagram_bytes, &slots, &batch, &cfg.rcvbuf_bytes, &cfg.cpu, &peer, &bind,
+                                     &cfg.idle_reset_ms))
+        return -1;
+    if (port > 65535 || capture_bytes <= 0 || datagram_bytes <= 0 || slots <= 0 || batch == 0) {
+        PyErr_SetString(PyExc_ValueError, "port must fit 16 bits; sizes, slots and batch must be positive");
+        return -1;
+    }
+    cfg.port = (uint16_t)port;
+    cfg.capture_bytes = (size_t)capture_bytes;
+    cfg.datagram_bytes = (size_t)datagram_bytes;
+    cfg.slots = (size_t)slots;
+    cfg.batch = batch;
+    cfg.peer_addr = peer;
+    cfg.bind_addr = bind;
+
+    /* Live Captures point into the old receiver's ring */
+    if (self->captures > 0) {
+        PyErr_SetString(PyExc_RuntimeError, "Receiver has unreleased captures, release them before __init__");
+        return -1;
+    }
+    delete self->rx;
+    self->rx = nullptr;
+    try {
+        self->rx = new udp_rx::receiver(cfg);
+    } catch (const std::exception &e) {
+        PyErr_SetString(PyExc_RuntimeError, e.what());
+        return -1;
+    }
+    return 0;
+}
+
+void Receiver_dealloc(ReceiverObject *self)
+{
+    if (self->rx) {
+        Py_BEGIN_ALLOW_THREADS
+        self->rx->stop();
+        Py_END_ALLOW_THREADS
+        delete self->rx;
+    }
+    Py_TYPE(self)->tp_free(reinterpret_cast<PyObject *>(self));
+}
+
+bool receiver_ready(ReceiverObject *self)
+{
+    if (self->rx) return true;
+    PyErr_SetString(PyExc_RuntimeError, "Receiver not initialised");
+    return false;
+}
+
+PyObject *Receiver_start(ReceiverObject *self, PyObject *)
+{
+    if (!receiver_ready(self)) return nullptr;
+    try {
+        self->rx->start();
+    } catch (const std::system_error &e) {
+        PyErr_SetString(PyExc_OSError, e.what());
+        return nullptr;
+    } catch (const std::exception &e) {
+        PyErr_SetString(PyExc_ValueError, e.what());
+        return nullptr;
+    }
+    Py_RETURN_NONE;
+}
+
+PyObject *Receiver_stop(ReceiverObject *self, PyObject *)
+{
+    if (!receiver_ready(self)) return nullptr;
+    Py_BEGIN_ALLOW_THREADS
+    self->rx->stop();
+    Py_END_ALLOW_THREADS
+    Py_RETURN_NONE;
+}
+
+PyObject *Receiver_get(ReceiverObject *self, PyObject *args)
+{
+    int timeout_ms = -1, slot;
+
+    if (!receiver_ready(self) || !PyArg_ParseTuple(args, "|i", &timeout_ms)) return nullptr;
+
+    /* wait in slices so Ctrl-C still gets through */
+    do {
+        int wait = (timeout_ms < 0 || timeout_ms > 100) ? 100 : timeout_ms;
+        Py_BEGIN_ALLOW_THREADS
+        slot = self->rx->acquire(wait);
+        Py_END_ALLOW_THREADS
+        if (slot >= 0) break;
+        if (PyErr_CheckSignals()) return nullptr;
+        if (timeout_ms >= 0) timeout_ms -= wait;
+    } while (timeout_ms != 0);
+
+    if (slot < 0) Py_RETURN_NONE;
+
+    CaptureObject *cap = PyObject_New(CaptureObject, &CaptureType);
+    if (!cap) {
+        self->rx->release(slot);
+        return nullptr;
+    }
+    Py_INCREF(self);
+    cap->owner = self;
+    cap->slot = slot;
+    cap->exports = 0;
+    self->captures++;
+    return reinterpret_cast<PyObject *>(cap);
+}
+
+PyObject *Receiver_stats(ReceiverObject *self, PyObject *)
+{
+    if (!receiver_ready(self)) return nullptr;
+    udp_rx::stats s = self->rx->get_stats();
+    return Py_BuildValue("{sKsKsKsKsKsKsKsKsi}", "datagrams", s.datagrams, "bytes", s.bytes, "syscalls", s.syscalls,
+                         "captures", s.captures, "partial_dropped", s.partial_dropped, "overruns", s.overruns,
+                         "truncated", s.truncated, "foreign", s.foreign, "rcvbuf", self->rx->actual_rcvbuf());
+}
+
+PyMethodDef Receiver_methods[] = {
+    { "start", (PyCFunction)Receiver_start, METH_NOARGS,  "Bind the socket and start the receive thread" },
+    { "stop",  (PyCFunction)Receiver_stop,  METH_NOARGS,  "Stop the receive thread and close the socket" },
+    { "get",   (PyCFunction)Receiver_get,   METH_VARARGS, "get(timeout_ms=-1) -> next completed Capture, or None" },
+    { "stats", (PyCFunction)Receiver_stats, METH_NOARGS,  "Receive counters as a dict" },
+    { nullptr, nullptr, 0, nullptr }
+};
+
+PyModuleDef udp_rx_module = {
+    PyModuleDef_HEAD_INIT, "_udp_rx", "recvmmsg capture receiver with zero-copy capture buffers", -1,
+    nullptr, nullptr, nullptr, nullptr, nullptr
+};
+
+} // namespace
+
+PyMODINIT_FUNC PyInit__udp_rx(void)
+{
+    ReceiverType.tp_name = "_udp_rx.Receiver";
+    ReceiverType.tp_basicsize = sizeof(ReceiverObject);
+    ReceiverType.tp_flags = Py_TPFLAGS_DEFAULT;
+    ReceiverType.tp_doc = "Receiver(port=5002, capture_bytes=16384, datagram_bytes=512, slots=64, batch=64, "
+                          "rcvbuf=64 MiB, cpu=-1, peer='', bind='0.0.0.0', idle_reset_ms=100)";
+    ReceiverType.tp_new = PyType_GenericNew;
+    ReceiverType.tp_init = (initproc)Receiver_init;
+    ReceiverType.tp_dealloc = (destructor)Receiver_dealloc;
+    ReceiverType.tp_methods = Receiver_methods;
+
+    CaptureType.tp_name = "_udp_rx.Capture";
+    CaptureType.tp_basicsize = sizeof(CaptureObject);
+    CaptureType.tp_flags = Py_TPFLAGS_DEFAULT;
+    CaptureType.tp_doc = "One completed capture; exposes its ring slot through the buffer protocol";
+    CaptureType.tp_dealloc = (destructor)Capture_dealloc;
+    CaptureType.tp_methods = Capture_methods;
+    CaptureType.tp_getset = Capture_getset;
+    CaptureType.tp_as_buffer = &Capture_as_buffer;
+    CaptureType.tp_as_sequence = &Capture_as_sequence;
+
+    if (PyType_Ready(&ReceiverType) < 0 || PyType_Ready(&CaptureType) < 0) return nullptr;
+
+    PyObject *m = PyModule_Create(&udp_rx_module);
+    if (!m) return nullptr;
+    Py_INCREF(&ReceiverType);
+    Py_INCREF(&CaptureType);
+    if (PyModule_AddObject(m, "Receiver", reinterpret_cast<PyObject *>(&ReceiverType)) < 0 ||
+        PyModule_AddObject(m, "Capture", reinterpret_cast<PyObject *>(&CaptureType)) < 0) {
+        Py_DECREF(m);
+        return nullptr;
+    }
+    return m;
+}
@@ -0,0 +1,126 @@
+/* udp_rx_record.cpp
+ * Record the board's sample stream straight into a .tcap capture file:
+ * every transfer (NUM_OF_TX captures) becomes one chunk, unpacked to
+ * planar int16 on the consumer thread while the receive thread keeps
+ * filling the ring.
+ *
+ *   udp_rx_record <out.tcap> [seconds] [mode_id,L,M,NP,dcm,num_ddc,complex] [port] [cpu]
+ *
+ * The mode defaults to jesd mode 11 (L=4 M=2 NP=16).  Stops after the given
+ * seconds (0 = until SIGINT) and reports the sustained rate and any loss.
+ */
+
+#include <algorithm>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <vector>
+
+#include <time.h>
+
+#include "capture_file.h"
+#include "udp_rx.h"
+
+static constexpr size_t NUM_OF_TX = 32;                // NUM_OF_TX in ethernet.h
+static constexpr size_t UDP_CHUNK_MAX = 1024;          // UDP_CHUNK_MAX in ethernet.h
+static constexpr size_t CAPTURE_SAMPLES = 128;         // JESDMODE_CAPTURE_SAMPLES
+static constexpr uint64_t ADC_CLK_HZ = 500000000ULL;   // ADC_SAMPLE_CLK_KHZ in main.c
+
+static volatile std::sig_atomic_t stop_requested = 0;
+
+static void on_sigint(int)
+{
+    stop_requested = 1;
+}
+
+static bool parse_mode(const char *s, tcap::layout &m)
+{
+    unsigned v[7];
+    if (std::sscanf(s, "%u,%u,%u,%u,%u,%u,%u", &v[0], &v[1], &v[2], &v[3], &v[4], &v[5], &v[6]) != 7) return false;
+    if (v[2] == 0 || v[2] > 8 || (v[3] != 8 && v[3] != 16)) return false;
+    m.mode_id = (uint16_t)v[0];
+    m.L = (uint8_t)v[1];
+    m.M = (uint8_t)v[2];
+    m.NP = (uint8_t)v[3];
+    m.dcm = (uint8_t)v[4];
+    m.num_ddc = (uint8_t)v[5];
+    m.complex = v[6] != 0;
+    return true;
+}
+
+int main(int argc, char **argv)
+{
+    if (argc < 2) {
+        std::fprintf(stderr, "usage: %s <out.tcap> [seconds] [mode_id,L,M,NP,dcm,num_ddc,complex] [port] [cpu]\n", argv[0]);
+        return 2;
+    }
+    double seconds = (argc > 2) ? std::atof(argv[2]) : 0.0;
+    tcap::layout mode;
+    if (argc > 3 && !parse_mode(argv[3], mode)) {
+        std::fprintf(stderr, "bad mode \"%s\"\n", argv[3]);
+        return 2;
+    }
+
+    size_t spc = std::max<size_t>(1, (32u * mode.L) / ((size_t)mode.M * mode.NP));
+    size_t capture_bytes = (CAPTURE_SAMPLES / spc) * (mode.M * spc * mode.NP / 8);
+    udp_rx::config cfg;
+    cfg.capture_bytes = NUM_OF_TX * capture_bytes;
+    cfg.datagram_bytes = std::min(capture_bytes, UDP_CHUNK_MAX);
+    cfg.port = (argc > 4) ? (uint16_t)std::atoi(argv[4]) : cfg.port;
+    cfg.cpu = (argc > 5) ? std::atoi(argv[5]) : -1;
+    uint32_t samples = (uint32_t)(NUM_OF_TX * (CAPTURE_SAMPLES / spc) * spc);
+
+    tcap::writer out;
+    udp_rx::receiver rx(cfg);
+    try {
+        out.open(argv[1], tcap::make_header(mode, ADC_CLK_HZ, tcap::pack_delay(0, 0, 0, 3), "udp_rx_record"));
+        rx.start();
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+    std::signal(SIGINT, on_sigint);
+
+    /* Capture timestamps are CLOCK_MONOTONIC, the file wants wall time */
+    struct timespec ts;
+    clock_gettime(CLOCK_REALTIME, &ts);
+    int64_t wall_offset = (int64_t)((uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec) -
+                          (int64_t)udp_rx::monotonic_ns();
+
+    std::vector<int16_t> planar((size_t)mode.M * samples);
+    uint64_t t0 = udp_rx::monotonic_ns(), deadline = t0 + (uint64_t)(seconds * 1e9);
+    int rc = 0;
+    std::printf("recording port %u, %zu bytes per transfer -> %s\n", cfg.port, cfg.capture_bytes, argv[1]);
+
+    while (!stop_requested && (seconds <= 0 || udp_rx::monotonic_ns() < deadline)) {
+        int slot = rx.acquire(100);
+        if (slot < 0) continue;
+        const udp_rx::capture_info &info = rx.info(slot);
+        tcap::unpack(mode, rx.data(slot), cfg.capture_bytes, planar.data());
+        uint64_t seq = info.seq, t_ns = (uint64_t)((int64_t)info.t_first_ns + wall_offset);
+        rx.release(slot);
+        try {
+            out.append(planar.data(), samples, seq, t_ns, tcap::pack_delay(0, 0, 0, 3));
+        } catch (const std::exception &e) {
+            std::fprintf(stderr, "%s\n", e.what());
+            rc = 1;
+            break;
+        }
+    }
+    uint64_t t1 = udp_rx::monotonic_ns();
+    rx.stop();
+    try {
+        out.close();
+    } catch (const std::exception &e) {
+        std::fprintf(stderr, "%s\n", e.what());
+        rc = 1;
+    }
+
+    udp_rx::stats s = rx.get_stats();
+    double secs = (double)(t1 - t0) / 1e9;
+    std::printf("recorded %llu chunks, %.1f MB in %.2f s (%.1f MB/s); partial %llu, overruns %llu, truncated %llu\n",
+                (unsigned long long)out.chunks(), (double)out.bytes() / 1e6, secs, (double)out.bytes() / secs / 1e6,
+                (unsigned long long)s.partial_dropped, (unsigned long long)s.overruns,
+                (unsigned long long)s.truncated);
+    return rc;
+}
@@ -0,0 +1,33 @@
+# Same dither as matlab_engine.py (MATLAB test1), from the tiadc_dspd compute
+# service instead of a fresh MATLAB engine: the service starts on first use and
+# stays up, so later runs get the curve back from its cache in microseconds.
+# Build it first: cmake -S ../py_UDP_interface/tiadc_dsp -B ../py_UDP_interface/tiadc_dsp/build
+import os
+import sys
+import time
+
+import numpy as np
+
+sys.path.insert(0, os.path.join(os.path.dirname(os.path.abspath(__file__)), "..", "py_UDP_interface"))
+from dspd_client import DspClient  # noqa: E402
+
+
+def main():
+    # same variables as matlab_engine.py
+    PERIOD = 100
+    TIME_CONSTANTS = 0.217 * PERIOD
+    START_t = 900.0
+    END_t = START_t + PERIOD * 4
+    NUM_PLOTS = 3000
+
+    t0 = time.perf_counter()
+    with DspClient() as dsp:
+        dither_plot = dsp.dither(PERIOD, TIME_CONSTANTS, START_t, END_t, NUM_PLOTS)
+    print(f"dither: {len(dither_plot)} points in {(time.perf_counter() - t0) * 1e3:.1f} ms")
+
+    np.savetxt("dither_plot.txt", dither_plot, fmt = "%.3f", delimiter="\t",
+           header="t\ty", comments="")
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,79 @@
+/* lwipopts.h (host_sim)
+ * The platform's lwIP configuration (bsp/include/lwipopts.h), unchanged
+ * where it shapes the stack's behaviour: raw API without timers, the same
+ * heap and pool sizes, checksums left to the MAC (the link model fills them
+ * in, as GEM0's offload does).  Only the critical-region hooks are dropped:
+ * the simulator is single threaded like the firmware.
+ */
+
+#ifndef LWIPOPTS_H
+#define LWIPOPTS_H
+
+#define SYS_LIGHTWEIGHT_PROT        0
+
+#define NO_SYS                      1
+#define LWIP_SOCKET                 0
+#define LWIP_COMPAT_SOCKETS         0
+#define LWIP_NETCONN                0
+
+#define NO_SYS_NO_TIMERS            1
+#define LWIP_TCP_KEEPALIVE          0
+
+#define MEM_ALIGNMENT               64
+#define MEM_SIZE                    131072
+#define MEMP_NUM_PBUF               16
+#define MEMP_NUM_UDP_PCB            4
+#define MEMP_NUM_TCP_PCB            32
+#define MEMP_NUM_TCP_PCB_LISTEN     8
+#define MEMP_NUM_TCP_SEG            256
+#define MEMP_NUM_SYS_TIMEOUT        8
+
+#define PBUF_POOL_SIZE              256
+#define PBUF_POOL_BUFSIZE           1700
+#define PBUF_LINK_HLEN              16
+
+#define ARP_TABLE_SIZE              10
+#define ARP_QUEUEING                1
+
+#define ICMP_TTL                    255
+
+#define LWIP_IPV6                   0
+
+#define IP_REASSEMBLY               1
+#define IP_FRAG                     1
+#define IP_REASS_MAX_PBUFS          128
+#define IP_FRAG_MAX_MTU             1500
+#define IP_DEFAULT_TTL              255
+#define LWIP_CHKSUM_ALGORITHM       3
+
+#define LWIP_UDP                    1
+#define UDP_TTL                     255
+
+#define LWIP_TCP                    1
+#define TCP_MSS                     1460
+#define TCP_SND_BUF                 8192
+#define TCP_WND                     2048
+#define TCP_TTL                     255
+#define TCP_MAXRTX                  12
+#define TCP_SYNMAXRTX               4
+#define TCP_QUEUE_OOSEQ             1
+#define TCP_SND_QUEUELEN            16 * TCP_SND_BUF/TCP_MSS
+
+#define CHECKSUM_GEN_TCP            0
+#define CHECKSUM_GEN_UDP            0
+#define CHECKSUM_GEN_IP             0
+#define CHECKSUM_CHECK_TCP          0
+#define CHECKSUM_CHECK_UDP          0
+#define CHECKSUM_CHECK_IP           0
+
+#define MEMP_SEPARATE_POOLS         1
+#define MEMP_NUM_FRAG_PBUF          256
+#define IP_OPTIONS_ALLOWED          0
+
+#define TCP_OVERSIZE                TCP_MSS
+
+#define LWIP_DHCP                   0
+#define LWIP_DHCP_DOES_ACD_CHECK    0
+#define LWIP_ACD                    0
+
+#endif /* LWIPOPTS_H */
@@ -0,0 +1,26 @@
+/* netif/xadapter.h (host_sim)
+ * The Xilinx lwIP adapter entry points, backed by the host link model
+ * (sim/sim_netif.c) instead of GEM0.
+ */
+
+#ifndef XADAPTER_H
+#define XADAPTER_H
+
+#include "lwip/netif.h"
+#include "lwip/ip_addr.h"
+#include "xil_types.h"
+
+enum xemac_types { xemac_type_unknown = -1, xemac_type_xps_emaclite, xemac_type_xps_ll_temac,
+                   xemac_type_axi_ethernet, xemac_type_emacps };
+
+struct xemac_s {
+    enum xemac_types type;
+    int  topology_index;
+    void *state;
+};
+
+int           xemacif_input(struct netif *netif);
+struct netif *xemac_add(struct netif *netif, ip_addr_t *ipaddr, ip_addr_t *netmask, ip_addr_t *gw,
+                        unsigned char *mac_ethernet_address, UINTPTR mac_baseaddr);
+
+#endif /* XADAPTER_H */
@@ -0,0 +1,13 @@
+/* netif/xemacpsif.h (host_sim) */
+
+#ifndef XEMACPSIF_H
+#define XEMACPSIF_H
+
+#include "xemacps.h"
+#include "netif/xadapter.h"
+
+typedef struct {
+    XEmacPs emacps;
+} xemacpsif_s;
+
+#endif /* XEMACPSIF_H */
@@ -0,0 +1,20 @@
+/* sleep.h (host_sim)
+ * Delays run on the simulated clock (sim/sim_time.c): skipped by default so
+ * bring-up and polling loops cost no wall time, or slept for real with -r.
+ * Renamed, after <unistd.h> has declared the originals, so they do not clash.
+ */
+
+#ifndef SLEEP_H
+#define SLEEP_H
+
+#include <unistd.h>
+#include "xil_types.h"
+#include "xil_io.h"
+
+#define usleep  sim_usleep
+#define sleep   sim_sleep
+
+int sim_usleep(ULONG useconds);
+unsigned sim_sleep(unsigned seconds);
+
+#endif /* SLEEP_H */
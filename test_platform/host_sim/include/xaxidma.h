@@ -0,0 +1,55 @@
+/* xaxidma.h (host_sim)
+ * AXI DMA in simple (non-SG) mode, S2MM only: a transfer is filled from the
+ * ADC source model and stays busy for the time the stream would take
+ * (sim/sim_dma.c).
+ */
+
+#ifndef XAXIDMA_H
+#define XAXIDMA_H
+
+#include <string.h>
+#include "xil_types.h"
+#include "xstatus.h"
+#include "xil_io.h"
+#include "xil_cache.h"
+
+#define XAXIDMA_DMA_TO_DEVICE       0x00
+#define XAXIDMA_DEVICE_TO_DMA       0x01
+#define XAXIDMA_IRQ_IOC_MASK        0x00001000
+#define XAXIDMA_IRQ_DELAY_MASK      0x00002000
+#define XAXIDMA_IRQ_ERROR_MASK      0x00004000
+#define XAXIDMA_IRQ_ALL_MASK        0x00007000
+
+typedef struct {
+    u32 DeviceId;
+    UINTPTR BaseAddr;
+    int HasStsCntrlStrm;
+    int HasMm2S;
+    int HasS2Mm;
+    int SgLengthWidth;
+    int HasSg;
+} XAxiDma_Config;
+
+typedef struct {
+    UINTPTR RegBase;
+    int HasMm2S;
+    int HasS2Mm;
+    int HasSg;
+    int Initialized;
+    u32 IrqMask;
+    u64 BusyUntil;              /* XTime the running S2MM transfer completes */
+} XAxiDma;
+
+XAxiDma_Config *XAxiDma_LookupConfig(UINTPTR id);
+int  XAxiDma_CfgInitialize(XAxiDma *dma, XAxiDma_Config *config);
+u32  XAxiDma_SimpleTransfer(XAxiDma *dma, UINTPTR addr, u32 length, int direction);
+u32  XAxiDma_Busy(XAxiDma *dma, int direction);
+void XAxiDma_Reset(XAxiDma *dma);
+int  XAxiDma_ResetIsDone(XAxiDma *dma);
+int  XAxiDma_Resume(XAxiDma *dma);
+
+#define XAxiDma_HasSg(InstancePtr)                      ((InstancePtr)->HasSg)
+#define XAxiDma_IntrDisable(InstancePtr, Mask, Direction) \
+    ((void)(Direction), (InstancePtr)->IrqMask &= ~((u32)(Mask) & XAXIDMA_IRQ_ALL_MASK))
+
+#endif /* XAXIDMA_H */
@@ -0,0 +1,31 @@
+/* xemacps.h (host_sim)
+ * Only what bstats.c reads: the buffer descriptor ring occupancy, kept by
+ * the link model (sim/sim_netif.c) as if frames went through GEM0's rings.
+ */
+
+#ifndef XEMACPS_H
+#define XEMACPS_H
+
+#include "xil_types.h"
+#include "xstatus.h"
+#include "xil_io.h"
+
+typedef struct {
+    u32 AllCnt;
+    u32 FreeCnt;
+    volatile u32 HwCnt;
+    u32 PreCnt;
+    u32 PostCnt;
+} XEmacPs_BdRing;
+
+typedef struct {
+    UINTPTR BaseAddress;
+    u32 IsStarted;
+    XEmacPs_BdRing TxBdRing;
+    XEmacPs_BdRing RxBdRing;
+} XEmacPs;
+
+#define XEmacPs_GetTxRing(InstancePtr)  ((InstancePtr)->TxBdRing)
+#define XEmacPs_GetRxRing(InstancePtr)  ((InstancePtr)->RxBdRing)
+
+#endif /* XEMACPS_H */
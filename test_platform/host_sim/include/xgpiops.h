@@ -0,0 +1,35 @@
+/* xgpiops.h (host_sim)
+ * PS GPIO pins as a bank of latches; the AD9695 PDWN pin is wired to the
+ * converter model (sim/sim_spi.c).
+ */
+
+#ifndef XGPIOPS_H
+#define XGPIOPS_H
+
+#include "xil_types.h"
+#include "xstatus.h"
+#include "xil_io.h"
+
+#define XGPIOPS_MAX_PINS    174U
+
+typedef struct {
+    u16 DeviceId;
+    UINTPTR BaseAddr;
+} XGpioPs_Config;
+
+typedef struct {
+    XGpioPs_Config GpioConfig;
+    u32 IsReady;
+    u8  Direction[XGPIOPS_MAX_PINS];
+    u8  OutputEnable[XGPIOPS_MAX_PINS];
+    u8  Value[XGPIOPS_MAX_PINS];
+} XGpioPs;
+
+XGpioPs_Config *XGpioPs_LookupConfig(UINTPTR id);
+s32  XGpioPs_CfgInitialize(XGpioPs *gpio, const XGpioPs_Config *config, UINTPTR base);
+void XGpioPs_SetDirectionPin(XGpioPs *gpio, u32 pin, u32 direction);
+void XGpioPs_SetOutputEnablePin(XGpioPs *gpio, u32 pin, u32 enable);
+void XGpioPs_WritePin(XGpioPs *gpio, u32 pin, u32 data);
+u32  XGpioPs_ReadPin(const XGpioPs *gpio, u32 pin);
+
+#endif /* XGPIOPS_H */
@@ -0,0 +1,16 @@
+/* xil_cache.h (host_sim)
+ * The DMA model writes through the host's coherent memory, so cache
+ * maintenance has nothing to do.
+ */
+
+#ifndef XIL_CACHE_H
+#define XIL_CACHE_H
+
+#include "xil_types.h"
+
+static inline void Xil_ICacheEnable(void) {}
+static inline void Xil_DCacheEnable(void) {}
+static inline void Xil_DCacheFlushRange(INTPTR addr, INTPTR len) { (void)addr; (void)len; }
+static inline void Xil_DCacheInvalidateRange(INTPTR addr, INTPTR len) { (void)addr; (void)len; }
+
+#endif /* XIL_CACHE_H */
@@ -0,0 +1,14 @@
+/* xil_io.h (host_sim)
+ * Register access goes through the bus model (sim/sim_bus.c): peripheral
+ * windows to their models, DDR to the host mapping of the buffer region.
+ */
+
+#ifndef XIL_IO_H
+#define XIL_IO_H
+
+#include "xil_types.h"
+
+u32  Xil_In32(UINTPTR addr);
+void Xil_Out32(UINTPTR addr, u32 value);
+
+#endif /* XIL_IO_H */
@@ -0,0 +1,11 @@
+/* xil_printf.h (host_sim): the console is the process's stdout */
+
+#ifndef XIL_PRINTF_H
+#define XIL_PRINTF_H
+
+#include <string.h>
+#include "xil_types.h"
+
+void xil_printf(const char8 *fmt, ...);
+
+#endif /* XIL_PRINTF_H */
@@ -0,0 +1,15 @@
+/* xiltimer.h (host_sim): XTime counts at the board's timestamp clock rate */
+
+#ifndef XILTIMER_H
+#define XILTIMER_H
+
+#include "xil_types.h"
+#include "xparameters.h"
+
+typedef u64 XTime;
+
+#define COUNTS_PER_SECOND   XPAR_CPU_TIMESTAMP_CLK_FREQ
+
+void XTime_GetTime(XTime *t);
+
+#endif /* XILTIMER_H */
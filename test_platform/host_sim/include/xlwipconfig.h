@@ -0,0 +1,12 @@
+/* xlwipconfig.h (host_sim)
+ * The BSP's adapter configuration: GEM with 64-descriptor rings, no 1588.
+ */
+
+#ifndef XLWIPCONFIG_H
+#define XLWIPCONFIG_H
+
+#define XLWIP_CONFIG_INCLUDE_GEM 1
+#define XLWIP_CONFIG_N_TX_DESC 64
+#define XLWIP_CONFIG_N_RX_DESC 64
+
+#endif /* XLWIPCONFIG_H */
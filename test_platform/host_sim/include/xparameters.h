@@ -0,0 +1,33 @@
+/* xparameters.h (host_sim)
+ * The subset of the platform's xparameters.h the application uses, same
+ * values, so addresses printed by the console match the board.  Accesses to
+ * these windows land in the peripheral models of sim/sim_bus.c.
+ */
+
+#ifndef XPARAMETERS_H
+#define XPARAMETERS_H
+
+#define XPAR_PSU_DDR_0_BASEADDRESS      0x0
+#define XPAR_PSU_DDR_0_HIGHADDRESS      0x7fefffff
+
+#define XPAR_CPU_CORE_CLOCK_FREQ_HZ     1199880127
+#define XPAR_CPU_TIMESTAMP_CLK_FREQ     99990005
+
+#define XPAR_JESD204C_0_BASEADDR        0xa0010000
+#define XPAR_JESD204C_0_HIGHADDR        0xa001ffff
+#define XPAR_JESD204_PHY_0_BASEADDR     0xa0020000
+#define XPAR_JESD204_PHY_0_HIGHADDR     0xa002ffff
+
+#define XPAR_AXI_DMA_0_BASEADDR         0xa0000000
+#define XPAR_XAXIDMA_0_BASEADDR         0xa0000000
+#define XPAR_AXI_DMA_SG_LENGTH_WIDTH    0xc
+
+#define XPAR_XSPIPS_0_BASEADDR          0xff040000
+#define XPAR_XSPIPS_0_SPI_CLK_FREQ_HZ   0xbeb73fa
+#define XPAR_XUARTPS_0_BASEADDR         0xff000000
+#define XPAR_XUARTPS_0_CLOCK_FREQ       0x5f5b9f5
+#define XPAR_XGPIOPS_0_BASEADDR         0xff0a0000
+#define XPAR_XEMACPS_0_BASEADDR         0xff0e0000
+#define XPAR_GEM0_BASEADDR              XPAR_XEMACPS_0_BASEADDR
+
+#endif /* XPARAMETERS_H */
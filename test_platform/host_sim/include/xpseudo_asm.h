@@ -0,0 +1,22 @@
+/* xpseudo_asm.h (host_sim)
+ * The PMU registers bprofile.c touches; the cycle counter reads the host
+ * clock scaled to XPAR_CPU_CORE_CLOCK_FREQ_HZ.
+ */
+
+#ifndef XPSEUDO_ASM_H
+#define XPSEUDO_ASM_H
+
+#include "xil_types.h"
+
+#define PMCR_EL0            0
+#define PMCNTENSET_EL0      1
+#define PMCCNTR_EL0         2
+
+#define mfcp(reg)           sim_mfcp(reg)
+#define mtcp(reg, v)        sim_mtcp((reg), (v))
+#define isb()               ((void)0)
+
+u64  sim_mfcp(int reg);
+void sim_mtcp(int reg, u64 value);
+
+#endif /* XPSEUDO_ASM_H */
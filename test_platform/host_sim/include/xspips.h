@@ -0,0 +1,47 @@
+/* xspips.h (host_sim)
+ * PS SPI master as the application drives it: manual chip select, polled
+ * transfers.  The far end is the AD9695 model (sim/sim_spi.c).
+ */
+
+#ifndef XSPIPS_H
+#define XSPIPS_H
+
+#include "xil_types.h"
+#include "xstatus.h"
+#include "xil_io.h"
+
+#define XSPIPS_MASTER_OPTION            0x00000001U
+#define XSPIPS_CLK_ACTIVE_LOW_OPTION    0x00000002U
+#define XSPIPS_CLK_PHASE_1_OPTION       0x00000004U
+#define XSPIPS_FORCE_SSELECT_OPTION     0x00000010U
+
+#define XSPIPS_CLK_PRESCALE_4           0x01U
+#define XSPIPS_CLK_PRESCALE_8           0x02U
+#define XSPIPS_CLK_PRESCALE_16          0x03U
+#define XSPIPS_CLK_PRESCALE_32          0x04U
+#define XSPIPS_CLK_PRESCALE_64          0x05U
+#define XSPIPS_CLK_PRESCALE_128         0x06U
+#define XSPIPS_CLK_PRESCALE_256         0x07U
+
+typedef struct {
+    u16 DeviceId;
+    u32 BaseAddress;
+    u32 InputClockHz;
+} XSpiPs_Config;
+
+typedef struct {
+    XSpiPs_Config Config;
+    u32 IsReady;
+    u32 Options;
+    u8  Prescaler;
+    u8  SlaveSelect;
+} XSpiPs;
+
+XSpiPs_Config *XSpiPs_LookupConfig(UINTPTR id);
+s32  XSpiPs_CfgInitialize(XSpiPs *spi, const XSpiPs_Config *config, u32 base);
+s32  XSpiPs_SetOptions(XSpiPs *spi, u32 options);
+s32  XSpiPs_SetClkPrescaler(XSpiPs *spi, u8 prescaler);
+s32  XSpiPs_SetSlaveSelect(XSpiPs *spi, u8 slave);
+s32  XSpiPs_PolledTransfer(XSpiPs *spi, u8 *tx, u8 *rx, u32 count);
+
+#endif /* XSPIPS_H */
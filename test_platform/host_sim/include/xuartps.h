@@ -0,0 +1,38 @@
+/* xuartps.h (host_sim)
+ * UART0 is the process's stdin/stdout.  XUartPs_IsReceiveData() is the idle
+ * hook of the command loop: besides polling stdin it waits (briefly) for the
+ * network link, so an idle simulator does not spin (sim/sim_uart.c).
+ */
+
+#ifndef XUARTPS_H
+#define XUARTPS_H
+
+#include "xil_types.h"
+#include "xstatus.h"
+#include "xil_io.h"
+
+#define XUARTPS_FIFO_OFFSET     0x0030U
+
+typedef struct {
+    u16 DeviceId;
+    u32 BaseAddress;
+    u32 InputClockHz;
+} XUartPs_Config;
+
+typedef struct {
+    XUartPs_Config Config;
+    u32 IsReady;
+    u32 BaudRate;
+} XUartPs;
+
+XUartPs_Config *XUartPs_LookupConfig(UINTPTR id);
+s32  XUartPs_CfgInitialize(XUartPs *uart, const XUartPs_Config *config, u32 base);
+s32  XUartPs_SetBaudRate(XUartPs *uart, u32 baud);
+
+u32  sim_uart_rx_ready(void);
+u32  sim_uart_read(void);
+
+#define XUartPs_IsReceiveData(BaseAddress)          ((void)(BaseAddress), sim_uart_rx_ready())
+#define XUartPs_ReadReg(BaseAddress, RegOffset)     ((void)(BaseAddress), (void)(RegOffset), sim_uart_read())
+
+#endif /* XUARTPS_H */
@@ -0,0 +1,107 @@
+/* sim.h
+ * Host simulator of the thesis_v3_500mhz application: the firmware sources
+ * run unmodified on Linux against models of the hardware they drive.
+ *
+ *   sim_time.c   simulated clock behind XTime, usleep and the PMU counter
+ *   sim_bus.c    Xil_In32/Out32: DDR buffer region, JESD204C and PHY models
+ *   sim_spi.c    XSpiPs master with transfer timing, PS GPIO
+ *   sim_ad9695.c the AD9695 register space behind the SPI master
+ *   sim_dma.c    AXI DMA S2MM transfers fed by the ADC source
+ *   sim_uart.c   UART0 on stdin/stdout, xil_printf
+ *   sim_netif.c  xemac_add/xemacif_input: lwIP's side of GEM0
+ *   sim_link.c   the wire behind it: a TAP device or a UDP shim
+ *   sim_main.c   options, then the firmware's main()
+ */
+
+#ifndef SIM_H
+#define SIM_H
+
+#include <stddef.h>
+#include <stdint.h>
+#include "xil_types.h"
+
+/* DDR the firmware addresses directly (RX_BUFFER_BASE in main.c lies inside),
+ * mapped at the same addresses in the simulator's address space */
+#define SIM_DDR_BASE            0x01000000UL
+#define SIM_DDR_SIZE            (64UL << 20)
+
+/* S2MM stream rate of the capture path: 500 MSPS x 2 converters x 16 bit */
+#define SIM_ADC_BYTES_PER_SEC   2000000000ULL
+#define SIM_DMA_START_NS        500
+
+/* UDP shim: a board port p is reachable at <board addr>:(p + SIM_PORT_OFFSET) */
+#define SIM_PORT_OFFSET         10000
+
+#define SIM_NEVER               UINT64_MAX
+
+struct sim_options {
+    int         real_time;      /* sleep for real instead of skipping delays */
+    int         deterministic;  /* only modelled delays advance the clock */
+    int         keep_running;   /* stdin EOF does not end the run */
+    double      seconds;        /* wall-clock limit, 0 = none */
+    const char *tap;            /* TAP interface name, NULL = UDP shim */
+    const char *board_addr;     /* shim bind address, NULL = 127.0.0.<IP_ADDR3> */
+    const char *host_addr;      /* where the shim sends the board's datagrams */
+    int         port_offset;
+};
+
+extern struct sim_options sim_opt;
+
+/* sim_time.c */
+uint64_t sim_time_ns(void);                 /* simulated time since start */
+uint64_t sim_wall_ns(void);                 /* host CLOCK_MONOTONIC since start */
+void     sim_delay_ns(uint64_t ns);         /* time a peripheral access takes */
+
+/* sim_bus.c */
+int      sim_ddr_contains(UINTPTR addr, size_t len);
+int      sim_link_synced(void);
+
+/* sim_spi.c */
+void     sim_spi_report(void);
+
+/* sim_ad9695.c */
+struct sim_ad9695_channel {
+    uint8_t  test_mode;             /* TEST_MODE_REG[3:0], AD9695_TESTMODE_* */
+    uint8_t  twos_complement;
+    uint32_t delay_fs;              /* clock delay the delay registers select */
+};
+
+struct sim_ad9695_link {
+    uint8_t  L, M, NP;              /* JESD204 transport parameters the link registers select */
+};
+
+void     sim_ad9695_pdwn(int level);
+uint8_t  sim_ad9695_read(uint16_t addr);
+void     sim_ad9695_write(uint16_t addr, uint8_t value);
+int      sim_ad9695_addr_step(void);            /* streaming direction, +1 or -1 */
+uint64_t sim_ad9695_pll_lock_ns(void);          /* sim time the SERDES PLL locks, SIM_NEVER if it will not */
+void     sim_ad9695_channel(int ch, struct sim_ad9695_channel *out);
+void     sim_ad9695_link(struct sim_ad9695_link *out);
+void     sim_ad9695_report(void);
+
+/* sim_dma.c: the converter data one S2MM transfer delivers, from the AD9695 model's settings */
+void     sim_adc_fill(u8 *dst, u32 bytes);
+
+/* sim_netif.c */
+int      sim_netif_fd(void);                /* descriptor to wait on, -1 if none */
+void     sim_netif_report(void);
+
+/* sim_link.c: whole Ethernet frames, addresses in network byte order */
+#define SIM_LINK_MTU            1500
+
+struct sim_link_stats {
+    uint64_t rx_datagrams, rx_dropped;      /* frames (TAP) or datagrams (shim) */
+    uint64_t tx_datagrams, tx_dropped;
+};
+
+int      sim_link_open(const uint8_t board_mac[6], uint32_t board_ip, uint32_t host_ip);
+int      sim_link_fd(void);
+void     sim_link_listen(uint16_t board_port);  /* shim: expose a port lwIP has bound */
+size_t   sim_link_rx(uint8_t *frame, size_t cap);   /* 0 = nothing pending */
+void     sim_link_tx(uint8_t *frame, size_t len);   /* fills checksums in place */
+const struct sim_link_stats *sim_link_get_stats(void);
+
+/* sim_uart.c */
+void     sim_check_deadline(void);
+
+#endif /* SIM_H */
@@ -0,0 +1,267 @@
+/* sim_ad9695.c
+ * The AD9695 as its SPI port presents it, at register level.
+ *
+ *   - global registers, and local ones kept per channel and selected by
+ *     CH_INDEX (writes go to every selected page, reads come from channel A
+ *     when both are selected)
+ *   - reset values from the datasheet for everything bring-up reads back
+ *   - IF_CFG_A soft reset and IF_CFG_B datapath reset: the bits read back
+ *     set for the reset time, then clear; the soft reset restores the
+ *     register file
+ *   - PDWN: the chip does not answer while it is held, nor for its power-on
+ *     time after release; the input clock detect follows
+ *   - the JESD SERDES PLL: unlocked while the link is powered down (0x571
+ *     bit 0), locking a lock time after power-up or after a lane rate or
+ *     link parameter change made with the link up
+ *   - test mode, output format and the clock delay registers per channel,
+ *     and the JESD transport parameters, read by the ADC source (sim_dma.c)
+ *     to shape the data each transfer carries
+ *
+ * Times are on the simulated clock, so a driver that polls instead of
+ * sleeping sees exactly what it saves.  Registers outside this list are
+ * plain storage.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "sim.h"
+#include "ad9695.h"
+#include "ad9695_registers.h"
+
+#define AD9695_REGS             0x2000
+#define AD9695_IF_CFG_A_RESET   0x81        /* soft reset, mirrored */
+#define AD9695_IF_CFG_A_ASCEND  0x24        /* address ascension, mirrored */
+#define AD9695_IF_CFG_B_DP_RESET 0x02       /* datapath soft reset */
+#define AD9695_CLK_DETECTED     0x01
+#define AD9695_CH_BOTH          0x03
+
+/* Timing assumptions (the datasheet gives no figures for these): */
+#define AD9695_POR_NS           1000000     /* PDWN release to SPI ready and clock detected */
+#define AD9695_SOFT_RESET_NS    5000000     /* IF_CFG_A reset bits set */
+#define AD9695_DP_RESET_NS      10000       /* IF_CFG_B datapath reset bit set */
+#define AD9695_PLL_LOCK_NS      2000000     /* JESD SERDES PLL power-up/retune to lock */
+
+#define AD9695_FINE_STEP_FS     1725        /* 1.725 ps */
+#define AD9695_SUPER_FINE_STEP_FS 250       /* 0.25 ps */
+
+struct range {
+    uint16_t lo, hi;
+};
+
+/* Local registers, one copy per channel */
+static const struct range local_regs[] = {
+    { AD9695_DEV_CFG_REG,           AD9695_DEV_CFG_REG           },
+    { AD9695_IP_CLK_PHASE_ADJ_REG,  AD9695_IP_CLK_PHASE_ADJ_REG  },
+    { AD9695_CLK_DELAY_CTRL_REG,    AD9695_CLK_FINE_DELAY_REG    },
+    { 0x0245,                       AD9695_FD_DWELL_MSB_REG      },
+    { AD9695_TEST_MODE_REG,         AD9695_TEST_MODE_REG         },
+    { AD9695_OUTPUT_MODE_REG,       AD9695_OUTPUT_MODE_REG       },
+    { AD9695_DC_OFFSET_CAL_CTRL,    AD9695_DC_OFFSET_CAL_CTRL    },
+    { AD9695_VREF_CTRL_REG,         AD9695_BUFF_CFG_N_REG        },
+};
+
+static const struct range read_only_regs[] = {
+    { AD9695_CHIP_TYPE_REG,         AD9695_CHIP_GRADE_REG        },
+    { AD9695_IP_CLK_STAT_REG,       AD9695_IP_CLK_STAT_REG       },
+    { AD9695_SYSREF_STAT_0_REG,     AD9695_SYSREF_STAT_2_REG     },
+    { AD9695_OP_OVERANGE_STAT_REG,  AD9695_OP_OVERANGE_STAT_REG  },
+    { AD9695_JESD_SERDES_PLL_REG,   AD9695_JESD_SERDES_PLL_REG   },
+};
+
+/* Written with the link up, these retune the SERDES PLL */
+static const struct range pll_retune_regs[] = {
+    { AD9695_JESD_SERDES_PLL_CFG_REG, AD9695_JESD_SERDES_PLL_CFG_REG },
+    { AD9695_JESD_L_SCR_CFG_REG,    AD9695_JESD_HD_CF_CFG_REG    },
+};
+
+static const struct { uint16_t addr; uint8_t value; } reset_values[] = {
+    { AD9695_CHIP_TYPE_REG,         ad9695_CHIP_TYPE },
+    { AD9695_PROD_ID_LSB_REG,       ad9695_CHIP_ID },
+    { AD9695_CH_INDEX_REG,          AD9695_CH_BOTH },
+    { AD9695_OUTPUT_MODE_REG,       AD9695_OUTPUT_MODE_TWOS_COMPLEMENT },
+    { AD9695_JESD_LINK_CTRL1_REG,   0x14 },
+    { AD9695_JESD_L_SCR_CFG_REG,    AD9695_JESD_SCR_EN | AD9695_JESD_LANES(4 - 1) },
+    { AD9695_JESD_F_CFG_REG,        AD9695_JESD_F(1 - 1) },
+    { AD9695_JESD_K_CFG_REG,        AD9695_JESD_K(32 - 1) },
+    { AD9695_JESD_M_CFG_REG,        AD9695_JESD_M(2 - 1) },
+    { AD9695_JESD_CS_N_CFG_REG,     AD9695_JESD_N(16 - 1) },
+    { AD9695_JESD_SCV_NP_CFG_REG,   AD9695_JESD_SUBCLASS(1) | AD9695_JESD_NP(16 - 1) },
+};
+
+static struct {
+    uint8_t  global[AD9695_REGS];
+    uint8_t  local[2][AD9695_REGS];
+    int      pdwn;
+    uint64_t ready_ns;              /* SPI answers from here on (after PDWN release) */
+    uint64_t soft_reset_end_ns, dp_reset_end_ns;
+    uint64_t pll_lock_ns;           /* SIM_NEVER while the link is powered down */
+    uint32_t soft_resets, pll_retunes;
+} adc;
+
+static int in_ranges(const struct range *r, size_t n, uint16_t addr)
+{
+    for (size_t i = 0; i < n; i++)
+        if (addr >= r[i].lo && addr <= r[i].hi) return 1;
+    return 0;
+}
+
+#define IN(list, a)     in_ranges(list, sizeof(list) / sizeof(list[0]), (a))
+
+static int link_powered_down(void)
+{
+    return adc.global[AD9695_JESD_LINK_CTRL1_REG] & AD9695_JESD_LINK_PDN;
+}
+
+static void pll_retune(void)
+{
+    adc.pll_lock_ns = (adc.pdwn || link_powered_down()) ? SIM_NEVER : sim_time_ns() + AD9695_PLL_LOCK_NS;
+    adc.pll_retunes++;
+}
+
+static void reset_regs(void)
+{
+    memset(adc.global, 0, sizeof(adc.global));
+    memset(adc.local, 0, sizeof(adc.local));
+    for (size_t i = 0; i < sizeof(reset_values) / sizeof(reset_values[0]); i++)
+        adc.global[reset_values[i].addr] = reset_values[i].value;
+    for (int ch = 0; ch < 2; ch++)
+        adc.local[ch][AD9695_OUTPUT_MODE_REG] = AD9695_OUTPUT_MODE_TWOS_COMPLEMENT;
+    pll_retune();
+}
+
+__attribute__((constructor)) static void sim_ad9695_init(void)
+{
+    reset_regs();
+    adc.pll_lock_ns = 0;            /* powered and locked long before the firmware starts */
+    adc.pll_retunes = 0;
+}
+
+static int ready(void)
+{
+    return !adc.pdwn && sim_time_ns() >= adc.ready_ns;
+}
+
+void sim_ad9695_pdwn(int level)
+{
+    if (adc.pdwn && !level) {
+        adc.pdwn = 0;
+        adc.ready_ns = sim_time_ns() + AD9695_POR_NS;
+        reset_regs();
+    } else if (level && !adc.pdwn) {
+        adc.pdwn = 1;
+        adc.pll_lock_ns = SIM_NEVER;
+    }
+}
+
+uint64_t sim_ad9695_pll_lock_ns(void)
+{
+    return adc.pll_lock_ns;
+}
+
+int sim_ad9695_addr_step(void)
+{
+    return (adc.global[AD9695_IF_CFG_A_REG] & AD9695_IF_CFG_A_ASCEND) ? 1 : -1;
+}
+
+uint8_t sim_ad9695_read(uint16_t addr)
+{
+    uint64_t now = sim_time_ns();
+
+    addr %= AD9695_REGS;
+    if (!ready()) return 0;         /* SDO not driven */
+    switch (addr) {
+    case AD9695_IF_CFG_A_REG:
+        return (uint8_t)(adc.global[addr] | (now < adc.soft_reset_end_ns ? AD9695_IF_CFG_A_RESET : 0));
+    case AD9695_IF_CFG_B_REG:
+        return (uint8_t)(adc.global[addr] | (now < adc.dp_reset_end_ns ? AD9695_IF_CFG_B_DP_RESET : 0));
+    case AD9695_IP_CLK_STAT_REG:
+        return AD9695_CLK_DETECTED;
+    case AD9695_JESD_SERDES_PLL_REG:
+        return now >= adc.pll_lock_ns ? AD9695_JESD_PLL_LOCK_STAT : 0;
+    }
+    if (IN(local_regs, addr)) return adc.local[(adc.global[AD9695_CH_INDEX_REG] & 1) ? 0 : 1][addr];
+    return adc.global[addr];
+}
+
+void sim_ad9695_write(uint16_t addr, uint8_t value)
+{
+    addr %= AD9695_REGS;
+    if (!ready() || IN(read_only_regs, addr)) return;
+    if (sim_time_ns() < adc.soft_reset_end_ns) return;     /* held in reset */
+
+    switch (addr) {
+    case AD9695_IF_CFG_A_REG:
+        if (value & AD9695_IF_CFG_A_RESET) {
+            reset_regs();
+            adc.soft_reset_end_ns = sim_time_ns() + AD9695_SOFT_RESET_NS;
+            adc.soft_resets++;
+            return;
+        }
+        break;
+    case AD9695_IF_CFG_B_REG:
+        if (value & AD9695_IF_CFG_B_DP_RESET) adc.dp_reset_end_ns = sim_time_ns() + AD9695_DP_RESET_NS;
+        value &= (uint8_t)~AD9695_IF_CFG_B_DP_RESET;
+        break;
+    case AD9695_CH_INDEX_REG:
+        value &= AD9695_CH_BOTH;
+        break;
+    case AD9695_CHIP_SPI_XFER_REG:
+        value &= (uint8_t)~AD9695_CHIP_TRIGGER_SPI_XFER;
+        break;
+    case AD9695_JESD_LINK_CTRL1_REG: {
+        int was_down = link_powered_down();
+        adc.global[addr] = value;
+        if (was_down != link_powered_down()) pll_retune();
+        return;
+    }
+    }
+
+    if (IN(local_regs, addr)) {
+        for (int ch = 0; ch < 2; ch++)
+            if (adc.global[AD9695_CH_INDEX_REG] >> ch & 1) adc.local[ch][addr] = value;
+        return;
+    }
+    int changed = adc.global[addr] != value;
+    adc.global[addr] = value;
+    if (changed && IN(pll_retune_regs, addr) && !link_powered_down()) pll_retune();
+}
+
+void sim_ad9695_channel(int ch, struct sim_ad9695_channel *out)
+{
+    const uint8_t *r = adc.local[ch & 1];
+    uint32_t fine = r[AD9695_CLK_FINE_DELAY_REG], super_fine = r[AD9695_CLK_SUPER_FINE_DELAY_REG];
+
+    out->test_mode = r[AD9695_TEST_MODE_REG] & 0x0F;
+    out->twos_complement = r[AD9695_OUTPUT_MODE_REG] & AD9695_OUTPUT_MODE_TWOS_COMPLEMENT;
+    switch (r[AD9695_CLK_DELAY_CTRL_REG] & 0x07) {
+    case AD9695_FINE_DELAY_16:
+    case AD9695_FINE_DELAY_16_LOW_JITTER:
+        fine = fine > 16 ? 16 : fine;
+        super_fine = 0;
+        break;
+    case AD9695_FINE_DELAY_192:
+        super_fine = 0;
+        break;
+    case AD9695_SUPERFINE_DELAY:
+        break;
+    default:
+        fine = super_fine = 0;
+    }
+    fine = fine > 192 ? 192 : fine;
+    super_fine = super_fine > 128 ? 128 : super_fine;
+    out->delay_fs = fine * AD9695_FINE_STEP_FS + super_fine * AD9695_SUPER_FINE_STEP_FS;
+}
+
+void sim_ad9695_link(struct sim_ad9695_link *out)
+{
+    out->L = (uint8_t)((adc.global[AD9695_JESD_L_SCR_CFG_REG] & 0x1F) + 1);
+    out->M = (uint8_t)((adc.global[AD9695_JESD_M_CFG_REG] & 0x07) + 1);
+    out->NP = (uint8_t)((adc.global[AD9695_JESD_SCV_NP_CFG_REG] & 0x1F) + 1);
+}
+
+void sim_ad9695_report(void)
+{
+    fprintf(stderr, "sim: ad9695 %u soft resets, %u PLL retunes, PLL %s\n", adc.soft_resets, adc.pll_retunes,
+            sim_time_ns() >= adc.pll_lock_ns ? "locked" : "unlocked");
+}
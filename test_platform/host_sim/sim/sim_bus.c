@@ -0,0 +1,155 @@
+/* sim_bus.c
+ * The AXI address map as the firmware sees it through Xil_In32/Out32:
+ *   - the DDR buffer region, mapped at its physical address so the
+ *     firmware's fixed pointers (RX_BUFFER_BASE) work as they are
+ *   - the JESD204C link core: registers read back what was written, the
+ *     status register reports SYNC a lane alignment time after the core and
+ *     the PHY RX are out of reset and the AD9695's SERDES PLL is locked,
+ *     error counters stay at zero
+ *   - the JESD204 PHY: reset and power-down registers, PLLs locked, and a
+ *     DRP port per interface that completes in one access
+ * Anything else reads as zero and is counted as a bus error.
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#include "sim.h"
+#include "xil_io.h"
+#include "xparameters.h"
+#include "bjesdlink.h"
+#include "bjesdphy.h"
+
+#define LINK_REGS           (0x800 / 4)
+#define PHY_REGS            (0x600 / 4)
+#define DRP_SPACE           0x1000
+#define DRP_INTERFACES      JESDPHY_NUM_LANES
+#define LINK_ALIGN_NS       20000       /* CGS + ILA at the slowest lane rate */
+
+static uint32_t link_reg[LINK_REGS];
+static uint32_t phy_reg[PHY_REGS];
+static uint16_t drp_common[DRP_INTERFACES][DRP_SPACE];
+static uint16_t drp_gt[DRP_INTERFACES][DRP_SPACE];
+static uint64_t link_release_ns;        /* sim time link and PHY RX left reset, 0 = in reset */
+static uint64_t bus_errors;
+
+__attribute__((constructor)) static void sim_bus_init(void)
+{
+    void *p = mmap((void *)SIM_DDR_BASE, SIM_DDR_SIZE, PROT_READ | PROT_WRITE,
+                   MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE | MAP_FIXED_NOREPLACE, -1, 0);
+    if (p != (void *)SIM_DDR_BASE) {
+        fprintf(stderr, "sim: cannot map DDR at 0x%lx (%s)\n", SIM_DDR_BASE,
+                p == MAP_FAILED ? "mmap failed" : "address taken");
+        exit(1);
+    }
+}
+
+int sim_ddr_contains(UINTPTR addr, size_t len)
+{
+    return addr >= SIM_DDR_BASE && len <= SIM_DDR_SIZE && addr - SIM_DDR_BASE <= SIM_DDR_SIZE - len;
+}
+
+static void link_state_update(void)
+{
+    int in_reset = (link_reg[JESDLINK_RESET_REG / 4] & 1) || (phy_reg[JESDPHY_RX_RESET_REG / 4] & 1);
+    if (in_reset) link_release_ns = 0;
+    else if (!link_release_ns) link_release_ns = sim_time_ns();
+}
+
+int sim_link_synced(void)
+{
+    uint64_t lock_ns = sim_ad9695_pll_lock_ns();
+
+    if (!link_release_ns || lock_ns == SIM_NEVER) return 0;
+    return sim_time_ns() >= (lock_ns > link_release_ns ? lock_ns : link_release_ns) + LINK_ALIGN_NS;
+}
+
+/* ------------------------------- JESD204C ------------------------------- */
+static uint32_t link_read(uint32_t off)
+{
+    uint32_t lanes = link_reg[JESDLINK_CTRL_LANE_ENA_REG / 4];
+
+    if (off == JESDLINK_STAT_STATUS_REG) return sim_link_synced() ? JESDLINK_STATUS_SYNC : 0;
+    if (off == JESDLINK_STAT_RX_ERR_REG) return 0;
+    for (uint32_t n = 0; n < JESDLINK_NUM_LANES; n++) {
+        if (off == JESDLINK_STAT_RX_BUF_LVL_REG(n)) return sim_link_synced() && (lanes >> n & 1) ? 0x20 : 0;
+        if (off == JESDLINK_STAT_LINK_ERR_CNT(n) || off == JESDLINK_STAT_TEST_ERR_CNT(n)) return 0;
+    }
+    return off / 4 < LINK_REGS ? link_reg[off / 4] : 0;
+}
+
+static void link_write(uint32_t off, uint32_t value)
+{
+    if (off / 4 >= LINK_REGS) return;
+    link_reg[off / 4] = value;
+    if (off == JESDLINK_RESET_REG) link_state_update();
+}
+
+/* ------------------------------- JESD PHY ------------------------------- */
+static void drp_access(uint16_t (*space)[DRP_SPACE], uint32_t sel_reg, uint32_t wdata_reg, uint32_t rdata_reg,
+                       uint32_t cmd)
+{
+    uint32_t sel = phy_reg[sel_reg / 4] % DRP_INTERFACES;
+    uint32_t addr = cmd & JESDPHY_DRP_ADDR_MASK;
+
+    if (cmd & JESDPHY_DRP_WRITE) space[sel][addr] = (uint16_t)phy_reg[wdata_reg / 4];
+    else if (cmd & JESDPHY_DRP_READ) phy_reg[rdata_reg / 4] = space[sel][addr];
+}
+
+static uint32_t phy_read(uint32_t off)
+{
+    if (off == JESDPHY_PLL_STATUS_REG)
+        return (phy_reg[JESDPHY_TX_RESET_REG / 4] & 1) << 4 | (phy_reg[JESDPHY_RX_RESET_REG / 4] & 1) << 3;
+    if (off == JESDPHY_COMMON_DRP_STATUS_REG || off == JESDPHY_TRANSC_DRP_STATUS_REG) return 0;
+    if (off == JESDPHY_COMMON_INTERFACE_NUM_REG || off == JESDPHY_GT_INTERFACE_NUM_REG) return DRP_INTERFACES;
+    return off / 4 < PHY_REGS ? phy_reg[off / 4] : 0;
+}
+
+static void phy_write(uint32_t off, uint32_t value)
+{
+    if (off / 4 >= PHY_REGS) return;
+    phy_reg[off / 4] = value;
+    if (off == JESDPHY_COMMON_DRP_ADDR_REG)
+        drp_access(drp_common, JESDPHY_COMMON_INTERFACE_SEL_REG, JESDPHY_COMMON_DRP_WDATA_REG,
+                   JESDPHY_COMMON_DRP_RDATA_REG, value);
+    else if (off == JESDPHY_TRANSC_DRP_ADDR_REG)
+        drp_access(drp_gt, JESDPHY_GT_INTERFACE_SEL_REG, JESDPHY_TRANSC_DRP_WDATA_REG,
+                   JESDPHY_TRANSC_DRP_RDATA_REG, value);
+    else if (off == JESDPHY_RX_RESET_REG)
+        link_state_update();
+}
+
+/* --------------------------------- bus ---------------------------------- */
+static void bus_error(const char *dir, UINTPTR addr)
+{
+    if (bus_errors++ < 8) fprintf(stderr, "sim: %s of unmapped address 0x%08lx\n", dir, (unsigned long)addr);
+}
+
+u32 Xil_In32(UINTPTR addr)
+{
+    if (addr >= XPAR_JESD204C_0_BASEADDR && addr <= XPAR_JESD204C_0_HIGHADDR)
+        return link_read((uint32_t)(addr - XPAR_JESD204C_0_BASEADDR));
+    if (addr >= XPAR_JESD204_PHY_0_BASEADDR && addr <= XPAR_JESD204_PHY_0_HIGHADDR)
+        return phy_read((uint32_t)(addr - XPAR_JESD204_PHY_0_BASEADDR));
+    if (sim_ddr_contains(addr, 4)) {
+        u32 v;
+        memcpy(&v, (const void *)addr, sizeof(v));
+        return v;
+    }
+    bus_error("read", addr);
+    return 0;
+}
+
+void Xil_Out32(UINTPTR addr, u32 value)
+{
+    if (addr >= XPAR_JESD204C_0_BASEADDR && addr <= XPAR_JESD204C_0_HIGHADDR)
+        link_write((uint32_t)(addr - XPAR_JESD204C_0_BASEADDR), value);
+    else if (addr >= XPAR_JESD204_PHY_0_BASEADDR && addr <= XPAR_JESD204_PHY_0_HIGHADDR)
+        phy_write((uint32_t)(addr - XPAR_JESD204_PHY_0_BASEADDR), value);
+    else if (sim_ddr_contains(addr, 4))
+        memcpy((void *)addr, &value, sizeof(value));
+    else
+        bus_error("write", addr);
+}
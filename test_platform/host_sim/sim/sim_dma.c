@@ -0,0 +1,254 @@
+/* sim_dma.c
+ * AXI DMA, simple mode, S2MM (device to memory) only, as baxidma.c uses it.
+ * A transfer writes its buffer at once from the ADC source and then reports
+ * busy for the time the stream would take to deliver it, so the polling
+ * loop in dma_capture() sees the board's timing.
+ */
+
+#include <math.h>
+#include <string.h>
+
+#include "sim.h"
+#include "ad9695_registers.h"
+#include "xaxidma.h"
+#include "xparameters.h"
+
+#define DMA_MAX_TRANSFER    ((1U << XPAR_AXI_DMA_SG_LENGTH_WIDTH) - 1)
+
+/* The analog input: one tone, coherent in a JESDMODE_CAPTURE_SAMPLES capture */
+#define ADC_SAMPLE_HZ       500e6
+#define ADC_TONE_CYCLES     25          /* per ADC_TONE_PERIOD samples */
+#define ADC_TONE_PERIOD     128
+#define ADC_TONE_AMPLITUDE  29204.0     /* -1 dBFS */
+#define ADC_MAX_CONV        8
+#define ADC_MAX_SLICE       16          /* samples per converter per block, L=4 M=1 NP=8 */
+
+struct adc_source {
+    uint64_t n;                 /* samples this converter has produced */
+    uint32_t pn;                /* PN history, bit 0 newest */
+    uint8_t  test_mode;         /* mode the history belongs to */
+};
+
+/* One channel's input over a tone period, delayed and coded for its settings */
+struct adc_tone {
+    uint32_t delay_fs;
+    int      twos_complement;       /* -1 = not built yet */
+    uint16_t code[ADC_TONE_PERIOD];
+};
+
+static XAxiDma_Config dma_cfg = { 0, XPAR_XAXIDMA_0_BASEADDR, 0, 0, 1, XPAR_AXI_DMA_SG_LENGTH_WIDTH, 0 };
+static struct adc_source adc_src[ADC_MAX_CONV];
+static struct adc_tone adc_tone[2] = { { 0, -1, { 0 } }, { 0, -1, { 0 } } };
+static uint32_t adc_tone_builds;          /* bumped whenever a tone is rebuilt */
+static double tone_sin[ADC_TONE_PERIOD], tone_cos[ADC_TONE_PERIOD];
+
+/* Patterns the source generates; every other test mode carries the tone */
+#define ADC_PATTERN(mode)   (((mode) >= AD9695_TESTMODE_MIDSCALE_SHORT && (mode) <= AD9695_TESTMODE_ONE_ZERO_TOGGLE) \
+                             || (mode) == AD9695_TESTMODE_RAMP)
+
+/* One tone period of every converter in the capture layout, the link and
+ * tones it was built from, and where the next transfer starts in it */
+static struct {
+    struct sim_ad9695_link link;
+    uint32_t tone_builds;
+    u32 bytes, pos;                 /* bytes == 0: not built */
+    u8  raw[ADC_TONE_PERIOD * ADC_MAX_CONV * 2];
+} adc_period;
+
+__attribute__((constructor)) static void sim_dma_init(void)
+{
+    for (int n = 0; n < ADC_TONE_PERIOD; n++) {
+        tone_sin[n] = sin(2 * M_PI * ADC_TONE_CYCLES * n / ADC_TONE_PERIOD);
+        tone_cos[n] = cos(2 * M_PI * ADC_TONE_CYCLES * n / ADC_TONE_PERIOD);
+    }
+}
+
+static const uint16_t *tone_of(int c, const struct sim_ad9695_channel *ch)
+{
+    struct adc_tone *t = &adc_tone[c];
+
+    if (t->delay_fs != ch->delay_fs || t->twos_complement != ch->twos_complement) {
+        double ph = 2 * M_PI * ADC_SAMPLE_HZ * ADC_TONE_CYCLES / ADC_TONE_PERIOD * ch->delay_fs * 1e-15;
+        double sin_ph = sin(ph), cos_ph = cos(ph);
+        for (int n = 0; n < ADC_TONE_PERIOD; n++) {
+            int16_t v = (int16_t)lrint(ADC_TONE_AMPLITUDE * (tone_sin[n] * cos_ph + tone_cos[n] * sin_ph));
+            t->code[n] = (uint16_t)v ^ (ch->twos_complement ? 0 : 0x8000);
+        }
+        t->delay_fs = ch->delay_fs;
+        t->twos_complement = ch->twos_complement;
+        adc_tone_builds++;
+    }
+    return t->code;
+}
+
+/* The next count samples of one converter as the chip codes them; tone is
+ * its channel's input over one period, already delayed and coded.  Patterns
+ * the model has no data for (user pattern) fall back to the tone. */
+static void adc_next(struct adc_source *s, const struct sim_ad9695_channel *ch, const uint16_t *tone,
+                     uint16_t *out, u32 count)
+{
+    uint64_t n = s->n;
+    int a = 4, b = 8;
+
+    s->n += count;
+    if (s->test_mode != ch->test_mode) {
+        s->test_mode = ch->test_mode;
+        s->pn = UINT32_MAX;                 /* PN generators restart from all ones */
+    }
+    switch (ch->test_mode) {
+    case AD9695_TESTMODE_MIDSCALE_SHORT:
+        for (u32 k = 0; k < count; k++) out[k] = 0x0000;
+        return;
+    case AD9695_TESTMODE_POS_FULLSCALE:
+        for (u32 k = 0; k < count; k++) out[k] = 0x7FFF;
+        return;
+    case AD9695_TESTMODE_NEG_FULLSCALE:
+        for (u32 k = 0; k < count; k++) out[k] = 0x8000;
+        return;
+    case AD9695_TESTMODE_ALT_CHECKERBOARD:
+        for (u32 k = 0; k < count; k++) out[k] = ((n + k) & 1) ? 0x5555 : 0xAAAA;
+        return;
+    case AD9695_TESTMODE_ONE_ZERO_TOGGLE:
+        for (u32 k = 0; k < count; k++) out[k] = ((n + k) & 1) ? 0x0000 : 0xFFFF;
+        return;
+    case AD9695_TESTMODE_RAMP:
+        for (u32 k = 0; k < count; k++) out[k] = (uint16_t)(n + k);
+        return;
+    case AD9695_TESTMODE_PN23_SEQ:
+        a = 17;
+        b = 22;
+        /* fall through */
+    case AD9695_TESTMODE_PN9_SEQ:
+        /* one bit stream, MSB of each sample first: x^9 + x^5 + 1, x^23 + x^18 + 1 */
+        for (u32 k = 0; k < count; k++) {
+            for (int j = 0; j < 16; j++) s->pn = (s->pn << 1) | (((s->pn >> a) ^ (s->pn >> b)) & 1);
+            out[k] = (uint16_t)s->pn;
+        }
+        return;
+    }
+    for (u32 k = 0; k < count; k++) out[k] = tone[(n + k) % ADC_TONE_PERIOD];
+}
+
+/* Converters in the capture layout of link, from each converter's source */
+static void adc_layout(u8 *dst, u32 bytes, const struct sim_ad9695_link *link, const struct sim_ad9695_channel *ch,
+                       const uint16_t *const *tone, struct adc_source *src)
+{
+    uint16_t slice[ADC_MAX_SLICE];
+    u32 i = 0, width = link->NP > 8 ? 2 : 1;
+    u32 spc = 4U * link->L / (link->M * width);
+
+    spc = spc == 0 ? 1 : spc > ADC_MAX_SLICE ? ADC_MAX_SLICE : spc;
+    while (i < bytes) {
+        for (u32 c = 0; c < link->M && i < bytes; c++) {
+            u32 from = (link->M == 1) ? 0 : c * 2 / link->M;
+            u32 k, count = (bytes - i + width - 1) / width;
+
+            if (count > spc) count = spc;
+            adc_next(&src[c], &ch[from], tone[from], slice, count);
+            for (k = 0; k < count && width == 1; k++) dst[i++] = (u8)(slice[k] >> 8);
+            for (k = 0; k < count && width == 2 && i + 1 < bytes; k++, i += 2) {
+                dst[i] = (u8)slice[k];
+                dst[i + 1] = (u8)(slice[k] >> 8);
+            }
+            if (k < count && width == 2) dst[i++] = (u8)slice[k];     /* odd tail byte */
+        }
+    }
+}
+
+/*
+ * The converter data one transfer carries, in the capture layout of the link
+ * mode the AD9695 JESD registers select (see bjesdmode.h): per block, each
+ * converter's slice of samples, NP=8 modes keeping the sample MSBs.  Each
+ * channel follows its own test mode, output format and clock delay; the DDC
+ * outputs of M = 4/8 modes carry their channel's samples undecimated, I and
+ * Q alike.  While neither channel runs a pattern the data repeats every tone
+ * period, and a transfer is a copy out of one period built for the settings.
+ */
+void sim_adc_fill(u8 *dst, u32 bytes)
+{
+    struct sim_ad9695_link link;
+    struct sim_ad9695_channel ch[2];
+    const uint16_t *tone[2];
+
+    sim_ad9695_link(&link);
+    if (link.M > ADC_MAX_CONV) link.M = ADC_MAX_CONV;
+    for (int c = 0; c < 2; c++) {
+        sim_ad9695_channel(c, &ch[c]);
+        tone[c] = tone_of(c, &ch[c]);
+    }
+    if (ADC_PATTERN(ch[0].test_mode) || ADC_PATTERN(ch[1].test_mode)) {
+        adc_layout(dst, bytes, &link, ch, tone, adc_src);
+        return;
+    }
+
+    if (!adc_period.bytes || memcmp(&adc_period.link, &link, sizeof(link)) ||
+        adc_period.tone_builds != adc_tone_builds) {
+        struct adc_source fresh[ADC_MAX_CONV];
+
+        memset(fresh, 0, sizeof(fresh));
+        adc_period.link = link;
+        adc_period.tone_builds = adc_tone_builds;
+        adc_period.bytes = ADC_TONE_PERIOD * link.M * (link.NP > 8 ? 2 : 1);
+        adc_period.pos = 0;
+        adc_layout(adc_period.raw, adc_period.bytes, &link, ch, tone, fresh);
+    }
+    while (bytes) {
+        u32 n = adc_period.bytes - adc_period.pos;
+        if (n > bytes) n = bytes;
+        memcpy(dst, adc_period.raw + adc_period.pos, n);
+        dst += n;
+        bytes -= n;
+        adc_period.pos = (adc_period.pos + n) % adc_period.bytes;
+    }
+}
+
+XAxiDma_Config *XAxiDma_LookupConfig(UINTPTR id)
+{
+    (void)id;
+    return &dma_cfg;
+}
+
+int XAxiDma_CfgInitialize(XAxiDma *dma, XAxiDma_Config *config)
+{
+    memset(dma, 0, sizeof(*dma));
+    dma->RegBase = config->BaseAddr;
+    dma->HasMm2S = config->HasMm2S;
+    dma->HasS2Mm = config->HasS2Mm;
+    dma->HasSg = config->HasSg;
+    dma->IrqMask = XAXIDMA_IRQ_ALL_MASK;
+    dma->Initialized = 1;
+    return XST_SUCCESS;
+}
+
+u32 XAxiDma_SimpleTransfer(XAxiDma *dma, UINTPTR addr, u32 length, int direction)
+{
+    if (!dma->Initialized || direction != XAXIDMA_DEVICE_TO_DMA || !dma->HasS2Mm) return XST_INVALID_PARAM;
+    if (length == 0 || length > DMA_MAX_TRANSFER || !sim_ddr_contains(addr, length)) return XST_INVALID_PARAM;
+    if (XAxiDma_Busy(dma, direction)) return XST_FAILURE;
+
+    sim_adc_fill((u8 *)addr, length);
+    dma->BusyUntil = sim_time_ns() + SIM_DMA_START_NS + (uint64_t)length * 1000000000ULL / SIM_ADC_BYTES_PER_SEC;
+    return XST_SUCCESS;
+}
+
+u32 XAxiDma_Busy(XAxiDma *dma, int direction)
+{
+    return direction == XAXIDMA_DEVICE_TO_DMA && sim_time_ns() < dma->BusyUntil;
+}
+
+void XAxiDma_Reset(XAxiDma *dma)
+{
+    dma->BusyUntil = 0;
+}
+
+int XAxiDma_ResetIsDone(XAxiDma *dma)
+{
+    (void)dma;
+    return 1;
+}
+
+int XAxiDma_Resume(XAxiDma *dma)
+{
+    (void)dma;
+    return XST_SUCCESS;
+}
@@ -0,0 +1,328 @@
+/* sim_link.c
+ * The wire behind the simulated GEM0: Ethernet frames in and out of lwIP,
+ * either on a TAP device or through a UDP shim.  Kept free of lwIP headers
+ * (their byte-order macros clash with the host's socket headers); the lwIP
+ * side is sim_netif.c.
+ *
+ * TAP (-t <ifname>): frames go to the host kernel as they are, the board is
+ * a real 192.168.1.10 on that interface:
+ *     ip tuntap add dev tap0 mode tap user $USER
+ *     ip addr add 192.168.1.100/24 dev tap0 && ip link set tap0 up
+ *
+ * UDP shim (default, no privileges): every port the firmware binds, p, is a
+ * host UDP socket on <board addr>:(p + port offset), 127.0.0.<IP_ADDR3> by
+ * default.  A datagram arriving there enters lwIP as if the host at
+ * 192.168.1.100 had sent it from the same source port; a datagram lwIP sends
+ * leaves from the socket of its source port to <host addr>:<its dest port>.
+ * ARP for the host is answered locally.  So a host tool that talks to
+ * 127.0.0.10:15002 and listens on 5002 sees the board's usual traffic.
+ *
+ * Either way the transmit path fills in the IPv4 and UDP/TCP checksums,
+ * which lwIP leaves to the MAC's offload on the board.
+ */
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <linux/if.h>
+#include <linux/if_tun.h>
+#include <netinet/in.h>
+#include <sys/epoll.h>
+#include <sys/ioctl.h>
+#include <sys/socket.h>
+
+#include "sim.h"
+
+#define ETH_HLEN            14
+#define ETHTYPE_ARP         0x0806
+#define ETHTYPE_IP          0x0800
+#define IP_PROTO_TCP        6
+#define IP_PROTO_UDP        17
+#define SHIM_MAX_PORTS      8
+#define SHIM_QUEUE          8
+#define SHIM_PAYLOAD_MAX    (SIM_LINK_MTU - 28)
+
+static const uint8_t host_mac[6] = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x01 };
+
+static struct {
+    int      tap_fd;
+    int      epoll_fd;
+    uint8_t  board_mac[6];
+    uint32_t board_ip, host_ip;             /* network order */
+    struct in_addr bind_addr, host_addr;
+    struct { uint16_t port; int fd; } sock[SHIM_MAX_PORTS];
+    int      nsock;
+    uint8_t  queue[SHIM_QUEUE][64];          /* locally generated frames (ARP replies) */
+    size_t   queue_len[SHIM_QUEUE];
+    int      queued;
+    uint16_t ip_id;
+    int      announced;
+    struct sim_link_stats st;
+} lk = { .tap_fd = -1, .epoll_fd = -1 };
+
+static uint16_t rd16(const uint8_t *p) { return (uint16_t)(p[0] << 8 | p[1]); }
+static void     wr16(uint8_t *p, uint16_t v) { p[0] = (uint8_t)(v >> 8); p[1] = (uint8_t)v; }
+
+static uint32_t csum_add(uint32_t sum, const uint8_t *p, size_t len)
+{
+    for (; len > 1; p += 2, len -= 2) sum += rd16(p);
+    if (len) sum += (uint32_t)p[0] << 8;
+    return sum;
+}
+
+static uint16_t csum_fold(uint32_t sum)
+{
+    while (sum >> 16) sum = (sum & 0xFFFF) + (sum >> 16);
+    return (uint16_t)~sum;
+}
+
+/* What GEM0's checksum offload does to an outgoing IPv4 frame */
+static void fill_checksums(uint8_t *f, size_t len)
+{
+    if (len < ETH_HLEN + 20 || rd16(f + 12) != ETHTYPE_IP) return;
+    uint8_t *ip = f + ETH_HLEN;
+    size_t ihl = (size_t)(ip[0] & 0x0F) * 4, tot = rd16(ip + 2);
+    if (ihl < 20 || tot < ihl || ETH_HLEN + tot > len) return;
+
+    wr16(ip + 10, 0);
+    wr16(ip + 10, csum_fold(csum_add(0, ip, ihl)));
+
+    if (rd16(ip + 6) & 0x3FFF) return;      /* fragment: L4 header only in the first, leave it */
+    size_t off = ip[9] == IP_PROTO_UDP ? 6 : ip[9] == IP_PROTO_TCP ? 16 : 0;
+    size_t l4len = tot - ihl;
+    if (!off || l4len < off + 2) return;
+    uint8_t *l4 = ip + ihl;
+    uint32_t sum = csum_add(0, ip + 12, 8) + ip[9] + (uint32_t)l4len;
+    wr16(l4 + off, 0);
+    uint16_t c = csum_fold(csum_add(sum, l4, l4len));
+    wr16(l4 + off, (ip[9] == IP_PROTO_UDP && c == 0) ? 0xFFFF : c);
+}
+
+/* ------------------------------ UDP shim -------------------------------- */
+void sim_link_listen(uint16_t board_port)
+{
+    if (lk.epoll_fd < 0) return;
+    for (int i = 0; i < lk.nsock; i++)
+        if (lk.sock[i].port == board_port) return;
+    if (lk.nsock == SHIM_MAX_PORTS) return;
+
+    struct sockaddr_in a = { .sin_family = AF_INET, .sin_addr = lk.bind_addr };
+    int port = board_port + sim_opt.port_offset;
+    int fd = socket(AF_INET, SOCK_DGRAM | SOCK_NONBLOCK, 0);
+    a.sin_port = htons((uint16_t)port);
+    if (fd < 0 || port > 65535 || bind(fd, (struct sockaddr *)&a, sizeof(a)) != 0) {
+        fprintf(stderr, "sim: cannot bind %s:%d for board port %u (%s)\n", inet_ntoa(lk.bind_addr), port,
+                board_port, strerror(errno));
+        if (fd >= 0) close(fd);
+        lk.sock[lk.nsock++] = (typeof(lk.sock[0])){ board_port, -1 };  /* do not retry every poll */
+        return;
+    }
+    struct epoll_event ev = { .events = EPOLLIN, .data.fd = fd };
+    epoll_ctl(lk.epoll_fd, EPOLL_CTL_ADD, fd, &ev);
+    lk.sock[lk.nsock++] = (typeof(lk.sock[0])){ board_port, fd };
+    fprintf(stderr, "sim: board port %u at %s:%d\n", board_port, inet_ntoa(lk.bind_addr), port);
+}
+
+static void shim_queue(const uint8_t *f, size_t len)
+{
+    if (lk.queued == SHIM_QUEUE || len > sizeof(lk.queue[0])) return;
+    memcpy(lk.queue[lk.queued], f, len);
+    lk.queue_len[lk.queued++] = len;
+}
+
+static void shim_arp(const uint8_t *f, size_t len)
+{
+    const uint8_t *a = f + ETH_HLEN;
+    uint8_t r[ETH_HLEN + 28];
+
+    if (len < sizeof(r) || rd16(a + 6) != 1) return;           /* requests only */
+    if (!memcmp(a + 24, &lk.board_ip, 4)) return;              /* probe for ourselves */
+    memcpy(r, f + 6, 6);
+    memcpy(r + 6, host_mac, 6);
+    wr16(r + 12, ETHTYPE_ARP);
+    memcpy(r + ETH_HLEN, a, 6);                                /* htype, ptype, hlen, plen */
+    wr16(r + ETH_HLEN + 6, 2);
+    memcpy(r + ETH_HLEN + 8, host_mac, 6);
+    memcpy(r + ETH_HLEN + 14, a + 24, 4);                      /* the address asked for is "us" */
+    memcpy(r + ETH_HLEN + 18, a + 8, 10);                      /* back to the asker */
+    shim_queue(r, sizeof(r));
+}
+
+static void shim_ip(const uint8_t *f, size_t len)
+{
+    const uint8_t *ip = f + ETH_HLEN;
+    size_t ihl = (size_t)(ip[0] & 0x0F) * 4;
+
+    if (len < ETH_HLEN + 28 || ip[9] != IP_PROTO_UDP || ETH_HLEN + ihl + 8 > len) {
+        lk.st.tx_dropped++;
+        return;
+    }
+    if (rd16(ip + 6) & 0x3FFF) {                               /* fragments would need reassembly */
+        lk.st.tx_dropped++;
+        return;
+    }
+    const uint8_t *udp = ip + ihl;
+    size_t plen = rd16(udp + 4) - 8;
+    if (ETH_HLEN + ihl + 8 + plen > len) {
+        lk.st.tx_dropped++;
+        return;
+    }
+    int fd = -1;
+    for (int i = 0; i < lk.nsock && fd < 0; i++)
+        if (lk.sock[i].port == rd16(udp)) fd = lk.sock[i].fd;
+    for (int i = 0; i < lk.nsock && fd < 0; i++) fd = lk.sock[i].fd;
+    struct sockaddr_in to = { .sin_family = AF_INET, .sin_port = htons(rd16(udp + 2)), .sin_addr = lk.host_addr };
+    if (fd < 0 || sendto(fd, udp + 8, plen, 0, (struct sockaddr *)&to, sizeof(to)) < 0) {
+        lk.st.tx_dropped++;
+        return;
+    }
+    lk.st.tx_datagrams++;
+}
+
+/* The host resolving the board before its first request, as a real host
+ * does; lwIP learns the host's MAC from it and the board's first reply
+ * does not wait on ARP */
+static void shim_announce_host(void)
+{
+    uint8_t r[ETH_HLEN + 28];
+
+    memset(r, 0xFF, 6);
+    memcpy(r + 6, host_mac, 6);
+    wr16(r + 12, ETHTYPE_ARP);
+    wr16(r + ETH_HLEN, 1);
+    wr16(r + ETH_HLEN + 2, ETHTYPE_IP);
+    r[ETH_HLEN + 4] = 6;
+    r[ETH_HLEN + 5] = 4;
+    wr16(r + ETH_HLEN + 6, 1);
+    memcpy(r + ETH_HLEN + 8, host_mac, 6);
+    memcpy(r + ETH_HLEN + 14, &lk.host_ip, 4);
+    memset(r + ETH_HLEN + 18, 0, 6);
+    memcpy(r + ETH_HLEN + 24, &lk.board_ip, 4);
+    shim_queue(r, sizeof(r));
+}
+
+static size_t shim_rx(uint8_t *f, size_t cap)
+{
+    if (!lk.announced) {
+        shim_announce_host();
+        lk.announced = 1;
+    }
+    if (lk.queued) {
+        size_t len = lk.queue_len[0];
+        memcpy(f, lk.queue[0], len);
+        memmove(lk.queue, lk.queue + 1, sizeof(lk.queue[0]) * (size_t)(lk.queued - 1));
+        memmove(lk.queue_len, lk.queue_len + 1, sizeof(lk.queue_len[0]) * (size_t)(lk.queued - 1));
+        lk.queued--;
+        return len;
+    }
+    if (cap < ETH_HLEN + 28 + SHIM_PAYLOAD_MAX) return 0;
+    for (int i = 0; i < lk.nsock; i++) {
+        struct sockaddr_in from;
+        socklen_t fl = sizeof(from);
+        if (lk.sock[i].fd < 0) continue;
+        ssize_t n = recvfrom(lk.sock[i].fd, f + ETH_HLEN + 28, SHIM_PAYLOAD_MAX + 1, MSG_TRUNC,
+                             (struct sockaddr *)&from, &fl);
+        if (n < 0) continue;
+        if (n > SHIM_PAYLOAD_MAX) {                            /* larger than one frame */
+            lk.st.rx_dropped++;
+            continue;
+        }
+        uint8_t *ip = f + ETH_HLEN, *udp = ip + 20;
+        memcpy(f, lk.board_mac, 6);
+        memcpy(f + 6, host_mac, 6);
+        wr16(f + 12, ETHTYPE_IP);
+        ip[0] = 0x45;
+        ip[1] = 0;
+        wr16(ip + 2, (uint16_t)(28 + n));
+        wr16(ip + 4, lk.ip_id++);
+        wr16(ip + 6, 0);
+        ip[8] = 64;
+        ip[9] = IP_PROTO_UDP;
+        memcpy(ip + 12, &lk.host_ip, 4);
+        memcpy(ip + 16, &lk.board_ip, 4);
+        wr16(udp, ntohs(from.sin_port));
+        wr16(udp + 2, lk.sock[i].port);
+        wr16(udp + 4, (uint16_t)(8 + n));
+        fill_checksums(f, ETH_HLEN + 28 + (size_t)n);
+        lk.st.rx_datagrams++;
+        return ETH_HLEN + 28 + (size_t)n;
+    }
+    return 0;
+}
+
+/* -------------------------------- link ---------------------------------- */
+int sim_link_open(const uint8_t board_mac[6], uint32_t board_ip, uint32_t host_ip)
+{
+    memcpy(lk.board_mac, board_mac, 6);
+    lk.board_ip = board_ip;
+    lk.host_ip = host_ip;
+
+    if (sim_opt.tap) {
+        struct ifreq ifr;
+        lk.tap_fd = open("/dev/net/tun", O_RDWR | O_NONBLOCK);
+        memset(&ifr, 0, sizeof(ifr));
+        ifr.ifr_flags = IFF_TAP | IFF_NO_PI;
+        strncpy(ifr.ifr_name, sim_opt.tap, IFNAMSIZ - 1);
+        if (lk.tap_fd < 0 || ioctl(lk.tap_fd, TUNSETIFF, &ifr) != 0) {
+            fprintf(stderr, "sim: cannot attach to TAP %s (%s)\n", sim_opt.tap, strerror(errno));
+            if (lk.tap_fd >= 0) close(lk.tap_fd);
+            lk.tap_fd = -1;
+            return 1;
+        }
+        fprintf(stderr, "sim: link on TAP %s\n", ifr.ifr_name);
+        return 0;
+    }
+
+    char board[32];
+    const uint8_t *b = (const uint8_t *)&board_ip;
+    snprintf(board, sizeof(board), "127.0.0.%u", b[3]);
+    if (!inet_aton(sim_opt.board_addr ? sim_opt.board_addr : board, &lk.bind_addr) ||
+        !inet_aton(sim_opt.host_addr, &lk.host_addr)) {
+        fprintf(stderr, "sim: bad shim address\n");
+        return 1;
+    }
+    lk.epoll_fd = epoll_create1(0);
+    if (lk.epoll_fd < 0) {
+        perror("sim: epoll_create1");
+        return 1;
+    }
+    fprintf(stderr, "sim: link on UDP shim, board %s (+%d), host %s\n", inet_ntoa(lk.bind_addr),
+            sim_opt.port_offset, sim_opt.host_addr);
+    return 0;
+}
+
+int sim_link_fd(void)
+{
+    return lk.tap_fd >= 0 ? lk.tap_fd : lk.epoll_fd;
+}
+
+size_t sim_link_rx(uint8_t *frame, size_t cap)
+{
+    if (lk.tap_fd < 0) return shim_rx(frame, cap);
+    ssize_t n = read(lk.tap_fd, frame, cap);
+    if (n <= 0) return 0;
+    lk.st.rx_datagrams++;
+    return (size_t)n;
+}
+
+void sim_link_tx(uint8_t *frame, size_t len)
+{
+    fill_checksums(frame, len);
+    if (lk.tap_fd >= 0) {
+        if (write(lk.tap_fd, frame, len) == (ssize_t)len) lk.st.tx_datagrams++;
+        else lk.st.tx_dropped++;
+        return;
+    }
+    if (len < ETH_HLEN) return;
+    if (rd16(frame + 12) == ETHTYPE_ARP) shim_arp(frame, len);
+    else if (rd16(frame + 12) == ETHTYPE_IP) shim_ip(frame, len);
+}
+
+const struct sim_link_stats *sim_link_get_stats(void)
+{
+    return &lk.st;
+}
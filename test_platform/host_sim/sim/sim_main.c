@@ -0,0 +1,57 @@
+/* sim_main.c
+ * Options, then the firmware's own main() (built as fw_main).
+ */
+
+#include <getopt.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "sim.h"
+
+int fw_main(void);
+
+struct sim_options sim_opt = {
+    .host_addr = "127.0.0.1",
+    .port_offset = SIM_PORT_OFFSET,
+};
+
+static void usage(const char *argv0)
+{
+    fprintf(stderr,
+            "usage: %s [-r | -d] [-k] [-T seconds] [-t tap] [-a board_addr] [-H host_addr] [-o port_offset]\n"
+            "  -r  sleep through delays in real time (default: skip them on the simulated clock)\n"
+            "  -d  deterministic clock: only modelled delays advance it, idle waits aside\n"
+            "  -k  keep running after stdin ends\n"
+            "  -T  stop after this many wall-clock seconds\n"
+            "  -t  attach GEM0 to this TAP interface instead of the UDP shim\n"
+            "  -a  shim: address the board's ports are bound on (default 127.0.0.<IP_ADDR3>)\n"
+            "  -H  shim: address the board's datagrams are sent to (default 127.0.0.1)\n"
+            "  -o  shim: board port p is bound at p + offset (default %d)\n",
+            argv0, SIM_PORT_OFFSET);
+    exit(2);
+}
+
+int main(int argc, char **argv)
+{
+    int c;
+
+    while ((c = getopt(argc, argv, "rdkT:t:a:H:o:")) != -1) {
+        switch (c) {
+        case 'r': sim_opt.real_time = 1; break;
+        case 'd': sim_opt.deterministic = 1; break;
+        case 'k': sim_opt.keep_running = 1; break;
+        case 'T': sim_opt.seconds = atof(optarg); break;
+        case 't': sim_opt.tap = optarg; break;
+        case 'a': sim_opt.board_addr = optarg; break;
+        case 'H': sim_opt.host_addr = optarg; break;
+        case 'o': sim_opt.port_offset = atoi(optarg); break;
+        default: usage(argv[0]);
+        }
+    }
+    if (optind != argc || sim_opt.port_offset < 0 || (sim_opt.real_time && sim_opt.deterministic)) usage(argv[0]);
+
+    atexit(sim_netif_report);
+    atexit(sim_spi_report);
+    atexit(sim_ad9695_report);
+    return fw_main();
+}
@@ -0,0 +1,120 @@
+/* sim_netif.c
+ * The Xilinx adapter's two entry points for GEM0 (xemac_add, xemacif_input)
+ * over the host link in sim_link.c, and lwIP's clock.
+ *
+ * Frames move synchronously: lwIP's linkoutput hands the frame to the link
+ * at once and xemacif_input drains what the link has pending, so the ring
+ * counters bstats reads only ever show an idle MAC.  Before each drain the
+ * UDP pcbs are scanned so a port the firmware has just bound is reachable
+ * through the shim.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "lwip/etharp.h"
+#include "lwip/netif.h"
+#include "lwip/pbuf.h"
+#include "lwip/udp.h"
+#include "netif/ethernet.h"
+#include "netif/xadapter.h"
+#include "netif/xemacpsif.h"
+#include "xlwipconfig.h"
+
+#include "sim.h"
+#include "ethernet.h"
+
+#define SIM_RX_BUDGET       64      /* frames per xemacif_input() call */
+
+static xemacpsif_s sim_emac = {
+    .emacps = {
+        .BaseAddress = XPAR_XEMACPS_0_BASEADDR,
+        .TxBdRing = { XLWIP_CONFIG_N_TX_DESC, XLWIP_CONFIG_N_TX_DESC, 0, 0, 0 },
+        .RxBdRing = { XLWIP_CONFIG_N_RX_DESC, XLWIP_CONFIG_N_RX_DESC, 0, 0, 0 },
+    },
+};
+static struct xemac_s sim_xemac = { xemac_type_emacps, 0, &sim_emac };
+static u8 sim_mac[6];
+static int link_ok;
+static uint64_t rx_nomem;
+
+u32_t sys_now(void)
+{
+    return (u32_t)(sim_time_ns() / 1000000);
+}
+
+static err_t sim_linkoutput(struct netif *netif, struct pbuf *p)
+{
+    uint8_t frame[SIM_LINK_MTU + 18];
+    (void)netif;
+
+    if (p->tot_len > sizeof(frame)) return ERR_BUF;
+    pbuf_copy_partial(p, frame, p->tot_len, 0);
+    sim_link_tx(frame, p->tot_len);
+    return ERR_OK;
+}
+
+static err_t sim_netif_init(struct netif *netif)
+{
+    memcpy(netif->hwaddr, sim_mac, sizeof(sim_mac));
+    netif->hwaddr_len = ETH_HWADDR_LEN;
+    netif->mtu = SIM_LINK_MTU;
+    netif->flags = NETIF_FLAG_BROADCAST | NETIF_FLAG_ETHARP | NETIF_FLAG_LINK_UP;
+    netif->name[0] = 's';
+    netif->name[1] = 'm';
+    netif->output = etharp_output;
+    netif->linkoutput = sim_linkoutput;
+    return ERR_OK;
+}
+
+struct netif *xemac_add(struct netif *netif, ip_addr_t *ipaddr, ip_addr_t *netmask, ip_addr_t *gw,
+                        unsigned char *mac_ethernet_address, UINTPTR mac_baseaddr)
+{
+    ip4_addr_t host;
+
+    if (mac_baseaddr != XPAR_XEMACPS_0_BASEADDR) return NULL;
+    memcpy(sim_mac, mac_ethernet_address, sizeof(sim_mac));
+    IP4_ADDR(&host, USR_IP_ADDR0, USR_IP_ADDR1, USR_IP_ADDR2, USR_IP_ADDR3);
+    if (sim_link_open(sim_mac, ip4_addr_get_u32(ip_2_ip4(ipaddr)), ip4_addr_get_u32(&host))) return NULL;
+    link_ok = 1;
+    sim_emac.emacps.IsStarted = 1;
+    return netif_add(netif, ip_2_ip4(ipaddr), ip_2_ip4(netmask), ip_2_ip4(gw), &sim_xemac, sim_netif_init,
+                     ethernet_input);
+}
+
+int xemacif_input(struct netif *netif)
+{
+    uint8_t frame[SIM_LINK_MTU + 18];
+    int n = 0;
+
+    if (!link_ok) return 0;
+    for (struct udp_pcb *pcb = udp_pcbs; pcb; pcb = pcb->next)
+        if (pcb->local_port) sim_link_listen(pcb->local_port);
+
+    for (size_t len; n < SIM_RX_BUDGET && (len = sim_link_rx(frame, sizeof(frame))) != 0; n++) {
+        struct pbuf *p = pbuf_alloc(PBUF_RAW, (u16_t)len, PBUF_POOL);
+        if (!p) {
+            rx_nomem++;
+            continue;
+        }
+        pbuf_take(p, frame, (u16_t)len);
+        if (netif->input(p, netif) != ERR_OK) pbuf_free(p);
+    }
+    return n;
+}
+
+int sim_netif_fd(void)
+{
+    return link_ok ? sim_link_fd() : -1;
+}
+
+void sim_netif_report(void)
+{
+    const struct sim_link_stats *st = sim_link_get_stats();
+
+    if (!link_ok) return;
+    fprintf(stderr, "sim: link rx %llu (%llu dropped, %llu no pbuf)  tx %llu (%llu dropped)\n",
+            (unsigned long long)st->rx_datagrams, (unsigned long long)st->rx_dropped,
+            (unsigned long long)rx_nomem, (unsigned long long)st->tx_datagrams,
+            (unsigned long long)st->tx_dropped);
+}
@@ -0,0 +1,131 @@
+/* sim_spi.c
+ * PS SPI master and PS GPIO.  The slave is the AD9695 model (sim_ad9695.c);
+ * PDWN is the GPIO pin peripherals.h names for it.
+ *
+ * A polled transfer takes its SCLK time at the programmed prescaler plus a
+ * fixed cost for chip select and FIFO turnaround, on the simulated clock, so
+ * bulk and cached register access can be compared by the time they take.
+ * The totals are printed at exit.
+ */
+
+#include <stdio.h>
+#include <string.h>
+
+#include "sim.h"
+#include "xspips.h"
+#include "xgpiops.h"
+#include "xparameters.h"
+#include "peripherals.h"
+
+#define SPI_XFER_OVERHEAD_NS    400         /* CS setup/hold and FIFO turnaround */
+
+static XSpiPs_Config spi_cfg = { 0, XPAR_XSPIPS_0_BASEADDR, XPAR_XSPIPS_0_SPI_CLK_FREQ_HZ };
+static XGpioPs_Config gpio_cfg = { 0, XPAR_XGPIOPS_0_BASEADDR };
+static uint64_t spi_xfers, spi_bytes, spi_busy_ns;
+
+void sim_spi_report(void)
+{
+    fprintf(stderr, "sim: spi %llu transfers, %llu bytes, %llu us on the bus\n", (unsigned long long)spi_xfers,
+            (unsigned long long)spi_bytes, (unsigned long long)(spi_busy_ns / 1000));
+}
+
+/* --------------------------------- SPI ---------------------------------- */
+XSpiPs_Config *XSpiPs_LookupConfig(UINTPTR id)
+{
+    (void)id;
+    return &spi_cfg;
+}
+
+s32 XSpiPs_CfgInitialize(XSpiPs *spi, const XSpiPs_Config *config, u32 base)
+{
+    memset(spi, 0, sizeof(*spi));
+    spi->Config = *config;
+    spi->Config.BaseAddress = base;
+    spi->Prescaler = XSPIPS_CLK_PRESCALE_256;
+    spi->SlaveSelect = 0xF;
+    spi->IsReady = 1;
+    return XST_SUCCESS;
+}
+
+s32 XSpiPs_SetOptions(XSpiPs *spi, u32 options)
+{
+    spi->Options = options;
+    return XST_SUCCESS;
+}
+
+s32 XSpiPs_SetClkPrescaler(XSpiPs *spi, u8 prescaler)
+{
+    if (prescaler < XSPIPS_CLK_PRESCALE_4 || prescaler > XSPIPS_CLK_PRESCALE_256) return XST_INVALID_PARAM;
+    spi->Prescaler = prescaler;
+    return XST_SUCCESS;
+}
+
+s32 XSpiPs_SetSlaveSelect(XSpiPs *spi, u8 slave)
+{
+    spi->SlaveSelect = slave;
+    return XST_SUCCESS;
+}
+
+s32 XSpiPs_PolledTransfer(XSpiPs *spi, u8 *tx, u8 *rx, u32 count)
+{
+    if (!spi->IsReady || !tx || count < 2) return XST_INVALID_PARAM;
+
+    int read = (tx[0] & 0x80) != 0;
+    int step = sim_ad9695_addr_step();
+    uint16_t addr = (uint16_t)(((tx[0] & 0x7F) << 8) | tx[1]);
+
+    if (rx) rx[0] = rx[1] = 0;
+    for (u32 i = 2; i < count; i++, addr = (uint16_t)((addr + step) & 0x7FFF)) {
+        if (read) {
+            if (rx) rx[i] = sim_ad9695_read(addr);
+        } else {
+            sim_ad9695_write(addr, tx[i]);
+        }
+    }
+
+    uint32_t sclk_hz = spi->Config.InputClockHz >> (spi->Prescaler + 1);
+    uint64_t ns = SPI_XFER_OVERHEAD_NS + (uint64_t)count * 8 * 1000000000ULL / (sclk_hz ? sclk_hz : 1);
+    spi_xfers++;
+    spi_bytes += count;
+    spi_busy_ns += ns;
+    sim_delay_ns(ns);
+    return XST_SUCCESS;
+}
+
+/* --------------------------------- GPIO --------------------------------- */
+XGpioPs_Config *XGpioPs_LookupConfig(UINTPTR id)
+{
+    (void)id;
+    return &gpio_cfg;
+}
+
+s32 XGpioPs_CfgInitialize(XGpioPs *gpio, const XGpioPs_Config *config, UINTPTR base)
+{
+    memset(gpio, 0, sizeof(*gpio));
+    gpio->GpioConfig = *config;
+    gpio->GpioConfig.BaseAddr = base;
+    gpio->IsReady = 1;
+    return XST_SUCCESS;
+}
+
+void XGpioPs_SetDirectionPin(XGpioPs *gpio, u32 pin, u32 direction)
+{
+    if (pin < XGPIOPS_MAX_PINS) gpio->Direction[pin] = (u8)direction;
+}
+
+void XGpioPs_SetOutputEnablePin(XGpioPs *gpio, u32 pin, u32 enable)
+{
+    if (pin < XGPIOPS_MAX_PINS) gpio->OutputEnable[pin] = (u8)enable;
+}
+
+void XGpioPs_WritePin(XGpioPs *gpio, u32 pin, u32 data)
+{
+    if (pin >= XGPIOPS_MAX_PINS) return;
+    gpio->Value[pin] = (u8)(data & 1);
+    if (pin == GPIO_PWDN_PIN) sim_ad9695_pdwn((int)(data & 1));
+}
+
+u32 XGpioPs_ReadPin(const XGpioPs *gpio, u32 pin)
+{
+    return pin < XGPIOPS_MAX_PINS ? gpio->Value[pin] : 0;
+}
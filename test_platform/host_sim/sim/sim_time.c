@@ -0,0 +1,86 @@
+/* sim_time.c
+ * Simulated time: the host's monotonic clock plus every delay the firmware
+ * asked for but did not have to wait out.  By default usleep() and the time
+ * peripheral accesses take are skipped, so a 500 ms reset wait costs
+ * nothing while XTime still reports it; with -r they are slept for real.
+ * With -d the host clock is left out: only modelled delays (and the UART's
+ * idle waits, sim_uart.c) move time, so a scripted run reports the same
+ * timings every time.
+ */
+
+#include <time.h>
+
+#include "sim.h"
+#include "sleep.h"
+#include "xiltimer.h"
+#include "xpseudo_asm.h"
+
+static uint64_t t_start_ns;
+static uint64_t skipped_ns;
+static uint64_t pmcr;
+
+static uint64_t monotonic_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+__attribute__((constructor)) static void sim_time_init(void)
+{
+    t_start_ns = monotonic_ns();
+}
+
+uint64_t sim_wall_ns(void)
+{
+    return monotonic_ns() - t_start_ns;
+}
+
+uint64_t sim_time_ns(void)
+{
+    return (sim_opt.deterministic ? 0 : sim_wall_ns()) + skipped_ns;
+}
+
+void sim_delay_ns(uint64_t ns)
+{
+    if (!sim_opt.real_time) {
+        skipped_ns += ns;
+        return;
+    }
+    uint64_t end = monotonic_ns() + ns;
+    if (ns > 100000) {
+        struct timespec ts = { (time_t)(ns / 1000000000ULL), (long)(ns % 1000000000ULL) };
+        nanosleep(&ts, NULL);
+    }
+    while (monotonic_ns() < end) {
+    }
+}
+
+int sim_usleep(ULONG useconds)
+{
+    sim_delay_ns((uint64_t)useconds * 1000ULL);
+    return 0;
+}
+
+unsigned sim_sleep(unsigned seconds)
+{
+    sim_delay_ns((uint64_t)seconds * 1000000000ULL);
+    return 0;
+}
+
+void XTime_GetTime(XTime *t)
+{
+    *t = (XTime)((unsigned __int128)sim_time_ns() * COUNTS_PER_SECOND / 1000000000ULL);
+}
+
+u64 sim_mfcp(int reg)
+{
+    if (reg == PMCCNTR_EL0)
+        return (u64)((unsigned __int128)sim_time_ns() * XPAR_CPU_CORE_CLOCK_FREQ_HZ / 1000000000ULL);
+    return reg == PMCR_EL0 ? pmcr : 0;
+}
+
+void sim_mtcp(int reg, u64 value)
+{
+    if (reg == PMCR_EL0) pmcr = value;
+}
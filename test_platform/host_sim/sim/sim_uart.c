@@ -0,0 +1,110 @@
+/* sim_uart.c
+ * UART0 on the process's stdin/stdout.  The command loop polls
+ * XUartPs_IsReceiveData() between xemacif_input() calls; when neither stdin
+ * nor the network link has anything, the poll here waits up to
+ * UART_IDLE_WAIT_MS for either, so an idle simulator sleeps instead of
+ * spinning and a frame is still picked up as soon as it arrives.
+ * End of input ends the run (unless -k), which makes piped command scripts
+ * self-terminating.
+ * Output costs its line time at the set baud rate, as the board's polled
+ * xil_printf does; bring-up code that prints between two steps gets the
+ * same slack on the simulated clock as on hardware.
+ */
+
+#include <errno.h>
+#include <poll.h>
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "sim.h"
+#include "xuartps.h"
+#include "xil_printf.h"
+#include "xparameters.h"
+
+#define UART_IDLE_WAIT_MS   1
+
+static XUartPs_Config uart_cfg = { 0, XPAR_XUARTPS_0_BASEADDR, XPAR_XUARTPS_0_CLOCK_FREQ };
+static u8 rx_buf[256];
+static size_t rx_head, rx_tail;
+static int rx_eof;
+static u32 tx_baud = 115200;
+
+void xil_printf(const char8 *fmt, ...)
+{
+    va_list ap;
+    va_start(ap, fmt);
+    int n = vprintf(fmt, ap);
+    va_end(ap);
+    fflush(stdout);
+    if (n > 0) sim_delay_ns((uint64_t)n * 10 * 1000000000ULL / tx_baud);     /* 8N1 */
+}
+
+void sim_check_deadline(void)
+{
+    if (sim_opt.seconds > 0 && (double)sim_wall_ns() > sim_opt.seconds * 1e9) {
+        fprintf(stderr, "\nsim: %.1f s limit reached\n", sim_opt.seconds);
+        exit(0);
+    }
+}
+
+static void uart_fill(int timeout_ms)
+{
+    struct pollfd fds[2] = { { STDIN_FILENO, POLLIN, 0 }, { sim_netif_fd(), POLLIN, 0 } };
+    int nfds = fds[1].fd >= 0 ? 2 : 1;
+
+    if (rx_eof) fds[0].fd = -1;
+    uint64_t t0 = sim_wall_ns();
+    int ready = poll(fds, (nfds_t)nfds, timeout_ms);
+    if (sim_opt.deterministic) sim_delay_ns(sim_wall_ns() - t0);    /* idle time is still time */
+    if (ready <= 0 || !(fds[0].revents & (POLLIN | POLLHUP))) return;
+
+    ssize_t n = read(STDIN_FILENO, rx_buf, sizeof(rx_buf));
+    if (n > 0) {
+        rx_head = 0;
+        rx_tail = (size_t)n;
+    } else if (n == 0 || errno != EAGAIN) {
+        rx_eof = 1;
+        if (!sim_opt.keep_running) exit(0);
+    }
+}
+
+u32 sim_uart_rx_ready(void)
+{
+    if (rx_head < rx_tail) return 1;
+    sim_check_deadline();
+    uart_fill(0);
+    if (rx_head < rx_tail) return 1;
+    uart_fill(UART_IDLE_WAIT_MS);
+    return rx_head < rx_tail;
+}
+
+u32 sim_uart_read(void)
+{
+    return rx_head < rx_tail ? rx_buf[rx_head++] : 0;
+}
+
+XUartPs_Config *XUartPs_LookupConfig(UINTPTR id)
+{
+    (void)id;
+    return &uart_cfg;
+}
+
+s32 XUartPs_CfgInitialize(XUartPs *uart, const XUartPs_Config *config, u32 base)
+{
+    memset(uart, 0, sizeof(*uart));
+    uart->Config = *config;
+    uart->Config.BaseAddress = base;
+    uart->BaudRate = tx_baud;
+    uart->IsReady = 1;
+    return XST_SUCCESS;
+}
+
+s32 XUartPs_SetBaudRate(XUartPs *uart, u32 baud)
+{
+    if (!baud) return XST_INVALID_PARAM;
+    uart->BaudRate = tx_baud = baud;
+    return XST_SUCCESS;
+}
@@ -7,6 +7,9 @@
 #include "ad9695_registers.h"
 #include "sleep.h"
 #include "ad9695_api.h"
+#include "ad9695_regcache.h"
+#include "bstats.h"
+#include "bboot.h"
 
 // External SPI inst for ZCU102
 extern XSpiPs spi_inst; 
@@ -28,7 +31,7 @@ extern XSpiPs spi_inst;
 static void ad9695_testmode_set(uint8_t ch, uint8_t mode)
 {
     ad9695_adc_set_channel_select(ch);
-	ad9695_write_register(&spi_inst, AD9695_REG_TEST_MODE, mode);
+	ad9695_reg_write(AD9695_REG_TEST_MODE, mode);
     ad9695_adc_set_channel_select(2);
 }
 
@@ -46,8 +49,17 @@ void ad9695_initialize(struct ad9695_state* state_ptr)
 	ad9695_init();
 
     // Reset
+#if BOOT_FAST
+    ad9695_hardware_reset_poll(AD9695_RESET_TIMEOUT_US);
+    ad9695_software_reset_poll(AD9695_RESET_TIMEOUT_US);
+#else
     ad9695_hardware_reset();
 	ad9695_software_reset();
+#endif
+    boot_phase_mark("ad9695 reset");
+
+    // Collect the configuration in the register shadow, flushed before link enable
+    ad9695_regcache_batch_begin();
 
     // Use all channels
 	ad9695_adc_set_channel_select(AD9695_ADC_CH_ALL - 1);
@@ -58,7 +70,12 @@ void ad9695_initialize(struct ad9695_state* state_ptr)
 	sample_rate_khz = state_ptr->sample_clk_freq_khz;
 
     // Set Operation Mode
-	ad9695_adc_set_fc_ch_mode(state_ptr->fc_ch);
+    if (state_ptr->num_ddc) {
+        ad9695_adc_set_ddc(state_ptr->num_ddc, state_ptr->dcm, state_ptr->ddc_complex);
+        sample_rate_khz /= state_ptr->dcm;
+    } else {
+	    ad9695_adc_set_fc_ch_mode(state_ptr->fc_ch);
+    }
 
     // Channel test mode, will return to both channels
 	ad9695_testmode_set(0, state_ptr->test_mode_ch0);
@@ -78,9 +95,18 @@ void ad9695_initialize(struct ad9695_state* state_ptr)
     // Set appropriate delays
     
 
+    ad9695_regcache_batch_commit();
+
     // Enable the link with JESD init sequence. IMPORTANT!
 	ad9695_jesd_enable_link(1);
-
+    boot_phase_mark("ad9695 config");
+
+#if BOOT_FAST
+    // PLL lock is awaited by the caller so it can overlap the JESD PHY reset
+    (void)pll_stat;
+    (void)timeout;
+	printf("ad9695 successfully configured, PLL locking\n");
+#else
 	timeout = 10;
 
 	do {
@@ -88,13 +114,17 @@ void ad9695_initialize(struct ad9695_state* state_ptr)
 		ad9695_jesd_get_pll_status(&pll_stat);
 	} while (!(pll_stat & AD9695_JESD_PLL_LOCK_STAT) && timeout--);
 
+	if (!(pll_stat & AD9695_JESD_PLL_LOCK_STAT)) {
+		bstats_inc(BSTAT_AD9695_PLL_UNLOCK);
+	}
 	xil_printf("ad9695 PLL %s\r\n", (pll_stat & AD9695_JESD_PLL_LOCK_STAT) ? "LOCKED" : "UNLOCKED");
 	printf("ad9695 successfully initialized\n");
+#endif
 }
 
 /*
  * Forces the link to output K28.5
  */
 void ad9695_jesd_link_force_cgs() {
-    ad9695_write_register(&spi_inst, AD9695_JESD_LINK_CTRL2_REG, AD9695_JESD_LINK_FORCE_CGS);
+    ad9695_reg_write(AD9695_JESD_LINK_CTRL2_REG, AD9695_JESD_LINK_FORCE_CGS);
 }
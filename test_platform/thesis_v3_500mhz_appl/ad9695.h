@@ -53,11 +53,18 @@
 #define ad9695_CHIP_TYPE	0x03
 #define ad9695_CHIP_ID		0xDF
 
+/* Bounded timeouts for the fast bring-up path (see bboot.h) */
+#define AD9695_RESET_TIMEOUT_US     20000
+#define AD9695_PLL_LOCK_TIMEOUT_US  100000
+
 struct ad9695_state{
 	uint64_t sample_clk_freq_khz;
 	uint8_t powerdown_pin_en;
 	uint32_t powerdown_mode;
 	uint8_t fc_ch;
+	uint8_t num_ddc;        /* 0 = full bandwidth (fc_ch), else DDCs in front of JESD */
+	uint8_t dcm;            /* chip decimation when num_ddc != 0 */
+	uint8_t ddc_complex;    /* DDC output is I/Q */
 	uint32_t test_mode_ch0;
 	uint32_t test_mode_ch1;
     struct jesd_param_t *jesd_param;
@@ -12,6 +12,9 @@
 #include "ad9695_api.h"
 #include "ad9695_registers.h"
 #include "peripherals.h"
+#include "ad9695_regcache.h"
+#include "bstats.h"
+#include "ad9695.h"
 #include "xspips.h"
 #include "xgpiops.h"
 #include "xil_printf.h"
@@ -26,6 +29,10 @@
 extern XSpiPs spi_inst;
 extern XGpioPs gpio_inst;
 
+#define AD9695_PDWN_PULSE_US    1000    /* PDWN high time for the fast hardware reset */
+#define AD9695_POLL_STEP_US     10      /* status polling granularity                  */
+#define AD9695_CLK_DETECTED     SET_BIT(0)
+
 void ad9695_init(void)
 {
     uint8_t tmp_reg;
@@ -43,6 +50,7 @@ void ad9695_hardware_reset(void)
     XGpioPs_WritePin(&gpio_inst, GPIO_PWDN_PIN, 1);
     usleep(500000);
     XGpioPs_WritePin(&gpio_inst, GPIO_PWDN_PIN, 0);
+    ad9695_regcache_invalidate();
     xil_printf("AD9695 hardware reset performed.\r\n");
 }
 
@@ -50,49 +58,103 @@ void ad9695_software_reset(void)
 {
     ad9695_write_register(&spi_inst, AD9695_IF_CFG_A_REG, SET_BIT(0) | SET_BIT(7));
     ad9695_write_register(&spi_inst, AD9695_IF_CFG_B_REG, SET_BIT(1));
+    ad9695_regcache_invalidate();
     usleep(500000);
     if ((ad9695_read_bit(&spi_inst, AD9695_IF_CFG_A_REG, 0) == 0) &&
         (ad9695_read_bit(&spi_inst, AD9695_IF_CFG_B_REG, 1) == 0)) {
         xil_printf("AD9695 software reset success!\r\n");
     } else {
+        bstats_inc(BSTAT_AD9695_RESET_FAIL);
         xil_printf("FAILURE: AD9695 software reset failed! Reset bits did not self clear.\r\n");
     }
 }
 
+/* Short PDWN pulse, then wait only until SPI answers with the chip type and
+ * the input clock is detected again, instead of a fixed 500 ms. */
+int ad9695_hardware_reset_poll(uint32_t timeout_us)
+{
+    uint8_t chip_type = 0, clk_stat = 0;
+    uint32_t waited = 0;
+
+    XGpioPs_WritePin(&gpio_inst, GPIO_PWDN_PIN, 1);
+    usleep(AD9695_PDWN_PULSE_US);
+    XGpioPs_WritePin(&gpio_inst, GPIO_PWDN_PIN, 0);
+    ad9695_regcache_invalidate();
+
+    do {
+        ad9695_read_register(&spi_inst, AD9695_CHIP_TYPE_REG, &chip_type);
+        ad9695_read_register(&spi_inst, AD9695_IP_CLK_STAT_REG, &clk_stat);
+        if ((chip_type == ad9695_CHIP_TYPE) && (clk_stat & AD9695_CLK_DETECTED)) {
+            xil_printf("AD9695 hardware reset performed (%d us).\r\n", waited);
+            return 0;
+        }
+        usleep(AD9695_POLL_STEP_US);
+        waited += AD9695_POLL_STEP_US;
+    } while (waited < timeout_us);
+
+    bstats_inc(BSTAT_AD9695_RESET_FAIL);
+    xil_printf("FAILURE: AD9695 not ready after hardware reset (type 0x%02X, clk 0x%02X).\r\n", chip_type, clk_stat);
+    return 1;
+}
+
+/* Issue the soft reset and poll the self-clearing bits instead of sleeping */
+int ad9695_software_reset_poll(uint32_t timeout_us)
+{
+    uint32_t waited = 0;
+
+    ad9695_write_register(&spi_inst, AD9695_IF_CFG_A_REG, SET_BIT(0) | SET_BIT(7));
+    ad9695_write_register(&spi_inst, AD9695_IF_CFG_B_REG, SET_BIT(1));
+    ad9695_regcache_invalidate();
+
+    do {
+        usleep(AD9695_POLL_STEP_US);
+        waited += AD9695_POLL_STEP_US;
+        if ((ad9695_read_bit(&spi_inst, AD9695_IF_CFG_A_REG, 0) == 0) &&
+            (ad9695_read_bit(&spi_inst, AD9695_IF_CFG_B_REG, 1) == 0)) {
+            xil_printf("AD9695 software reset success (%d us).\r\n", waited);
+            return 0;
+        }
+    } while (waited < timeout_us);
+
+    bstats_inc(BSTAT_AD9695_RESET_FAIL);
+    xil_printf("FAILURE: AD9695 software reset failed! Reset bits did not self clear.\r\n");
+    return 1;
+}
+
 void ad9695_adc_set_channel_select(uint8_t ch)
 {
     uint8_t temp_reg;
-    ad9695_write_register(&spi_inst, AD9695_CH_INDEX_REG, ch + 1);
-    ad9695_read_register(&spi_inst, AD9695_CH_INDEX_REG, &temp_reg);
+    ad9695_reg_write(AD9695_CH_INDEX_REG, ch + 1);
+    ad9695_reg_read(AD9695_CH_INDEX_REG, &temp_reg);
     xil_printf("CH IDX REG: %0x\r\n", temp_reg);
 }
 
 void ad9695_adc_get_channel_select(uint8_t *ch)
 {
-    ad9695_read_register(&spi_inst, AD9695_CH_INDEX_REG, ch);
+    ad9695_reg_read(AD9695_CH_INDEX_REG, ch);
 }
 
 void ad9695_set_pdn_pin_mode(uint8_t pin_en, uint8_t pin_mode)
 {
     uint8_t tmp_reg;
     if (pin_en == 0)
-        ad9695_write_register(&spi_inst, AD9695_CHIP_PIN_CTRL0_REG, SET_BIT(7));
+        ad9695_reg_write(AD9695_CHIP_PIN_CTRL0_REG, SET_BIT(7));
     else
-        ad9695_write_register(&spi_inst, AD9695_CHIP_PIN_CTRL0_REG, 0x0);
+        ad9695_reg_write(AD9695_CHIP_PIN_CTRL0_REG, 0x0);
 
-    ad9695_read_register(&spi_inst, AD9695_CHIP_PIN_CTRL1_REG, &tmp_reg);
+    ad9695_reg_read(AD9695_CHIP_PIN_CTRL1_REG, &tmp_reg);
     tmp_reg |= 0b00111111;
-    ad9695_write_register(&spi_inst, AD9695_CHIP_PIN_CTRL1_REG, (pin_mode << 6) | tmp_reg);
+    ad9695_reg_write(AD9695_CHIP_PIN_CTRL1_REG, (pin_mode << 6) | tmp_reg);
 }
 
 void ad9695_set_input_clk_cfg(uint8_t div)
 {
-    ad9695_write_register(&spi_inst, AD9695_IP_CLK_CFG_REG, 0b00000011 & (div - 1));
+    ad9695_reg_write(AD9695_IP_CLK_CFG_REG, 0b00000011 & (div - 1));
 }
 
 void ad9695_adc_set_ch_pdn_mode(uint8_t mode)
 {
-    ad9695_write_register(&spi_inst, AD9695_DEV_CFG_REG, 0b00000011 & mode);
+    ad9695_reg_write(AD9695_DEV_CFG_REG, 0b00000011 & mode);
 }
 
 /* ------------------------------------------------------------------------- */
@@ -102,23 +164,72 @@ void ad9695_adc_set_ch_pdn_mode(uint8_t mode)
 void ad9695_adc_set_clk_phase(uint8_t ch, uint8_t phase_adj)
 {
     ad9695_adc_set_channel_select(ch);
-    ad9695_write_register(&spi_inst, AD9695_IP_CLK_PHASE_ADJ_REG, phase_adj);
+    ad9695_reg_write(AD9695_IP_CLK_PHASE_ADJ_REG, phase_adj);
     ad9695_adc_set_channel_select(2); /* Restore default broadcast */
 }
 
 void ad9695_adc_set_dc_offset_filt_en(uint8_t en)
 {
-    ad9695_write_register(&spi_inst, AD9695_DC_OFFSET_CAL_CTRL, en << 7);
+    ad9695_reg_write(AD9695_DC_OFFSET_CAL_CTRL, en << 7);
 }
 
 void ad9695_adc_set_fc_ch_mode(uint8_t fc_ch)
 {
-    ad9695_write_register(&spi_inst, AD9695_ADC_MODE_REG, fc_ch);
+    ad9695_reg_write(AD9695_ADC_MODE_REG, fc_ch);
+}
+
+/*
+ * Route the ADC through num_ddc DDCs (0 = full bandwidth, 1, 2 or 4) at
+ * zero IF with an overall decimation of dcm (2/4/8/16), complex or real
+ * output. DDCs take channel A for the first half and channel B for the
+ * second half (a single DDC takes channel A).
+ */
+int ad9695_adc_set_ddc(uint8_t num_ddc, uint8_t dcm, uint8_t complex_out)
+{
+    static const uint8_t cplx_sel[] = { AD9695_DDCX_CPLX_DCM2, AD9695_DDCX_CPLX_DCM4,
+                                        AD9695_DDCX_CPLX_DCM8, AD9695_DDCX_CPLX_DCM16 };
+    static const uint8_t real_sel[] = { AD9695_DDCX_REAL_DCM2, AD9695_DDCX_REAL_DCM4,
+                                        AD9695_DDCX_REAL_DCM8, AD9695_DDCX_REAL_DCM16 };
+    uint8_t mode, dcm_log2 = 0, sel, chb;
+
+    if (num_ddc == 0) {
+        ad9695_reg_write(AD9695_ADC_MODE_REG, AD9695_ADC_MODE_FULL_BW);
+        ad9695_reg_write(AD9695_ADC_DCM_REG, AD9695_DCM_NONE);
+        return 0;
+    }
+
+    while ((1U << dcm_log2) < dcm) dcm_log2++;
+    if ((1U << dcm_log2) != dcm || dcm_log2 < 1 || dcm_log2 > 4) {
+        xil_printf("ERROR: DDC decimation %d not supported!\r\n", dcm);
+        return 1;
+    }
+    switch (num_ddc) {
+    case 1: mode = AD9695_ADC_MODE_ONE_DDC;  break;
+    case 2: mode = AD9695_ADC_MODE_TWO_DDC;  break;
+    case 4: mode = AD9695_ADC_MODE_FOUR_DDC; break;
+    default:
+        xil_printf("ERROR: %d DDCs not supported!\r\n", num_ddc);
+        return 1;
+    }
+
+    sel = complex_out ? cplx_sel[dcm_log2 - 1] : real_sel[dcm_log2 - 1];
+    for (uint8_t ddc = 0; ddc < num_ddc; ddc++) {
+        uint16_t base = ddc * AD9695_DDCX_REG_OFFSET;
+        chb = (num_ddc > 1 && ddc >= num_ddc / 2) ? (AD9695_DDCX_I_IP_CHB_SEL | AD9695_DDCX_Q_IP_CHB_SEL) : 0;
+        ad9695_reg_write(AD9695_DDCX_CTRL0_REG + base,
+                         AD9695_DDCX_NCO_IF_MODE(AD9695_DDCX_NCO_ZIF) |
+                         (complex_out ? 0 : AD9695_DDCX_COMPLEX_TO_REAL) |
+                         AD9695_DDCX_DCM_FILT_SEL_0(sel));
+        ad9695_reg_write(AD9695_DDCX_DATA_SEL_REG + base, chb);
+    }
+    ad9695_reg_write(AD9695_ADC_MODE_REG, AD9695_ADC_MODE(mode) | (complex_out ? 0 : AD9695_ADC_Q_IGNORE));
+    ad9695_reg_write(AD9695_ADC_DCM_REG, AD9695_ADC_DCM_RATE(dcm_log2));
+    return 0;
 }
 
 void ad9695_adc_delay_mode(uint8_t mode)
 {
-    ad9695_write_register(&spi_inst, AD9695_CLK_DELAY_CTRL_REG, mode);
+    ad9695_reg_write(AD9695_CLK_DELAY_CTRL_REG, mode);
 }
 
 void ad9695_adc_fine_delay(uint8_t fine_delay)
@@ -126,7 +237,7 @@ void ad9695_adc_fine_delay(uint8_t fine_delay)
     if (fine_delay > 0xC0) {
         xil_printf("ERROR: Fine delay cannot exceed 0xC0!\r\n");
     }
-    ad9695_write_register(&spi_inst, AD9695_CLK_FINE_DELAY_REG, fine_delay);
+    ad9695_reg_write(AD9695_CLK_FINE_DELAY_REG, fine_delay);
 }
 // New function 
 void ad9695_adc_super_fine_delay(uint8_t super_fine_delay)
@@ -134,7 +245,7 @@ void ad9695_adc_super_fine_delay(uint8_t super_fine_delay)
     if (super_fine_delay > 0x80) {
         xil_printf("ERROR: Super fine delay cannot exceed 0x80!\r\n");
     }
-    ad9695_write_register(&spi_inst, AD9695_CLK_FINE_DELAY_REG, super_fine_delay);
+    ad9695_reg_write(AD9695_CLK_SUPER_FINE_DELAY_REG, super_fine_delay);
 }
 
 /* ------------------------------------------------------------------------- */
@@ -166,19 +277,19 @@ typedef struct {
 
 static void jesd_init_sequence(void)
 {
-    ad9695_write_register(&spi_inst, 0x1228, 0x4F);
+    ad9695_reg_write(0x1228, 0x4F);
     usleep(10);
-    ad9695_write_register(&spi_inst, 0x1228, 0x0F);
+    ad9695_reg_write(0x1228, 0x0F);
     usleep(10);
-    ad9695_write_register(&spi_inst, 0x1222, 0x00);
+    ad9695_reg_write(0x1222, 0x00);
     usleep(10);
-    ad9695_write_register(&spi_inst, 0x1222, 0x04);
+    ad9695_reg_write(0x1222, 0x04);
     usleep(10);
-    ad9695_write_register(&spi_inst, 0x1222, 0x00);
+    ad9695_reg_write(0x1222, 0x00);
     usleep(10);
-    ad9695_write_register(&spi_inst, 0x1262, 0x08);
+    ad9695_reg_write(0x1262, 0x08);
     usleep(10);
-    ad9695_write_register(&spi_inst, 0x1262, 0x00);
+    ad9695_reg_write(0x1262, 0x00);
 }
 
 static int check_jesd_params_range(struct jesd_param_t jesd_param)
@@ -225,8 +336,6 @@ void ad9695_jesd_set_if_config(struct jesd_param_t jesd_param,
                                uint64_t sample_clk_freq_khz,
                                uint64_t *lane_rate_kbps)
 {
-    uint8_t tmp_reg;
-
     if (!check_jesd_params_range(jesd_param)) {
         xil_printf("ERROR: JESD parameters out of range!\r\n");
         return;
@@ -239,17 +348,17 @@ void ad9695_jesd_set_if_config(struct jesd_param_t jesd_param,
     xil_printf("INFO: Calculated Lane rate is %lld kbps.\r\n", *lane_rate_kbps);
 
     /* Configure SERDES PLL according to lane‑rate */
-    if (*lane_rate_kbps > 16000000ULL) {
+    if (*lane_rate_kbps > AD9695_LANE_RATE_MAX_KBPS) {
         xil_printf("ERROR: Lane rate is too high!\r\n");
         return;
     } else if (*lane_rate_kbps > 13500000ULL) {
-        ad9695_write_register(&spi_inst, AD9695_JESD_SERDES_PLL_CFG_REG, 0b0011 << 4);
+        ad9695_reg_write(AD9695_JESD_SERDES_PLL_CFG_REG, 0b0011 << 4);
     } else if (*lane_rate_kbps > 6750000ULL) {
-        ad9695_write_register(&spi_inst, AD9695_JESD_SERDES_PLL_CFG_REG, 0b0000 << 4);
+        ad9695_reg_write(AD9695_JESD_SERDES_PLL_CFG_REG, 0b0000 << 4);
     } else if (*lane_rate_kbps > 3375000ULL) {
-        ad9695_write_register(&spi_inst, AD9695_JESD_SERDES_PLL_CFG_REG, 0b0001 << 4);
-    } else if (*lane_rate_kbps > 1687500ULL) {
-        ad9695_write_register(&spi_inst, AD9695_JESD_SERDES_PLL_CFG_REG, 0b0101 << 4);
+        ad9695_reg_write(AD9695_JESD_SERDES_PLL_CFG_REG, 0b0001 << 4);
+    } else if (*lane_rate_kbps > AD9695_LANE_RATE_MIN_KBPS) {
+        ad9695_reg_write(AD9695_JESD_SERDES_PLL_CFG_REG, 0b0101 << 4);
     } else {
         xil_printf("ERROR: Lane rate is too low!\r\n");
         return;
@@ -257,35 +366,30 @@ void ad9695_jesd_set_if_config(struct jesd_param_t jesd_param,
 
 
     /* Apply remaining JESD configuration registers */
-    tmp_reg = AD9695_JESD_M(jesd_param.jesd_M) - 1;
-    ad9695_write_register(&spi_inst, AD9695_JESD_M_CFG_REG, tmp_reg);
-
-    tmp_reg = AD9695_JESD_CS(jesd_param.jesd_CS) | (AD9695_JESD_N(jesd_param.jesd_N) - 1);
-    ad9695_write_register(&spi_inst, AD9695_JESD_CS_N_CFG_REG, tmp_reg);
-
-    ad9695_read_register(&spi_inst, AD9695_JESD_SCV_NP_CFG_REG, &tmp_reg);
-    tmp_reg |= (AD9695_JESD_NP(jesd_param.jesd_NP) - 1);
-    ad9695_write_register(&spi_inst, AD9695_JESD_SCV_NP_CFG_REG, tmp_reg);
-
-    tmp_reg = AD9695_JESD_F(jesd_param.jesd_F) - 1;
-    ad9695_write_register(&spi_inst, AD9695_JESD_F_CFG_REG, tmp_reg);
-    tmp_reg = AD9695_JESD_K(jesd_param.jesd_K) - 1;
-    ad9695_write_register(&spi_inst, AD9695_JESD_K_CFG_REG, tmp_reg);
-
-    ad9695_read_register(&spi_inst, AD9695_JESD_L_SCR_CFG_REG, &tmp_reg);
-    tmp_reg |= (AD9695_JESD_LANES(jesd_param.jesd_L) - 1);
-    ad9695_write_register(&spi_inst, AD9695_JESD_L_SCR_CFG_REG, tmp_reg);
+    /* L/SCR .. SCV/NP (0x058B..0x0590) are contiguous: one streamed
+     * read-modify-write instead of eight single-register transfers
+     * (served from the shadow when it is already populated). */
+    uint8_t cfg[AD9695_JESD_SCV_NP_CFG_REG - AD9695_JESD_L_SCR_CFG_REG + 1];
+    ad9695_reg_read_block(AD9695_JESD_L_SCR_CFG_REG, cfg, sizeof(cfg));
+
+    cfg[AD9695_JESD_L_SCR_CFG_REG  - AD9695_JESD_L_SCR_CFG_REG] &= ~AD9695_JESD_LANES(0xFF);
+    cfg[AD9695_JESD_L_SCR_CFG_REG  - AD9695_JESD_L_SCR_CFG_REG] |= (AD9695_JESD_LANES(jesd_param.jesd_L) - 1);
+    cfg[AD9695_JESD_F_CFG_REG      - AD9695_JESD_L_SCR_CFG_REG]  = AD9695_JESD_F(jesd_param.jesd_F) - 1;
+    cfg[AD9695_JESD_K_CFG_REG      - AD9695_JESD_L_SCR_CFG_REG]  = AD9695_JESD_K(jesd_param.jesd_K) - 1;
+    cfg[AD9695_JESD_M_CFG_REG      - AD9695_JESD_L_SCR_CFG_REG]  = AD9695_JESD_M(jesd_param.jesd_M) - 1;
+    cfg[AD9695_JESD_CS_N_CFG_REG   - AD9695_JESD_L_SCR_CFG_REG]  = AD9695_JESD_CS(jesd_param.jesd_CS) | (AD9695_JESD_N(jesd_param.jesd_N) - 1);
+    cfg[AD9695_JESD_SCV_NP_CFG_REG - AD9695_JESD_L_SCR_CFG_REG] &= ~AD9695_JESD_NP(0xFF);
+    cfg[AD9695_JESD_SCV_NP_CFG_REG - AD9695_JESD_L_SCR_CFG_REG] |= (AD9695_JESD_NP(jesd_param.jesd_NP) - 1);
+
+    ad9695_reg_write_block(AD9695_JESD_L_SCR_CFG_REG, cfg, sizeof(cfg));
 }
 
 void ad9695_jesd_get_cfg_param(struct jesd_param_t *jesd_param)
 {
-    int i;
     uint8_t tmp_reg[AD9695_JESD_CFG_REG_OFFSET];
 
     /* Bulk‑read JESD configuration block */
-    for (i = 0; i < AD9695_JESD_CFG_REG_OFFSET; ++i) {
-        ad9695_read_register(&spi_inst, AD9695_JESD_L_SCR_CFG_REG + i, &tmp_reg[i]);
-    }
+    ad9695_reg_read_block(AD9695_JESD_L_SCR_CFG_REG, tmp_reg, AD9695_JESD_CFG_REG_OFFSET);
 
     jesd_param->jesd_L  = AD9695_JESD_LANES(tmp_reg[0]) + 1;
     jesd_param->jesd_F  = AD9695_JESD_F    (tmp_reg[1]) + 1;
@@ -299,9 +403,7 @@ void ad9695_jesd_get_cfg_param(struct jesd_param_t *jesd_param)
     jesd_param->jesd_HD = (tmp_reg[6] & AD9695_JESD_HD) ? 1 : 0;
     jesd_param->jesd_CF = AD9695_JESD_CF(tmp_reg[6]);
 
-    for (i = 0; i < AD9695_JESD_ID_CFG_REG_OFFSET; ++i) {
-        ad9695_read_register(&spi_inst, AD9695_JESD_DID_CFG_REG + i, &tmp_reg[i]);
-    }
+    ad9695_reg_read_block(AD9695_JESD_DID_CFG_REG, tmp_reg, AD9695_JESD_ID_CFG_REG_OFFSET);
     jesd_param->jesd_DID  = tmp_reg[0];
     jesd_param->jesd_BID  = AD9695_JESD_BID(tmp_reg[1]);
     jesd_param->jesd_LID0 = AD9695_JESD_LID0(tmp_reg[2]);
@@ -310,15 +412,15 @@ void ad9695_jesd_get_cfg_param(struct jesd_param_t *jesd_param)
 void ad9695_jesd_enable_link(uint8_t en)
 {
     uint8_t tmp_reg;
-    ad9695_read_register(&spi_inst, AD9695_JESD_LINK_CTRL1_REG, &tmp_reg);
+    ad9695_reg_read(AD9695_JESD_LINK_CTRL1_REG, &tmp_reg);
     xil_printf("Enabling JESD: first read 0x571 = 0x%x.\r\n", tmp_reg);
 
     tmp_reg |= AD9695_JESD_LINK_PDN;
-    ad9695_write_register(&spi_inst, AD9695_JESD_LINK_CTRL1_REG, tmp_reg);
+    ad9695_reg_write(AD9695_JESD_LINK_CTRL1_REG, tmp_reg);
     xil_printf("Enabling JESD: second write 0x571 = 0x%x.\r\n", tmp_reg);
 
     tmp_reg = (en) ? 0x14 : tmp_reg;
-    ad9695_write_register(&spi_inst, AD9695_JESD_LINK_CTRL1_REG, tmp_reg);
+    ad9695_reg_write(AD9695_JESD_LINK_CTRL1_REG, tmp_reg);
     xil_printf("Enabling JESD: third write 0x571 = 0x%x.\r\n", tmp_reg);
 
     if (en) {
@@ -330,38 +432,58 @@ void ad9695_jesd_enable_link(uint8_t en)
 void ad9695_jesd_enable_scrambler(uint8_t en)
 {
     uint8_t tmp_reg;
-    ad9695_read_register(&spi_inst, AD9695_JESD_L_SCR_CFG_REG, &tmp_reg);
+    ad9695_reg_read(AD9695_JESD_L_SCR_CFG_REG, &tmp_reg);
     tmp_reg &= ~AD9695_JESD_SCR_EN;
     tmp_reg |= en ? AD9695_JESD_SCR_EN : 0;
-    ad9695_write_register(&spi_inst, AD9695_JESD_L_SCR_CFG_REG, tmp_reg);
+    ad9695_reg_write(AD9695_JESD_L_SCR_CFG_REG, tmp_reg);
 }
 
 void ad9695_jesd_get_pll_status(uint8_t *pll_status)
 {
-    ad9695_read_register(&spi_inst, AD9695_JESD_SERDES_PLL_REG, pll_status);
+    ad9695_reg_read(AD9695_JESD_SERDES_PLL_REG, pll_status);
+}
+
+int ad9695_jesd_wait_pll_lock(uint32_t timeout_us)
+{
+    uint8_t pll_stat;
+    uint32_t waited = 0;
+
+    do {
+        ad9695_jesd_get_pll_status(&pll_stat);
+        if (pll_stat & AD9695_JESD_PLL_LOCK_STAT) {
+            xil_printf("ad9695 PLL LOCKED (%d us)\r\n", waited);
+            return 0;
+        }
+        usleep(AD9695_POLL_STEP_US);
+        waited += AD9695_POLL_STEP_US;
+    } while (waited < timeout_us);
+
+    bstats_inc(BSTAT_AD9695_PLL_UNLOCK);
+    xil_printf("ad9695 PLL UNLOCKED\r\n");
+    return 1;
 }
 
 void ad9695_jesd_subclass_set(uint8_t subclass)
 {
     uint8_t tmp_reg;
-    ad9695_read_register(&spi_inst, AD9695_JESD_SCV_NP_CFG_REG, &tmp_reg);
+    ad9695_reg_read(AD9695_JESD_SCV_NP_CFG_REG, &tmp_reg);
     tmp_reg &= ~AD9695_JESD_SUBCLASS(-1);
     tmp_reg |= AD9695_JESD_SUBCLASS(subclass);
-    ad9695_write_register(&spi_inst, AD9695_JESD_SCV_NP_CFG_REG, tmp_reg);
+    ad9695_reg_write(AD9695_JESD_SCV_NP_CFG_REG, tmp_reg);
 }
 
 void ad9695_jesd_syref_mode_set(uint8_t mode, uint8_t sysref_count)
 {
     uint8_t tmp_reg;
 
-    ad9695_read_register(&spi_inst, AD9695_SYSREF_CTRL_0_REG, &tmp_reg);
+    ad9695_reg_read(AD9695_SYSREF_CTRL_0_REG, &tmp_reg);
     tmp_reg &= ~AD9695_SYSREF_MODE_SEL(-1);
     tmp_reg |= AD9695_SYSREF_MODE_SEL(mode);
-    ad9695_write_register(&spi_inst, AD9695_SYSREF_CTRL_0_REG, tmp_reg);
+    ad9695_reg_write(AD9695_SYSREF_CTRL_0_REG, tmp_reg);
 
-    ad9695_read_register(&spi_inst, AD9695_SYSREF_CTRL_1_REG, &tmp_reg);
+    ad9695_reg_read(AD9695_SYSREF_CTRL_1_REG, &tmp_reg);
     tmp_reg &= ~AD9695_SYSREF_NSHOT_IGNORE(-1);
     tmp_reg |= (mode == 0b10) ? AD9695_SYSREF_NSHOT_IGNORE(sysref_count)
                               : AD9695_SYSREF_NSHOT_IGNORE(0x0);
-    ad9695_write_register(&spi_inst, AD9695_SYSREF_CTRL_1_REG, tmp_reg);
+    ad9695_reg_write(AD9695_SYSREF_CTRL_1_REG, tmp_reg);
 }
@@ -95,6 +95,10 @@ void ad9695_init(void);
 void ad9695_hardware_reset(void);
 void ad9695_software_reset(void);
 
+/* Bounded-poll variants for fast bring-up. Return 0 on success, 1 on timeout */
+int  ad9695_hardware_reset_poll(uint32_t timeout_us);
+int  ad9695_software_reset_poll(uint32_t timeout_us);
+
 /* Channel‑selection helpers */
 void ad9695_adc_set_channel_select(uint8_t ch);
 void ad9695_adc_get_channel_select(uint8_t *ch);
@@ -114,6 +118,7 @@ void ad9695_adc_set_ch_pdn_mode(uint8_t mode);
 void ad9695_adc_set_clk_phase(uint8_t ch, uint8_t phase_adj);
 void ad9695_adc_set_dc_offset_filt_en(uint8_t en);
 void ad9695_adc_set_fc_ch_mode(uint8_t fc_ch);
+int  ad9695_adc_set_ddc(uint8_t num_ddc, uint8_t dcm, uint8_t complex_out);
 void ad9695_adc_delay_mode(uint8_t mode);
 void ad9695_adc_fine_delay(uint8_t fine_delay);
 void ad9695_adc_super_fine_delay(uint8_t super_fine_delay);
@@ -123,6 +128,10 @@ void ad9695_adc_super_fine_delay(uint8_t super_fine_delay);
  * ===========================================================*/
 struct jesd_param_t;    /* Forward‑declared from ad9695_api_def.h */
 
+/* SERDES lane rate limits */
+#define AD9695_LANE_RATE_MIN_KBPS   1687500ULL
+#define AD9695_LANE_RATE_MAX_KBPS   16000000ULL
+
 void ad9695_jesd_set_if_config(struct jesd_param_t jesd_param,
                                uint64_t sample_clk_freq_khz,
                                uint64_t *lane_rate_kbps);
@@ -130,6 +139,7 @@ void ad9695_jesd_get_cfg_param(struct jesd_param_t *jesd_param);
 void ad9695_jesd_enable_link(uint8_t en);
 void ad9695_jesd_enable_scrambler(uint8_t en);
 void ad9695_jesd_get_pll_status(uint8_t *pll_status);
+int  ad9695_jesd_wait_pll_lock(uint32_t timeout_us);
 void ad9695_jesd_subclass_set(uint8_t subclass);
 void ad9695_jesd_syref_mode_set(uint8_t mode, uint8_t sysref_count);
 
@@ -0,0 +1,489 @@
+#include "ad9695_regcache.h"
+#include <string.h>
+#include "ad9695_registers.h"
+#include "peripherals.h"
+#include "bstats.h"
+#include "xspips.h"
+#include "xil_printf.h"
+
+extern XSpiPs spi_inst;
+
+#if AD9695_REGCACHE_ENABLE
+
+/* Page 0 holds global registers, pages 1/2 the channel A/B copies of local
+ * ones.  The page numbers match the CH_INDEX bits, so a CH_INDEX value is
+ * also the set of pages a local access touches. */
+#define REGC_PAGE_GLOBAL    0
+#define REGC_PAGE_A         1
+#define REGC_PAGE_B         2
+#define REGC_CH_BOTH        (REGC_PAGE_A | REGC_PAGE_B)
+#define REGC_NUM_PAGES      3
+
+#define REGC_VALID          0x01
+#define REGC_DIRTY          0x02
+
+struct regc_range {
+    uint16_t lo, hi;
+};
+
+/* Local (CH_INDEX paged) registers */
+static const struct regc_range local_regs[] = {
+    { AD9695_DEV_CFG_REG,           AD9695_DEV_CFG_REG           },
+    { AD9695_IP_CLK_PHASE_ADJ_REG,  AD9695_IP_CLK_PHASE_ADJ_REG  },
+    { AD9695_CLK_DELAY_CTRL_REG,    AD9695_CLK_FINE_DELAY_REG    },
+    { 0x0245,                       AD9695_FD_DWELL_MSB_REG      },
+    { AD9695_TEST_MODE_REG,         AD9695_TEST_MODE_REG         },
+    { AD9695_OUTPUT_MODE_REG,       AD9695_OUTPUT_MODE_REG       },
+    { AD9695_DC_OFFSET_CAL_CTRL,    AD9695_DC_OFFSET_CAL_CTRL    },
+    { AD9695_VREF_CTRL_REG,         AD9695_BUFF_CFG_N_REG        },
+};
+
+/* Never cached: self-clearing, status, strobe and action registers */
+static const struct regc_range volatile_regs[] = {
+    { AD9695_IF_CFG_A_REG,          AD9695_IF_CFG_B_REG          },
+    { AD9695_CHIP_SPI_XFER_REG,     AD9695_CHIP_SPI_XFER_REG     },
+    { AD9695_IP_CLK_STAT_REG,       AD9695_IP_CLK_STAT_REG       },
+    { AD9695_SYSREF_STAT_0_REG,     AD9695_SYSREF_STAT_2_REG     },
+    { AD9695_OP_OVERANGE_CLR_REG,   AD9695_OP_OVERANGE_STAT_REG  },
+    { AD9695_JESD_SERDES_PLL_REG,   AD9695_JESD_SERDES_PLL_REG   },
+    { AD9695_JESD_LINK_CTRL1_REG,   AD9695_JESD_LINK_CTRL1_REG   },  /* power-down toggles must all reach the chip */
+    { 0x1222,                       0x1222                       },  /* JESD init sequence strobes */
+    { 0x1228,                       0x1228                       },
+    { 0x1262,                       0x1262                       },
+};
+
+static uint8_t  regc_val [REGC_NUM_PAGES][AD9695_REGC_SIZE];
+static uint8_t  regc_flag[REGC_NUM_PAGES][AD9695_REGC_SIZE];
+static uint16_t regc_dirty_lo[REGC_NUM_PAGES], regc_dirty_hi[REGC_NUM_PAGES];
+static uint8_t  regc_pending;       /* any dirty entry              */
+static uint8_t  regc_batch;         /* batch nesting depth          */
+static uint8_t  regc_verify_en;     /* read back every flushed run  */
+
+static uint8_t  regc_ch;            /* CH_INDEX as the code sees it */
+static uint8_t  regc_hw_ch;         /* CH_INDEX as the chip has it  */
+static uint8_t  regc_ch_valid;
+
+static int in_ranges(const struct regc_range *r, uint32_t n, uint16_t addr)
+{
+    for (uint32_t i = 0; i < n; i++) {
+        if (addr >= r[i].lo && addr <= r[i].hi) return 1;
+    }
+    return 0;
+}
+
+#define IS_LOCAL(a)     in_ranges(local_regs, sizeof(local_regs) / sizeof(local_regs[0]), (a))
+#define IS_VOLATILE(a)  in_ranges(volatile_regs, sizeof(volatile_regs) / sizeof(volatile_regs[0]), (a))
+
+static int regc_cacheable(uint16_t addr)
+{
+    return (addr < AD9695_REGC_SIZE) && (addr != AD9695_CH_INDEX_REG) && !IS_VOLATILE(addr);
+}
+
+static void regc_load_ch(void)
+{
+    if (regc_ch_valid) return;
+    ad9695_read_register(&spi_inst, AD9695_CH_INDEX_REG, &regc_hw_ch);
+    regc_hw_ch &= REGC_CH_BOTH;
+    regc_ch = regc_hw_ch;
+    regc_ch_valid = 1;
+}
+
+static void regc_select_hw(uint8_t ch)
+{
+    if (regc_hw_ch == ch) return;
+    ad9695_write_register(&spi_inst, AD9695_CH_INDEX_REG, ch);
+    regc_hw_ch = ch;
+}
+
+/* Pages an access to addr touches under the current CH_INDEX (bit mask) */
+static uint8_t regc_pages(uint16_t addr)
+{
+    if (!IS_LOCAL(addr)) return 1U << REGC_PAGE_GLOBAL;
+    regc_load_ch();
+    return (uint8_t)(regc_ch << 1);     /* CH_INDEX bit n -> page n */
+}
+
+static void regc_mark_dirty(uint8_t page, uint16_t addr)
+{
+    regc_flag[page][addr] |= REGC_DIRTY;
+    if (addr < regc_dirty_lo[page]) regc_dirty_lo[page] = addr;
+    if (addr > regc_dirty_hi[page]) regc_dirty_hi[page] = addr;
+    regc_pending = 1;
+}
+
+static void regc_clear_dirty_ranges(void)
+{
+    for (int p = 0; p < REGC_NUM_PAGES; p++) {
+        regc_dirty_lo[p] = 0xFFFF;
+        regc_dirty_hi[p] = 0;
+    }
+    regc_pending = 0;
+}
+
+/* Bring the chip up to date before an access the shadow cannot serve */
+static void regc_sync(void)
+{
+    if (regc_pending) ad9695_regcache_flush();
+}
+
+/* -------------------------------------------------------------------------------- */
+/*  Single register access                                                           */
+/* -------------------------------------------------------------------------------- */
+void ad9695_reg_read(uint16_t addr, uint8_t *data)
+{
+    if (addr == AD9695_CH_INDEX_REG) {
+        regc_load_ch();
+        *data = regc_ch;
+        bstats_inc(BSTAT_REGC_HITS);
+        return;
+    }
+    if (!regc_cacheable(addr)) {
+        regc_sync();
+        ad9695_read_register(&spi_inst, addr, data);
+        return;
+    }
+
+    uint8_t pages = regc_pages(addr);
+    if (pages == 0) {                   /* no channel selected: let the chip answer */
+        regc_sync();
+        ad9695_read_register(&spi_inst, addr, data);
+        return;
+    }
+    uint8_t page = (pages & (1U << REGC_PAGE_GLOBAL)) ? REGC_PAGE_GLOBAL :
+                   (pages & (1U << REGC_PAGE_A))      ? REGC_PAGE_A : REGC_PAGE_B;
+
+    if (regc_flag[page][addr] & REGC_VALID) {
+        *data = regc_val[page][addr];
+        bstats_inc(BSTAT_REGC_HITS);
+        return;
+    }
+
+    /* With both channels selected the chip reads back channel A */
+    regc_sync();
+    if (page != REGC_PAGE_GLOBAL) regc_select_hw(regc_ch);
+    ad9695_read_register(&spi_inst, addr, data);
+    regc_val[page][addr] = *data;
+    regc_flag[page][addr] |= REGC_VALID;
+    bstats_inc(BSTAT_REGC_MISSES);
+}
+
+void ad9695_reg_write(uint16_t addr, uint8_t value)
+{
+    if (addr == AD9695_CH_INDEX_REG) {
+        regc_load_ch();
+        regc_ch = value & REGC_CH_BOTH;
+        if (regc_batch == 0) {
+            if (regc_hw_ch == regc_ch) bstats_inc(BSTAT_REGC_SKIPPED);
+            regc_select_hw(regc_ch);
+        }
+        return;
+    }
+    if (!regc_cacheable(addr)) {
+        regc_sync();
+        ad9695_write_register(&spi_inst, addr, value);
+        /* Soft reset returns every register to its default */
+        if (addr == AD9695_IF_CFG_A_REG && (value & (SET_BIT(0) | SET_BIT(7)))) {
+            ad9695_regcache_invalidate();
+        }
+        return;
+    }
+
+    uint8_t pages = regc_pages(addr), changed = 0;
+    if (pages == 0) {
+        regc_sync();
+        ad9695_write_register(&spi_inst, addr, value);
+        return;
+    }
+    for (uint8_t p = 0; p < REGC_NUM_PAGES; p++) {
+        if (!(pages & (1U << p))) continue;
+        if (!(regc_flag[p][addr] & REGC_VALID) || regc_val[p][addr] != value) changed = 1;
+    }
+    if (!changed) {
+        bstats_inc(BSTAT_REGC_SKIPPED);
+        return;
+    }
+
+    for (uint8_t p = 0; p < REGC_NUM_PAGES; p++) {
+        if (!(pages & (1U << p))) continue;
+        regc_val[p][addr] = value;
+        regc_flag[p][addr] |= REGC_VALID;
+        if (regc_batch) regc_mark_dirty(p, addr);
+    }
+    if (regc_batch) return;
+
+    if (!(pages & (1U << REGC_PAGE_GLOBAL))) regc_select_hw(regc_ch);
+    ad9695_write_register(&spi_inst, addr, value);
+}
+
+/* -------------------------------------------------------------------------------- */
+/*  Block access: global, cacheable runs go through the streamed SPI accessors;     */
+/*  anything else falls back to register-by-register access.                         */
+/* -------------------------------------------------------------------------------- */
+static int regc_global_run(uint16_t start_addr, uint16_t count)
+{
+    if (count == 0 || count > AD9695_SPI_STREAM_MAX) return 0;
+    for (uint16_t i = 0; i < count; i++) {
+        uint16_t a = start_addr + i;
+        if (!regc_cacheable(a) || IS_LOCAL(a)) return 0;
+    }
+    return 1;
+}
+
+void ad9695_reg_read_block(uint16_t start_addr, uint8_t *data, uint16_t count)
+{
+    uint16_t i;
+
+    if (!regc_global_run(start_addr, count)) {
+        for (i = 0; i < count; i++) ad9695_reg_read(start_addr + i, &data[i]);
+        return;
+    }
+    for (i = 0; i < count; i++) {
+        if (!(regc_flag[REGC_PAGE_GLOBAL][start_addr + i] & REGC_VALID)) break;
+    }
+    if (i == count) {
+        memcpy(data, &regc_val[REGC_PAGE_GLOBAL][start_addr], count);
+        bstats_add(BSTAT_REGC_HITS, count);
+        return;
+    }
+
+    regc_sync();
+    ad9695_read_registers(&spi_inst, start_addr, data, count);
+    memcpy(&regc_val[REGC_PAGE_GLOBAL][start_addr], data, count);
+    for (i = 0; i < count; i++) regc_flag[REGC_PAGE_GLOBAL][start_addr + i] |= REGC_VALID;
+    bstats_add(BSTAT_REGC_MISSES, count);
+}
+
+void ad9695_reg_write_block(uint16_t start_addr, const uint8_t *data, uint16_t count)
+{
+    int first = -1, last = -1;
+
+    if (!regc_global_run(start_addr, count)) {
+        for (uint16_t i = 0; i < count; i++) ad9695_reg_write(start_addr + i, data[i]);
+        return;
+    }
+
+    for (uint16_t i = 0; i < count; i++) {
+        uint16_t a = start_addr + i;
+        if ((regc_flag[REGC_PAGE_GLOBAL][a] & REGC_VALID) && regc_val[REGC_PAGE_GLOBAL][a] == data[i]) {
+            bstats_inc(BSTAT_REGC_SKIPPED);
+            continue;
+        }
+        if (first < 0) first = i;
+        last = i;
+        regc_val[REGC_PAGE_GLOBAL][a] = data[i];
+        regc_flag[REGC_PAGE_GLOBAL][a] |= REGC_VALID;
+        if (regc_batch) regc_mark_dirty(REGC_PAGE_GLOBAL, a);
+    }
+    if (first < 0 || regc_batch) return;
+
+    /* Only the span that actually changed goes out */
+    if (first == last) {
+        ad9695_write_register(&spi_inst, start_addr + first, data[first]);
+    } else {
+        ad9695_write_registers(&spi_inst, start_addr + first, &data[first], last - first + 1);
+    }
+}
+
+/* -------------------------------------------------------------------------------- */
+/*  Batching and flush                                                               */
+/* -------------------------------------------------------------------------------- */
+void ad9695_regcache_batch_begin(void)
+{
+    regc_batch++;
+}
+
+int ad9695_regcache_batch_commit(void)
+{
+    if (regc_batch == 0) return 0;
+    if (--regc_batch) return 0;
+    return ad9695_regcache_flush();
+}
+
+/* Flush group: 0 = global page, otherwise the CH_INDEX value to write under */
+static int regc_eligible(uint8_t group, uint16_t addr)
+{
+    uint8_t da = regc_flag[REGC_PAGE_A][addr] & REGC_DIRTY;
+    uint8_t db = regc_flag[REGC_PAGE_B][addr] & REGC_DIRTY;
+
+    switch (group) {
+    case 0:            return regc_flag[REGC_PAGE_GLOBAL][addr] & REGC_DIRTY;
+    case REGC_CH_BOTH: return da && db && (regc_val[REGC_PAGE_A][addr] == regc_val[REGC_PAGE_B][addr]);
+    case REGC_PAGE_A:  return da;
+    default:           return db;
+    }
+}
+
+/* Write one run of a page and optionally read it back; returns mismatches */
+static int regc_write_run(uint8_t page, uint16_t start, uint16_t count)
+{
+    uint8_t readback[AD9695_SPI_STREAM_MAX];
+    int err = 0;
+
+    if (count == 1) {
+        ad9695_write_register(&spi_inst, start, regc_val[page][start]);
+    } else {
+        ad9695_write_registers(&spi_inst, start, &regc_val[page][start], count);
+    }
+    if (!regc_verify_en) return 0;
+
+    ad9695_read_registers(&spi_inst, start, readback, count);
+    for (uint16_t i = 0; i < count; i++) {
+        if (readback[i] != regc_val[page][start + i]) {
+            xil_printf("regcache: 0x%04X page %d wrote 0x%02X read 0x%02X\r\n",
+                       start + i, page, regc_val[page][start + i], readback[i]);
+            regc_val[page][start + i] = readback[i];
+            err++;
+        }
+    }
+    return err;
+}
+
+/* Write every dirty entry: global page first, then paged registers that are
+ * equal on both channels under broadcast, then the per-channel leftovers.
+ * Within a group runs go out in ascending address order; a streamed run is
+ * committed top-down by the chip (descending address mode). */
+int ad9695_regcache_flush(void)
+{
+    static const uint8_t group_order[] = { 0, REGC_CH_BOTH, REGC_PAGE_A, REGC_PAGE_B };
+    int err = 0;
+
+    if (!regc_pending) {
+        /* CH_INDEX writes inside a batch only moved the shadow pointer */
+        if (regc_ch_valid) regc_select_hw(regc_ch);
+        return 0;
+    }
+
+    for (uint32_t g = 0; g < sizeof(group_order); g++) {
+        uint8_t group = group_order[g];
+        uint8_t page  = (group == 0) ? REGC_PAGE_GLOBAL : (group == REGC_PAGE_B) ? REGC_PAGE_B : REGC_PAGE_A;
+        uint32_t addr = regc_dirty_lo[page], hi = regc_dirty_hi[page];
+
+        while (addr <= hi) {
+            if (!regc_eligible(group, addr)) { addr++; continue; }
+
+            uint32_t start = addr;
+            while (addr <= hi && (addr - start) < AD9695_SPI_STREAM_MAX && regc_eligible(group, addr)) addr++;
+
+            if (group) regc_select_hw(group);
+            err += regc_write_run(page, start, addr - start);
+            for (uint32_t a = start; a < addr; a++) {
+                regc_flag[page][a] &= ~REGC_DIRTY;
+                if (group == REGC_CH_BOTH) regc_flag[REGC_PAGE_B][a] &= ~REGC_DIRTY;
+            }
+        }
+    }
+    if (regc_ch_valid) regc_select_hw(regc_ch);
+    regc_clear_dirty_ranges();
+
+    if (err) bstats_add(BSTAT_REGC_VERIFY_ERR, err);
+    return err;
+}
+
+/* Read every valid shadow entry back from the chip; mismatches are reported
+ * and the shadow takes the hardware value.  Returns the mismatch count. */
+int ad9695_regcache_verify(void)
+{
+    uint8_t hw[AD9695_SPI_STREAM_MAX];
+    int err = 0;
+
+    regc_sync();
+    for (uint8_t page = 0; page < REGC_NUM_PAGES; page++) {
+        uint32_t addr = 0;
+
+        while (addr < AD9695_REGC_SIZE) {
+            if (!(regc_flag[page][addr] & REGC_VALID)) { addr++; continue; }
+
+            uint32_t start = addr;
+            while (addr < AD9695_REGC_SIZE && (addr - start) < AD9695_SPI_STREAM_MAX &&
+                   (regc_flag[page][addr] & REGC_VALID)) addr++;
+
+            if (page != REGC_PAGE_GLOBAL) regc_select_hw(page);
+            ad9695_read_registers(&spi_inst, start, hw, addr - start);
+            for (uint32_t a = start; a < addr; a++) {
+                if (hw[a - start] != regc_val[page][a]) {
+                    xil_printf("regcache: 0x%04X page %d shadow 0x%02X chip 0x%02X\r\n",
+                               a, page, regc_val[page][a], hw[a - start]);
+                    regc_val[page][a] = hw[a - start];
+                    err++;
+                }
+            }
+        }
+    }
+    if (regc_ch_valid) regc_select_hw(regc_ch);
+
+    if (err) bstats_add(BSTAT_REGC_VERIFY_ERR, err);
+    xil_printf("regcache: verify done, %d mismatch(es)\r\n", err);
+    return err;
+}
+
+/* -------------------------------------------------------------------------------- */
+/*  Maintenance                                                                      */
+/* -------------------------------------------------------------------------------- */
+void ad9695_regcache_invalidate(void)
+{
+    memset(regc_flag, 0, sizeof(regc_flag));
+    regc_clear_dirty_ranges();
+    regc_ch_valid = 0;
+}
+
+/* Drop one register from every page, e.g. after a raw console write */
+void ad9695_regcache_forget(uint16_t addr)
+{
+    if (addr == AD9695_CH_INDEX_REG) {
+        regc_sync();
+        regc_ch_valid = 0;
+        return;
+    }
+    if (addr >= AD9695_REGC_SIZE) return;
+    for (int p = 0; p < REGC_NUM_PAGES; p++) {
+        regc_flag[p][addr] &= ~REGC_VALID;
+    }
+}
+
+void ad9695_regcache_set_verify(uint8_t en)
+{
+    regc_verify_en = en;
+}
+
+void ad9695_regcache_print(void)
+{
+    uint32_t valid[REGC_NUM_PAGES] = {0}, dirty = 0;
+
+    for (int p = 0; p < REGC_NUM_PAGES; p++) {
+        for (uint32_t a = 0; a < AD9695_REGC_SIZE; a++) {
+            if (regc_flag[p][a] & REGC_VALID) valid[p]++;
+            if (regc_flag[p][a] & REGC_DIRTY) dirty++;
+        }
+    }
+    xil_printf("regcache: valid global %d / chA %d / chB %d, dirty %d, batch depth %d\r\n",
+               valid[0], valid[1], valid[2], dirty, regc_batch);
+    xil_printf("regcache: CH_INDEX %d (chip %d%s), verify-on-flush %s\r\n", regc_ch, regc_hw_ch,
+               regc_ch_valid ? "" : ", unknown", regc_verify_en ? "on" : "off");
+    xil_printf("regcache: hits %d, misses %d, skipped writes %d, verify errors %d\r\n",
+               (u32)bstats_get(BSTAT_REGC_HITS), (u32)bstats_get(BSTAT_REGC_MISSES),
+               (u32)bstats_get(BSTAT_REGC_SKIPPED), (u32)bstats_get(BSTAT_REGC_VERIFY_ERR));
+}
+
+#else /* !AD9695_REGCACHE_ENABLE */
+
+void ad9695_reg_read(uint16_t addr, uint8_t *data)    { ad9695_read_register(&spi_inst, addr, data); }
+void ad9695_reg_write(uint16_t addr, uint8_t value)   { ad9695_write_register(&spi_inst, addr, value); }
+void ad9695_reg_read_block(uint16_t start_addr, uint8_t *data, uint16_t count)
+{
+    ad9695_read_registers(&spi_inst, start_addr, data, count);
+}
+void ad9695_reg_write_block(uint16_t start_addr, const uint8_t *data, uint16_t count)
+{
+    ad9695_write_registers(&spi_inst, start_addr, data, count);
+}
+
+void ad9695_regcache_invalidate(void)           { }
+void ad9695_regcache_forget(uint16_t addr)      { (void)addr; }
+void ad9695_regcache_batch_begin(void)          { }
+int  ad9695_regcache_batch_commit(void)         { return 0; }
+int  ad9695_regcache_flush(void)                { return 0; }
+int  ad9695_regcache_verify(void)               { return 0; }
+void ad9695_regcache_set_verify(uint8_t en)     { (void)en; }
+void ad9695_regcache_print(void)                { xil_printf("regcache: compiled out (AD9695_REGCACHE_ENABLE=0)\r\n"); }
+
+#endif /* AD9695_REGCACHE_ENABLE */
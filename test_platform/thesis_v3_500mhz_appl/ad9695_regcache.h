@@ -0,0 +1,45 @@
+/* ad9695_regcache.h
+ * Shadow copy of the AD9695 register map.
+ *
+ * Reads of non-volatile registers are served from the shadow once it holds a
+ * value, and writes that would not change a register are dropped.  Registers
+ * the register map marks as local keep one page per ADC channel, selected by
+ * CH_INDEX (0x0008) exactly like on the chip; writing CH_INDEX only moves the
+ * shadow page pointer, the SPI write happens when a paged register needs it.
+ *
+ * Outside a batch every change is written through immediately.  Between
+ * ad9695_regcache_batch_begin() and ad9695_regcache_batch_commit() changes
+ * are only marked dirty; the commit flushes them in address order, merging
+ * contiguous registers into one streamed SPI transfer and grouping paged
+ * registers per channel.  Status, self-clearing and strobe registers are
+ * never cached and flush any pending batch before they are accessed.
+ *
+ * Build with -DAD9695_REGCACHE_ENABLE=0 to pass every access straight to SPI.
+ */
+
+#ifndef AD9695_REGCACHE_H
+#define AD9695_REGCACHE_H
+
+#include <stdint.h>
+
+#ifndef AD9695_REGCACHE_ENABLE
+#define AD9695_REGCACHE_ENABLE      1
+#endif
+
+#define AD9695_REGC_SIZE            0x2000  /* covers the whole documented map */
+
+void ad9695_reg_read (uint16_t addr, uint8_t *data);
+void ad9695_reg_write(uint16_t addr, uint8_t value);
+void ad9695_reg_read_block (uint16_t start_addr, uint8_t *data, uint16_t count);
+void ad9695_reg_write_block(uint16_t start_addr, const uint8_t *data, uint16_t count);
+
+void ad9695_regcache_invalidate(void);
+void ad9695_regcache_forget(uint16_t addr);
+void ad9695_regcache_batch_begin(void);
+int  ad9695_regcache_batch_commit(void);
+int  ad9695_regcache_flush(void);
+int  ad9695_regcache_verify(void);
+void ad9695_regcache_set_verify(uint8_t en);
+void ad9695_regcache_print(void);
+
+#endif /* AD9695_REGCACHE_H */
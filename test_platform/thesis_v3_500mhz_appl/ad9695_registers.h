@@ -117,6 +117,10 @@
 #define AD9695_ADC_MODE_REG 0x0200
 #define AD9695_ADC_MODE(x) (((x)&0x3) << 0)
 #define AD9695_ADC_Q_IGNORE SET_BIT(5)
+#define AD9695_ADC_MODE_FULL_BW 0x0
+#define AD9695_ADC_MODE_ONE_DDC 0x1
+#define AD9695_ADC_MODE_TWO_DDC 0x2
+#define AD9695_ADC_MODE_FOUR_DDC 0x3
 
 // Chip Decimation Select (Full Sample Rate, DDC Bypassed)
 #define AD9695_ADC_DCM_REG 0x0201
@@ -154,6 +158,17 @@
 #define AD9695_DDCX_NCO_IF_MODE(x) (((x)&0x3) << 4)
 #define AD9695_DDCX_COMPLEX_TO_REAL SET_BIT(3)
 #define AD9695_DDCX_DCM_FILT_SEL_0(x) (((x)&0x7) << 0)
+#define AD9695_DDCX_NCO_ZIF 0x1
+/* DCM_FILT_SEL_0 codes, complex output (complex to real disabled) */
+#define AD9695_DDCX_CPLX_DCM2 0x3
+#define AD9695_DDCX_CPLX_DCM4 0x0
+#define AD9695_DDCX_CPLX_DCM8 0x1
+#define AD9695_DDCX_CPLX_DCM16 0x2
+/* DCM_FILT_SEL_0 codes, real output (complex to real enabled) */
+#define AD9695_DDCX_REAL_DCM2 0x0
+#define AD9695_DDCX_REAL_DCM4 0x1
+#define AD9695_DDCX_REAL_DCM8 0x2
+#define AD9695_DDCX_REAL_DCM16 0x3
 #define AD9695_DDCX_DATA_SEL_REG 0x0311
 #define AD9695_DDCX_DCM_FILT_SEL_1(x) (((x)&0xF) << 4)
 #define AD9695_DDCX_Q_IP_CHB_SEL SET_BIT(2)
@@ -2,6 +2,9 @@
 #include "xparameters.h"
 #include "xil_cache.h"
 #include "xil_printf.h"
+#include "sleep.h"
+#include "bstats.h"
+#include "bprofile.h"
 #include <xaxidma.h>
 
 /* We keep a single static instance under the hood */
@@ -33,3 +36,29 @@ XAxiDma_Config* dma_init(XAxiDma* dma)
     return config;
 }
 
+/* Polled S2MM capture of <bytes> into dst. Returns 0 on success, 1 on submit error or timeout */
+int dma_capture(XAxiDma* dma, u8* dst, u32 bytes)
+{
+    BPROF_BEGIN(BPROF_DMA_CAPTURE);
+    BPROF_BEGIN(BPROF_DCACHE_FLUSH);
+    Xil_DCacheFlushRange((UINTPTR)dst, bytes);
+    BPROF_END_BYTES(BPROF_DCACHE_FLUSH, bytes);
+    int res = XAxiDma_SimpleTransfer(dma, (UINTPTR)dst, bytes, XAXIDMA_DEVICE_TO_DMA);
+    if (res != XST_SUCCESS) {
+        bstats_inc(BSTAT_DMA_SUBMIT_ERR);
+        return 1;
+    }
+
+    for (u32 timeout = DMA_CAPTURE_TIMEOUT_US; XAxiDma_Busy(dma, XAXIDMA_DEVICE_TO_DMA); timeout--) {
+        if (timeout == 0) {
+            bstats_inc(BSTAT_DMA_TIMEOUT);
+            return 1;
+        }
+        usleep(1);
+    }
+    /* Drop lines the CPU fetched while the DMA wrote, so readers see the capture */
+    Xil_DCacheInvalidateRange((UINTPTR)dst, bytes);
+    bstats_inc(BSTAT_DMA_CAPTURES);
+    BPROF_END_BYTES(BPROF_DMA_CAPTURE, bytes);
+    return 0;
+}
@@ -4,10 +4,12 @@
 #include "xaxidma.h"
 #include "xil_types.h"
 
-#define DMA_CMD_BUF_SIZE   512
+#define DMA_CMD_BUF_SIZE   2048     /* largest capture (M=8, NP=16), see bjesdmode.h */
 #define DMA_DEVICE_ID      0
+#define DMA_CAPTURE_TIMEOUT_US  1000
 
 XAxiDma_Config* dma_init(XAxiDma* dma);
+int dma_capture(XAxiDma* dma, u8* dst, u32 bytes);
 
 
 #endif // BAXIDMA_H
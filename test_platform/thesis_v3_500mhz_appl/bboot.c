@@ -0,0 +1,43 @@
+#include "bboot.h"
+#include "xil_printf.h"
+#include "xiltimer.h"
+
+#define COUNTS_PER_US   (COUNTS_PER_SECOND / 1000000U)
+
+static struct {
+    const char *name;
+    XTime       end;
+} boot_phase[BOOT_MAX_PHASES];
+
+static XTime    boot_t0;
+static uint32_t boot_num_phases;
+
+void boot_timer_start(void)
+{
+    XTime_GetTime(&boot_t0);
+    boot_num_phases = 0;
+}
+
+void boot_phase_mark(const char *name)
+{
+    if (boot_num_phases >= BOOT_MAX_PHASES) return;
+    XTime_GetTime(&boot_phase[boot_num_phases].end);
+    boot_phase[boot_num_phases].name = name;
+    boot_num_phases++;
+}
+
+void boot_report(void)
+{
+    XTime start = boot_t0;
+
+    xil_printf("---- Boot timing (%s bring-up) ----\r\n", BOOT_FAST ? "fast" : "legacy");
+    for (uint32_t i = 0; i < boot_num_phases; i++) {
+        xil_printf("  %-24s %8d us\r\n", boot_phase[i].name,
+                   (u32)((boot_phase[i].end - start) / COUNTS_PER_US));
+        start = boot_phase[i].end;
+    }
+    if (boot_num_phases) {
+        xil_printf("  %-24s %8d us\r\n", "total",
+                   (u32)((boot_phase[boot_num_phases - 1].end - boot_t0) / COUNTS_PER_US));
+    }
+}
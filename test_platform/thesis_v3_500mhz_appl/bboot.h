@@ -0,0 +1,27 @@
+/* bboot.h
+ * Boot phase timing for the bring-up sequence.
+ *
+ * boot_timer_start() stamps t0, every boot_phase_mark() closes the phase
+ * that started at the previous mark, and boot_report() prints the per-phase
+ * durations once bring-up is done.  Timestamps come from XTime_GetTime().
+ */
+
+#ifndef BBOOT_H
+#define BBOOT_H
+
+#include <stdint.h>
+
+#define BOOT_MAX_PHASES     16
+
+/* Fast bring-up: poll reset/lock flags with bounded timeouts instead of
+ * fixed sleeps, and overlap the JESD PHY reset with the ADC PLL lock.
+ * Build with -DBOOT_FAST=0 to get the original fixed-delay sequence. */
+#ifndef BOOT_FAST
+#define BOOT_FAST           1
+#endif
+
+void     boot_timer_start(void);
+void     boot_phase_mark(const char *name);
+void     boot_report(void);
+
+#endif /* BBOOT_H */
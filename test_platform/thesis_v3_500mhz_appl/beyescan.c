@@ -0,0 +1,201 @@
+#include "beyescan.h"
+#include <string.h>
+#include "bjesdphy.h"
+#include "bjesdlink.h"
+#include "bjesdmon.h"
+#include "bstats.h"
+#include "xil_printf.h"
+#include "xiltimer.h"
+
+#define COUNTS_PER_US   (COUNTS_PER_SECOND / 1000000U)
+
+#define GTH_VS_MASK         0x07FC      /* NEG_DIR | UT_SIGN | CODE, RANGE untouched */
+#define GTH_ES_CTRL_MASK    0xFC00
+#define GTH_ES_ENABLE_MASK  (GTH_ES_ERRDET_EN | GTH_ES_EYE_SCAN_EN | GTH_ES_PRESCALE_MASK)
+
+static struct eyescan_lane_result results[EYESCAN_MAX_LANES];
+static struct jesdphy_drp_queue drp_q;
+
+static uint64_t now_us(void)
+{
+    XTime now;
+    XTime_GetTime(&now);
+    return now / COUNTS_PER_US;
+}
+
+/* Enable the eye-scan block and program the qualifier / data masks so every
+ * bit of the RX word is compared and no qualifier is required. */
+static int eyescan_setup(uint8_t lane)
+{
+    uint32_t es_ctrl;
+    uint16_t word;
+
+    if (jesdphy_drp_transceiver_read(lane, GTH_ES_CONTROL_ADDR, &es_ctrl)) return 1;
+
+    jesdphy_drp_queue_reset(&drp_q);
+    jesdphy_drp_queue_rmw(&drp_q, lane, GTH_ES_CONTROL_ADDR, GTH_ES_ENABLE_MASK | GTH_ES_CTRL_MASK,
+                          GTH_ES_ERRDET_EN | GTH_ES_EYE_SCAN_EN | EYESCAN_PRESCALE);
+    for (uint16_t k = 0; k < 5; k++) {
+        /* bit b of the 80-bit window is compared when b >= 80 - width */
+        word = 0;
+        for (uint16_t b = 0; b < 16; b++) {
+            if ((uint16_t)(16 * k + b) < 80 - EYESCAN_DATA_WIDTH) word |= (uint16_t)(1U << b);
+        }
+        jesdphy_drp_queue_write(&drp_q, lane, GTH_ES_QUALIFIER0_ADDR + k, 0x0000);
+        jesdphy_drp_queue_write(&drp_q, lane, GTH_ES_QUAL_MASK0_ADDR + k, 0xFFFF);
+        jesdphy_drp_queue_write(&drp_q, lane, GTH_ES_SDATA_MASK0_ADDR + k, word);
+        jesdphy_drp_queue_write(&drp_q, lane, GTH_ES_QUALIFIER5_ADDR + k, 0x0000);
+        jesdphy_drp_queue_write(&drp_q, lane, GTH_ES_QUAL_MASK5_ADDR + k, 0xFFFF);
+        jesdphy_drp_queue_write(&drp_q, lane, GTH_ES_SDATA_MASK5_ADDR + k, 0xFFFF);
+    }
+    if (jesdphy_drp_queue_run(&drp_q)) return 1;
+
+    /* The offset sampler only powers up through an RX PMA reset */
+    if (!(es_ctrl & GTH_ES_EYE_SCAN_EN)) {
+        xil_printf("EYESCAN: enabling eye scan on lane %d, resetting PHY RX\r\n", lane);
+        jesdphy_rx_reset();
+        jesdmon_link_reset_issued();
+    }
+    return 0;
+}
+
+/* One measurement at (h, v) with the given UT sign; counts are added to pt */
+static int eyescan_measure(uint8_t lane, int16_t h, int16_t v, uint8_t ut_sign, struct eyescan_point *pt)
+{
+    uint16_t horz = (uint16_t)((h & 0x7FF) | ((h < 0) ? 0x800 : 0)) << 4;
+    uint16_t vs   = (uint16_t)(((v < 0) ? 0x400 : 0) | (ut_sign ? 0x200 : 0) | (((v < 0) ? -v : v) & 0x7F) << 2);
+    uint64_t t0;
+    uint32_t status;
+
+    jesdphy_drp_queue_reset(&drp_q);
+    jesdphy_drp_queue_write(&drp_q, lane, GTH_ES_HORZ_OFFSET_ADDR, horz);
+    jesdphy_drp_queue_rmw(&drp_q, lane, GTH_RX_EYESCAN_VS_ADDR, GTH_VS_MASK, vs);
+    jesdphy_drp_queue_rmw(&drp_q, lane, GTH_ES_CONTROL_ADDR, GTH_ES_CTRL_MASK, GTH_ES_CONTROL_RUN);
+    if (jesdphy_drp_queue_run(&drp_q)) return 1;
+
+    t0 = now_us();
+    do {
+        if (jesdphy_drp_transceiver_read(lane, GTH_ES_CONTROL_STATUS_ADDR, &status)) return 1;
+        if (status & GTH_ES_STATUS_DONE) break;
+    } while (now_us() - t0 < EYESCAN_POINT_TIMEOUT_US);
+
+    jesdphy_drp_queue_reset(&drp_q);
+    jesdphy_drp_queue_read(&drp_q, lane, GTH_ES_ERROR_COUNT_ADDR);
+    jesdphy_drp_queue_read(&drp_q, lane, GTH_ES_SAMPLE_COUNT_ADDR);
+    jesdphy_drp_queue_rmw(&drp_q, lane, GTH_ES_CONTROL_ADDR, GTH_ES_CTRL_MASK, 0);
+    if (jesdphy_drp_queue_run(&drp_q)) return 1;
+
+    if (!(status & GTH_ES_STATUS_DONE)) {
+        xil_printf("EYESCAN: lane %d point (%d,%d) timed out\r\n", lane, h, v);
+        return 1;
+    }
+    pt->errors  += drp_q.ops[0].data;
+    pt->samples += drp_q.ops[1].data;
+    return 0;
+}
+
+/* Zero-error span around the centre along one row or column of the map */
+static void eyescan_opening(const struct eyescan_lane_result *r, int horizontal, int16_t *lo, int16_t *hi)
+{
+    int centre = horizontal ? EYESCAN_H_POINTS / 2 : EYESCAN_V_POINTS / 2;
+    int n      = horizontal ? EYESCAN_H_POINTS : EYESCAN_V_POINTS;
+    int step   = horizontal ? EYESCAN_H_STEP : EYESCAN_V_STEP;
+    int a, b;
+
+#define PT(i) (horizontal ? &r->map[EYESCAN_V_POINTS / 2][(i)] : &r->map[(i)][EYESCAN_H_POINTS / 2])
+    if (PT(centre)->errors) { *lo = 1; *hi = 0; return; }   /* closed */
+    for (a = centre; a > 0 && PT(a - 1)->errors == 0; a--);
+    for (b = centre; b < n - 1 && PT(b + 1)->errors == 0; b++);
+#undef PT
+    *lo = (int16_t)((a - centre) * step);
+    *hi = (int16_t)((b - centre) * step);
+}
+
+int eyescan_lane(uint8_t lane)
+{
+    struct eyescan_lane_result *r;
+    uint64_t t0 = now_us();
+
+    if (lane >= EYESCAN_MAX_LANES) {
+        xil_printf("EYESCAN: lane %d out of range\r\n", lane);
+        return 1;
+    }
+    r = &results[lane];
+    memset(r, 0, sizeof(*r));
+
+    if (eyescan_setup(lane)) {
+        xil_printf("EYESCAN: DRP setup failed on lane %d\r\n", lane);
+        return 1;
+    }
+
+    for (int vi = 0; vi < EYESCAN_V_POINTS; vi++) {
+        int16_t v = (int16_t)((vi - EYESCAN_V_POINTS / 2) * EYESCAN_V_STEP);
+        for (int hi = 0; hi < EYESCAN_H_POINTS; hi++) {
+            int16_t h = (int16_t)((hi - EYESCAN_H_POINTS / 2) * EYESCAN_H_STEP);
+            struct eyescan_point *pt = &r->map[vi][hi];
+            if (eyescan_measure(lane, h, v, 0, pt) || eyescan_measure(lane, h, v, 1, pt)) {
+                return 1;
+            }
+        }
+    }
+
+    eyescan_opening(r, 1, &r->h_open_lo, &r->h_open_hi);
+    eyescan_opening(r, 0, &r->v_open_lo, &r->v_open_hi);
+    r->prescale = EYESCAN_PRESCALE;
+    r->scan_ms  = (uint32_t)((now_us() - t0) / 1000);
+    r->valid    = 1;
+    return 0;
+}
+
+int eyescan_all(void)
+{
+    int fail = 0;
+    for (uint8_t lane = 0; lane < JESDLINK_NUM_LANES && lane < EYESCAN_MAX_LANES; lane++) {
+        fail += eyescan_lane(lane);
+        eyescan_print(lane);
+    }
+    return fail;
+}
+
+const struct eyescan_lane_result* eyescan_result(uint8_t lane)
+{
+    return (lane < EYESCAN_MAX_LANES && results[lane].valid) ? &results[lane] : NULL;
+}
+
+/* '.' = no error, digit d = BER around 1e-d, '#' = BER >= 1e-1 */
+static char eyescan_cell(const struct eyescan_point *pt, uint8_t prescale)
+{
+    uint64_t bits, ratio;
+    int d = 0;
+
+    if (pt->errors == 0) return '.';
+    bits  = (uint64_t)pt->samples * ((uint64_t)2 << prescale) * EYESCAN_DATA_WIDTH;
+    ratio = bits / pt->errors;
+    while (ratio >= 10 && d < 9) { ratio /= 10; d++; }
+    return d ? (char)('0' + d) : '#';
+}
+
+void eyescan_print(uint8_t lane)
+{
+    const struct eyescan_lane_result *r = eyescan_result(lane);
+
+    if (!r) {
+        xil_printf("EYESCAN: no result for lane %d\r\n", lane);
+        return;
+    }
+    xil_printf("EYESCAN lane %d (%d ms, prescale %d)\r\n", lane, r->scan_ms, r->prescale);
+    for (int vi = EYESCAN_V_POINTS - 1; vi >= 0; vi--) {
+        xil_printf("  %4d |", (vi - EYESCAN_V_POINTS / 2) * EYESCAN_V_STEP);
+        for (int hi = 0; hi < EYESCAN_H_POINTS; hi++) {
+            xil_printf(" %c", eyescan_cell(&r->map[vi][hi], r->prescale));
+        }
+        xil_printf("\r\n");
+    }
+    if (r->h_open_lo > r->h_open_hi) {
+        xil_printf("  eye closed at centre\r\n");
+    } else {
+        xil_printf("  horizontal opening %d..%d phase steps (%d/%d UI)\r\n", r->h_open_lo, r->h_open_hi,
+                   r->h_open_hi - r->h_open_lo, 2 * EYESCAN_H_RANGE);
+        xil_printf("  vertical opening %d..%d codes\r\n", r->v_open_lo, r->v_open_hi);
+    }
+}
@@ -0,0 +1,70 @@
+/* beyescan.h
+ * Statistical 2-D eye scan of the JESD204 PHY lanes (UltraScale+ GTH).
+ *
+ * For every (horizontal, vertical) offset of the grid the GTH eye-scan block
+ * compares the offset sampler against the data sampler and counts errors and
+ * samples; each point is run for both UT signs and summed.  All DRP traffic
+ * goes through the batched DRP queue in bjesdphy.c.  The per-lane result is
+ * a margin map (error/sample counts per point) plus the zero-error opening
+ * along both axes through the eye centre.
+ *
+ * DRP addresses and fields follow the GTHE4 attribute map (UG576).
+ */
+
+#ifndef BEYESCAN_H
+#define BEYESCAN_H
+
+#include <stdint.h>
+
+/* GTHE4 eye-scan DRP addresses */
+#define GTH_ES_CONTROL_ADDR         0x003C  /* [15:10] ES_CONTROL, [9] ERRDET_EN, [8] EYE_SCAN_EN, [4:0] PRESCALE */
+#define GTH_ES_QUALIFIER0_ADDR      0x003F  /* ES_QUALIFIER0..4    0x03F..0x043 */
+#define GTH_ES_QUAL_MASK0_ADDR      0x0044  /* ES_QUAL_MASK0..4    0x044..0x048 */
+#define GTH_ES_SDATA_MASK0_ADDR     0x0049  /* ES_SDATA_MASK0..4   0x049..0x04D */
+#define GTH_ES_HORZ_OFFSET_ADDR     0x004F  /* [15:4] ES_HORZ_OFFSET */
+#define GTH_ES_QUALIFIER5_ADDR      0x00EC  /* ES_QUALIFIER5..9    0x0EC..0x0F0 */
+#define GTH_ES_QUAL_MASK5_ADDR      0x00F1  /* ES_QUAL_MASK5..9    0x0F1..0x0F5 */
+#define GTH_ES_SDATA_MASK5_ADDR     0x00F6  /* ES_SDATA_MASK5..9   0x0F6..0x0FA */
+#define GTH_RX_EYESCAN_VS_ADDR      0x0097  /* [10] NEG_DIR, [9] UT_SIGN, [8:2] CODE, [1:0] RANGE */
+#define GTH_ES_ERROR_COUNT_ADDR     0x0251
+#define GTH_ES_SAMPLE_COUNT_ADDR    0x0252
+#define GTH_ES_CONTROL_STATUS_ADDR  0x0253  /* [3:1] state, [0] done */
+
+#define GTH_ES_CONTROL_RUN          0x0400  /* ES_CONTROL[0] */
+#define GTH_ES_ERRDET_EN            0x0200
+#define GTH_ES_EYE_SCAN_EN          0x0100
+#define GTH_ES_PRESCALE_MASK        0x001F
+#define GTH_ES_STATUS_DONE          0x0001
+
+/* Scan grid and dwell */
+#define EYESCAN_MAX_LANES           4
+#define EYESCAN_H_RANGE             32      /* +/- phase steps per UI at RXOUT_DIV = 1 */
+#define EYESCAN_V_RANGE             127     /* +/- vertical codes                     */
+#define EYESCAN_H_STEP              4
+#define EYESCAN_V_STEP              16
+#define EYESCAN_H_POINTS            (2 * EYESCAN_H_RANGE / EYESCAN_H_STEP + 1)
+#define EYESCAN_V_POINTS            (2 * (EYESCAN_V_RANGE / EYESCAN_V_STEP) + 1)
+#define EYESCAN_PRESCALE            3       /* samples counted in units of 2^(1+prescale) words */
+#define EYESCAN_DATA_WIDTH          40      /* RX parallel width (bits) */
+#define EYESCAN_POINT_TIMEOUT_US    200000
+
+struct eyescan_point {
+    uint32_t errors;        /* both UT signs */
+    uint32_t samples;       /* raw ES_SAMPLE_COUNT sum */
+};
+
+struct eyescan_lane_result {
+    uint8_t  valid;
+    uint8_t  prescale;
+    int16_t  h_open_lo, h_open_hi;      /* zero-error span on the vertical centre line */
+    int16_t  v_open_lo, v_open_hi;      /* zero-error span on the horizontal centre line */
+    uint32_t scan_ms;
+    struct eyescan_point map[EYESCAN_V_POINTS][EYESCAN_H_POINTS];
+};
+
+int  eyescan_lane(uint8_t lane);
+int  eyescan_all(void);
+void eyescan_print(uint8_t lane);
+const struct eyescan_lane_result* eyescan_result(uint8_t lane);
+
+#endif /* BEYESCAN_H */
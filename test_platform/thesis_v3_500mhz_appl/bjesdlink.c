@@ -4,6 +4,8 @@
 #include "xil_printf.h"
 #include "sleep.h"
 #include "xparameters.h"
+#include "bprofile.h"
+#include "bstats.h"
 
 #define SET_BIT(n) ((uint32_t)1 << n)
 #define CLEAR_BIT(n) (~((uint32_t)1 << n))
@@ -34,6 +36,15 @@ void jesdlink_k_f_set(uint8_t k, uint8_t f){
     xil_printf("JESD204C SUBCLASS REG = %x.\r\n", tmp_reg);
 }
 
+/* Enable lanes 0..lanes-1, the rest are ignored by the link */
+void jesdlink_lanes_set(uint8_t lanes){
+    if (lanes == 0 || lanes > JESDLINK_NUM_LANES) {
+        xil_printf("Error: lane count can only be 1 - %d!\r\n", JESDLINK_NUM_LANES);
+        return;
+    }
+    jesdlink_write(JESDLINK_CTRL_LANE_ENA_REG, (1U << lanes) - 1);
+}
+
 void jesdlink_subclass_set(uint8_t subclass) {
     if (subclass > 3) {
         xil_printf("Error: subclass can only be 0 - 2!\r\n");
@@ -44,6 +55,8 @@ void jesdlink_subclass_set(uint8_t subclass) {
 }
 
 void jesdlink_reset() {
+    BPROF_BEGIN(BPROF_JESDLINK_RESET);
+    bstats_inc(BSTAT_JESDLINK_RESETS);
     xil_printf("JESD204C IP Reset Starting...");
     uint32_t tmp_reg;
     jesdlink_read(JESDLINK_RESET_REG, &tmp_reg);
@@ -56,6 +69,34 @@ void jesdlink_reset() {
     jesdlink_write(JESDLINK_RESET_REG, tmp_reg);
     jesdlink_read(JESDLINK_RESET_REG, &tmp_reg);
     xil_printf("JESD204C IP Reset Finished. RESET_REG = 0x%x.\r\n",tmp_reg);
+    BPROF_END(BPROF_JESDLINK_RESET);
+}
+
+/* Quiet reset for the reconfiguration path: no read-back prints, caller
+ * chooses the pulse width (the core only needs a few AXI clock cycles). */
+void jesdlink_reset_pulse(uint32_t pulse_us) {
+    uint32_t tmp_reg;
+    bstats_inc(BSTAT_JESDLINK_RESETS);
+    jesdlink_read(JESDLINK_RESET_REG, &tmp_reg);
+    jesdlink_write(JESDLINK_RESET_REG, tmp_reg | SET_BIT(0));
+    if (pulse_us) usleep(pulse_us);
+    jesdlink_write(JESDLINK_RESET_REG, tmp_reg & CLEAR_BIT(0));
+}
+
+/* Poll for SYNC; returns 0 once in sync (waited time in *waited_us), 1 on timeout */
+int jesdlink_wait_sync(uint32_t timeout_us, uint32_t* waited_us) {
+    uint32_t tmp_reg, waited = 0;
+    do {
+        jesdlink_read(JESDLINK_STAT_STATUS_REG, &tmp_reg);
+        if (tmp_reg & JESDLINK_STATUS_SYNC) {
+            if (waited_us) *waited_us = waited;
+            return 0;
+        }
+        usleep(1);
+        waited++;
+    } while (waited < timeout_us);
+    if (waited_us) *waited_us = waited;
+    return 1;
 }
 
 void jesdlink_read(uint32_t addr, uint32_t* data_ptr) {
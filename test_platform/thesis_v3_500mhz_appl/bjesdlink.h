@@ -2,6 +2,8 @@
 #define BJESDLINK_H
 #include <stdint.h>
 
+#define JESDLINK_NUM_LANES                  4
+
 #define JESDLINK_RESET_REG                  0x0020
 #define JESDLINK_CTRL_SUB_CLASS_REG         0x0034
 #define JESDLINK_CTRL_8B10B_CFG_REG         0x003c
@@ -30,12 +32,20 @@
 #define JESDLINK_CTRL_TX_GT(n)              (0x0460 + (n*0x0080))
 #define JESDLINK_CTRL_RX_GT(n)              (0x0464 + (n*0x0080))
 
+/* JESDLINK_STAT_STATUS_REG fields (8B10B mode) */
+#define JESDLINK_STATUS_SYNC                0x00000001  /* SYNC~ released, lanes in data phase */
+#define JESDLINK_STATUS_SYSREF_CAPT         0x00000002
+#define JESDLINK_STATUS_SYSREF_ERR          0x00000004
+
 void jesdlink_read(uint32_t addr, uint32_t* data_ptr);
 void jesdlink_write(uint32_t addr, uint32_t data);
 void jesdlink_reset();
+void jesdlink_reset_pulse(uint32_t pulse_us);
+int  jesdlink_wait_sync(uint32_t timeout_us, uint32_t* waited_us);
 void jesdlink_subclass_set(uint8_t subclass);
 void jesdlink_en_scrambling(uint8_t en);
 void jesdlink_k_f_set(uint8_t k, uint8_t f);
+void jesdlink_lanes_set(uint8_t lanes);
 
 
 #endif
\ No newline at end of file
@@ -0,0 +1,239 @@
+#include "bjesdmode.h"
+#include <string.h>
+#include "ad9695.h"
+#include "ad9695_regcache.h"
+#include "bjesdlink.h"
+#include "bjesdphy.h"
+#include "bjesdmon.h"
+#include "bstats.h"
+#include "bprofile.h"
+#include "xil_printf.h"
+
+/* ---------------------------------------------------------------------- */
+/*  Unpack kernels, one per (NP, samples per slice)                        */
+/* ---------------------------------------------------------------------- */
+#define JESDMODE_UNPACK16(SPC)                                                          \
+static void unpack16_##SPC(const uint8_t *raw, size_t nblk, uint8_t m, int16_t *const *out) \
+{                                                                                       \
+    for (size_t b = 0; b < nblk; b++) {                                                 \
+        for (uint8_t c = 0; c < m; c++, raw += 2 * SPC) {                               \
+            memcpy(out[c] + b * SPC, raw, 2 * SPC);                                     \
+        }                                                                               \
+    }                                                                                   \
+}
+
+/* 8-bit samples are the converter MSBs: scale to the 16-bit full range */
+#define JESDMODE_UNPACK8(SPC)                                                           \
+static void unpack8_##SPC(const uint8_t *raw, size_t nblk, uint8_t m, int16_t *const *out) \
+{                                                                                       \
+    for (size_t b = 0; b < nblk; b++) {                                                 \
+        for (uint8_t c = 0; c < m; c++, raw += SPC) {                                   \
+            int16_t *o = out[c] + b * SPC;                                              \
+            for (int k = 0; k < SPC; k++) o[k] = (int16_t)((int8_t)raw[k] * 256);       \
+        }                                                                               \
+    }                                                                                   \
+}
+
+JESDMODE_UNPACK16(1)
+JESDMODE_UNPACK16(2)
+JESDMODE_UNPACK16(4)
+JESDMODE_UNPACK16(8)
+JESDMODE_UNPACK8(1)
+JESDMODE_UNPACK8(2)
+JESDMODE_UNPACK8(4)
+JESDMODE_UNPACK8(8)
+JESDMODE_UNPACK8(16)
+
+/* ---------------------------------------------------------------------- */
+/*  Mode table                                                             */
+/* ---------------------------------------------------------------------- */
+#define MODE_S(L, M, NP)    ((8 * (L)) > ((M) * (NP)) ? (8 * (L)) / ((M) * (NP)) : 1)
+#define MODE_F(L, M, NP)    ((M) * (NP) * MODE_S(L, M, NP) / (8 * (L)))
+
+/* Lane rate in the comments is for the 500 MSPS sample clock */
+#define JESDMODE_ROW(L, M, NP, SPC, DDC, DCM, CPLX) \
+    { L, M, NP, NP, MODE_F(L, M, NP), MODE_S(L, M, NP), SPC, DDC, DCM, CPLX, unpack##NP##_##SPC }
+
+static const struct jesd_mode jesd_modes[] = {
+    /*            L  M  NP SPC DDC DCM CPLX */
+    JESDMODE_ROW(1, 1,  8,  4, 0,  1, 0),      /* 5.0 Gbps */
+    JESDMODE_ROW(1, 1, 16,  2, 1,  2, 0),      /* 5.0 */
+    JESDMODE_ROW(2, 1,  8,  8, 0,  1, 0),      /* 2.5 */
+    JESDMODE_ROW(2, 1, 16,  4, 0,  1, 0),      /* 5.0 */
+    JESDMODE_ROW(4, 1,  8, 16, 0,  1, 0),      /* 1.25, below the AD9695 minimum */
+    JESDMODE_ROW(4, 1, 16,  8, 0,  1, 0),      /* 2.5 */
+    JESDMODE_ROW(1, 2,  8,  2, 2,  2, 0),      /* 5.0 */
+    JESDMODE_ROW(1, 2, 16,  1, 2,  4, 0),      /* 5.0 */
+    JESDMODE_ROW(2, 2,  8,  4, 0,  1, 0),      /* 5.0 */
+    JESDMODE_ROW(2, 2, 16,  2, 2,  2, 0),      /* 5.0 */
+    JESDMODE_ROW(4, 2,  8,  8, 0,  1, 0),      /* 2.5 */
+    JESDMODE_ROW(4, 2, 16,  4, 0,  1, 0),      /* 5.0, default */
+    JESDMODE_ROW(1, 4,  8,  1, 2,  4, 1),      /* 5.0 */
+    JESDMODE_ROW(1, 4, 16,  1, 2,  8, 1),      /* 5.0 */
+    JESDMODE_ROW(2, 4,  8,  2, 2,  2, 1),      /* 5.0 */
+    JESDMODE_ROW(2, 4, 16,  1, 2,  4, 1),      /* 5.0 */
+    JESDMODE_ROW(4, 4,  8,  4, 2,  2, 1),      /* 2.5 */
+    JESDMODE_ROW(4, 4, 16,  2, 2,  2, 1),      /* 5.0 */
+    JESDMODE_ROW(1, 8,  8,  1, 4,  8, 1),      /* 5.0 */
+    JESDMODE_ROW(1, 8, 16,  1, 4, 16, 1),      /* 5.0 */
+    JESDMODE_ROW(2, 8,  8,  1, 4,  4, 1),      /* 5.0 */
+    JESDMODE_ROW(2, 8, 16,  1, 4,  8, 1),      /* 5.0 */
+    JESDMODE_ROW(4, 8,  8,  2, 4,  2, 1),      /* 5.0 */
+    JESDMODE_ROW(4, 8, 16,  1, 4,  4, 1),      /* 5.0 */
+};
+
+#define JESDMODE_NUM    (sizeof(jesd_modes) / sizeof(jesd_modes[0]))
+
+static const struct jesd_mode *cur_mode;
+static uint64_t adc_clk_khz;
+
+void jesdmode_init(uint64_t clk_khz)
+{
+    adc_clk_khz = clk_khz;
+
+    /* The SPC column picks the kernel, so it has to agree with L, M, NP */
+    for (uint32_t i = 0; i < JESDMODE_NUM; i++) {
+        const struct jesd_mode *m = &jesd_modes[i];
+        uint32_t spc = (32U * m->L) / ((uint32_t)m->M * m->NP);
+        if (spc == 0) spc = 1;
+        if (m->spc != spc) xil_printf("JESDMODE: row %d has SPC %d, expected %d\r\n", i, m->spc, spc);
+    }
+
+    cur_mode = jesdmode_find(JESDMODE_DEFAULT_L, JESDMODE_DEFAULT_M, JESDMODE_DEFAULT_NP);
+    bstats_set(BSTAT_G_JESD_MODE, jesdmode_id(cur_mode));
+}
+
+uint32_t jesdmode_count(void)
+{
+    return JESDMODE_NUM;
+}
+
+const struct jesd_mode* jesdmode_get(uint32_t id)
+{
+    return (id < JESDMODE_NUM) ? &jesd_modes[id] : NULL;
+}
+
+const struct jesd_mode* jesdmode_find(uint8_t L, uint8_t M, uint8_t NP)
+{
+    for (uint32_t i = 0; i < JESDMODE_NUM; i++) {
+        if (jesd_modes[i].L == L && jesd_modes[i].M == M && jesd_modes[i].NP == NP) return &jesd_modes[i];
+    }
+    return NULL;
+}
+
+const struct jesd_mode* jesdmode_current(void)
+{
+    return cur_mode;
+}
+
+/* Lanes the active mode runs on; every lane before a mode is set */
+uint32_t jesdmode_lanes(void)
+{
+    return cur_mode ? cur_mode->L : JESDLINK_NUM_LANES;
+}
+
+uint32_t jesdmode_id(const struct jesd_mode *mode)
+{
+    return (uint32_t)(mode - jesd_modes);
+}
+
+void jesdmode_to_param(const struct jesd_mode *mode, struct jesd_param_t *param)
+{
+    memset(param, 0, sizeof(*param));
+    param->jesd_L  = mode->L;
+    param->jesd_M  = mode->M;
+    param->jesd_F  = mode->F;
+    param->jesd_S  = mode->S;
+    param->jesd_K  = JESDMODE_K;
+    param->jesd_N  = mode->N;
+    param->jesd_NP = mode->NP;
+}
+
+uint64_t jesdmode_lane_rate_kbps(const struct jesd_mode *mode)
+{
+    return ((uint64_t)mode->M * mode->NP * 10ULL * adc_clk_khz) / ((uint64_t)mode->dcm * mode->L * 8ULL);
+}
+
+uint32_t jesdmode_block_bytes(const struct jesd_mode *mode)
+{
+    return (uint32_t)mode->M * mode->spc * mode->NP / 8;
+}
+
+uint32_t jesdmode_capture_bytes(const struct jesd_mode *mode)
+{
+    return (JESDMODE_CAPTURE_SAMPLES / mode->spc) * jesdmode_block_bytes(mode);
+}
+
+/* Split raw capture data into per-converter sample arrays; returns the
+ * number of samples written to each of out[0..M-1]. */
+size_t jesdmode_unpack(const struct jesd_mode *mode, const uint8_t *raw, size_t raw_bytes,
+                       int16_t *const *out, size_t max_per_conv)
+{
+    size_t nblk = raw_bytes / jesdmode_block_bytes(mode);
+
+    if (nblk > max_per_conv / mode->spc) nblk = max_per_conv / mode->spc;
+    BPROF_BEGIN(BPROF_JESD_UNPACK);
+    mode->unpack(raw, nblk, mode->M, out);
+    BPROF_END_BYTES(BPROF_JESD_UNPACK, nblk * jesdmode_block_bytes(mode));
+    return nblk * mode->spc;
+}
+
+/*
+ * Switch the running link to another mode: AD9695 link down, DDC and JESD
+ * registers in one shadow batch, link up; then the JESD204C IP (K/F, lanes)
+ * and the PHY line rate, followed by PHY and link resets.
+ */
+int jesdmode_apply(const struct jesd_mode *mode)
+{
+    struct jesd_param_t param;
+    uint64_t lane_rate_kbps = jesdmode_lane_rate_kbps(mode);
+    uint32_t waited_us;
+    int fail;
+
+    if (lane_rate_kbps < AD9695_LANE_RATE_MIN_KBPS || lane_rate_kbps > AD9695_LANE_RATE_MAX_KBPS) {
+        xil_printf("JESDMODE: lane rate %d kbps outside the AD9695 range\r\n", (u32)lane_rate_kbps);
+        return 1;
+    }
+
+    jesdmode_to_param(mode, &param);
+    ad9695_jesd_enable_link(0);
+    ad9695_regcache_batch_begin();
+    fail = ad9695_adc_set_ddc(mode->num_ddc, mode->dcm, mode->ddc_complex);
+    ad9695_jesd_set_if_config(param, adc_clk_khz / mode->dcm, &lane_rate_kbps);
+    fail |= ad9695_regcache_batch_commit();
+    ad9695_jesd_enable_link(1);
+    if (fail) {
+        xil_printf("JESDMODE: AD9695 configuration failed\r\n");
+        return 1;
+    }
+
+    jesdlink_k_f_set(JESDMODE_K, mode->F);
+    jesdlink_lanes_set(mode->L);
+    if (jesdphy_set_line_rate(lane_rate_kbps)) return 1;
+    jesdphy_rx_reset();
+    jesdlink_reset();
+    jesdmon_link_reset_issued();
+
+    cur_mode = mode;
+    bstats_set(BSTAT_G_JESD_MODE, jesdmode_id(mode));
+
+    if (jesdlink_wait_sync(JESDMODE_SYNC_TIMEOUT_US, &waited_us)) {
+        xil_printf("JESDMODE: no SYNC after %d us\r\n", waited_us);
+        return 1;
+    }
+    xil_printf("JESDMODE: L=%d M=%d NP=%d up, %d kbps/lane, SYNC after %d us\r\n",
+               mode->L, mode->M, mode->NP, (u32)lane_rate_kbps, waited_us);
+    return 0;
+}
+
+void jesdmode_print_table(void)
+{
+    xil_printf(" id  L  M NP  F  S spc ddc dcm   kbps/lane  bytes/capture\r\n");
+    for (uint32_t i = 0; i < JESDMODE_NUM; i++) {
+        const struct jesd_mode *m = &jesd_modes[i];
+        xil_printf("%c%2d %2d %2d %2d %2d %2d %3d %2d%c %3d %11d %14d\r\n",
+                   (m == cur_mode) ? '*' : ' ', i, m->L, m->M, m->NP, m->F, m->S, m->spc,
+                   m->num_ddc, m->ddc_complex ? 'c' : ' ', m->dcm,
+                   (u32)jesdmode_lane_rate_kbps(m), jesdmode_capture_bytes(m));
+    }
+}
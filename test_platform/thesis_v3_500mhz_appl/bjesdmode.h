@@ -0,0 +1,66 @@
+/* bjesdmode.h
+ * Table-driven JESD204 link modes.
+ *
+ * One row per (L, M, NP) combination accepted by check_jesd_params_range().
+ * A row carries everything needed to bring the link up in that mode: the
+ * AD9695 transport parameters (F and S follow from L, M and NP), the DDC
+ * routing and decimation that keep the lane rate within what the PHY can
+ * reach, and the unpack kernel for the captured data.
+ *
+ * M = 1/2 are real converters (channel A / channels A, B), through one or two
+ * real-output DDCs when decimation is needed; M = 4/8 are the I/Q outputs of
+ * two/four complex DDCs, channel A first.
+ *
+ * Capture layout: the transport layer hands out link words of L*32 bits.
+ * A block is one word, or M*NP/(L*32) words when one converter sample does
+ * not fit; converter c owns the c-th contiguous slice of a block, holding
+ * <spc> samples of NP bits, oldest first.  For the default L=4 M=2 NP=16
+ * mode that is the familiar "4 channel A samples, then 4 channel B samples"
+ * per 128-bit beat.  Lower-rate modes produce proportionally fewer bytes.
+ */
+
+#ifndef BJESDMODE_H
+#define BJESDMODE_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include "ad9695_api.h"
+
+#define JESDMODE_DEFAULT_L          4
+#define JESDMODE_DEFAULT_M          2
+#define JESDMODE_DEFAULT_NP         16
+#define JESDMODE_K                  32
+#define JESDMODE_CAPTURE_SAMPLES    128     /* per converter, one dma -w */
+#define JESDMODE_SYNC_TIMEOUT_US    50000
+
+typedef void (*jesdmode_unpack_fn)(const uint8_t *raw, size_t nblk, uint8_t m, int16_t *const *out);
+
+struct jesd_mode {
+    uint8_t  L, M, NP, N;
+    uint8_t  F, S;
+    uint8_t  spc;               /* samples per converter per block */
+    uint8_t  num_ddc;           /* 0 = full bandwidth */
+    uint8_t  dcm;               /* chip decimation */
+    uint8_t  ddc_complex;
+    jesdmode_unpack_fn unpack;
+};
+
+void                    jesdmode_init(uint64_t adc_clk_khz);
+uint32_t                jesdmode_count(void);
+const struct jesd_mode* jesdmode_get(uint32_t id);
+const struct jesd_mode* jesdmode_find(uint8_t L, uint8_t M, uint8_t NP);
+const struct jesd_mode* jesdmode_current(void);
+uint32_t                jesdmode_lanes(void);
+uint32_t                jesdmode_id(const struct jesd_mode *mode);
+
+void     jesdmode_to_param(const struct jesd_mode *mode, struct jesd_param_t *param);
+uint64_t jesdmode_lane_rate_kbps(const struct jesd_mode *mode);
+uint32_t jesdmode_block_bytes(const struct jesd_mode *mode);
+uint32_t jesdmode_capture_bytes(const struct jesd_mode *mode);
+size_t   jesdmode_unpack(const struct jesd_mode *mode, const uint8_t *raw, size_t raw_bytes,
+                         int16_t *const *out, size_t max_per_conv);
+
+int      jesdmode_apply(const struct jesd_mode *mode);
+void     jesdmode_print_table(void);
+
+#endif /* BJESDMODE_H */
@@ -0,0 +1,301 @@
+#include "bjesdmon.h"
+#include <string.h>
+#include "bjesdlink.h"
+#include "bjesdmode.h"
+#include "bjesdphy.h"
+#include "ad9695_api.h"
+#include "ad9695_registers.h"
+#include "bstats.h"
+#include "xil_printf.h"
+#include "xiltimer.h"
+#include "sleep.h"
+
+#define COUNTS_PER_US   (COUNTS_PER_SECOND / 1000000U)
+
+static const char *const event_name[JESDMON_EV_NUM] = {
+    [JESDMON_EV_START]           = "monitor start",
+    [JESDMON_EV_LINK_UP]         = "link up",
+    [JESDMON_EV_LINK_DOWN]       = "link down",
+    [JESDMON_EV_LANE_ERR]        = "lane errors",
+    [JESDMON_EV_BUF_SHIFT]       = "rx buffer shift",
+    [JESDMON_EV_PHY_PLL_UNLOCK]  = "phy pll unlock",
+    [JESDMON_EV_ADC_PLL_UNLOCK]  = "adc pll unlock",
+    [JESDMON_EV_RELINK_START]    = "re-link start",
+    [JESDMON_EV_RELINK_OK]       = "re-link ok",
+    [JESDMON_EV_RELINK_FAIL]     = "re-link fail",
+    [JESDMON_EV_CAPTURE_FLAGGED] = "capture flagged",
+    [JESDMON_EV_RESET_ISSUED]    = "reset issued",
+};
+
+static struct jesdmon_event events[JESDMON_NUM_EVENTS];
+static uint32_t event_total;
+
+static jesdmon_state_t mon_state = JESDMON_STATE_IDLE;
+static uint8_t  mon_enabled = 1;
+static uint64_t next_poll_us;
+static uint64_t next_relink_us;
+static uint32_t backoff_ms;
+static uint32_t relink_attempts;
+static uint32_t bad_epoch;
+
+static uint32_t last_err_cnt[JESDLINK_NUM_LANES];
+static uint32_t last_buf_lvl[JESDLINK_NUM_LANES];
+
+static uint64_t now_us(void)
+{
+    XTime now;
+    XTime_GetTime(&now);
+    return now / COUNTS_PER_US;
+}
+
+static void log_event(jesdmon_event_t type, uint16_t lane, uint32_t arg)
+{
+    struct jesdmon_event *ev = &events[event_total % JESDMON_NUM_EVENTS];
+    ev->t_us = now_us();
+    ev->type = type;
+    ev->lane = lane;
+    ev->arg  = arg;
+    event_total++;
+}
+
+/* Re-read the per-lane baselines so deltas restart from the current counts */
+static void sample_baseline(void)
+{
+    for (uint32_t lane = 0; lane < jesdmode_lanes(); lane++) {
+        jesdlink_read(JESDLINK_STAT_LINK_ERR_CNT(lane), &last_err_cnt[lane]);
+        jesdlink_read(JESDLINK_STAT_RX_BUF_LVL_REG(lane), &last_buf_lvl[lane]);
+    }
+}
+
+static void link_down(uint32_t status)
+{
+    mon_state = JESDMON_STATE_DOWN;
+    bad_epoch++;
+    bstats_inc(BSTAT_JESDMON_LINK_DOWN);
+    log_event(JESDMON_EV_LINK_DOWN, 0, status);
+    backoff_ms = 0;
+    next_relink_us = now_us();      /* first attempt right away */
+}
+
+/* One health sample; returns 1 while the link looks usable */
+static int sample_link(void)
+{
+    uint32_t status, tmp_reg, healthy = 1;
+    struct jesdphy_pll_status phy;
+    uint8_t adc_pll;
+
+    jesdlink_read(JESDLINK_STAT_STATUS_REG, &status);
+    if (!(status & JESDLINK_STATUS_SYNC)) healthy = 0;
+
+    for (uint32_t lane = 0; lane < jesdmode_lanes(); lane++) {
+        jesdlink_read(JESDLINK_STAT_LINK_ERR_CNT(lane), &tmp_reg);
+        uint32_t delta = tmp_reg - last_err_cnt[lane];
+        last_err_cnt[lane] = tmp_reg;
+        if (delta && mon_state == JESDMON_STATE_UP) {
+            bad_epoch++;
+            log_event(JESDMON_EV_LANE_ERR, lane, delta);
+            if (delta >= JESDMON_LANE_ERR_THRESH) healthy = 0;
+        }
+
+        /* A lane buffer level only moves when the lanes are re-aligned */
+        jesdlink_read(JESDLINK_STAT_RX_BUF_LVL_REG(lane), &tmp_reg);
+        if (tmp_reg != last_buf_lvl[lane] && mon_state == JESDMON_STATE_UP) {
+            bad_epoch++;
+            log_event(JESDMON_EV_BUF_SHIFT, lane, tmp_reg);
+        }
+        last_buf_lvl[lane] = tmp_reg;
+    }
+
+    jesdphy_get_pll_status(&phy);
+    if (phy.qpll0_unlocked || phy.rx_reset_in_prog) {
+        jesdphy_read(JESDPHY_PLL_STATUS_REG, &tmp_reg);
+        if (mon_state == JESDMON_STATE_UP) log_event(JESDMON_EV_PHY_PLL_UNLOCK, 0, tmp_reg);
+        healthy = 0;
+    }
+
+    ad9695_jesd_get_pll_status(&adc_pll);
+    if (!(adc_pll & AD9695_JESD_PLL_LOCK_STAT)) {
+        if (mon_state == JESDMON_STATE_UP) log_event(JESDMON_EV_ADC_PLL_UNLOCK, 0, adc_pll);
+        healthy = 0;
+    }
+
+    if (!healthy && mon_state == JESDMON_STATE_UP) link_down(status);
+    return healthy;
+}
+
+/* Minimal re-link: wait for the ADC SERDES PLL, reset the PHY RX only if its
+ * PLL dropped, reset the link core and wait for SYNC. */
+static int relink(void)
+{
+    struct jesdphy_pll_status phy;
+    uint32_t status, waited = 0;
+    uint64_t t0 = now_us();
+
+    relink_attempts++;
+    bstats_inc(BSTAT_JESDMON_RELINKS);
+    log_event(JESDMON_EV_RELINK_START, 0, relink_attempts);
+
+    if (ad9695_jesd_wait_pll_lock(JESDMON_SYNC_TIMEOUT_US)) return 0;
+
+    jesdphy_get_pll_status(&phy);
+    if (phy.qpll0_unlocked || phy.rx_reset_in_prog) {
+        jesdphy_rx_reset();
+        jesdphy_get_pll_status(&phy);
+        if (phy.qpll0_unlocked) return 0;
+    }
+
+    jesdlink_reset();
+    do {
+        jesdlink_read(JESDLINK_STAT_STATUS_REG, &status);
+        if (status & JESDLINK_STATUS_SYNC) {
+            sample_baseline();
+            log_event(JESDMON_EV_RELINK_OK, 0, (uint32_t)(now_us() - t0));
+            return 1;
+        }
+        usleep(10);
+        waited += 10;
+    } while (waited < JESDMON_SYNC_TIMEOUT_US);
+    return 0;
+}
+
+void jesdmon_init(void)
+{
+    uint32_t status;
+
+    sample_baseline();
+    jesdlink_read(JESDLINK_STAT_STATUS_REG, &status);
+    mon_state = JESDMON_STATE_UP;
+    log_event(JESDMON_EV_START, 0, status);
+    if (!sample_link()) {
+        xil_printf("JESDMON: link not in sync at start (status 0x%x)\r\n", status);
+    }
+    next_poll_us = now_us() + JESDMON_PERIOD_MS * 1000U;
+}
+
+void jesdmon_poll(void)
+{
+    uint64_t t = now_us();
+    uint32_t status;
+
+    if (!mon_enabled || mon_state == JESDMON_STATE_IDLE || t < next_poll_us) return;
+    next_poll_us = t + JESDMON_PERIOD_MS * 1000U;
+
+    if (mon_state == JESDMON_STATE_UP) {
+        sample_link();
+        return;
+    }
+
+    if (mon_state == JESDMON_STATE_SETTLING) {
+        jesdlink_read(JESDLINK_STAT_STATUS_REG, &status);
+        if (status & JESDLINK_STATUS_SYNC) {
+            sample_baseline();
+            mon_state = JESDMON_STATE_UP;
+            log_event(JESDMON_EV_LINK_UP, 0, status);
+        } else if (t >= next_relink_us) {
+            link_down(status);
+        }
+        return;
+    }
+
+    /* DOWN: retry the re-link with exponential back-off */
+    if (t < next_relink_us) return;
+    if (relink()) {
+        mon_state = JESDMON_STATE_UP;
+        backoff_ms = 0;
+        jesdlink_read(JESDLINK_STAT_STATUS_REG, &status);
+        log_event(JESDMON_EV_LINK_UP, 0, status);
+        relink_attempts = 0;
+        xil_printf("JESDMON: link recovered\r\n");
+    } else {
+        backoff_ms = backoff_ms ? backoff_ms * 2 : JESDMON_BACKOFF_MIN_MS;
+        if (backoff_ms > JESDMON_BACKOFF_MAX_MS) backoff_ms = JESDMON_BACKOFF_MAX_MS;
+        next_relink_us = now_us() + (uint64_t)backoff_ms * 1000U;
+        bstats_inc(BSTAT_JESDMON_RELINK_FAIL);
+        log_event(JESDMON_EV_RELINK_FAIL, 0, backoff_ms);
+    }
+}
+
+void jesdmon_enable(uint8_t en)
+{
+    mon_enabled = en;
+}
+
+/* The link was reset on purpose: no re-link unless SYNC fails to return */
+void jesdmon_link_reset_issued(void)
+{
+    if (mon_state == JESDMON_STATE_IDLE) return;
+    bad_epoch++;
+    log_event(JESDMON_EV_RESET_ISSUED, 0, 0);
+    mon_state = JESDMON_STATE_SETTLING;
+    next_relink_us = now_us() + JESDMON_SETTLE_MS * 1000U;
+}
+
+jesdmon_state_t jesdmon_state(void)
+{
+    return mon_state;
+}
+
+/* Bracket a capture: sample now, remember the epoch, compare afterwards */
+uint32_t jesdmon_capture_begin(void)
+{
+    if (mon_state != JESDMON_STATE_IDLE) sample_link();
+    return bad_epoch;
+}
+
+/* Returns 1 when the capture was taken on a healthy link, 0 when flagged */
+int jesdmon_capture_end(uint32_t epoch)
+{
+    if (mon_state == JESDMON_STATE_IDLE) return 1;
+
+    sample_link();
+    if (mon_state == JESDMON_STATE_UP && bad_epoch == epoch) return 1;
+
+    bstats_inc(BSTAT_CAPTURE_FLAGGED);
+    log_event(JESDMON_EV_CAPTURE_FLAGGED, 0, bad_epoch - epoch);
+    return 0;
+}
+
+void jesdmon_clear_events(void)
+{
+    event_total = 0;
+}
+
+/* Serialise the timeline (oldest first); returns bytes written or 0 */
+size_t jesdmon_timeline_copy(uint8_t *buf, size_t len)
+{
+    struct jesdmon_timeline_hdr hdr;
+    uint32_t count = (event_total < JESDMON_NUM_EVENTS) ? event_total : JESDMON_NUM_EVENTS;
+    uint32_t first = event_total - count;
+
+    if (len < sizeof(hdr)) return 0;
+    if (count > (len - sizeof(hdr)) / sizeof(struct jesdmon_event)) {
+        count = (len - sizeof(hdr)) / sizeof(struct jesdmon_event);
+        first = event_total - count;
+    }
+
+    hdr.magic = JESDMON_MAGIC;
+    hdr.total = event_total;
+    hdr.count = count;
+    hdr.state = mon_state;
+    memcpy(buf, &hdr, sizeof(hdr));
+    for (uint32_t i = 0; i < count; i++) {
+        memcpy(buf + sizeof(hdr) + i * sizeof(struct jesdmon_event),
+               &events[(first + i) % JESDMON_NUM_EVENTS], sizeof(struct jesdmon_event));
+    }
+    return sizeof(hdr) + count * sizeof(struct jesdmon_event);
+}
+
+void jesdmon_print(void)
+{
+    static const char *const state_name[] = { "idle", "up", "down", "settling" };
+    uint32_t count = (event_total < JESDMON_NUM_EVENTS) ? event_total : JESDMON_NUM_EVENTS;
+
+    xil_printf("JESDMON: %s, link %s, bad epoch %d, back-off %d ms\r\n",
+               mon_enabled ? "enabled" : "disabled", state_name[mon_state], bad_epoch, backoff_ms);
+    for (uint32_t i = event_total - count; i < event_total; i++) {
+        const struct jesdmon_event *ev = &events[i % JESDMON_NUM_EVENTS];
+        xil_printf("  %8d.%03d ms  %-16s lane %d  0x%08x\r\n",
+                   (u32)(ev->t_us / 1000), (u32)(ev->t_us % 1000),
+                   event_name[ev->type], ev->lane, ev->arg);
+    }
+}
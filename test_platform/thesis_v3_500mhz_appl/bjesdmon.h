@@ -0,0 +1,85 @@
+/* bjesdmon.h
+ * Background JESD204C link health monitor.
+ *
+ * jesdmon_poll() is called from the idle loop and samples the link every
+ * JESDMON_PERIOD_MS: link status/SYNC, per-lane error counters and RX buffer
+ * levels, the PHY PLL status and the AD9695 SERDES PLL lock.  Loss of sync
+ * or a PLL unlock takes the link down and triggers the minimal re-link
+ * sequence, retried with exponential back-off until the link comes back.
+ *
+ * Every disturbance bumps a "bad epoch"; a capture bracketed by
+ * jesdmon_capture_begin()/jesdmon_capture_end() is flagged when the epoch
+ * moved or the link was down.  Code that resets the link on purpose calls
+ * jesdmon_link_reset_issued() so the monitor waits for SYNC instead of
+ * starting a re-link of its own.  All transitions go into a timestamped event
+ * ring that is printed on the console (mon -r) and exported on STATS_PORT.
+ */
+
+#ifndef BJESDMON_H
+#define BJESDMON_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define JESDMON_PERIOD_MS           10
+#define JESDMON_LANE_ERR_THRESH     16      /* errors per lane per period that mean lost sync */
+#define JESDMON_BACKOFF_MIN_MS      10
+#define JESDMON_BACKOFF_MAX_MS      5000
+#define JESDMON_SYNC_TIMEOUT_US     5000    /* wait for SYNC after a re-link */
+#define JESDMON_SETTLE_MS           50      /* grace after a deliberate link reset */
+#define JESDMON_NUM_EVENTS          64
+
+typedef enum {
+    JESDMON_STATE_IDLE = 0,         /* not started yet */
+    JESDMON_STATE_UP,
+    JESDMON_STATE_DOWN,             /* waiting for the next re-link attempt */
+    JESDMON_STATE_SETTLING,         /* deliberate link reset, waiting for SYNC */
+} jesdmon_state_t;
+
+typedef enum {
+    JESDMON_EV_START = 0,
+    JESDMON_EV_LINK_UP,             /* arg: status register            */
+    JESDMON_EV_LINK_DOWN,           /* arg: status register            */
+    JESDMON_EV_LANE_ERR,            /* lane, arg: error count delta    */
+    JESDMON_EV_BUF_SHIFT,           /* lane, arg: new RX buffer level  */
+    JESDMON_EV_PHY_PLL_UNLOCK,      /* arg: PHY PLL status register    */
+    JESDMON_EV_ADC_PLL_UNLOCK,      /* arg: AD9695 0x056F              */
+    JESDMON_EV_RELINK_START,        /* arg: attempt number             */
+    JESDMON_EV_RELINK_OK,           /* arg: re-link time in us         */
+    JESDMON_EV_RELINK_FAIL,         /* arg: next back-off in ms        */
+    JESDMON_EV_CAPTURE_FLAGGED,     /* arg: bad epochs during capture  */
+    JESDMON_EV_RESET_ISSUED,        /* deliberate reset by other code  */
+    JESDMON_EV_NUM
+} jesdmon_event_t;
+
+struct jesdmon_event {
+    uint64_t t_us;                  /* since power-up */
+    uint16_t type;
+    uint16_t lane;
+    uint32_t arg;
+} __attribute__((packed));
+
+/* Timeline export: header followed by <count> events, oldest first */
+struct jesdmon_timeline_hdr {
+    uint32_t magic;                 /* JESDMON_MAGIC */
+    uint32_t total;                 /* events logged since start/clear */
+    uint16_t count;
+    uint16_t state;
+} __attribute__((packed));
+
+#define JESDMON_MAGIC               0x4D445342U     /* "BSDM" */
+
+void            jesdmon_init(void);
+void            jesdmon_poll(void);
+void            jesdmon_enable(uint8_t en);
+void            jesdmon_link_reset_issued(void);
+jesdmon_state_t jesdmon_state(void);
+
+uint32_t        jesdmon_capture_begin(void);
+int             jesdmon_capture_end(uint32_t epoch);
+
+void            jesdmon_clear_events(void);
+size_t          jesdmon_timeline_copy(uint8_t *buf, size_t len);
+void            jesdmon_print(void);
+
+#endif /* BJESDMON_H */
@@ -3,6 +3,7 @@
 #include "xil_printf.h"
 #include "sleep.h"
 #include "xparameters.h"
+#include "bstats.h"
 #include <stdint.h>
 
 void jesdphy_read(uint32_t addr, uint32_t* data_ptr) {
@@ -27,6 +28,16 @@ void jesdphy_rx_reset() {
     jesdphy_write(JESDPHY_RX_RESET_REG, 0x0000);
 }
 
+/* Split form of jesdphy_rx_reset() so other bring-up work can run while the
+ * reset is held, e.g. waiting for the AD9695 SERDES PLL to lock. */
+void jesdphy_rx_reset_assert() {
+    jesdphy_write(JESDPHY_RX_RESET_REG, 0x0001);
+}
+
+void jesdphy_rx_reset_release() {
+    jesdphy_write(JESDPHY_RX_RESET_REG, 0x0000);
+}
+
 void jesdphy_get_pll_status(struct jesdphy_pll_status* status_ptr) {
     uint32_t tmp_reg;
     jesdphy_read(JESDPHY_PLL_STATUS_REG, &tmp_reg);
@@ -43,103 +54,181 @@ void jesdphy_drp_reset() {
     usleep(1000);
 }
 
-void jesdphy_drp_common_read(uint8_t interface_sel, uint32_t drp_addr, uint32_t* data_ptr) {
-    uint8_t timeout = 100;
+/* Wait for the DRP access started through status_reg to finish; 0 = done */
+static int jesdphy_drp_wait(uint32_t status_reg) {
+    uint32_t timeout = JESDPHY_DRP_TIMEOUT;
     uint32_t tmp_reg;
 
+    do {
+        jesdphy_read(status_reg, &tmp_reg);
+        if ((tmp_reg & JESDPHY_DRP_BUSY) == 0) return 0;
+    } while (--timeout > 0);
+
+    bstats_inc(BSTAT_JESDPHY_DRP_TIMEOUT);
+    return 1;
+}
+
+int jesdphy_drp_common_read(uint8_t interface_sel, uint32_t drp_addr, uint32_t* data_ptr) {
     // set interface
     jesdphy_write(JESDPHY_COMMON_INTERFACE_SEL_REG, interface_sel);
 
-    // write to drp addr reg
-    jesdphy_write(JESDPHY_COMMON_DRP_ADDR_REG, drp_addr&0x40000000); // bit 30 is set to 1 to perform a read
+    // write to drp addr reg, the command bit starts the access
+    jesdphy_write(JESDPHY_COMMON_DRP_ADDR_REG, (drp_addr & JESDPHY_DRP_ADDR_MASK) | JESDPHY_DRP_READ);
 
-    // check complete
-    do {
-        jesdphy_read(JESDPHY_COMMON_DRP_STATUS_REG, &tmp_reg);
-        timeout --;
-    }while(((tmp_reg&0x00000001) == 0x1) && (timeout > 0));
-    
-    if ((tmp_reg&0x00000001) == 0x1) {
+    if (jesdphy_drp_wait(JESDPHY_COMMON_DRP_STATUS_REG)) {
         xil_printf("Timeout during DRP access!\r\n");
-        return;
+        return 1;
     }
 
     jesdphy_read(JESDPHY_COMMON_DRP_RDATA_REG, data_ptr);
     *data_ptr = *data_ptr & 0x0000ffff;
+    return 0;
 }
 
-void jesdphy_drp_common_write(uint8_t interface_sel, uint32_t drp_addr, uint32_t data) {
-    uint8_t timeout = 100;
-    uint32_t tmp_reg;
-
+int jesdphy_drp_common_write(uint8_t interface_sel, uint32_t drp_addr, uint32_t data) {
     // set interface
     jesdphy_write(JESDPHY_COMMON_INTERFACE_SEL_REG, interface_sel);
 
     // write to drp wdata reg
     jesdphy_write(JESDPHY_COMMON_DRP_WDATA_REG, data&0x0000ffff);
 
-    // write to drp addr reg
-    jesdphy_write(JESDPHY_COMMON_DRP_ADDR_REG, drp_addr&0x80000000); // bit 30 is set to 1 to perform a read
+    // write to drp addr reg, the command bit starts the access
+    jesdphy_write(JESDPHY_COMMON_DRP_ADDR_REG, (drp_addr & JESDPHY_DRP_ADDR_MASK) | JESDPHY_DRP_WRITE);
 
-    // check complete
-    do {
-        jesdphy_read(JESDPHY_COMMON_DRP_STATUS_REG, &tmp_reg);
-        timeout --;
-    }while(((tmp_reg&0x00000001) == 0x1) && (timeout > 0));
-    
-    if ((tmp_reg&0x00000001) == 0x1) {
+    if (jesdphy_drp_wait(JESDPHY_COMMON_DRP_STATUS_REG)) {
         xil_printf("Timeout during DRP access!\r\n");
-        return;
+        return 1;
     }
+    return 0;
 }
 
-void jesdphy_drp_transceiver_read(uint8_t interface_sel, uint32_t drp_addr, uint32_t* data_ptr) {
-    uint8_t timeout = 100;
-    uint32_t tmp_reg;
-
+int jesdphy_drp_transceiver_read(uint8_t interface_sel, uint32_t drp_addr, uint32_t* data_ptr) {
     // set interface
     jesdphy_write(JESDPHY_GT_INTERFACE_SEL_REG, interface_sel);
 
-    // write to drp addr reg
-    jesdphy_write(JESDPHY_TRANSC_DRP_ADDR_REG, drp_addr&0x40000000); // bit 30 is set to 1 to perform a read
+    // write to drp addr reg, the command bit starts the access
+    jesdphy_write(JESDPHY_TRANSC_DRP_ADDR_REG, (drp_addr & JESDPHY_DRP_ADDR_MASK) | JESDPHY_DRP_READ);
 
-    // check complete
-    do {
-        jesdphy_read(JESDPHY_TRANSC_DRP_STATUS_REG, &tmp_reg);
-        timeout --;
-    }while(((tmp_reg&0x00000001) == 0x1) && (timeout > 0));
-    
-    if ((tmp_reg&0x00000001) == 0x1) {
+    if (jesdphy_drp_wait(JESDPHY_TRANSC_DRP_STATUS_REG)) {
         xil_printf("Timeout during DRP access!\r\n");
-        return;
+        return 1;
     }
 
     jesdphy_read(JESDPHY_TRANSC_DRP_RDATA_REG, data_ptr);
     *data_ptr = *data_ptr & 0x0000ffff;
+    return 0;
 }
-void jesdphy_drp_transceiver_write(uint8_t interface_sel, uint32_t drp_addr, uint32_t data) {
-    uint8_t timeout = 100;
-    uint32_t tmp_reg;
 
+int jesdphy_drp_transceiver_write(uint8_t interface_sel, uint32_t drp_addr, uint32_t data) {
     // set interface
     jesdphy_write(JESDPHY_GT_INTERFACE_SEL_REG, interface_sel);
 
     // write to drp wdata reg
     jesdphy_write(JESDPHY_TRANSC_DRP_WDATA_REG, data&0x0000ffff);
 
-    // write to drp addr reg
-    jesdphy_write(JESDPHY_TRANSC_DRP_ADDR_REG, drp_addr&0x80000000); // bit 30 is set to 1 to perform a read
+    // write to drp addr reg, the command bit starts the access
+    jesdphy_write(JESDPHY_TRANSC_DRP_ADDR_REG, (drp_addr & JESDPHY_DRP_ADDR_MASK) | JESDPHY_DRP_WRITE);
 
-    // check complete
-    do {
-        jesdphy_read(JESDPHY_TRANSC_DRP_STATUS_REG, &tmp_reg);
-        timeout --;
-    }while(((tmp_reg&0x00000001) == 0x1) && (timeout > 0));
-    
-    if ((tmp_reg&0x00000001) == 0x1) {
+    if (jesdphy_drp_wait(JESDPHY_TRANSC_DRP_STATUS_REG)) {
         xil_printf("Timeout during DRP access!\r\n");
-        return;
+        return 1;
+    }
+    return 0;
+}
+
+/* -------------------------------------------------------------------------------- */
+/*  Batched transceiver DRP queue                                                    */
+/* -------------------------------------------------------------------------------- */
+void jesdphy_drp_queue_reset(struct jesdphy_drp_queue* q) {
+    q->count = 0;
+}
+
+static struct jesdphy_drp_op* jesdphy_drp_queue_push(struct jesdphy_drp_queue* q, uint8_t op, uint8_t lane, uint16_t addr) {
+    if (q->count >= JESDPHY_DRP_QUEUE_LEN) {
+        xil_printf("ERROR: DRP queue full!\r\n");
+        return NULL;
+    }
+    struct jesdphy_drp_op* o = &q->ops[q->count++];
+    o->op = op;
+    o->lane = lane;
+    o->addr = addr;
+    o->mask = 0xffff;
+    o->data = 0;
+    return o;
+}
+
+void jesdphy_drp_queue_read(struct jesdphy_drp_queue* q, uint8_t lane, uint16_t addr) {
+    jesdphy_drp_queue_push(q, JESDPHY_DRP_OP_READ, lane, addr);
+}
+
+void jesdphy_drp_queue_write(struct jesdphy_drp_queue* q, uint8_t lane, uint16_t addr, uint16_t data) {
+    struct jesdphy_drp_op* o = jesdphy_drp_queue_push(q, JESDPHY_DRP_OP_WRITE, lane, addr);
+    if (o) o->data = data;
+}
+
+/* Read-modify-write of the bits set in mask */
+void jesdphy_drp_queue_rmw(struct jesdphy_drp_queue* q, uint8_t lane, uint16_t addr, uint16_t mask, uint16_t data) {
+    struct jesdphy_drp_op* o = jesdphy_drp_queue_push(q, JESDPHY_DRP_OP_RMW, lane, addr);
+    if (o) { o->mask = mask; o->data = data & mask; }
+}
+
+/*
+ * Execute the queue in order.  The interface select is only rewritten when
+ * the lane changes and the write-data register only when the value changes,
+ * so a batch costs little more than its DRP cycles.  Read results (and the
+ * final value of RMW ops) are left in op->data.  Returns the number of
+ * failed (timed out) ops.
+ */
+int jesdphy_drp_queue_run(struct jesdphy_drp_queue* q) {
+    int lane = -1, fail = 0;
+    uint32_t wdata = 0xffffffff, tmp_reg;
+
+    for (uint32_t i = 0; i < q->count; i++) {
+        struct jesdphy_drp_op* o = &q->ops[i];
+
+        if (o->lane != lane) {
+            jesdphy_write(JESDPHY_GT_INTERFACE_SEL_REG, o->lane);
+            lane = o->lane;
+        }
+
+        if (o->op != JESDPHY_DRP_OP_WRITE) {
+            jesdphy_write(JESDPHY_TRANSC_DRP_ADDR_REG, (o->addr & JESDPHY_DRP_ADDR_MASK) | JESDPHY_DRP_READ);
+            if (jesdphy_drp_wait(JESDPHY_TRANSC_DRP_STATUS_REG)) { fail++; continue; }
+            jesdphy_read(JESDPHY_TRANSC_DRP_RDATA_REG, &tmp_reg);
+            if (o->op == JESDPHY_DRP_OP_READ) { o->data = tmp_reg & 0xffff; continue; }
+            o->data = (tmp_reg & ~o->mask & 0xffff) | o->data;
+        }
+
+        if (o->data != wdata) {
+            jesdphy_write(JESDPHY_TRANSC_DRP_WDATA_REG, o->data);
+            wdata = o->data;
+        }
+        jesdphy_write(JESDPHY_TRANSC_DRP_ADDR_REG, (o->addr & JESDPHY_DRP_ADDR_MASK) | JESDPHY_DRP_WRITE);
+        if (jesdphy_drp_wait(JESDPHY_TRANSC_DRP_STATUS_REG)) fail++;
+    }
+    bstats_add(BSTAT_JESDPHY_DRP_OPS, q->count);
+    return fail;
+}
+
+/* Select RXOUT_DIV on every lane so the CDR runs at lane_rate_kbps, which
+ * must be JESDPHY_LINE_RATE_KBPS divided by a power of two.  The caller
+ * resets the PHY RX afterwards.  Returns 0 on success. */
+int jesdphy_set_line_rate(uint64_t lane_rate_kbps) {
+    struct jesdphy_drp_queue q;
+    uint16_t div_log2 = 0;
+
+    while (div_log2 < JESDPHY_RXOUT_DIV_LOG2_MAX && (JESDPHY_LINE_RATE_KBPS >> div_log2) > lane_rate_kbps) div_log2++;
+    if ((JESDPHY_LINE_RATE_KBPS >> div_log2) != lane_rate_kbps) {
+        xil_printf("JESDPHY: lane rate %d kbps not reachable from %d kbps.\r\n",
+                   (u32)lane_rate_kbps, (u32)JESDPHY_LINE_RATE_KBPS);
+        return 1;
+    }
+
+    jesdphy_drp_queue_reset(&q);
+    for (uint8_t lane = 0; lane < JESDPHY_NUM_LANES; lane++) {
+        jesdphy_drp_queue_rmw(&q, lane, GTH_RXOUT_DIV_ADDR, GTH_RXOUT_DIV_MASK, div_log2);
     }
+    return jesdphy_drp_queue_run(&q) ? 1 : 0;
 }
 
 void jesdphy_check_pll_status(struct jesdphy_pll_status* pll_status_ptr) {
@@ -153,6 +242,7 @@ void jesdphy_check_pll_status(struct jesdphy_pll_status* pll_status_ptr) {
         xil_printf("JESDPHY: RX reset complete and QPLL locked.\r\n");
     }
     else {
+        bstats_inc(BSTAT_JESDPHY_PLL_UNLOCK);
         xil_printf("JESDPHY: RX reset not complete or QPLL not locked.\r\n");
     }
 }
\ No newline at end of file
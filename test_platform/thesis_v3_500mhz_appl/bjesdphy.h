@@ -31,6 +31,41 @@
 #define JESDPHY_RX_RESET_REG                0x0424
 #define JESDPHY_TXPD_REG                    0x0504
 
+/* DRP address register: command bits are OR-ed onto the DRP address */
+#define JESDPHY_DRP_READ                    0x40000000
+#define JESDPHY_DRP_WRITE                   0x80000000
+#define JESDPHY_DRP_ADDR_MASK               0x00000fff
+#define JESDPHY_DRP_BUSY                    0x00000001  /* DRP status register */
+#define JESDPHY_DRP_TIMEOUT                 1000        /* status polls */
+
+#define JESDPHY_DRP_QUEUE_LEN               32
+
+/* Line rate the PHY was generated for; lower rates use the RX output divider */
+#define JESDPHY_LINE_RATE_KBPS              5000000ULL
+#define JESDPHY_NUM_LANES                   4
+#define GTH_RXOUT_DIV_ADDR                  0x0063      /* [2:0] RXOUT_DIV, log2 encoded */
+#define GTH_RXOUT_DIV_MASK                  0x0007
+#define JESDPHY_RXOUT_DIV_LOG2_MAX          4
+
+enum {
+    JESDPHY_DRP_OP_READ = 0,
+    JESDPHY_DRP_OP_WRITE,
+    JESDPHY_DRP_OP_RMW
+};
+
+struct jesdphy_drp_op {
+    uint8_t  op;
+    uint8_t  lane;          /* transceiver interface select */
+    uint16_t addr;
+    uint16_t mask;          /* RMW only */
+    uint16_t data;          /* write data in, read data out */
+};
+
+struct jesdphy_drp_queue {
+    uint32_t count;
+    struct jesdphy_drp_op ops[JESDPHY_DRP_QUEUE_LEN];
+};
+
 struct jesdphy_pll_status {
     uint8_t tx_reset_in_prog;
     uint8_t rx_reset_in_prog;
@@ -41,14 +76,22 @@ struct jesdphy_pll_status {
 
 void jesdphy_tx_disable();
 void jesdphy_rx_reset();
+void jesdphy_rx_reset_assert();
+void jesdphy_rx_reset_release();
 void jesdphy_get_pll_status(struct jesdphy_pll_status* status_ptr);
 void jesdphy_read(uint32_t addr, uint32_t* data_ptr);
 void jesdphy_write(uint32_t addr, uint32_t data);
 void jesdphy_drp_reset();
-void jesdphy_drp_common_read(uint8_t interface_sel, uint32_t drp_addr, uint32_t* data_ptr);
-void jesdphy_drp_common_write(uint8_t interface_sel, uint32_t drp_addr, uint32_t data);
-void jesdphy_drp_transceiver_read(uint8_t interface_sel, uint32_t drp_addr, uint32_t* data_ptr);
-void jesdphy_drp_transceiver_write(uint8_t interface_sel, uint32_t drp_addr, uint32_t data);
+int  jesdphy_drp_common_read(uint8_t interface_sel, uint32_t drp_addr, uint32_t* data_ptr);
+int  jesdphy_drp_common_write(uint8_t interface_sel, uint32_t drp_addr, uint32_t data);
+int  jesdphy_drp_transceiver_read(uint8_t interface_sel, uint32_t drp_addr, uint32_t* data_ptr);
+int  jesdphy_drp_transceiver_write(uint8_t interface_sel, uint32_t drp_addr, uint32_t data);
+void jesdphy_drp_queue_reset(struct jesdphy_drp_queue* q);
+void jesdphy_drp_queue_read(struct jesdphy_drp_queue* q, uint8_t lane, uint16_t addr);
+void jesdphy_drp_queue_write(struct jesdphy_drp_queue* q, uint8_t lane, uint16_t addr, uint16_t data);
+void jesdphy_drp_queue_rmw(struct jesdphy_drp_queue* q, uint8_t lane, uint16_t addr, uint16_t mask, uint16_t data);
+int  jesdphy_drp_queue_run(struct jesdphy_drp_queue* q);
+int  jesdphy_set_line_rate(uint64_t lane_rate_kbps);
 void jesdphy_check_pll_status(struct jesdphy_pll_status* pll_status_ptr);
 
 
@@ -0,0 +1,131 @@
+#include "bprofile.h"
+
+#if BPROF_ENABLE
+
+#include <string.h>
+#include "xil_printf.h"
+#include "xparameters.h"
+#include "xpseudo_asm.h"
+
+#define PMCR_E          (1U << 0)   /* enable all counters        */
+#define PMCR_C          (1U << 2)   /* reset cycle counter        */
+#define PMCR_LC         (1U << 6)   /* 64-bit cycle counter       */
+#define PMCNTEN_C       (1U << 31)  /* cycle counter enable bit   */
+
+#define CYCLES_PER_US   (XPAR_CPU_CORE_CLOCK_FREQ_HZ / 1000000U)
+
+static struct bprof_region_stat prof_stat[BPROF_NUM_REGIONS];
+
+static const char *const prof_name[BPROF_NUM_REGIONS] = {
+    [BPROF_UDP_SEND_MEM]   = "udp_send_mem",
+    [BPROF_RECV_CALLBACK]  = "recv_callback",
+    [BPROF_SPI_XFER]       = "spi_xfer",
+    [BPROF_JESDLINK_RESET] = "jesdlink_reset",
+    [BPROF_DMA_CAPTURE]    = "dma_capture",
+    [BPROF_DCACHE_FLUSH]   = "dcache_flush",
+    [BPROF_JESD_UNPACK]    = "jesd_unpack",
+    [BPROF_UDP_SEND_BUF]   = "udp_send_buf",
+};
+
+void bprof_init(void)
+{
+    u64 reg = mfcp(PMCR_EL0);
+    mtcp(PMCR_EL0, reg | PMCR_E | PMCR_C | PMCR_LC);
+    mtcp(PMCNTENSET_EL0, PMCNTEN_C);
+    isb();
+    bprof_reset();
+    xil_printf("Profiler enabled (%d regions, PMU cycle counter).\r\n", BPROF_NUM_REGIONS);
+}
+
+void bprof_reset(void)
+{
+    memset(prof_stat, 0, sizeof(prof_stat));
+    for (int i = 0; i < BPROF_NUM_REGIONS; i++) {
+        prof_stat[i].min_cycles = UINT64_MAX;
+    }
+}
+
+void bprof_record(bprof_region_t id, uint64_t cycles, uint64_t bytes)
+{
+    struct bprof_region_stat *s = &prof_stat[id];
+    uint32_t bucket = cycles ? 63U - (uint32_t)__builtin_clzll(cycles) : 0U;
+
+    if (bucket >= BPROF_NUM_BUCKETS) bucket = BPROF_NUM_BUCKETS - 1;
+
+    s->count++;
+    s->total_cycles += cycles;
+    s->total_bytes += bytes;
+    if (cycles < s->min_cycles) s->min_cycles = cycles;
+    if (cycles > s->max_cycles) s->max_cycles = cycles;
+    s->hist[bucket]++;
+}
+
+void bprof_snapshot(struct bprof_region_stat *out)
+{
+    memcpy(out, prof_stat, sizeof(prof_stat));
+}
+
+const char* bprof_region_name(bprof_region_t id)
+{
+    return (id < BPROF_NUM_REGIONS) ? prof_name[id] : "?";
+}
+
+void bprof_print(void)
+{
+    /* Work on a copy so the regions printed below are not disturbed by the
+     * (slow) UART output itself. */
+    struct bprof_region_stat snap[BPROF_NUM_REGIONS];
+    bprof_snapshot(snap);
+
+    xil_printf("%-16s %10s %12s %12s %12s\r\n", "region", "count", "avg[cyc]", "min[cyc]", "max[cyc]");
+    for (int i = 0; i < BPROF_NUM_REGIONS; i++) {
+        const struct bprof_region_stat *s = &snap[i];
+        if (s->count == 0) {
+            xil_printf("%-16s %10d %12s %12s %12s\r\n", prof_name[i], 0, "-", "-", "-");
+            continue;
+        }
+        xil_printf("%-16s %10d %12d %12d %12d  (avg %d us)\r\n", prof_name[i], s->count,
+                   (u32)(s->total_cycles / s->count), (u32)s->min_cycles, (u32)s->max_cycles,
+                   (u32)(s->total_cycles / s->count / CYCLES_PER_US));
+        if (s->total_bytes && s->total_cycles) {
+            xil_printf("    %d bytes, %d MB/s\r\n", (u32)s->total_bytes,
+                       (u32)(s->total_bytes * CYCLES_PER_US / s->total_cycles));
+        }
+        for (int b = 0; b < BPROF_NUM_BUCKETS; b++) {
+            if (s->hist[b]) {
+                xil_printf("    [2^%02d, 2^%02d) cyc : %d\r\n", b, b + 1, s->hist[b]);
+            }
+        }
+    }
+}
+
+/* The network form of a snapshot; returns the bytes written, 0 if len is too small */
+size_t bprof_wire(uint8_t *buf, size_t len)
+{
+    struct bprof_region_stat snap[BPROF_NUM_REGIONS];
+    struct bprof_wire_hdr hdr;
+    struct bprof_wire_region r;
+    size_t need = sizeof(hdr) + BPROF_NUM_REGIONS * sizeof(r);
+
+    if (len < need) return 0;
+    bprof_snapshot(snap);
+
+    hdr.magic = BPROF_MAGIC;
+    hdr.version = BPROF_VERSION;
+    hdr.count = BPROF_NUM_REGIONS;
+    hdr.cycles_per_us = CYCLES_PER_US;
+    memcpy(buf, &hdr, sizeof(hdr));
+    for (int i = 0; i < BPROF_NUM_REGIONS; i++) {
+        memset(&r, 0, sizeof(r));
+        memcpy(r.name, prof_name[i], strnlen(prof_name[i], sizeof(r.name)));   /* NUL padded, not terminated at 16 */
+        r.count = snap[i].count;
+        r.total_cycles = snap[i].total_cycles;
+        r.min_cycles = snap[i].min_cycles;
+        r.max_cycles = snap[i].max_cycles;
+        r.total_bytes = snap[i].total_bytes;
+        memcpy(buf + sizeof(hdr) + (size_t)i * sizeof(r), &r, sizeof(r));
+    }
+    return need;
+}
+
+#endif /* BPROF_ENABLE */
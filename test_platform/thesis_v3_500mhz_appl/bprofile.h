@@ -0,0 +1,116 @@
+/* bprofile.h
+ * Lightweight hot-path profiler built on the A53 PMU cycle counter.
+ *
+ * Every measured region has a static ID.  A region is bracketed with
+ * BPROF_BEGIN(id) / BPROF_END(id); the elapsed PMCCNTR_EL0 cycles are
+ * accumulated into count/total/min/max and a log2-bucket histogram.
+ *
+ * BPROF_END_BYTES(id, n) also adds the n bytes the region moved, so the
+ * host can turn a region into a rate (perf_bench.py).
+ *
+ * Recording only touches the per-region counters.  Reporting (UART or
+ * network) works on a copy taken with bprof_snapshot(), so printing never
+ * happens inside a measured region and does not skew the numbers.  Over the
+ * network the stats port answers "P" with bprof_wire() (struct
+ * bprof_wire_hdr + one struct bprof_wire_region per region) and "p" with the
+ * same after clearing the counters.
+ *
+ * Build with -DBPROF_ENABLE=0 (or -DNDEBUG) to compile every marker out.
+ */
+
+#ifndef BPROFILE_H
+#define BPROFILE_H
+
+#include <stdint.h>
+
+#ifndef BPROF_ENABLE
+#ifdef NDEBUG
+#define BPROF_ENABLE 0
+#else
+#define BPROF_ENABLE 1
+#endif
+#endif
+
+/* Bucket b holds samples with 2^b <= cycles < 2^(b+1); bucket 0 also holds 0 */
+#define BPROF_NUM_BUCKETS   32
+
+typedef enum {
+    BPROF_UDP_SEND_MEM = 0,     /* ethernet.c  udp_send_mem()               */
+    BPROF_RECV_CALLBACK,        /* ethernet.c  recv_callback()              */
+    BPROF_SPI_XFER,             /* peripherals.c  one XSpiPs polled transfer */
+    BPROF_JESDLINK_RESET,       /* bjesdlink.c jesdlink_reset()             */
+    BPROF_DMA_CAPTURE,          /* baxidma.c   dma_capture(), flush to done  */
+    BPROF_DCACHE_FLUSH,         /* baxidma.c   flush of the capture buffer   */
+    BPROF_JESD_UNPACK,          /* bjesdmode.c jesdmode_unpack()            */
+    BPROF_UDP_SEND_BUF,         /* ethernet.c  udp_send_buf(), all datagrams */
+    BPROF_NUM_REGIONS
+} bprof_region_t;
+
+struct bprof_region_stat {
+    uint32_t count;
+    uint64_t total_cycles;
+    uint64_t total_bytes;
+    uint64_t min_cycles;
+    uint64_t max_cycles;
+    uint32_t hist[BPROF_NUM_BUCKETS];
+};
+
+#define BPROF_MAGIC         0x46525042U     /* "BPRF" */
+#define BPROF_VERSION       1
+#define BPROF_NAME_LEN      16
+
+struct bprof_wire_hdr {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t count;             /* regions that follow */
+    uint32_t cycles_per_us;
+} __attribute__((packed));
+
+struct bprof_wire_region {
+    char     name[BPROF_NAME_LEN];  /* NUL padded */
+    uint32_t count;
+    uint32_t reserved;
+    uint64_t total_cycles;
+    uint64_t min_cycles;        /* UINT64_MAX while count is 0 */
+    uint64_t max_cycles;
+    uint64_t total_bytes;
+} __attribute__((packed));
+
+#if BPROF_ENABLE
+
+#include <stddef.h>
+#include "xpseudo_asm.h"
+
+static inline uint64_t bprof_now(void)
+{
+    return mfcp(PMCCNTR_EL0);
+}
+
+#define BPROF_BEGIN(id)     uint64_t bprof_t0_##id = bprof_now()
+#define BPROF_END(id)       bprof_record((id), bprof_now() - bprof_t0_##id, 0)
+#define BPROF_END_BYTES(id, n) bprof_record((id), bprof_now() - bprof_t0_##id, (n))
+
+void        bprof_init(void);
+void        bprof_record(bprof_region_t id, uint64_t cycles, uint64_t bytes);
+void        bprof_reset(void);
+void        bprof_snapshot(struct bprof_region_stat *out);
+const char* bprof_region_name(bprof_region_t id);
+void        bprof_print(void);
+size_t      bprof_wire(uint8_t *buf, size_t len);
+
+#else /* !BPROF_ENABLE */
+
+#include <stddef.h>
+
+#define BPROF_BEGIN(id)     do { } while (0)
+#define BPROF_END(id)       do { } while (0)
+#define BPROF_END_BYTES(id, n) do { (void)(n); } while (0)
+
+static inline void bprof_init(void) { }
+static inline void bprof_reset(void) { }
+static inline void bprof_print(void) { }
+static inline size_t bprof_wire(uint8_t *buf, size_t len) { (void)buf; (void)len; return 0; }
+
+#endif /* BPROF_ENABLE */
+
+#endif /* BPROFILE_H */
@@ -0,0 +1,134 @@
+#include "breconf.h"
+#include "ad9695_api.h"
+#include "ad9695_registers.h"
+#include "ad9695_regcache.h"
+#include "bjesdlink.h"
+#include "bjesdmode.h"
+#include "bjesdmon.h"
+#include "bstats.h"
+#include "xil_printf.h"
+#include "xiltimer.h"
+#include "sleep.h"
+
+#define COUNTS_PER_US   (COUNTS_PER_SECOND / 1000000U)
+
+struct link_snapshot {
+    uint32_t status;
+    uint32_t err_cnt[JESDLINK_NUM_LANES];
+    uint32_t buf_lvl[JESDLINK_NUM_LANES];
+};
+
+static uint64_t now_us(void)
+{
+    XTime now;
+    XTime_GetTime(&now);
+    return now / COUNTS_PER_US;
+}
+
+static void link_snapshot_take(struct link_snapshot *s)
+{
+    jesdlink_read(JESDLINK_STAT_STATUS_REG, &s->status);
+    for (uint32_t lane = 0; lane < jesdmode_lanes(); lane++) {
+        jesdlink_read(JESDLINK_STAT_LINK_ERR_CNT(lane), &s->err_cnt[lane]);
+        jesdlink_read(JESDLINK_STAT_RX_BUF_LVL_REG(lane), &s->buf_lvl[lane]);
+    }
+}
+
+/* 1 when the link is in sync and neither errors nor lane alignment moved */
+static int link_undisturbed(const struct link_snapshot *before)
+{
+    struct link_snapshot after;
+
+    link_snapshot_take(&after);
+    if (!(after.status & JESDLINK_STATUS_SYNC)) return 0;
+    for (uint32_t lane = 0; lane < jesdmode_lanes(); lane++) {
+        if (after.err_cnt[lane] != before->err_cnt[lane]) return 0;
+        if (after.buf_lvl[lane] != before->buf_lvl[lane]) return 0;
+    }
+    return 1;
+}
+
+/* Delay mode of one channel page; inside a batch the CH_INDEX write only
+ * moves the shadow page pointer, so a shadow hit costs no SPI transfer */
+static uint8_t delay_mode_on(uint8_t ch_index)
+{
+    uint8_t mode;
+    ad9695_reg_write(AD9695_CH_INDEX_REG, ch_index);
+    ad9695_reg_read(AD9695_CLK_DELAY_CTRL_REG, &mode);
+    return mode;
+}
+
+/*
+ * Apply delay mode (both channels), fine and super fine delay (channel_idx:
+ * 1 = A, 2 = B, 3 = both) and bring the data back with the least disturbance.
+ * CH_INDEX is driven directly through the shadow here, without the read-back
+ * print of ad9695_adc_set_channel_select(), to keep the path short.
+ * Returns 0 when data is valid at the end, 1 otherwise.
+ */
+int reconf_clock_delay(uint8_t mode, uint8_t fine, uint8_t super_fine, uint8_t channel_idx,
+                       struct reconf_result *res)
+{
+    struct link_snapshot before;
+    uint64_t t0, t_applied;
+    uint64_t spi_xfers;
+    uint8_t mode_changed;
+
+    res->path = RECONF_PATH_NONE;
+    res->escalated = 0;
+    res->ok = 1;
+
+    link_snapshot_take(&before);
+    t0 = now_us();
+
+    ad9695_regcache_batch_begin();
+    /* Mode is shared by both channels: a change on either page re-times the clock */
+    mode_changed = (delay_mode_on(1) != mode) || (delay_mode_on(2) != mode);
+    spi_xfers = bstats_get(BSTAT_SPI_XFERS);    /* after the probe: only the update itself counts */
+
+    ad9695_reg_write(AD9695_CH_INDEX_REG, 3);
+    ad9695_adc_delay_mode(mode);
+    ad9695_reg_write(AD9695_CH_INDEX_REG, channel_idx);
+    ad9695_adc_fine_delay(fine);
+    ad9695_adc_super_fine_delay(super_fine);
+    ad9695_reg_write(AD9695_CH_INDEX_REG, 3);
+    ad9695_regcache_batch_commit();
+
+    t_applied = now_us();
+    res->apply_us = (uint32_t)(t_applied - t0);
+
+    if (bstats_get(BSTAT_SPI_XFERS) == spi_xfers) {
+        res->ttv_us = res->apply_us;    /* register shadow already matched */
+    } else if (!mode_changed) {
+        res->path = RECONF_PATH_SETTLE;
+        usleep(RECONF_SETTLE_US);
+        if (link_undisturbed(&before)) {
+            bstats_inc(BSTAT_RECONF_SETTLE);
+        } else {
+            res->escalated = 1;
+            bstats_inc(BSTAT_RECONF_ESCALATED);
+        }
+    }
+
+    if (mode_changed || res->escalated) {
+        res->path = RECONF_PATH_RESET;
+        bstats_inc(BSTAT_RECONF_RESET);
+        jesdlink_reset_pulse(RECONF_RESET_PULSE_US);
+        jesdmon_link_reset_issued();
+        if (jesdlink_wait_sync(RECONF_SYNC_TIMEOUT_US, NULL)) res->ok = 0;
+    }
+
+    if (res->path != RECONF_PATH_NONE) res->ttv_us = (uint32_t)(now_us() - t0);
+
+    bstats_set(BSTAT_G_RECONF_PATH, res->path);
+    bstats_set(BSTAT_G_RECONF_TTV_US, res->ttv_us);
+    return res->ok ? 0 : 1;
+}
+
+void reconf_print(const struct reconf_result *res)
+{
+    static const char *const path_name[] = { "none", "settle", "reset" };
+
+    xil_printf("reconf: %s%s, apply %d us, data valid after %d us%s\r\n",
+               path_name[res->path], res->escalated ? " (escalated)" : "",
+               res->apply_us, res->ttv_us, res->ok ? "" : " -- LINK DID NOT RESYNC");
+}
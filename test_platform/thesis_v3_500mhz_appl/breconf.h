@@ -0,0 +1,41 @@
+/* breconf.h
+ * Low-latency reconfiguration of the AD9695 sampling clock delay.
+ *
+ * Only a change of the clock delay mode (0x0110) re-times the clock path
+ * that feeds the JESD204 transmitter; fine / super fine steps inside the
+ * current mode just move the sampling instant.  The fast path therefore
+ * applies the delay registers through the register shadow and, when the
+ * mode is unchanged, only waits RECONF_SETTLE_US while checking that SYNC,
+ * the lane error counters and the lane buffer levels stayed put.  A mode
+ * change, or a settle check that sees the link move, takes the short link
+ * reset path instead.  Every change reports its time-to-valid-data.
+ */
+
+#ifndef BRECONF_H
+#define BRECONF_H
+
+#include <stdint.h>
+
+#define RECONF_SETTLE_US        10      /* ADC pipeline + JESD latency, with margin */
+#define RECONF_RESET_PULSE_US   10
+#define RECONF_SYNC_TIMEOUT_US  50000
+
+typedef enum {
+    RECONF_PATH_NONE = 0,       /* nothing changed on the chip */
+    RECONF_PATH_SETTLE,         /* link untouched, settle only  */
+    RECONF_PATH_RESET,          /* short link reset + resync    */
+} reconf_path_t;
+
+struct reconf_result {
+    uint8_t  path;              /* reconf_path_t */
+    uint8_t  escalated;         /* settle check failed, reset was needed */
+    uint8_t  ok;                /* data valid at the end */
+    uint32_t apply_us;          /* SPI writes */
+    uint32_t ttv_us;            /* change start -> data valid */
+};
+
+int  reconf_clock_delay(uint8_t mode, uint8_t fine, uint8_t super_fine, uint8_t channel_idx,
+                        struct reconf_result *res);
+void reconf_print(const struct reconf_result *res);
+
+#endif /* BRECONF_H */
@@ -0,0 +1,242 @@
+#include "bstats.h"
+#include <string.h>
+#include "xil_printf.h"
+#include "xiltimer.h"
+#include "bjesdlink.h"
+#include "bjesdmon.h"
+#include "bprofile.h"
+#include "ethernet.h"
+#include "lwip/pbuf.h"
+#include "lwip/udp.h"
+#include "lwip/stats.h"
+#include "netif/xemacpsif.h"
+
+uint64_t bstat_val[BSTAT_NUM];
+
+static uint32_t snapshot_seq;
+static struct udp_pcb *stats_pcb;
+
+static const char *const stat_name[BSTAT_NUM] = {
+    [BSTAT_DMA_CAPTURES]        = "dma_captures",
+    [BSTAT_DMA_SUBMIT_ERR]      = "dma_submit_err",
+    [BSTAT_DMA_TIMEOUT]         = "dma_timeout",
+    [BSTAT_UDP_TX_PKTS]         = "udp_tx_pkts",
+    [BSTAT_UDP_TX_BYTES]        = "udp_tx_bytes",
+    [BSTAT_UDP_PBUF_ALLOC_ERR]  = "udp_pbuf_alloc_err",
+    [BSTAT_UDP_SENDTO_ERR]      = "udp_sendto_err",
+    [BSTAT_UDP_CFG_RX]          = "udp_cfg_rx",
+    [BSTAT_STATS_REQ]           = "stats_req",
+    [BSTAT_SPI_XFERS]           = "spi_xfers",
+    [BSTAT_SPI_BYTES]           = "spi_bytes",
+    [BSTAT_AD9695_RESET_FAIL]   = "ad9695_reset_fail",
+    [BSTAT_AD9695_PLL_UNLOCK]   = "ad9695_pll_unlock",
+    [BSTAT_JESDPHY_PLL_UNLOCK]  = "jesdphy_pll_unlock",
+    [BSTAT_JESDLINK_RESETS]     = "jesdlink_resets",
+    [BSTAT_REGC_HITS]           = "regc_hits",
+    [BSTAT_REGC_MISSES]         = "regc_misses",
+    [BSTAT_REGC_SKIPPED]        = "regc_skipped",
+    [BSTAT_REGC_VERIFY_ERR]     = "regc_verify_err",
+    [BSTAT_JESDMON_LINK_DOWN]   = "jesdmon_link_down",
+    [BSTAT_JESDMON_RELINKS]     = "jesdmon_relinks",
+    [BSTAT_JESDMON_RELINK_FAIL] = "jesdmon_relink_fail",
+    [BSTAT_CAPTURE_FLAGGED]     = "capture_flagged",
+    [BSTAT_JESDPHY_DRP_OPS]     = "jesdphy_drp_ops",
+    [BSTAT_JESDPHY_DRP_TIMEOUT] = "jesdphy_drp_timeout",
+    [BSTAT_RECONF_SETTLE]       = "reconf_settle",
+    [BSTAT_RECONF_RESET]        = "reconf_reset",
+    [BSTAT_RECONF_ESCALATED]    = "reconf_escalated",
+    [BSTAT_VERIFY_RUNS]         = "verify_runs",
+    [BSTAT_VERIFY_BIT_ERR]      = "verify_bit_err",
+    [BSTAT_VERIFY_SLIPS]        = "verify_slips",
+    [BSTAT_SWEEP_POINTS]        = "sweep_points",
+    [BSTAT_SWEEP_DROPPED]       = "sweep_dropped",
+    [BSTAT_SWEEP_STAMPED]       = "sweep_stamped",
+
+    [BSTAT_G_UPTIME_MS]         = "uptime_ms",
+    [BSTAT_G_JESD_STATUS]       = "jesd_status",
+    [BSTAT_G_JESD_RX_ERR]       = "jesd_rx_err",
+    [BSTAT_G_JESD_LINK_ERR_L0]  = "jesd_link_err_l0",
+    [BSTAT_G_JESD_LINK_ERR_L1]  = "jesd_link_err_l1",
+    [BSTAT_G_JESD_LINK_ERR_L2]  = "jesd_link_err_l2",
+    [BSTAT_G_JESD_LINK_ERR_L3]  = "jesd_link_err_l3",
+    [BSTAT_G_JESD_BUF_LVL_L0]   = "jesd_buf_lvl_l0",
+    [BSTAT_G_JESD_BUF_LVL_L1]   = "jesd_buf_lvl_l1",
+    [BSTAT_G_JESD_BUF_LVL_L2]   = "jesd_buf_lvl_l2",
+    [BSTAT_G_JESD_BUF_LVL_L3]   = "jesd_buf_lvl_l3",
+    [BSTAT_G_JESDMON_STATE]     = "jesdmon_state",
+    [BSTAT_G_RECONF_PATH]       = "reconf_path",
+    [BSTAT_G_RECONF_TTV_US]     = "reconf_ttv_us",
+    [BSTAT_G_JESD_MODE]         = "jesd_mode",
+    [BSTAT_G_LWIP_LINK_XMIT]    = "lwip_link_xmit",
+    [BSTAT_G_LWIP_LINK_RECV]    = "lwip_link_recv",
+    [BSTAT_G_LWIP_LINK_DROP]    = "lwip_link_drop",
+    [BSTAT_G_LWIP_LINK_ERR]     = "lwip_link_err",
+    [BSTAT_G_LWIP_UDP_XMIT]     = "lwip_udp_xmit",
+    [BSTAT_G_LWIP_UDP_RECV]     = "lwip_udp_recv",
+    [BSTAT_G_LWIP_UDP_DROP]     = "lwip_udp_drop",
+    [BSTAT_G_LWIP_UDP_ERR]      = "lwip_udp_err",
+    [BSTAT_G_LWIP_MEM_ERR]      = "lwip_mem_err",
+    [BSTAT_G_EMAC_TX_FREE_BD]   = "emac_tx_free_bd",
+    [BSTAT_G_EMAC_TX_HW_BD]     = "emac_tx_hw_bd",
+    [BSTAT_G_EMAC_RX_FREE_BD]   = "emac_rx_free_bd",
+    [BSTAT_G_EMAC_RX_HW_BD]     = "emac_rx_hw_bd",
+};
+
+static uint32_t uptime_ms(void)
+{
+    XTime now;
+    XTime_GetTime(&now);
+    return (uint32_t)(now / (COUNTS_PER_SECOND / 1000U));
+}
+
+/* Clear the counters; gauges are re-sampled on the next refresh anyway */
+void bstats_clear(void)
+{
+    memset(bstat_val, 0, BSTAT_FIRST_GAUGE * sizeof(bstat_val[0]));
+}
+
+void bstats_refresh(void)
+{
+    uint32_t tmp_reg;
+
+    bstats_set(BSTAT_G_UPTIME_MS, uptime_ms());
+
+    /* JESD204C link layer */
+    jesdlink_read(JESDLINK_STAT_STATUS_REG, &tmp_reg);
+    bstats_set(BSTAT_G_JESD_STATUS, tmp_reg);
+    jesdlink_read(JESDLINK_STAT_RX_ERR_REG, &tmp_reg);
+    bstats_set(BSTAT_G_JESD_RX_ERR, tmp_reg);
+    for (uint32_t lane = 0; lane < JESDLINK_NUM_LANES; lane++) {
+        jesdlink_read(JESDLINK_STAT_LINK_ERR_CNT(lane), &tmp_reg);
+        bstats_set(BSTAT_G_JESD_LINK_ERR_L0 + lane, tmp_reg);
+        jesdlink_read(JESDLINK_STAT_RX_BUF_LVL_REG(lane), &tmp_reg);
+        bstats_set(BSTAT_G_JESD_BUF_LVL_L0 + lane, tmp_reg);
+    }
+    bstats_set(BSTAT_G_JESDMON_STATE, jesdmon_state());
+
+#if LWIP_STATS
+#if LINK_STATS
+    bstats_set(BSTAT_G_LWIP_LINK_XMIT, lwip_stats.link.xmit);
+    bstats_set(BSTAT_G_LWIP_LINK_RECV, lwip_stats.link.recv);
+    bstats_set(BSTAT_G_LWIP_LINK_DROP, lwip_stats.link.drop);
+    bstats_set(BSTAT_G_LWIP_LINK_ERR,  lwip_stats.link.err);
+#endif
+#if UDP_STATS
+    bstats_set(BSTAT_G_LWIP_UDP_XMIT, lwip_stats.udp.xmit);
+    bstats_set(BSTAT_G_LWIP_UDP_RECV, lwip_stats.udp.recv);
+    bstats_set(BSTAT_G_LWIP_UDP_DROP, lwip_stats.udp.drop);
+    bstats_set(BSTAT_G_LWIP_UDP_ERR,  lwip_stats.udp.err);
+#endif
+#if MEM_STATS
+    bstats_set(BSTAT_G_LWIP_MEM_ERR, lwip_stats.mem.err);
+#endif
+#endif /* LWIP_STATS */
+
+    /* xemacpsif buffer descriptor rings */
+    struct xemac_s *xemac = (struct xemac_s *)server_netif.state;
+    if (xemac && xemac->state) {
+        xemacpsif_s *emac = (xemacpsif_s *)xemac->state;
+        XEmacPs_BdRing *txring = &XEmacPs_GetTxRing(&emac->emacps);
+        XEmacPs_BdRing *rxring = &XEmacPs_GetRxRing(&emac->emacps);
+        bstats_set(BSTAT_G_EMAC_TX_FREE_BD, txring->FreeCnt);
+        bstats_set(BSTAT_G_EMAC_TX_HW_BD,   txring->HwCnt);
+        bstats_set(BSTAT_G_EMAC_RX_FREE_BD, rxring->FreeCnt);
+        bstats_set(BSTAT_G_EMAC_RX_HW_BD,   rxring->HwCnt);
+    }
+}
+
+/* Serialise header + all values into buf; returns bytes written or 0 */
+size_t bstats_snapshot(uint8_t *buf, size_t len)
+{
+    struct bstats_snapshot_hdr hdr;
+    size_t need = sizeof(hdr) + sizeof(bstat_val);
+
+    if (len < need) return 0;
+
+    bstats_refresh();
+
+    hdr.magic     = BSTATS_MAGIC;
+    hdr.version   = BSTATS_VERSION;
+    hdr.count     = BSTAT_NUM;
+    hdr.seq       = snapshot_seq++;
+    hdr.uptime_ms = (uint32_t)bstats_get(BSTAT_G_UPTIME_MS);
+
+    memcpy(buf, &hdr, sizeof(hdr));
+    memcpy(buf + sizeof(hdr), bstat_val, sizeof(bstat_val));
+    return need;
+}
+
+const char* bstats_name(bstat_id_t id)
+{
+    return (id < BSTAT_NUM) ? stat_name[id] : "?";
+}
+
+void bstats_print(void)
+{
+    bstats_refresh();
+    for (int i = 0; i < BSTAT_NUM; i++) {
+        xil_printf("%-20s %s 0x%08x%08x\r\n", stat_name[i], (i < BSTAT_FIRST_GAUGE) ? "C" : "G",
+                   (u32)(bstat_val[i] >> 32), (u32)bstat_val[i]);
+    }
+}
+
+/* -------------------------------------------------------------------------------- */
+/*  UDP request handler: a snapshot, the name table, the link timeline or the profile */
+/* -------------------------------------------------------------------------------- */
+static void stats_recv_callback(void *arg, struct udp_pcb *pcb, struct pbuf *p,
+                                const ip_addr_t *addr, u16_t port)
+{
+    (void)arg;
+    if (p == NULL) return;
+
+    char op = (p->len > 0) ? ((char *)p->payload)[0] : 'S';
+    pbuf_free(p);
+    bstats_inc(BSTAT_STATS_REQ);
+
+    struct pbuf *reply = pbuf_alloc(PBUF_TRANSPORT, STATS_REPLY_MAX, PBUF_RAM);
+    if (!reply) {
+        bstats_inc(BSTAT_UDP_PBUF_ALLOC_ERR);
+        return;
+    }
+
+    size_t n = 0;
+    if (op == 'N') {
+        char *out = (char *)reply->payload;
+        for (int i = 0; i < BSTAT_NUM; i++) {
+            size_t l = strlen(stat_name[i]);
+            if (n + l + 1 >= reply->len) break;
+            memcpy(out + n, stat_name[i], l);
+            n += l;
+            out[n++] = (i == BSTAT_NUM - 1) ? '\0' : ',';
+        }
+    } else if (op == 'E') {
+        n = jesdmon_timeline_copy((uint8_t *)reply->payload, reply->len);
+    } else if (op == 'P' || op == 'p') {
+        n = bprof_wire((uint8_t *)reply->payload, reply->len);
+        if (op == 'p') bprof_reset();   /* after the reply is built: "p" is "P", then clear */
+    } else {
+        n = bstats_snapshot((uint8_t *)reply->payload, reply->len);
+    }
+
+    pbuf_realloc(reply, (u16_t)n);
+    if (udp_sendto(pcb, reply, addr, port) != ERR_OK) {
+        bstats_inc(BSTAT_UDP_SENDTO_ERR);
+    }
+    pbuf_free(reply);
+}
+
+int bstats_udp_init(void)
+{
+    stats_pcb = udp_new();
+    if (stats_pcb == NULL) {
+        xil_printf("stats: udp_new() failed\r\n");
+        return 1;
+    }
+    if (udp_bind(stats_pcb, IPADDR_ANY, STATS_PORT) != ERR_OK) {
+        xil_printf("stats: udp_bind failed\r\n");
+        return 1;
+    }
+    udp_recv(stats_pcb, stats_recv_callback, NULL);
+    xil_printf("Stats server port %d\r\n", STATS_PORT);
+    return 0;
+}
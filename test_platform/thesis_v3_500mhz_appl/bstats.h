@@ -0,0 +1,123 @@
+/* bstats.h
+ * Central runtime statistics registry.
+ *
+ * Counters are bumped in place by the DMA, UDP, SPI, AD9695 and JESD code
+ * paths (one increment, no printing).  Gauges are sampled from hardware and
+ * from lwIP only when a snapshot is taken, so the hot paths pay nothing for
+ * them.
+ *
+ * A host polls the registry over UDP (port STATS_PORT):
+ *   request "S" -> binary snapshot (struct bstats_snapshot_hdr + u64 values)
+ *   request "N" -> comma separated entry names, in ID order
+ *   request "E" -> JESD link event timeline (see bjesdmon.h)
+ *   request "P" -> hot-path profile (see bprofile.h), "p" clears it first
+ * All fields are little endian.
+ */
+
+#ifndef BSTATS_H
+#define BSTATS_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+#define STATS_PORT              5003
+#define STATS_REPLY_MAX         1200    /* stays below the Ethernet MTU */
+#define BSTATS_MAGIC            0x41545342U     /* "BSTA" */
+#define BSTATS_VERSION          1
+
+typedef enum {
+    /* ---- counters ---- */
+    BSTAT_DMA_CAPTURES = 0,
+    BSTAT_DMA_SUBMIT_ERR,
+    BSTAT_DMA_TIMEOUT,
+    BSTAT_UDP_TX_PKTS,
+    BSTAT_UDP_TX_BYTES,
+    BSTAT_UDP_PBUF_ALLOC_ERR,
+    BSTAT_UDP_SENDTO_ERR,
+    BSTAT_UDP_CFG_RX,
+    BSTAT_STATS_REQ,
+    BSTAT_SPI_XFERS,
+    BSTAT_SPI_BYTES,
+    BSTAT_AD9695_RESET_FAIL,
+    BSTAT_AD9695_PLL_UNLOCK,
+    BSTAT_JESDPHY_PLL_UNLOCK,
+    BSTAT_JESDLINK_RESETS,
+    BSTAT_REGC_HITS,
+    BSTAT_REGC_MISSES,
+    BSTAT_REGC_SKIPPED,
+    BSTAT_REGC_VERIFY_ERR,
+    BSTAT_JESDMON_LINK_DOWN,
+    BSTAT_JESDMON_RELINKS,
+    BSTAT_JESDMON_RELINK_FAIL,
+    BSTAT_CAPTURE_FLAGGED,
+    BSTAT_JESDPHY_DRP_OPS,
+    BSTAT_JESDPHY_DRP_TIMEOUT,
+    BSTAT_RECONF_SETTLE,
+    BSTAT_RECONF_RESET,
+    BSTAT_RECONF_ESCALATED,
+    BSTAT_VERIFY_RUNS,
+    BSTAT_VERIFY_BIT_ERR,
+    BSTAT_VERIFY_SLIPS,
+    BSTAT_SWEEP_POINTS,
+    BSTAT_SWEEP_DROPPED,
+    BSTAT_SWEEP_STAMPED,
+
+    /* ---- gauges (sampled by bstats_refresh) ---- */
+    BSTAT_G_UPTIME_MS,
+    BSTAT_G_JESD_STATUS,
+    BSTAT_G_JESD_RX_ERR,
+    BSTAT_G_JESD_LINK_ERR_L0,
+    BSTAT_G_JESD_LINK_ERR_L1,
+    BSTAT_G_JESD_LINK_ERR_L2,
+    BSTAT_G_JESD_LINK_ERR_L3,
+    BSTAT_G_JESD_BUF_LVL_L0,
+    BSTAT_G_JESD_BUF_LVL_L1,
+    BSTAT_G_JESD_BUF_LVL_L2,
+    BSTAT_G_JESD_BUF_LVL_L3,
+    BSTAT_G_JESDMON_STATE,
+    BSTAT_G_RECONF_PATH,
+    BSTAT_G_RECONF_TTV_US,
+    BSTAT_G_JESD_MODE,
+    BSTAT_G_LWIP_LINK_XMIT,
+    BSTAT_G_LWIP_LINK_RECV,
+    BSTAT_G_LWIP_LINK_DROP,
+    BSTAT_G_LWIP_LINK_ERR,
+    BSTAT_G_LWIP_UDP_XMIT,
+    BSTAT_G_LWIP_UDP_RECV,
+    BSTAT_G_LWIP_UDP_DROP,
+    BSTAT_G_LWIP_UDP_ERR,
+    BSTAT_G_LWIP_MEM_ERR,
+    BSTAT_G_EMAC_TX_FREE_BD,
+    BSTAT_G_EMAC_TX_HW_BD,
+    BSTAT_G_EMAC_RX_FREE_BD,
+    BSTAT_G_EMAC_RX_HW_BD,
+
+    BSTAT_NUM
+} bstat_id_t;
+
+#define BSTAT_FIRST_GAUGE       BSTAT_G_UPTIME_MS
+
+struct bstats_snapshot_hdr {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t count;         /* number of u64 values that follow */
+    uint32_t seq;           /* incremented per snapshot          */
+    uint32_t uptime_ms;
+} __attribute__((packed));
+
+extern uint64_t bstat_val[BSTAT_NUM];
+
+static inline void bstats_inc(bstat_id_t id)                { bstat_val[id]++; }
+static inline void bstats_add(bstat_id_t id, uint32_t n)    { bstat_val[id] += n; }
+static inline void bstats_add64(bstat_id_t id, uint64_t n)  { bstat_val[id] += n; }
+static inline void bstats_set(bstat_id_t id, uint64_t v)    { bstat_val[id] = v; }
+static inline uint64_t bstats_get(bstat_id_t id)            { return bstat_val[id]; }
+
+void        bstats_clear(void);
+void        bstats_refresh(void);
+size_t      bstats_snapshot(uint8_t *buf, size_t len);
+const char* bstats_name(bstat_id_t id);
+void        bstats_print(void);
+int         bstats_udp_init(void);
+
+#endif /* BSTATS_H */
@@ -12,11 +12,18 @@
 #include "bjesdphy.h"
 #include "bjesdlink.h"
 #include "ad9695_api.h"
+#include "ad9695_regcache.h"
 #include "xspips.h"
 #include "xaxidma.h"
 #include "baxidma.h"
 #include "sleep.h"
 #include "ad9695_registers.h"
+#include "bprofile.h"
+#include "bstats.h"
+#include "bjesdmon.h"
+#include "beyescan.h"
+#include "bjesdmode.h"
+#include "bverify.h"
 
 extern XSpiPs spi_inst;
 extern XAxiDma dma_inst;
@@ -39,7 +46,7 @@ static void parse_cmd_args(char *line, char *option, size_t opt_len, char *addr_
     strtok(ctx, " "); // skip command name
     if (!next_tok(&ctx, option, opt_len)) { ERR("Missing option (-r / -w)"); return; }
     if (!next_tok(&ctx, addr_str, addr_len)) { ERR("Missing address"); return; }
-    if (!strcmp(option, "-w") && !next_tok(&ctx, data_str, data_len)) { ERR("Missing write data"); return; }
+    if ((!strcmp(option, "-w") || !strcmp(option, "-d")) && !next_tok(&ctx, data_str, data_len)) { ERR("Missing write data / count"); return; }
 }
 
 // Handler for SPI commands
@@ -57,8 +64,19 @@ void handle_spi_cmd(char *line) {
     } else if (!strcmp(option, "-w")) {
         data = (uint8_t)strtol(data_str, NULL, 0);
         ad9695_write_register(&spi_inst, addr, data);
+        ad9695_regcache_forget(addr);   /* raw write: shadow no longer trusted */
         xil_printf("Command Success: Wrote 0x%02X to 0x%04X\r\n", data, addr);
-    } else ERR("Invalid option '%s' (use -r or -w)", option);
+    } else if (!strcmp(option, "-d")) {
+        uint8_t block[AD9695_SPI_STREAM_MAX];
+        uint16_t count = (uint16_t)strtol(data_str, NULL, 0);
+        if (count == 0 || count > AD9695_SPI_STREAM_MAX) { ERR("Count must be 1..%d", AD9695_SPI_STREAM_MAX); return; }
+        ad9695_read_registers(&spi_inst, addr, block, count);
+        for (uint16_t i = 0; i < count; i++) {
+            if ((i & 0xF) == 0) xil_printf("%s0x%04X:", i ? "\r\n" : "", addr + i);
+            xil_printf(" %02X", block[i]);
+        }
+        xil_printf("\r\n");
+    } else ERR("Invalid option '%s' (use -r, -w or -d)", option);
 }
 
 // Handler for JESD204 PHY commands
@@ -112,27 +130,18 @@ void handle_dma_cmd(char* line) {
     strncpy(option, token, sizeof(option) - 1);
     option[sizeof(option) - 1] = '\0';
 
+    uint32_t capture_bytes = jesdmode_capture_bytes(jesdmode_current());
+
     if (strcmp(option, "-w") == 0) {
-        xil_printf("Starting DMA capture of %d bytes...\r\n", DMA_CMD_BUF_SIZE);
-        Xil_DCacheFlushRange((UINTPTR)RxBufferPtr, DMA_CMD_BUF_SIZE);
-        int res =XAxiDma_SimpleTransfer(&dma_inst, (UINTPTR) RxBufferPtr,
-                        DMA_CMD_BUF_SIZE, XAXIDMA_DEVICE_TO_DMA);
-
-        if (res != XST_SUCCESS) { ERR("XAxiDma_SimpleTransfer failed. Error Code: %d.", res); return; }
-        u32 timeout = 1000;
-        int busy;
-        do {
-            busy = XAxiDma_Busy(&dma_inst, XAXIDMA_DEVICE_TO_DMA);
-            if(!busy){ break; }
-            timeout --;
-            usleep(1);
-        }while(timeout > 0);
-        if (busy) { xil_printf("DMA was still busy and timed out.\r\n"); }
-        else { xil_printf("DMA Finished Successfully.\r\n"); }
+        xil_printf("Starting DMA capture of %d bytes...\r\n", capture_bytes);
+        uint32_t epoch = jesdmon_capture_begin();
+        if (dma_capture(&dma_inst, RxBufferPtr, capture_bytes)) xil_printf("DMA submit failed or timed out.\r\n");
+        else xil_printf("DMA Finished Successfully.\r\n");
+        if (!jesdmon_capture_end(epoch)) xil_printf("WARNING: JESD link disturbed during capture, data flagged bad.\r\n");
         xil_printf("dma -w complete.\r\n");
     } else if (strcmp(option, "-r") == 0) {
-        xil_printf("Reading back %d bytes:\r\n", DMA_CMD_BUF_SIZE);
-        for (uint32_t i = 0; i < DMA_CMD_BUF_SIZE; i+=16) {
+        xil_printf("Reading back %d bytes:\r\n", capture_bytes);
+        for (uint32_t i = 0; i < capture_bytes; i+=16) {
             xil_printf("@0x%02X = 0x%02X ", i, RxBufferPtr[i]);
             xil_printf("\r\n");
         }
@@ -213,6 +222,7 @@ void handle_adc_cmd(char* line)
             ad9695_jesd_get_pll_status(&pll_stat);
         } while (!(pll_stat & AD9695_JESD_PLL_LOCK_STAT) && timeout--);
 
+        if (!(pll_stat & AD9695_JESD_PLL_LOCK_STAT)) bstats_inc(BSTAT_AD9695_PLL_UNLOCK);
         xil_printf("ad9695 PLL %s\r\n", (pll_stat & AD9695_JESD_PLL_LOCK_STAT) ? "LOCKED" : "UNLOCKED");
         jesdphy_check_pll_status(&pll_stat);
     }
@@ -220,6 +230,218 @@ void handle_adc_cmd(char* line)
 
 }
 
+void handle_prof_cmd(char* line)
+{
+    char copy[MAX_UART_LINE_LENGTH];
+    char option[4];
+
+    strncpy(copy, line, sizeof(copy) - 1);
+    copy[sizeof(copy) - 1] = '\0';
+
+    char* token = strtok(copy, " ");
+    if (!token || strcmp(token, "prof") != 0) { ERR("Expected \"prof\""); return; }
+
+    token = strtok(NULL, " ");
+    if (!token) { ERR("Missing option (-r or -c)"); return; }
+    strncpy(option, token, sizeof(option) - 1);
+    option[sizeof(option) - 1] = '\0';
+
+#if BPROF_ENABLE
+    if (strcmp(option, "-r") == 0) {
+        bprof_print();
+    } else if (strcmp(option, "-c") == 0) {
+        bprof_reset();
+        xil_printf("Profiler counters cleared.\r\n");
+    } else { ERR("Invalid option \"%s\" (use -r or -c)", option); }
+#else
+    ERR("Profiler compiled out (BPROF_ENABLE=0)");
+#endif
+}
+
+void handle_stat_cmd(char* line)
+{
+    char copy[MAX_UART_LINE_LENGTH];
+    char option[4];
+
+    strncpy(copy, line, sizeof(copy) - 1);
+    copy[sizeof(copy) - 1] = '\0';
+
+    char* token = strtok(copy, " ");
+    if (!token || strcmp(token, "stat") != 0) { ERR("Expected \"stat\""); return; }
+
+    token = strtok(NULL, " ");
+    if (!token) { ERR("Missing option (-r or -c)"); return; }
+    strncpy(option, token, sizeof(option) - 1);
+    option[sizeof(option) - 1] = '\0';
+
+    if (strcmp(option, "-r") == 0) {
+        bstats_print();
+    } else if (strcmp(option, "-c") == 0) {
+        bstats_clear();
+        xil_printf("Statistics counters cleared.\r\n");
+    } else { ERR("Invalid option \"%s\" (use -r or -c)", option); }
+}
+
+void handle_regc_cmd(char* line)
+{
+    char copy[MAX_UART_LINE_LENGTH];
+    char option[4];
+
+    strncpy(copy, line, sizeof(copy) - 1);
+    copy[sizeof(copy) - 1] = '\0';
+
+    char* token = strtok(copy, " ");
+    if (!token || strcmp(token, "regc") != 0) { ERR("Expected \"regc\""); return; }
+
+    token = strtok(NULL, " ");
+    if (!token) { ERR("Missing option (-r, -v, -i or -a)"); return; }
+    strncpy(option, token, sizeof(option) - 1);
+    option[sizeof(option) - 1] = '\0';
+
+    if (strcmp(option, "-r") == 0) {
+        ad9695_regcache_print();
+    } else if (strcmp(option, "-v") == 0) {
+        ad9695_regcache_verify();
+    } else if (strcmp(option, "-i") == 0) {
+        ad9695_regcache_invalidate();
+        xil_printf("Register shadow invalidated.\r\n");
+    } else if (strcmp(option, "-a") == 0) {
+        token = strtok(NULL, " ");
+        if (!token) { ERR("Missing 0/1 for -a"); return; }
+        ad9695_regcache_set_verify((uint8_t)strtol(token, NULL, 0) ? 1 : 0);
+        xil_printf("Verify-on-flush %s.\r\n", strtol(token, NULL, 0) ? "enabled" : "disabled");
+    } else { ERR("Invalid option \"%s\" (use -r, -v, -i or -a)", option); }
+}
+
+void handle_mon_cmd(char* line)
+{
+    char copy[MAX_UART_LINE_LENGTH];
+    char option[4];
+
+    strncpy(copy, line, sizeof(copy) - 1);
+    copy[sizeof(copy) - 1] = '\0';
+
+    char* token = strtok(copy, " ");
+    if (!token || strcmp(token, "mon") != 0) { ERR("Expected \"mon\""); return; }
+
+    token = strtok(NULL, " ");
+    if (!token) { ERR("Missing option (-r, -c or -e)"); return; }
+    strncpy(option, token, sizeof(option) - 1);
+    option[sizeof(option) - 1] = '\0';
+
+    if (strcmp(option, "-r") == 0) {
+        jesdmon_print();
+    } else if (strcmp(option, "-c") == 0) {
+        jesdmon_clear_events();
+        xil_printf("Link event timeline cleared.\r\n");
+    } else if (strcmp(option, "-e") == 0) {
+        token = strtok(NULL, " ");
+        if (!token) { ERR("Missing 0/1 for -e"); return; }
+        jesdmon_enable(strtol(token, NULL, 0) ? 1 : 0);
+        xil_printf("Link monitor %s.\r\n", strtol(token, NULL, 0) ? "enabled" : "disabled");
+    } else { ERR("Invalid option \"%s\" (use -r, -c or -e)", option); }
+}
+
+void handle_eye_cmd(char* line)
+{
+    char copy[MAX_UART_LINE_LENGTH];
+    char option[4];
+
+    strncpy(copy, line, sizeof(copy) - 1);
+    copy[sizeof(copy) - 1] = '\0';
+
+    char* token = strtok(copy, " ");
+    if (!token || strcmp(token, "eye") != 0) { ERR("Expected \"eye\""); return; }
+
+    token = strtok(NULL, " ");
+    if (!token) { ERR("Missing option (-s, -a or -r)"); return; }
+    strncpy(option, token, sizeof(option) - 1);
+    option[sizeof(option) - 1] = '\0';
+
+    if (strcmp(option, "-a") == 0) {
+        if (eyescan_all()) ERR("Eye scan failed on one or more lanes");
+        return;
+    }
+
+    token = strtok(NULL, " ");
+    if (!token) { ERR("Missing lane"); return; }
+    uint8_t lane = (uint8_t)strtol(token, NULL, 0);
+
+    if (strcmp(option, "-s") == 0) {
+        if (eyescan_lane(lane)) { ERR("Eye scan failed on lane %d", lane); return; }
+        eyescan_print(lane);
+    } else if (strcmp(option, "-r") == 0) {
+        eyescan_print(lane);
+    } else { ERR("Invalid option \"%s\" (use -s, -a or -r)", option); }
+}
+
+void handle_jesd_cmd(char* line)
+{
+    char copy[MAX_UART_LINE_LENGTH];
+    char option[4];
+    const struct jesd_mode* mode;
+
+    strncpy(copy, line, sizeof(copy) - 1);
+    copy[sizeof(copy) - 1] = '\0';
+
+    char* token = strtok(copy, " ");
+    if (!token || strcmp(token, "jesd") != 0) { ERR("Expected \"jesd\""); return; }
+
+    token = strtok(NULL, " ");
+    if (!token) { ERR("Missing option (-l, -r or -m)"); return; }
+    strncpy(option, token, sizeof(option) - 1);
+    option[sizeof(option) - 1] = '\0';
+
+    if (strcmp(option, "-l") == 0) {
+        jesdmode_print_table();
+    } else if (strcmp(option, "-r") == 0) {
+        mode = jesdmode_current();
+        xil_printf("JESD mode %d: L=%d M=%d F=%d S=%d NP=%d, %d bytes per capture\r\n", jesdmode_id(mode),
+                   mode->L, mode->M, mode->F, mode->S, mode->NP, jesdmode_capture_bytes(mode));
+    } else if (strcmp(option, "-m") == 0) {
+        token = strtok(NULL, " ");
+        if (!token) { ERR("Missing mode id (see jesd -l)"); return; }
+        mode = jesdmode_get((uint32_t)strtoul(token, NULL, 0));
+        if (!mode) { ERR("Unknown mode id %s", token); return; }
+        if (jesdmode_apply(mode)) ERR("Mode switch failed");
+    } else { ERR("Invalid option \"%s\" (use -l, -r or -m)", option); }
+}
+
+void handle_ver_cmd(char* line)
+{
+    char copy[MAX_UART_LINE_LENGTH];
+    char option[4];
+    struct verify_result res;
+    int pattern;
+
+    strncpy(copy, line, sizeof(copy) - 1);
+    copy[sizeof(copy) - 1] = '\0';
+
+    char* token = strtok(copy, " ");
+    if (!token || strcmp(token, "ver") != 0) { ERR("Expected \"ver\""); return; }
+
+    token = strtok(NULL, " ");
+    if (!token) { ERR("Missing option (-s or -r)"); return; }
+    strncpy(option, token, sizeof(option) - 1);
+    option[sizeof(option) - 1] = '\0';
+
+    if (strcmp(option, "-r") == 0) {
+        verify_print(verify_last());
+    } else if (strcmp(option, "-s") == 0) {
+        token = strtok(NULL, " ");
+        if (!token) { ERR("Missing pattern (pn9, pn23, ramp or chk)"); return; }
+        pattern = verify_pattern_parse(token);
+        if (pattern < 0) { ERR("Unknown pattern %s", token); return; }
+        token = strtok(NULL, " ");
+        if (!token) { ERR("Missing segment count"); return; }
+        uint32_t segments = (uint32_t)strtoul(token, NULL, 0);
+        if (segments == 0) { ERR("Segment count must be at least 1"); return; }
+        /* Uses the dma -w buffer: two segments of VERIFY_SEG_BYTES */
+        verify_run((uint8_t)pattern, segments, RxBufferPtr, &res);
+        verify_print(&res);
+    } else { ERR("Invalid option \"%s\" (use -s or -r)", option); }
+}
+
 typedef void (*cmd_fn)(char *line);
 static const struct { const char *name; cmd_fn fn; } cmd_table[] = {
     { "spi",  handle_spi_cmd  },
@@ -229,7 +451,14 @@ static const struct { const char *name; cmd_fn fn; } cmd_table[] = {
     { "dbg",  handle_dma_dbg_cmd  },
     { "mem",  handle_mem_cmd  },
     { "udp",  handle_udp_cmd  },
-    { "adc",  handle_adc_cmd  }
+    { "adc",  handle_adc_cmd  },
+    { "prof", handle_prof_cmd },
+    { "stat", handle_stat_cmd },
+    { "regc", handle_regc_cmd },
+    { "mon",  handle_mon_cmd  },
+    { "eye",  handle_eye_cmd  },
+    { "jesd", handle_jesd_cmd },
+    { "ver",  handle_ver_cmd  }
 };
 
 void handle_cmd(char *line) {
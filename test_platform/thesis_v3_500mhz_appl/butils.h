@@ -11,6 +11,7 @@
  *  ──────────────────────────────────────────────────────────────────────────   
  *  spi     -r    <reg16>                         Read AD9695 register          
  *          -w    <reg16> <data8>                Write AD9695 register         
+ *          -d    <reg16> <count>                Dump <count> regs (streamed)  
  *                                                                              
  *  phy     -r    <off32>                         Read JESD PHY register        
  *          -w    <off32> <data32>               Write JESD PHY register       
@@ -28,6 +29,32 @@
  *                                                                              
  *  mem     -r    <addr32>                        Read arbitrary address        
  *          -w    <addr32> <data32>              Write arbitrary address       
+ *                                                                              
+ *  prof    -r                                    Print hot-path profile        
+ *          -c                                    Clear profile counters        
+ *                                                                              
+ *  stat    -r                                    Print statistics registry     
+ *          -c                                    Clear statistics counters     
+ *                                                                              
+ *  regc    -r                                    Print register shadow state   
+ *          -v                                    Verify shadow against chip    
+ *          -i                                    Invalidate register shadow    
+ *          -a    <0|1>                           Verify every flush            
+ *                                                                              
+ *  mon     -r                                    Print link health timeline    
+ *          -c                                    Clear link event timeline     
+ *          -e    <0|1>                           Enable background monitor     
+ *                                                                              
+ *  eye     -s    <lane>                          2-D eye scan of one lane      
+ *          -a                                    Eye scan all lanes            
+ *          -r    <lane>                          Print last lane margin map    
+ *                                                                              
+ *  jesd    -l                                    List JESD link modes          
+ *          -r                                    Print current JESD mode       
+ *          -m    <id>                            Switch link to mode <id>      
+ *                                                                              
+ *  ver     -s    <pn9|pn23|ramp|chk> <segments>  Verify data path with pattern 
+ *          -r                                    Print last verify result      
  * --------------------------------------------------------------------------  
  *  © 2025 Your Project Name — MIT License                                      
  * ==========================================================================*/
@@ -47,5 +74,12 @@ void handle_link_cmd(char *line);
 void handle_dma_cmd (char *line);
 void handle_dma_dbg_cmd(char *line);
 void handle_mem_cmd (char *line);
+void handle_prof_cmd(char *line);
+void handle_stat_cmd(char *line);
+void handle_regc_cmd(char *line);
+void handle_mon_cmd (char *line);
+void handle_eye_cmd (char *line);
+void handle_jesd_cmd(char *line);
+void handle_ver_cmd (char *line);
 
 #endif /* CONSOLE_CMDS_H */
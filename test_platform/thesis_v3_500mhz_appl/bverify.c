@@ -0,0 +1,449 @@
+#include "bverify.h"
+#include <string.h>
+#include "xaxidma.h"
+#include "xil_cache.h"
+#include "xil_printf.h"
+#include "xiltimer.h"
+#include "sleep.h"
+#include "ad9695_registers.h"
+#include "ad9695_regcache.h"
+#include "bjesdmode.h"
+#include "bjesdmon.h"
+#include "bstats.h"
+
+#if defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+#define COUNTS_PER_US           (COUNTS_PER_SECOND / 1000000U)
+#define VERIFY_SEG_SAMPLES      (VERIFY_SEG_BYTES / 2)
+#define VERIFY_DETECT_WORDS     32      /* samples used to pick polarity / ramp direction */
+
+extern XAxiDma dma_inst;
+
+struct conv_state {
+    uint16_t ref1, ref2;        /* expected previous two samples */
+    uint16_t inv;               /* PN output mask, 0 or 0xFFFF */
+    uint16_t step;              /* ramp increment, 1 or 0xFFFF */
+    uint8_t  polarity_known;
+    uint8_t  bad_run;
+    uint8_t  dirty;             /* reference and data differ in the last two samples */
+    uint32_t pend_bits;         /* errors of the current bad run, dropped on a slip */
+    uint32_t pend_lane[JESDLINK_NUM_LANES];
+    uint64_t pend_first;
+};
+
+static const char *const pattern_name[VERIFY_NUM_PATTERNS] = { "pn9", "pn23", "ramp", "chk" };
+
+static uint8_t                  cur_pattern;
+static const struct jesd_mode  *cur_mode;
+static struct verify_result    *cur_res;
+static struct verify_result     last_res;
+static struct conv_state        conv_st[VERIFY_MAX_CONV];
+static int16_t                  conv_buf[VERIFY_MAX_CONV][VERIFY_SEG_SAMPLES] __attribute__((aligned(16)));
+
+static uint64_t now_us(void)
+{
+    XTime now;
+    XTime_GetTime(&now);
+    return now / COUNTS_PER_US;
+}
+
+/* ---------------------------------------------------------------------- */
+/*  Self-synchronising check: predict a sample from the received samples   */
+/*  before it.  PN bit n is bit n-5 ^ bit n-9 (PN9) or n-18 ^ n-23 (PN23).  */
+/* ---------------------------------------------------------------------- */
+static uint16_t sync_err(const struct conv_state *st, const uint16_t *s)
+{
+    uint32_t x;
+
+    switch (cur_pattern) {
+    case VERIFY_PN9:
+        x = ((uint32_t)s[-1] << 16) | s[0];
+        return s[0] ^ (uint16_t)((x >> 5) ^ (x >> 9)) ^ st->inv;
+    case VERIFY_PN23:
+        x = ((uint32_t)s[-2] << 16) | s[-1];
+        return s[0] ^ (uint16_t)((x >> 2) ^ (x >> 7)) ^ st->inv;
+    case VERIFY_RAMP:
+        return s[0] ^ (uint16_t)(s[-1] + st->step);
+    default:
+        return s[0] ^ (uint16_t)~s[-1];
+    }
+}
+
+#if defined(__ARM_NEON)
+/* Low 16 bits of ((hi:lo) >> A) ^ ((hi:lo) >> B), per 16-bit lane */
+#define VERIFY_PN_TAPS(NAME, A, B)                                                          \
+static inline uint16x8_t NAME(uint16x8_t hi, uint16x8_t lo)                                 \
+{                                                                                           \
+    uint32x4_t xl = vorrq_u32(vshll_n_u16(vget_low_u16(hi), 16), vmovl_u16(vget_low_u16(lo)));   \
+    uint32x4_t xh = vorrq_u32(vshll_n_u16(vget_high_u16(hi), 16), vmovl_u16(vget_high_u16(lo))); \
+    xl = veorq_u32(vshrq_n_u32(xl, A), vshrq_n_u32(xl, B));                                 \
+    xh = veorq_u32(vshrq_n_u32(xh, A), vshrq_n_u32(xh, B));                                 \
+    return vcombine_u16(vmovn_u32(xl), vmovn_u32(xh));                                      \
+}
+
+VERIFY_PN_TAPS(pn9_taps, 5, 9)
+VERIFY_PN_TAPS(pn23_taps, 2, 7)
+
+/* 1 when s[0..7] all follow from the samples before them */
+static int vec_clean(const struct conv_state *st, const uint16_t *s)
+{
+    uint16x8_t cur = vld1q_u16(s);
+    uint16x8_t p1  = vld1q_u16(s - 1);
+    uint16x8_t err;
+
+    switch (cur_pattern) {
+    case VERIFY_PN9:
+        err = veorq_u16(veorq_u16(cur, pn9_taps(p1, cur)), vdupq_n_u16(st->inv));
+        break;
+    case VERIFY_PN23:
+        err = veorq_u16(veorq_u16(cur, pn23_taps(vld1q_u16(s - 2), p1)), vdupq_n_u16(st->inv));
+        break;
+    case VERIFY_RAMP:
+        err = veorq_u16(cur, vaddq_u16(p1, vdupq_n_u16(st->step)));
+        break;
+    default:
+        err = veorq_u16(cur, vmvnq_u16(p1));
+        break;
+    }
+    return vmaxvq_u16(err) == 0;
+}
+#else
+static int vec_clean(const struct conv_state *st, const uint16_t *s)
+{
+    uint16_t err = 0;
+    for (int k = 0; k < 8; k++) err |= sync_err(st, s + k);
+    return err == 0;
+}
+#endif
+
+/* ---------------------------------------------------------------------- */
+/*  Locked reference: next sample from the expected (not received) ones    */
+/* ---------------------------------------------------------------------- */
+static uint16_t expect_next(const struct conv_state *st)
+{
+    uint32_t h;
+    int a, b;
+
+    switch (cur_pattern) {
+    case VERIFY_PN9:
+    case VERIFY_PN23:
+        /* bit 0 of h is the newest bit of the true (non-inverted) sequence */
+        a = (cur_pattern == VERIFY_PN9) ? 4 : 17;
+        b = (cur_pattern == VERIFY_PN9) ? 8 : 22;
+        h = (((uint32_t)st->ref2 << 16) | st->ref1) ^ (st->inv ? 0xFFFFFFFFU : 0);
+        for (int k = 0; k < 16; k++) h = (h << 1) | (((h >> a) ^ (h >> b)) & 1);
+        return (uint16_t)h ^ st->inv;
+    case VERIFY_RAMP:
+        return (uint16_t)(st->ref1 + st->step);
+    default:
+        return (uint16_t)~st->ref1;
+    }
+}
+
+/* Octet positions in a frame are converter-major, sample, then MSB first */
+static uint8_t octet_lane(uint8_t c, size_t i, int lsb)
+{
+    uint32_t octet = ((uint32_t)c * cur_mode->S + (uint32_t)(i % cur_mode->S)) * 2 + (lsb ? 1 : 0);
+    return (uint8_t)(octet / cur_mode->F);
+}
+
+static void pending_add(struct conv_state *st, uint8_t c, size_t i, uint16_t diff, uint64_t base)
+{
+    if (diff >> 8)   st->pend_lane[octet_lane(c, i, 0)] += __builtin_popcount(diff >> 8);
+    if (diff & 0xFF) st->pend_lane[octet_lane(c, i, 1)] += __builtin_popcount(diff & 0xFF);
+    st->pend_bits += __builtin_popcount(diff);
+    if (st->pend_first == VERIFY_NO_ERROR) st->pend_first = base + i;
+}
+
+static void pending_clear(struct conv_state *st)
+{
+    st->pend_bits = 0;
+    memset(st->pend_lane, 0, sizeof(st->pend_lane));
+    st->pend_first = VERIFY_NO_ERROR;
+}
+
+static void pending_commit(struct conv_state *st, struct verify_conv *cv)
+{
+    if (!st->pend_bits) return;
+    cv->bit_err += st->pend_bits;
+    if (cv->first_err == VERIFY_NO_ERROR) cv->first_err = st->pend_first;
+    for (uint32_t lane = 0; lane < JESDLINK_NUM_LANES; lane++) cur_res->lane_err[lane] += st->pend_lane[lane];
+    pending_clear(st);
+}
+
+/*
+ * Mismatching samples are held back until the data matches the reference
+ * again (bit errors) or VERIFY_LOSS_WORDS of them in a row follow the
+ * pattern on their own (the stream moved: slip, the held errors are dropped).
+ */
+static void check_word(struct conv_state *st, struct verify_conv *cv, uint8_t c,
+                       const uint16_t *s, size_t i, uint64_t base)
+{
+    uint16_t e = expect_next(st);
+    uint16_t diff = s[i] ^ e;
+
+    if (!diff) {
+        st->bad_run = 0;
+        pending_commit(st, cv);
+    } else {
+        st->bad_run = sync_err(st, s + i) ? 0 : st->bad_run + 1;
+        if (st->bad_run >= VERIFY_LOSS_WORDS) {
+            cv->slips++;
+            pending_clear(st);
+            st->bad_run = 0;
+            st->ref2 = s[i - 1];
+            st->ref1 = s[i];
+            return;
+        }
+        pending_add(st, c, i, diff, base);
+    }
+    st->ref2 = st->ref1;
+    st->ref1 = e;
+}
+
+/* Pick PN polarity / ramp direction from the start of the first segment */
+static void detect_polarity(struct conv_state *st, struct verify_conv *cv, const uint16_t *s, size_t n)
+{
+    uint32_t err[2] = { 0, 0 };
+    size_t end = (n < 2 + VERIFY_DETECT_WORDS) ? n : 2 + VERIFY_DETECT_WORDS;
+
+    st->polarity_known = 1;
+    st->step = 1;
+    if (cur_pattern == VERIFY_CHECKER) return;
+
+    for (int alt = 0; alt < 2; alt++) {
+        st->inv  = alt ? 0xFFFF : 0;
+        st->step = alt ? 0xFFFF : 1;
+        for (size_t i = 2; i < end; i++) err[alt] += __builtin_popcount(sync_err(st, s + i));
+    }
+    cv->inverted = (err[1] < err[0]);
+    st->inv  = (cur_pattern != VERIFY_RAMP && cv->inverted) ? 0xFFFF : 0;
+    st->step = (cur_pattern == VERIFY_RAMP && cv->inverted) ? 0xFFFF : 1;
+}
+
+/* One converter of one DMA segment; base is the run offset of sample 0 */
+static void check_segment(uint8_t c, const uint16_t *s, size_t n, uint64_t base)
+{
+    struct conv_state *st = &conv_st[c];
+    struct verify_conv *cv = &cur_res->conv[c];
+    size_t i = 2, end;
+
+    if (n < 3) return;
+    if (!st->polarity_known) detect_polarity(st, cv, s, n);
+
+    st->ref2 = s[0];
+    st->ref1 = s[1];
+    st->bad_run = 0;
+    st->dirty = 1;
+    pending_clear(st);
+
+    while (i < n) {
+        if (!st->dirty && i + 8 <= n && vec_clean(st, s + i)) {
+            st->ref2 = s[i + 6];
+            st->ref1 = s[i + 7];
+            i += 8;
+            continue;
+        }
+        end = (i + 8 <= n) ? i + 8 : n;
+        for (; i < end; i++) check_word(st, cv, c, s, i, base);
+        st->dirty = st->bad_run || st->ref1 != s[i - 1] || st->ref2 != s[i - 2];
+    }
+
+    /* a bad run cut short by the end of the segment cannot be told from errors */
+    pending_commit(st, cv);
+    cv->bits += 16ULL * (n - 2);
+}
+
+static void check_capture(const uint8_t *raw, uint32_t seg)
+{
+    int16_t *out[VERIFY_MAX_CONV] = { conv_buf[0], conv_buf[1] };
+    size_t n = jesdmode_unpack(cur_mode, raw, VERIFY_SEG_BYTES, out, VERIFY_SEG_SAMPLES);
+
+    for (uint8_t c = 0; c < cur_mode->M; c++) check_segment(c, (const uint16_t *)out[c], n, (uint64_t)seg * n);
+}
+
+/* ---------------------------------------------------------------------- */
+/*  Capture                                                                */
+/* ---------------------------------------------------------------------- */
+static int dma_start(uint8_t *slot)
+{
+    Xil_DCacheFlushRange((UINTPTR)slot, VERIFY_SEG_BYTES);
+    if (XAxiDma_SimpleTransfer(&dma_inst, (UINTPTR)slot, VERIFY_SEG_BYTES, XAXIDMA_DEVICE_TO_DMA) != XST_SUCCESS) {
+        bstats_inc(BSTAT_DMA_SUBMIT_ERR);
+        return 1;
+    }
+    return 0;
+}
+
+/* Spin rather than usleep(): a segment takes only a few microseconds */
+static int dma_wait(void)
+{
+    uint64_t deadline = now_us() + VERIFY_DMA_TIMEOUT_US;
+
+    while (XAxiDma_Busy(&dma_inst, XAXIDMA_DEVICE_TO_DMA)) {
+        if (now_us() > deadline) {
+            bstats_inc(BSTAT_DMA_TIMEOUT);
+            return 1;
+        }
+    }
+    bstats_inc(BSTAT_DMA_CAPTURES);
+    return 0;
+}
+
+static uint8_t test_mode_on(uint8_t ch_index)
+{
+    uint8_t mode;
+    ad9695_reg_write(AD9695_CH_INDEX_REG, ch_index);
+    ad9695_reg_read(AD9695_TEST_MODE_REG, &mode);
+    return mode;
+}
+
+static int result_clean(const struct verify_result *res)
+{
+    if (res->dma_err || !res->link_ok || res->segments == 0) return 0;
+    for (uint8_t c = 0; c < res->m; c++) {
+        if (res->conv[c].bit_err || res->conv[c].slips) return 0;
+    }
+    return 1;
+}
+
+int verify_pattern_parse(const char *name)
+{
+    for (int p = 0; p < VERIFY_NUM_PATTERNS; p++) {
+        if (!strcmp(name, pattern_name[p])) return p;
+    }
+    return -1;
+}
+
+const char* verify_pattern_name(uint8_t pattern)
+{
+    return (pattern < VERIFY_NUM_PATTERNS) ? pattern_name[pattern] : "?";
+}
+
+/*
+ * Run <segments> DMA transfers of the test pattern into two VERIFY_SEG_BYTES
+ * slots at buf.  Returns 0 when every segment was captured and checked clean
+ * with the link undisturbed, 1 otherwise; details are in res.
+ */
+int verify_run(uint8_t pattern, uint32_t segments, uint8_t *buf, struct verify_result *res)
+{
+    static const uint8_t test_mode[VERIFY_NUM_PATTERNS] = {
+        AD9695_TESTMODE_PN9_SEQ, AD9695_TESTMODE_PN23_SEQ, AD9695_TESTMODE_RAMP, AD9695_TESTMODE_ALT_CHECKERBOARD
+    };
+    const struct jesd_mode *mode = jesdmode_current();
+    uint8_t *slot[2] = { buf, buf + VERIFY_SEG_BYTES };
+    uint8_t saved_a, saved_b;
+    uint64_t t0, tc;
+    uint32_t epoch, seg;
+    int fail;
+
+    if (pattern >= VERIFY_NUM_PATTERNS || segments == 0) return 1;
+    if (mode->NP != 16 || mode->num_ddc || mode->M > VERIFY_MAX_CONV) {
+        xil_printf("VERIFY: JESD mode %d does not carry test patterns, use a full-bandwidth NP=16 mode\r\n",
+                   jesdmode_id(mode));
+        return 1;
+    }
+
+    memset(res, 0, sizeof(*res));
+    memset(conv_st, 0, sizeof(conv_st));
+    res->pattern = pattern;
+    res->m = mode->M;
+    res->lanes = mode->L;
+    for (uint8_t c = 0; c < VERIFY_MAX_CONV; c++) res->conv[c].first_err = VERIFY_NO_ERROR;
+    cur_pattern = pattern;
+    cur_mode = mode;
+    cur_res = res;
+
+    saved_a = test_mode_on(1);
+    saved_b = test_mode_on(2);
+    ad9695_regcache_batch_begin();
+    ad9695_reg_write(AD9695_CH_INDEX_REG, 3);
+    ad9695_reg_write(AD9695_TEST_MODE_REG, test_mode[pattern]);
+    ad9695_regcache_batch_commit();
+    usleep(VERIFY_SETTLE_US);
+
+    epoch = jesdmon_capture_begin();
+    t0 = now_us();
+    fail = dma_start(slot[0]);
+    for (seg = 0; seg < segments && !fail; seg++) {
+        uint8_t *cur = slot[seg & 1];
+
+        if (dma_wait()) { fail = 1; break; }
+        if (seg + 1 < segments) fail = dma_start(slot[(seg + 1) & 1]);
+
+        Xil_DCacheInvalidateRange((UINTPTR)cur, VERIFY_SEG_BYTES);
+        tc = now_us();
+        check_capture(cur, seg);
+        res->check_us += (uint32_t)(now_us() - tc);
+        res->segments++;
+    }
+    res->elapsed_us = (uint32_t)(now_us() - t0);
+    res->bytes = (uint64_t)res->segments * VERIFY_SEG_BYTES;
+    res->dma_err = fail;
+    res->link_ok = jesdmon_capture_end(epoch) ? 1 : 0;
+
+    ad9695_regcache_batch_begin();
+    ad9695_reg_write(AD9695_CH_INDEX_REG, 1);
+    ad9695_reg_write(AD9695_TEST_MODE_REG, saved_a);
+    ad9695_reg_write(AD9695_CH_INDEX_REG, 2);
+    ad9695_reg_write(AD9695_TEST_MODE_REG, saved_b);
+    ad9695_reg_write(AD9695_CH_INDEX_REG, 3);
+    ad9695_regcache_batch_commit();
+
+    bstats_inc(BSTAT_VERIFY_RUNS);
+    for (uint8_t c = 0; c < res->m; c++) {
+        bstats_add64(BSTAT_VERIFY_BIT_ERR, res->conv[c].bit_err);
+        bstats_add(BSTAT_VERIFY_SLIPS, res->conv[c].slips);
+    }
+    if (res != &last_res) last_res = *res;
+    return result_clean(res) ? 0 : 1;
+}
+
+const struct verify_result* verify_last(void)
+{
+    return &last_res;
+}
+
+/* Decimal text of v in buf (21 bytes): xil_printf has no 64-bit conversions */
+static const char *u64_str(uint64_t v, char *buf)
+{
+    char *p = buf + 20;
+
+    *p = '\0';
+    do {
+        *--p = (char)('0' + v % 10);
+        v /= 10;
+    } while (v);
+    return p;
+}
+
+void verify_print(const struct verify_result *res)
+{
+    char num[2][21];
+
+    uint32_t rate = res->elapsed_us ? (uint32_t)(res->bytes / res->elapsed_us) : 0;
+    uint32_t check_rate = res->check_us ? (uint32_t)(res->bytes / res->check_us) : 0;
+
+    if (res->segments == 0 && !res->dma_err) {
+        xil_printf("verify: no run yet\r\n");
+        return;
+    }
+
+    xil_printf("verify: %s, %d x %d bytes in %d us (%d MB/s, checker %d MB/s)%s%s\r\n",
+               verify_pattern_name(res->pattern), res->segments, VERIFY_SEG_BYTES, res->elapsed_us,
+               rate, check_rate, res->dma_err ? ", DMA FAILED" : "",
+               res->link_ok ? "" : ", LINK EVENT DURING RUN");
+    for (uint8_t c = 0; c < res->m; c++) {
+        const struct verify_conv *cv = &res->conv[c];
+        xil_printf("  ch %c: %s bits, %s bit errors, %d slips%s", 'A' + c, u64_str(cv->bits, num[0]),
+                   u64_str(cv->bit_err, num[1]), cv->slips,
+                   !cv->inverted ? "" : (res->pattern == VERIFY_RAMP) ? ", falling" : ", inverted");
+        if (cv->first_err != VERIFY_NO_ERROR) xil_printf(", first error at sample %s", u64_str(cv->first_err, num[0]));
+        xil_printf("\r\n");
+    }
+    xil_printf("  lane bit errors:");
+    for (uint8_t lane = 0; lane < res->lanes; lane++) xil_printf(" L%d=%s", lane, u64_str(res->lane_err[lane], num[0]));
+    xil_printf("\r\nverify: %s\r\n", result_clean(res) ? "PASS" : "FAIL");
+}
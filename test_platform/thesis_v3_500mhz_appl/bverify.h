@@ -0,0 +1,76 @@
+/* bverify.h
+ * Line-rate data path verifier: AD9695 test pattern -> JESD204 -> DMA -> DDR.
+ *
+ * verify_run() switches both AD9695 channels to a test pattern (PN9, PN23,
+ * ramp or alternating checkerboard), streams <segments> DMA transfers of
+ * VERIFY_SEG_BYTES through two ping-pong slots, checking one slot while the
+ * next transfer is in flight, and restores the previous test mode.
+ *
+ * Each DMA transfer is one contiguous piece of the sample stream, so every
+ * segment is checked on its own: the checker seeds from the first two
+ * samples of each converter and predicts the rest.  Runs of clean samples
+ * go through a self-synchronising compare, 8 samples per step with NEON on
+ * the A53.  A step with a mismatch is re-checked word by word against a
+ * locked reference: isolated bit errors are counted once and charged to
+ * the lane that carried the octet, while VERIFY_LOSS_WORDS words in a row
+ * that follow the pattern but not the reference are reported as a slip and
+ * the reference is re-seeded.  An even slip of the checkerboard cannot be
+ * seen.
+ *
+ * PN sequences are one bit stream, MSB of each 16-bit sample first.  An
+ * inverted PN output and a falling ramp are detected and accepted.  Only
+ * full-bandwidth NP=16 modes carry the pattern through unmodified.
+ */
+
+#ifndef BVERIFY_H
+#define BVERIFY_H
+
+#include <stdint.h>
+#include "xparameters.h"
+#include "bjesdlink.h"
+
+/* Largest simple-mode transfer, rounded down to whole link blocks */
+#define VERIFY_SEG_BYTES        (((1U << XPAR_AXI_DMA_SG_LENGTH_WIDTH) - 1) & ~63U)
+#define VERIFY_MAX_CONV         2       /* M of the full-bandwidth modes */
+#define VERIFY_SETTLE_US        100     /* pattern through the ADC pipeline and link */
+#define VERIFY_DMA_TIMEOUT_US   1000
+#define VERIFY_LOSS_WORDS       3       /* off-reference, self-consistent words that make a slip */
+#define VERIFY_NO_ERROR         UINT64_MAX
+
+typedef enum {
+    VERIFY_PN9 = 0,
+    VERIFY_PN23,
+    VERIFY_RAMP,
+    VERIFY_CHECKER,
+    VERIFY_NUM_PATTERNS
+} verify_pattern_t;
+
+struct verify_conv {
+    uint64_t bits;              /* bits compared */
+    uint64_t bit_err;
+    uint64_t first_err;         /* sample offset into the run, VERIFY_NO_ERROR if none */
+    uint32_t slips;
+    uint8_t  inverted;          /* PN: inverted polarity, ramp: falling */
+};
+
+struct verify_result {
+    uint8_t  pattern;           /* verify_pattern_t */
+    uint8_t  m;
+    uint8_t  lanes;
+    uint8_t  link_ok;           /* no link event during the run */
+    uint32_t segments;          /* DMA transfers checked */
+    uint32_t dma_err;
+    uint64_t bytes;
+    uint32_t elapsed_us;
+    uint32_t check_us;          /* part of elapsed_us spent checking */
+    uint64_t lane_err[JESDLINK_NUM_LANES];
+    struct verify_conv conv[VERIFY_MAX_CONV];
+};
+
+int         verify_pattern_parse(const char *name);
+const char* verify_pattern_name(uint8_t pattern);
+int         verify_run(uint8_t pattern, uint32_t segments, uint8_t *buf, struct verify_result *res);
+const struct verify_result* verify_last(void);
+void        verify_print(const struct verify_result *res);
+
+#endif /* BVERIFY_H */
@@ -1,6 +1,7 @@
 #include "ethernet.h"
 #include "lwip/pbuf.h"
 #include "ad9695_api.h"
+#include "ad9695_regcache.h"
 #include "ad9695_registers.h"
 #include "peripherals.h"
 #include "xspips.h"
@@ -13,8 +14,15 @@
 #include <sys/types.h>
 #include <xemacps.h>
 #include "bjesdlink.h"
+#include "bprofile.h"
+#include "bstats.h"
+#include "bjesdmon.h"
+#include "breconf.h"
+#include "bjesdmode.h"
+#include "baxidma.h"
+#include "xiltimer.h"
 
-static unsigned char mac_address[6] = {0x00,0x0A,0x35,0x00,0x01,0x02};  /* Xilinx OUI + unique ID :contentReference[oaicite:1]{index=1} */
+static unsigned char mac_address[6] = {0x00,0x0A,0x35,0x00,0x01,0x02 + BOARD_ID};  /* Xilinx OUI + unique ID :contentReference[oaicite:1]{index=1} */
 
 struct netif server_netif;
 
@@ -31,6 +39,12 @@ struct udp_pcb *udp_pcb_block;
 
 extern uint8_t uart_send_flag; //Send flag enabled by the uart
 extern uint8_t* dma_rx_base_ptr;
+extern XAxiDma dma_inst;
+
+static uint8_t sweep_captures = 0; //captures requested by the last sweep point, sent from udp_update()
+static uint8_t sweep_stamp = 0;    //last sweep point asked for a stamp datagram
+static uint32_t sweep_tag;
+static uint8_t sweep_delay[4];
 
 /* -------------------------------------------------------------------------------- */
 /*  UDP receive callback: Output the receive parameters using uart                  */
@@ -41,23 +55,37 @@ void recv_callback(void *arg,
                           const ip_addr_t *addr,
                           u16_t port)
 {
+    BPROF_BEGIN(BPROF_RECV_CALLBACK);
     uint8_t receive_buf[64] = {0x0}; //clock mode, fine delay, super fine delay
-    xil_printf("\r\nUDP Packet received. Enter Callback function\r\n");
     /* Always free the incoming packet as soon as possible */
     if (p != NULL) {
-        memcpy(receive_buf, p -> payload, sizeof(receive_buf));
-        xil_printf("Clk Mode: %0x\r\nFine delay steps: %0d\r\nSuper Fine delay steps: %0d\r\n", receive_buf[0], receive_buf[1],receive_buf[2]); 
-        uint8_t channel_idx = receive_buf[3] & 0xff;
-        xil_printf("channel idx: %0x\r\n", channel_idx);
-        ad9695_adc_delay_mode(receive_buf[0] & 0xff);
-        ad9695_adc_set_channel_select(channel_idx - 1);
-        ad9695_adc_fine_delay(receive_buf[1] & 0xff);
-        ad9695_adc_set_channel_select(channel_idx - 1);
-        ad9695_adc_super_fine_delay(receive_buf[2] & 0xff);
-        ad9695_adc_set_channel_select(2);
-        jesdlink_reset();
+        struct reconf_result res;
+        bstats_inc(BSTAT_UDP_CFG_RX);
+        memcpy(receive_buf, p -> payload, p->len < sizeof(receive_buf) ? p->len : sizeof(receive_buf));
+        reconf_clock_delay(receive_buf[0], receive_buf[1], receive_buf[2], receive_buf[3], &res);
+        if (p->len >= UDP_CFG_SWEEP_LEN && (receive_buf[4] & UDP_CFG_CAPTURE)) {
+            /* Sweep point: captures go out from udp_update(), outside the lwIP callback */
+            bstats_inc(BSTAT_SWEEP_POINTS);
+            if (res.ok) {
+                uint8_t n = receive_buf[5] ? receive_buf[5] : 1;
+                sweep_captures = n > UDP_SWEEP_MAX_CAPTURES ? UDP_SWEEP_MAX_CAPTURES : n;
+                sweep_stamp = p->len >= UDP_CFG_STAMP_LEN && (receive_buf[4] & UDP_CFG_STAMP);
+                sweep_tag = (uint32_t)receive_buf[6] | (uint32_t)receive_buf[7] << 8 |
+                            (uint32_t)receive_buf[8] << 16 | (uint32_t)receive_buf[9] << 24;
+                memcpy(sweep_delay, receive_buf, sizeof(sweep_delay));
+            } else {
+                bstats_inc(BSTAT_SWEEP_DROPPED);
+            }
+            pbuf_free(p);
+            BPROF_END(BPROF_RECV_CALLBACK);
+            return;
+        }
+        xil_printf("\r\nUDP cfg: mode %0x fine %0d super fine %0d ch %0x, ",
+                   receive_buf[0], receive_buf[1], receive_buf[2], receive_buf[3]);
+        reconf_print(&res);
         pbuf_free(p);                          /* release RX pbuf */
     }
+    BPROF_END(BPROF_RECV_CALLBACK);
     xil_printf("uart-cmd$: ");
 }
 
@@ -109,6 +137,10 @@ int lwIP_UDP_init()
 
     udp_recv(udp_pcb_block, recv_callback, NULL);   //Register receive callback handler
     xil_printf("UDP server port %d\r\n", SERVER_PORT);
+
+    if (bstats_udp_init()) {
+        return 1;
+    }
     
     xil_printf("UDP init successul\r\n");
 
@@ -116,39 +148,104 @@ int lwIP_UDP_init()
     return 0;
 }
 
-//Loading the payload with 1024 byte from the memory and send to the client 
-void udp_send_mem()
-{   
-    for (int i = 0; i < NUM_OF_TX; i++){\
-        //xil_printf("UDP sending Package #%d\r\n", i + 1);
+//Send <bytes> from buf to the client, in datagrams of at most UDP_CHUNK_MAX bytes
+//Returns 0 on success, 1 (after printing why) on the first failed datagram
+static int udp_send_chunks(const uint8_t *buf, uint32_t bytes)
+{
+    for (uint32_t off = 0; off < bytes; off += UDP_CHUNK_MAX){
+        uint32_t len = (bytes - off > UDP_CHUNK_MAX) ? UDP_CHUNK_MAX : bytes - off;
          //Reallocate a new Packet buffer so that we do not accidentally change the data packet that is already inside the data frame
-        struct pbuf *temp_packetBuffer = pbuf_alloc(PBUF_TRANSPORT, 1024, PBUF_RAM); //Reallocate a pbuf of 1024 bytes 
+        struct pbuf *temp_packetBuffer = pbuf_alloc(PBUF_TRANSPORT, len, PBUF_RAM);
 
         if(!temp_packetBuffer){
+            bstats_inc(BSTAT_UDP_PBUF_ALLOC_ERR);
             xil_printf("pbuf allocate failed\r\n");
-            return;
+            return 1;
         }
 
-
         //Fill Pbuf payload with contend from the memory 
-        //memcpy(temp_packetBuffer->payload, dma_rx_base_ptr + 1024 * i, 1024);
-        memcpy(temp_packetBuffer->payload, dma_rx_base_ptr, 512);
+        memcpy(temp_packetBuffer->payload, buf + off, len);
 
         //sending payload to the client
         if(udp_sendto(udp_pcb_block, temp_packetBuffer, &user_ip, SERVER_PORT) == ERR_OK){
-            //xil_printf("UDP loaded and sent the payload with data from 0x%x to 0x%x to the client terminal\r\n", dma_rx_base_ptr + 1024 * i, dma_rx_base_ptr + 1024 * i + 1024);
+            bstats_inc(BSTAT_UDP_TX_PKTS);
+            bstats_add(BSTAT_UDP_TX_BYTES, temp_packetBuffer->tot_len);
         } else {
+            bstats_inc(BSTAT_UDP_SENDTO_ERR);
+            pbuf_free(temp_packetBuffer);
             xil_printf("UDP sendto(_) failed\r\n");
-            return;
+            return 1;
         }
 
         //freeing the pbuf
         pbuf_free(temp_packetBuffer);        
     }
+    return 0;
+}
+
+static int udp_send_buf(const uint8_t *buf, uint32_t bytes)
+{
+    BPROF_BEGIN(BPROF_UDP_SEND_BUF);
+    int fail = udp_send_chunks(buf, bytes);
+    BPROF_END_BYTES(BPROF_UDP_SEND_BUF, bytes);
+    return fail;
+}
+
+//Loading the payload with the last capture (size set by the JESD mode) and send to the client
+//Captures larger than UDP_CHUNK_MAX go out in several datagrams
+void udp_send_mem()
+{   
+    BPROF_BEGIN(BPROF_UDP_SEND_MEM);
+    uint32_t capture_bytes = jesdmode_capture_bytes(jesdmode_current());
+    for (int i = 0; i < NUM_OF_TX; i++){
+        if (udp_send_buf(dma_rx_base_ptr, capture_bytes)) {
+            BPROF_END(BPROF_UDP_SEND_MEM);
+            return;
+        }
+    }
+    BPROF_END(BPROF_UDP_SEND_MEM);
     xil_printf("UDP package sent successfully\r\n");
 
 }
 
+//Sweep point: <count> back-to-back captures, sent only if all of them are valid,
+//behind a stamp datagram when <stamp> is set
+static void udp_send_sweep(uint8_t count, uint8_t stamp)
+{
+    uint32_t capture_bytes = jesdmode_capture_bytes(jesdmode_current());
+    uint32_t epoch = jesdmon_capture_begin();
+    struct udp_stamp st;
+    XTime t_capture;
+    int fail = 0;
+
+    XTime_GetTime(&t_capture);
+    for (uint8_t i = 0; i < count && !fail; i++) {
+        fail = dma_capture(&dma_inst, dma_rx_base_ptr + (uint32_t)i * capture_bytes, capture_bytes);
+    }
+    if (!jesdmon_capture_end(epoch)) fail = 1;
+    if (fail) {
+        bstats_inc(BSTAT_SWEEP_DROPPED);
+        return;
+    }
+    if (stamp) {
+        st.magic = UDP_STAMP_MAGIC;
+        st.board_id = BOARD_ID;
+        st.captures = count;
+        st.flags = 0;
+        st.tag = sweep_tag;
+        st.capture_bytes = capture_bytes;
+        st.t_capture = t_capture;
+        st.counts_per_second = COUNTS_PER_SECOND;
+        memcpy(st.delay, sweep_delay, sizeof(st.delay));
+        if (udp_send_buf((const uint8_t *)&st, sizeof(st))) {
+            bstats_inc(BSTAT_SWEEP_DROPPED);
+            return;
+        }
+        bstats_inc(BSTAT_SWEEP_STAMPED);
+    }
+    udp_send_buf(dma_rx_base_ptr, (uint32_t)count * capture_bytes);
+}
+
 //This function is to start 
 // void udp_connect()
 // {
@@ -161,6 +258,11 @@ void udp_send_mem()
 void udp_update()
 {
     xemacif_input(&server_netif);
+    if(sweep_captures){
+        uint8_t count = sweep_captures;
+        sweep_captures = 0;
+        udp_send_sweep(count, sweep_stamp);
+    }
     if(uart_send_flag){
         xil_printf("UDP will start to send received DMA samples to the computer station\r\n");
         uart_send_flag = 0;
@@ -10,12 +10,19 @@
 #include "lwip/udp.h"
 #include <lwip/err.h>
 #include <lwip/ip4_addr.h>
+#include <stdint.h>
 
-/* Static IPv4: 192.168.1.10/24, gateway 192.168.1.1 */
+/* Fleet builds: -DBOARD_ID=n gives each board its own address and MAC on the shared
+ * network (192.168.1.(10 + n), MAC ..:01:(02 + n)) and tags its stamp datagrams */
+#ifndef BOARD_ID
+#define BOARD_ID   0
+#endif
+
+/* Static IPv4: 192.168.1.10/24 (+ BOARD_ID), gateway 192.168.1.1 */
 #define IP_ADDR0   192
 #define IP_ADDR1   168
 #define IP_ADDR2   1
-#define IP_ADDR3   10
+#define IP_ADDR3   (10 + BOARD_ID)
 
 #define GW_ADDR0   192
 #define GW_ADDR1   168
@@ -32,10 +39,45 @@
 #define USR_IP_ADDR2    1
 #define USR_IP_ADDR3    100
 
-#define NUM_OF_TX 32 //32 k byte
+#define NUM_OF_TX 32 //repetitions of the capture buffer
+#define UDP_CHUNK_MAX 1024 //max payload per datagram
 
 #define SERVER_PORT 5002 //For netAssist -> 5001 For python script -> 5002
 
+/* Host -> board datagrams on SERVER_PORT
+ *   <mode, fine, super_fine, channel>                   set the clock delay (reconf_clock_delay)
+ *   <mode, fine, super_fine, channel, flags, captures>  sweep point: with UDP_CFG_CAPTURE set, take
+ *       <captures> fresh DMA captures once the delay is valid and send them back to back, capture
+ *       bytes each with no repetition.  Nothing is sent if the delay did not come back valid or the
+ *       link moved during the captures, so the host sees a missing point instead of bad data.
+ *       Sweep points print nothing on the UART, which would take longer than the point itself.
+ *   <mode, fine, super_fine, channel, flags, captures, tag[4]>  with UDP_CFG_STAMP set as well, the
+ *       captures are preceded by one struct udp_stamp datagram: board ID, the host's tag (little
+ *       endian), the delay applied and the board time of the first capture.  A host receiving
+ *       several boards on one port tells them apart and lines their captures up with it.
+ */
+#define UDP_CFG_SWEEP_LEN       6
+#define UDP_CFG_STAMP_LEN       10
+#define UDP_CFG_CAPTURE         0x01
+#define UDP_CFG_STAMP           0x02
+#define UDP_SWEEP_MAX_CAPTURES  NUM_OF_TX
+
+#define UDP_STAMP_MAGIC         0x504D5453u     /* "STMP" */
+
+/* Board -> host, ahead of stamped sweep captures; fleet_rx.h on the host side */
+struct udp_stamp {
+    uint32_t magic;                     /* UDP_STAMP_MAGIC */
+    uint16_t board_id;                  /* BOARD_ID */
+    uint8_t  captures;                  /* captures that follow, capture_bytes each */
+    uint8_t  flags;                     /* reserved, 0 */
+    uint32_t tag;                       /* echoed from the sweep datagram */
+    uint32_t capture_bytes;
+    uint64_t t_capture;                 /* XTime at the first capture's DMA start */
+    uint32_t counts_per_second;         /* XTime rate, COUNTS_PER_SECOND */
+    uint8_t  delay[4];                  /* mode, fine, super_fine, channel as applied */
+};
+_Static_assert(sizeof(struct udp_stamp) == 32, "udp_stamp is 32 bytes on the wire");
+
 extern struct netif server_netif; //Make it can be seen by other .c files
 
 int lwIP_UDP_init();
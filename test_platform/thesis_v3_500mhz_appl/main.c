@@ -12,6 +12,10 @@
 #include "bjesdphy.h"
 #include "baxidma.h"
 #include "ethernet.h"
+#include "bprofile.h"
+#include "bboot.h"
+#include "bjesdmon.h"
+#include "bjesdmode.h"
 
 // AD9695 Libs
 #include "ad9695_api.h"
@@ -21,6 +25,7 @@
 #define DDR_BASE_ADDR       XPAR_PSU_DDR_0_BASEADDRESS
 #define MEM_BASE_ADDR		(DDR_BASE_ADDR + 0x01000000ULL)
 #define RX_BUFFER_BASE		(MEM_BASE_ADDR + 0x00300000ULL)
+#define ADC_SAMPLE_CLK_KHZ  500000
 
 
 
@@ -52,6 +57,8 @@ uint8_t* dma_rx_base_ptr = (uint8_t*) RX_BUFFER_BASE;
 
 int main()
 {
+    boot_timer_start();
+
     // UART initialization
     uart_config = uart_init(&uart_inst);
 
@@ -64,32 +71,32 @@ int main()
     // DMA init
     dma_config = dma_init(&dma_inst);
 
+    boot_phase_mark("peripheral init");
+
     //lwIP init
     if(lwIP_UDP_init()){
         xil_printf("lwIP init fails\n");
     }
+    boot_phase_mark("lwip init");
 
     // line command received from UART
     char uart_line [MAX_UART_LINE_LENGTH];
 
-    // init parameters for AD9695 JESD204B link
-    struct jesd_param_t jesd_param_init = {
-        .jesd_L = 4,
-        .jesd_F = 1,
-        .jesd_M = 2,
-        .jesd_HD = 0,
-        .jesd_K = 32,
-        .jesd_N = 16,
-        .jesd_NP = 16,
-        .jesd_CS = 0
-    };
+    // init parameters for AD9695 JESD204B link, taken from the mode table
+    jesdmode_init(ADC_SAMPLE_CLK_KHZ);
+    const struct jesd_mode *jesd_mode = jesdmode_current();
+    struct jesd_param_t jesd_param_init;
+    jesdmode_to_param(jesd_mode, &jesd_param_init);
 
     // init parameters for AD9695
     struct ad9695_state ad9695_0_param = {
-        .sample_clk_freq_khz = 500000,
+        .sample_clk_freq_khz = ADC_SAMPLE_CLK_KHZ,
         .powerdown_pin_en = 0,
         .powerdown_mode = AD9695_POWERDOWN,
         .fc_ch = ad9695_FULL_BANDWIDTH_MODE,
+        .num_ddc = jesd_mode->num_ddc,
+        .dcm = jesd_mode->dcm,
+        .ddc_complex = jesd_mode->ddc_complex,
         .test_mode_ch0 = AD9695_TESTMODE_OFF,
         .test_mode_ch1 = AD9695_TESTMODE_OFF,
         .jesd_param = &jesd_param_init,
@@ -115,23 +122,45 @@ int main()
 	/* Enable the data cache. */
 	Xil_DCacheEnable();
 
+    // PMU cycle counter for the hot-path profiler (no-op if compiled out)
+    bprof_init();
+
     // init AD9695 (note that CGS force is embedeed in the setup function)
     ad9695_initialize(&ad9695_0_param);
 
     // init JESDPHY
     jesdphy_tx_disable();
+    jesdphy_set_line_rate(jesdmode_lane_rate_kbps(jesd_mode));
+#if BOOT_FAST
+    // hold the PHY RX reset while the AD9695 SERDES PLL locks
+    jesdphy_rx_reset_assert();
+    ad9695_jesd_wait_pll_lock(AD9695_PLL_LOCK_TIMEOUT_US);
+    boot_phase_mark("ad9695 pll lock");
+    jesdphy_rx_reset_release();
+#else
     jesdphy_rx_reset();
+#endif
 
     // init JESDLINK: reset needed after new parameters
     jesdlink_en_scrambling(0);
     jesdlink_subclass_set(0);
     jesdlink_k_f_set(jesd_param_init.jesd_K, jesd_param_init.jesd_F);
+    jesdlink_lanes_set(jesd_param_init.jesd_L);
     jesdlink_reset();
+    boot_phase_mark("jesd link init");
 
     // Check JESDPHY status
     jesdphy_check_pll_status(&pll_status);
+    boot_phase_mark("jesd phy lock");
+
+    // Start the background link health monitor (polled from the idle loop)
+    jesdmon_init();
 
+#if !BOOT_FAST
     usleep(100000);
+    boot_phase_mark("settle delay");
+#endif
+    boot_report();
     while (1) {
         
         uart_get_line(uart_line);
@@ -7,6 +7,10 @@
 #include "peripherals.h"
 #include "ethernet.h"
 #include "lwip/pbuf.h"
+#include "bprofile.h"
+#include "bstats.h"
+#include "bjesdmon.h"
+#include <string.h>
 
 
 /* ============================ GPIO ============================ */
@@ -55,7 +59,11 @@ void ad9695_read_register(XSpiPs *Spi, u16 reg_addr, u8 *data) {
     tx_buf[1] = reg_addr & 0xFF;                  /* bits 7–0 */
     tx_buf[2] = 0x00;                             /* Dummy byte */
 
+    BPROF_BEGIN(BPROF_SPI_XFER);
     XSpiPs_PolledTransfer(Spi, tx_buf, rx_buf, 3);
+    BPROF_END(BPROF_SPI_XFER);
+    bstats_inc(BSTAT_SPI_XFERS);
+    bstats_add(BSTAT_SPI_BYTES, 3);
 
     *data = rx_buf[2];  /* Received data is in the third byte */
 }
@@ -80,7 +88,77 @@ void ad9695_write_register(XSpiPs *Spi, u16 reg_addr, u8 value) {
     tx_buf[1] = reg_addr & 0xFF;         /* bits 7–0 */
     tx_buf[2] = value;
 
+    BPROF_BEGIN(BPROF_SPI_XFER);
     XSpiPs_PolledTransfer(Spi, tx_buf, NULL, 3);
+    BPROF_END(BPROF_SPI_XFER);
+    bstats_inc(BSTAT_SPI_XFERS);
+    bstats_add(BSTAT_SPI_BYTES, 3);
+}
+
+/*
+ * Streaming access: one instruction word followed by <count> data bytes in a
+ * single chip-select assertion (manual CS keeps SS low across FIFO refills).
+ * The AD9695 comes out of reset with descending address order, so the
+ * instruction carries the highest address and the buffer is walked backwards;
+ * this keeps the accessors independent of IF_CFG_A being reprogrammed.
+ */
+void ad9695_read_registers(XSpiPs *Spi, u16 start_addr, u8 *data, u16 count) {
+    u8 tx_buf[2 + AD9695_SPI_STREAM_MAX], rx_buf[2 + AD9695_SPI_STREAM_MAX];
+    u16 top_addr;
+
+    if (count == 0 || count > AD9695_SPI_STREAM_MAX) {
+        xil_printf("ERROR: SPI stream length %d out of range!\r\n", count);
+        return;
+    }
+    top_addr = start_addr + count - 1;
+
+    tx_buf[0] = 0x80 | ((top_addr >> 8) & 0x7F);  /* R/W=1, bits 14–8 */
+    tx_buf[1] = top_addr & 0xFF;                  /* bits 7–0 */
+    memset(&tx_buf[2], 0, count);                 /* Dummy bytes */
+
+    BPROF_BEGIN(BPROF_SPI_XFER);
+    XSpiPs_PolledTransfer(Spi, tx_buf, rx_buf, 2 + count);
+    BPROF_END(BPROF_SPI_XFER);
+    bstats_inc(BSTAT_SPI_XFERS);
+    bstats_add(BSTAT_SPI_BYTES, 2 + count);
+
+    for (u16 i = 0; i < count; i++) {
+        data[count - 1 - i] = rx_buf[2 + i];
+    }
+}
+
+void ad9695_write_registers(XSpiPs *Spi, u16 start_addr, const u8 *data, u16 count) {
+    u8 tx_buf[2 + AD9695_SPI_STREAM_MAX];
+    u16 top_addr;
+
+    if (count == 0 || count > AD9695_SPI_STREAM_MAX) {
+        xil_printf("ERROR: SPI stream length %d out of range!\r\n", count);
+        return;
+    }
+    top_addr = start_addr + count - 1;
+
+    tx_buf[0] = (top_addr >> 8) & 0x7F;  /* R/W=0, bits 14–8 */
+    tx_buf[1] = top_addr & 0xFF;         /* bits 7–0 */
+    for (u16 i = 0; i < count; i++) {
+        tx_buf[2 + i] = data[count - 1 - i];
+    }
+
+    BPROF_BEGIN(BPROF_SPI_XFER);
+    XSpiPs_PolledTransfer(Spi, tx_buf, NULL, 2 + count);
+    BPROF_END(BPROF_SPI_XFER);
+    bstats_inc(BSTAT_SPI_XFERS);
+    bstats_add(BSTAT_SPI_BYTES, 2 + count);
+}
+
+/* Smallest PS SPI prescaler (PCLK/4 .. PCLK/256) that keeps SCLK within the AD9695 limit */
+static u8 spi_fastest_prescaler(u32 input_clk_hz) {
+    u8 prescaler;
+    for (prescaler = XSPIPS_CLK_PRESCALE_4; prescaler < XSPIPS_CLK_PRESCALE_256; prescaler++) {
+        if ((input_clk_hz >> (prescaler + 1)) <= AD9695_SPI_MAX_SCLK_HZ) {
+            break;
+        }
+    }
+    return prescaler;
 }
 
 XSpiPs_Config* spi_init(XSpiPs* spi) {
@@ -97,10 +175,12 @@ XSpiPs_Config* spi_init(XSpiPs* spi) {
 
     /* SPI settings: Manual CS, Mode 0 (CPOL=0, CPHA=0), Master */
     XSpiPs_SetOptions(spi, XSPIPS_MASTER_OPTION | XSPIPS_FORCE_SSELECT_OPTION);
-    XSpiPs_SetClkPrescaler(spi, XSPIPS_CLK_PRESCALE_16);
+    u8 prescaler = spi_fastest_prescaler(config->InputClockHz);
+    XSpiPs_SetClkPrescaler(spi, prescaler);
     XSpiPs_SetSlaveSelect(spi, 0);  /* Select CS0 */
 
-    xil_printf("SPI master initialized successfully.\r\n");
+    xil_printf("SPI master initialized successfully (SCLK %d kHz).\r\n",
+               (config->InputClockHz >> (prescaler + 1)) / 1000);
 
     return config;
 }
@@ -131,9 +211,11 @@ void uart_get_line(char* buffer) {
     u8 c;
     xil_printf("uart-cmd$: ");
     while (i < MAX_UART_LINE_LENGTH - 1) {
-        /* Wait until data is available */
+        /* Wait until data is available; sweep points are served from here too,
+         * a sweep runs with the console idle */
         while (!XUartPs_IsReceiveData(uart_config->BaseAddress)){
-            xemacif_input(&server_netif);
+            udp_update();
+            jesdmon_poll();
         }
 
         c = XUartPs_ReadReg(uart_config->BaseAddress, XUARTPS_FIFO_OFFSET);
@@ -26,6 +26,11 @@
 /* ============================= SPI ============================ */
 #define SPI_DEVICE_ID   0
 
+/* AD9695 SCLK limit (t_SCLK >= 40 ns) and the largest register run moved in
+ * one chip-select assertion by the streaming (bulk) accessors. */
+#define AD9695_SPI_MAX_SCLK_HZ      25000000U
+#define AD9695_SPI_STREAM_MAX       256
+
 /* ============================ UART ============================ */
 #define UART0_DEVICE_ID      0
 #define MAX_UART_LINE_LENGTH 128
@@ -38,6 +43,8 @@ XGpioPs_Config* gpio_init(XGpioPs* InstancePtr);
 void ad9695_read_register(XSpiPs *Spi, u16 reg_addr, u8 *data);
 void ad9695_write_register(XSpiPs *Spi, u16 reg_addr, u8 value);
 u8   ad9695_read_bit   (XSpiPs *Spi, u16 reg_addr, u8 bit_pos);
+void ad9695_read_registers (XSpiPs *Spi, u16 start_addr, u8 *data, u16 count);
+void ad9695_write_registers(XSpiPs *Spi, u16 start_addr, const u8 *data, u16 count);
 XSpiPs_Config* spi_init(XSpiPs* InstancePtr);
 
 /* ---- UART ---- */
@@ -30,10 +30,19 @@ set(USER_INCLUDE_DIRECTORIES
 set(USER_COMPILE_SOURCES
 "../ad9695.c"
 "../ad9695_api.c"
+"../ad9695_regcache.c"
 "../baxidma.c"
+"../beyescan.c"
+"../bboot.c"
 "../bjesdlink.c"
+"../bjesdmode.c"
+"../bjesdmon.c"
 "../bjesdphy.c"
+"../bprofile.c"
+"../breconf.c"
+"../bstats.c"
 "../butils.c"
+"../bverify.c"
 "../ethernet.c"
 "../main.c"
 "../peripherals.c"